@@ -0,0 +1,92 @@
+//===-- smart-chess/Arena.cpp -----------------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file Arena.cpp
+/// \brief Bump allocator for scratch memory that is thrown away all at once.
+///
+//===----------------------------------------------------------------------===//
+
+#include "Arena.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+
+using namespace std;
+
+namespace sch {
+
+Arena::Arena(size_t block_size)
+: mBlocks(), mBlockSize(max<size_t>(block_size, CACHE_LINE)), mCurrent(0), mOffset(0),
+  mBlockAllocations(0) {
+}
+
+void* Arena::allocate(size_t size, size_t alignment) {
+	assert(alignment && (alignment & (alignment - 1)) == 0 && alignment <= CACHE_LINE);
+
+	// Blocks start on a cache line, so aligning the offset aligns the address
+	while(mCurrent < mBlocks.size()) {
+		Block& block = mBlocks[mCurrent];
+		const size_t offset = (mOffset + alignment - 1) & ~(alignment - 1);
+		if(offset + size <= block.size) {
+			mOffset = offset + size;
+			return block.begin + offset;
+		}
+		++mCurrent;
+		mOffset = 0;
+	}
+
+	Block block;
+	block.size = max(mBlockSize, size);
+	block.memory.reset(new char[block.size + CACHE_LINE]);
+	const uintptr_t address = reinterpret_cast<uintptr_t>(block.memory.get());
+	block.begin = block.memory.get() + ((CACHE_LINE - address % CACHE_LINE) % CACHE_LINE);
+	mBlocks.push_back(move(block));
+	++mBlockAllocations;
+
+	mCurrent = mBlocks.size() - 1;
+	mOffset = size;
+	return mBlocks.back().begin;
+}
+
+void Arena::reset() {
+	mCurrent = 0;
+	mOffset = 0;
+}
+
+size_t Arena::getUsed() const {
+	size_t used = 0;
+	for(size_t i = 0; i < mCurrent && i < mBlocks.size(); ++i)
+		used += mBlocks[i].size;
+	return used + mOffset;
+}
+
+size_t Arena::getCapacity() const {
+	size_t capacity = 0;
+	for(auto& block : mBlocks)
+		capacity += block.size;
+	return capacity;
+}
+
+} /* namespace sch */
@@ -0,0 +1,108 @@
+//===-- smart-chess/Arena.h -------------------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file Arena.h
+/// \brief Bump allocator for scratch memory that is thrown away all at once.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef ARENA_H_
+#define ARENA_H_
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace sch {
+
+/**
+ * A bump allocator: allocate() hands out consecutive pieces of a few large
+ * blocks and nothing is ever freed on its own, reset() rewinds the arena
+ * and makes all of its memory available again.
+ *
+ * The blocks are kept across resets, so once an arena has grown to what a
+ * task needs, doing the same task again calls the heap allocator no more.
+ * An arena is not thread safe, every thread is meant to own its own.
+ */
+class Arena {
+public:
+	/// Objects that are written by different threads should not share one.
+	static const size_t CACHE_LINE = 64;
+	static const size_t DEFAULT_BLOCK_SIZE = 256 * 1024;
+
+	explicit Arena(size_t block_size = DEFAULT_BLOCK_SIZE);
+
+	Arena(const Arena&) = delete;
+	Arena& operator = (const Arena&) = delete;
+
+	/**
+	 * Returns @b size bytes aligned to @b alignment, which must be a power
+	 * of two no larger than CACHE_LINE. A new block is only allocated when
+	 * the blocks already owned are full.
+	 */
+	void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+	/**
+	 * Value-initializes @b count objects of type @b T in the arena. They are
+	 * never destroyed, hence @b T must be trivially destructible.
+	 */
+	template<typename T>
+	T* create(size_t count) {
+		static_assert(std::is_trivially_destructible<T>::value, "arena objects are never destroyed");
+		T* objects = static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+		for(size_t i = 0; i < count; ++i)
+			new (objects + i) T();
+		return objects;
+	}
+
+	/// Invalidates everything allocated so far, keeping the blocks.
+	void reset();
+
+	/// Bytes handed out since the last reset(), alignment padding included.
+	size_t getUsed() const;
+	/// Bytes owned by the arena.
+	size_t getCapacity() const;
+	/// Number of times the arena asked the heap for a block.
+	size_t getBlockAllocations() const { return mBlockAllocations; }
+
+private:
+	struct Block {
+		std::unique_ptr<char[]> memory;
+		char* begin; //!< First byte aligned to CACHE_LINE
+		size_t size;
+	};
+
+	std::vector<Block> mBlocks;
+	size_t mBlockSize;
+	size_t mCurrent; //!< Index of the block being filled
+	size_t mOffset;  //!< First free byte in the current block
+	size_t mBlockAllocations;
+};
+
+} /* namespace sch */
+
+#endif /* ARENA_H_ */
@@ -0,0 +1,226 @@
+//===-- smart-chess/Attacks.cpp ---------------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file Attacks.cpp
+/// \brief Set-wise attack generation on bitboards.
+///
+//===----------------------------------------------------------------------===//
+
+#include "Attacks.h"
+#include "BoardState.h"
+#include <algorithm>
+
+namespace sch {
+
+namespace {
+	/*
+	 * Row 0 is the eighth rank, so moving north (towards row 0) shifts right
+	 * by 8 and moving east (towards column H) shifts left by 1. The masks
+	 * drop the bits that wrapped around to the other side of the board.
+	 */
+	const uint64_t FILE_A = 0x0101010101010101ULL;
+	const uint64_t FILE_B = FILE_A << 1;
+	const uint64_t FILE_G = FILE_A << 6;
+	const uint64_t FILE_H = FILE_A << 7;
+	const uint64_t ALL = ~0ULL;
+
+	/// South, east, south-east and south-west: left shifts.
+	const int LEFT_SHIFTS[4] = { 8, 1, 9, 7 };
+	const uint64_t LEFT_MASKS[4] = { ALL, ~FILE_A, ~FILE_A, ~FILE_H };
+	/// North, west, north-west and north-east: right shifts.
+	const int RIGHT_SHIFTS[4] = { 8, 1, 9, 7 };
+	const uint64_t RIGHT_MASKS[4] = { ALL, ~FILE_H, ~FILE_H, ~FILE_A };
+
+	inline uint64_t fillLeft(uint64_t gen, uint64_t empty, int shift, uint64_t mask) {
+		uint64_t pro = empty & mask;
+		gen |= pro & (gen << shift);
+		pro &= pro << shift;
+		gen |= pro & (gen << 2 * shift);
+		pro &= pro << 2 * shift;
+		gen |= pro & (gen << 4 * shift);
+		return (gen << shift) & mask;
+	}
+
+	inline uint64_t fillRight(uint64_t gen, uint64_t empty, int shift, uint64_t mask) {
+		uint64_t pro = empty & mask;
+		gen |= pro & (gen >> shift);
+		pro &= pro >> shift;
+		gen |= pro & (gen >> 2 * shift);
+		pro &= pro >> 2 * shift;
+		gen |= pro & (gen >> 4 * shift);
+		return (gen >> shift) & mask;
+	}
+
+	/// The first direction of each table is straight, the others diagonal.
+	inline uint64_t getSliders(int d, uint64_t straight, uint64_t diagonal) {
+		return d < 2 ? straight : diagonal;
+	}
+
+	typedef uint64_t (*SliderKernel)(uint64_t straight, uint64_t diagonal, uint64_t empty);
+
+	uint64_t slidersScalar(uint64_t straight, uint64_t diagonal, uint64_t empty) {
+		uint64_t attacks = 0;
+		for(int d = 0; d < 4; ++d) {
+			const uint64_t sliders = getSliders(d, straight, diagonal);
+			attacks |= fillLeft(sliders, empty, LEFT_SHIFTS[d], LEFT_MASKS[d]);
+			attacks |= fillRight(sliders, empty, RIGHT_SHIFTS[d], RIGHT_MASKS[d]);
+		}
+		return attacks;
+	}
+
+#ifdef SMARTCHESS_X86_SIMD
+	/// Square n becomes square 63 - n: the board turned by 180 degrees.
+	inline uint64_t reverse(uint64_t x) {
+		x = ((x >> 1) & 0x5555555555555555ULL) | ((x & 0x5555555555555555ULL) << 1);
+		x = ((x >> 2) & 0x3333333333333333ULL) | ((x & 0x3333333333333333ULL) << 2);
+		x = ((x >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((x & 0x0F0F0F0F0F0F0F0FULL) << 4);
+		return __builtin_bswap64(x);
+	}
+
+	/*
+	 * SSE has no per lane shift counts. On the board turned around every
+	 * right shift direction becomes a left shift one with the same count and
+	 * mask, so each register fills a direction in the low lane and its
+	 * opposite, on the turned board, in the high lane.
+	 */
+	__attribute__((target("sse4.1")))
+	uint64_t slidersSSE41(uint64_t straight, uint64_t diagonal, uint64_t empty) {
+		const __m128i straight2 = _mm_set_epi64x(static_cast<int64_t>(reverse(straight)), static_cast<int64_t>(straight));
+		const __m128i diagonal2 = _mm_set_epi64x(static_cast<int64_t>(reverse(diagonal)), static_cast<int64_t>(diagonal));
+		const __m128i empty2 = _mm_set_epi64x(static_cast<int64_t>(reverse(empty)), static_cast<int64_t>(empty));
+
+		__m128i attacks = _mm_setzero_si128();
+#define SMARTCHESS_FILL(shift, mask_value, sliders) { \
+			const __m128i mask = _mm_set1_epi64x(static_cast<int64_t>(mask_value)); \
+			__m128i gen = sliders; \
+			__m128i pro = _mm_and_si128(empty2, mask); \
+			gen = _mm_or_si128(gen, _mm_and_si128(pro, _mm_slli_epi64(gen, shift))); \
+			pro = _mm_and_si128(pro, _mm_slli_epi64(pro, shift)); \
+			gen = _mm_or_si128(gen, _mm_and_si128(pro, _mm_slli_epi64(gen, 2 * shift))); \
+			pro = _mm_and_si128(pro, _mm_slli_epi64(pro, 2 * shift)); \
+			gen = _mm_or_si128(gen, _mm_and_si128(pro, _mm_slli_epi64(gen, 4 * shift))); \
+			attacks = _mm_or_si128(attacks, _mm_and_si128(_mm_slli_epi64(gen, shift), mask)); \
+		}
+		SMARTCHESS_FILL(8, ALL, straight2)          // south and north
+		SMARTCHESS_FILL(1, ~FILE_A, straight2)      // east and west
+		SMARTCHESS_FILL(9, ~FILE_A, diagonal2)      // south-east and north-west
+		SMARTCHESS_FILL(7, ~FILE_H, diagonal2)      // south-west and north-east
+#undef SMARTCHESS_FILL
+
+		uint64_t lanes[2];
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), attacks);
+		return lanes[0] | reverse(lanes[1]);
+	}
+
+	__attribute__((target("avx2")))
+	uint64_t slidersAVX2(uint64_t straight, uint64_t diagonal, uint64_t empty) {
+		const __m256i sliders = _mm256_set_epi64x(static_cast<int64_t>(diagonal), static_cast<int64_t>(diagonal),
+				static_cast<int64_t>(straight), static_cast<int64_t>(straight));
+		const __m256i empty4 = _mm256_set1_epi64x(static_cast<int64_t>(empty));
+		const __m256i shift = _mm256_set_epi64x(7, 9, 1, 8);
+		const __m256i shift2 = _mm256_add_epi64(shift, shift);
+		const __m256i shift4 = _mm256_add_epi64(shift2, shift2);
+
+		const __m256i left_mask = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(LEFT_MASKS));
+		__m256i gen = sliders;
+		__m256i pro = _mm256_and_si256(empty4, left_mask);
+		gen = _mm256_or_si256(gen, _mm256_and_si256(pro, _mm256_sllv_epi64(gen, shift)));
+		pro = _mm256_and_si256(pro, _mm256_sllv_epi64(pro, shift));
+		gen = _mm256_or_si256(gen, _mm256_and_si256(pro, _mm256_sllv_epi64(gen, shift2)));
+		pro = _mm256_and_si256(pro, _mm256_sllv_epi64(pro, shift2));
+		gen = _mm256_or_si256(gen, _mm256_and_si256(pro, _mm256_sllv_epi64(gen, shift4)));
+		__m256i attacks = _mm256_and_si256(_mm256_sllv_epi64(gen, shift), left_mask);
+
+		const __m256i right_mask = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(RIGHT_MASKS));
+		gen = sliders;
+		pro = _mm256_and_si256(empty4, right_mask);
+		gen = _mm256_or_si256(gen, _mm256_and_si256(pro, _mm256_srlv_epi64(gen, shift)));
+		pro = _mm256_and_si256(pro, _mm256_srlv_epi64(pro, shift));
+		gen = _mm256_or_si256(gen, _mm256_and_si256(pro, _mm256_srlv_epi64(gen, shift2)));
+		pro = _mm256_and_si256(pro, _mm256_srlv_epi64(pro, shift2));
+		gen = _mm256_or_si256(gen, _mm256_and_si256(pro, _mm256_srlv_epi64(gen, shift4)));
+		attacks = _mm256_or_si256(attacks, _mm256_and_si256(_mm256_srlv_epi64(gen, shift), right_mask));
+
+		// OR the four lanes together
+		uint64_t lanes[2];
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(lanes),
+				_mm_or_si128(_mm256_castsi256_si128(attacks), _mm256_extracti128_si256(attacks, 1)));
+		return lanes[0] | lanes[1];
+	}
+#endif
+
+	/// Indexed by Simd.
+	const SliderKernel SLIDER_KERNELS[] = {
+		slidersScalar,
+#ifdef SMARTCHESS_X86_SIMD
+		slidersSSE41,
+		slidersAVX2,
+#endif
+	};
+}
+
+void AttackGenerator::setSimd(Simd simd) {
+	mSimd = std::min(simd, getBestSimd());
+}
+
+uint64_t AttackGenerator::getSliderAttacks(uint64_t straight, uint64_t diagonal, uint64_t occupied) const {
+	const size_t i = static_cast<size_t>(mSimd);
+	const size_t count = sizeof(SLIDER_KERNELS) / sizeof(SLIDER_KERNELS[0]);
+	return SLIDER_KERNELS[i < count ? i : 0](straight, diagonal, ~occupied);
+}
+
+uint64_t AttackGenerator::getPawnAttacks(uint64_t pawns, bool white) {
+	// White pawns move towards row 0
+	if(white)
+		return ((pawns >> 9) & ~FILE_H) | ((pawns >> 7) & ~FILE_A);
+	return ((pawns << 7) & ~FILE_H) | ((pawns << 9) & ~FILE_A);
+}
+
+uint64_t AttackGenerator::getKnightAttacks(uint64_t knights) {
+	return ((knights >> 17) & ~FILE_H) | ((knights >> 15) & ~FILE_A)
+			| ((knights >> 10) & ~(FILE_G | FILE_H)) | ((knights >> 6) & ~(FILE_A | FILE_B))
+			| ((knights << 6) & ~(FILE_G | FILE_H)) | ((knights << 10) & ~(FILE_A | FILE_B))
+			| ((knights << 15) & ~FILE_H) | ((knights << 17) & ~FILE_A);
+}
+
+uint64_t AttackGenerator::getKingAttacks(uint64_t kings) {
+	const uint64_t row = kings | ((kings << 1) & ~FILE_A) | ((kings >> 1) & ~FILE_H);
+	return (row | (row << 8) | (row >> 8)) & ~kings;
+}
+
+uint64_t AttackGenerator::getAttacks(const BoardState& state, ChessPlayer::Color c) const {
+	const bool white = c == ChessPlayer::Color::WHITE;
+	auto pieces = [&](PieceType generic) {
+		return state.getPieceBitboard(makePieceType(getPieceKind(generic), white));
+	};
+	const uint64_t queens = pieces(PieceType::WHITE_QUEEN);
+	return getPawnAttacks(pieces(PieceType::WHITE_PAWN), white)
+			| getKnightAttacks(pieces(PieceType::WHITE_KNIGHT))
+			| getKingAttacks(pieces(PieceType::WHITE_KING))
+			| getSliderAttacks(pieces(PieceType::WHITE_ROOK) | queens,
+					pieces(PieceType::WHITE_BISHOP) | queens, state.getOccupied());
+}
+
+} /* namespace sch */
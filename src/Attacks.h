@@ -0,0 +1,81 @@
+//===-- smart-chess/Attacks.h -----------------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file Attacks.h
+/// \brief Set-wise attack generation on bitboards.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef ATTACKS_H_
+#define ATTACKS_H_
+
+#include <cstdint>
+#include "ChessPlayer.h"
+#include "Simd.h"
+
+namespace sch {
+
+class BoardState;
+
+/**
+ * Computes the squares attacked by all the pieces of a color at once, the
+ * input of whole-board evaluation terms such as mobility, space or king
+ * safety. Bitboards have bit n set for square n (see toSquareIndex).
+ *
+ * Sliders use Kogge-Stone occluded fills: every ray of every slider grows
+ * in three shift-and-mask steps, whatever the number of sliders. The eight
+ * directions are independent, so the vector kernels fill them side by side:
+ * four per register with AVX2, two with SSE4.1 and one by one otherwise
+ * (see Simd).
+ */
+class AttackGenerator {
+public:
+	AttackGenerator() : mSimd(getBestSimd()) {}
+
+	/// Uses @b simd, or the best supported one below it.
+	void setSimd(Simd simd);
+	Simd getSimd() const { return mSimd; }
+
+	/**
+	 * The squares attacked by the @b straight sliders (rooks and queens) and
+	 * the @b diagonal ones (bishops and queens). Rays stop at the first
+	 * square in @b occupied, which is attacked too.
+	 */
+	uint64_t getSliderAttacks(uint64_t straight, uint64_t diagonal, uint64_t occupied) const;
+
+	/// Every square attacked by the pieces of color @b c in @b state.
+	uint64_t getAttacks(const BoardState& state, ChessPlayer::Color c) const;
+
+	static uint64_t getPawnAttacks(uint64_t pawns, bool white);
+	static uint64_t getKnightAttacks(uint64_t knights);
+	static uint64_t getKingAttacks(uint64_t kings);
+
+private:
+	Simd mSimd;
+};
+
+} /* namespace sch */
+
+#endif /* ATTACKS_H_ */
@@ -0,0 +1,215 @@
+//===-- smart-chess/BatchEvaluation.cpp -------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file BatchEvaluation.cpp
+/// \brief Evaluation of many unrelated positions in one call.
+///
+//===----------------------------------------------------------------------===//
+
+#include "BatchEvaluation.h"
+#include "EvalWeights.h"
+#include "Evaluation.h"
+#include <algorithm>
+
+using namespace std;
+
+namespace sch {
+
+namespace {
+	const int PIECE_TYPES = static_cast<int>(PieceType::UNDEFINED);
+	const int LANES = BatchEvaluator::LANES;
+
+	/// The row of the score table that is all zeros, for missing pieces.
+	const uint16_t EMPTY_INDEX = PIECE_TYPES * SQUARE_COUNT;
+
+	/**
+	 * The midgame value goes in the high 16 bits and the endgame value is
+	 * added to the low ones, so a single addition sums both. It works as long
+	 * as the sums fit an int16_t, which any chess position does by far.
+	 */
+	inline int32_t pack(const TaperedScore& s) {
+		return static_cast<int32_t>((static_cast<uint32_t>(s.midgame) << 16) + static_cast<uint32_t>(s.endgame));
+	}
+
+	inline int blend(int32_t packed, int phase) {
+		const int endgame = static_cast<int16_t>(packed & 0xFFFF);
+		const int midgame = static_cast<int32_t>(static_cast<uint32_t>(packed) - static_cast<uint32_t>(endgame)) >> 16;
+		phase = min(phase, MAX_PHASE);
+		return (midgame * phase + endgame * (MAX_PHASE - phase)) / MAX_PHASE;
+	}
+
+	/// The arguments every kernel scores a block with.
+	struct Block {
+		const uint16_t (*indices)[LANES];
+		const int32_t* signs;
+		const int32_t* scores;
+		const int32_t* phases;
+		int pieces;   //!< Rows of @b indices in use
+	};
+
+	/// Scores all LANES positions of @b block to @b out.
+	typedef void (*Kernel)(const Block& block, int* out);
+
+	void scoreScalar(const Block& b, int* out) {
+		int32_t sums[LANES] = {};
+		int32_t phases[LANES] = {};
+		for(int n = 0; n < b.pieces; ++n) {
+			for(int lane = 0; lane < LANES; ++lane) {
+				const int index = b.indices[n][lane];
+				sums[lane] += b.scores[index];
+				phases[lane] += b.phases[index / SQUARE_COUNT];
+			}
+		}
+		for(int lane = 0; lane < LANES; ++lane)
+			out[lane] = b.signs[lane] * blend(sums[lane], phases[lane]);
+	}
+
+#ifdef SMARTCHESS_X86_SIMD
+	/*
+	 * The blend divides by MAX_PHASE in single precision: the dividends are
+	 * integers below 2^24, so the division truncated to an integer gives the
+	 * same result as the integer one.
+	 */
+
+	__attribute__((target("sse4.1")))
+	void scoreSSE41(const Block& b, int* out) {
+		const __m128 max_phase = _mm_set1_ps(static_cast<float>(MAX_PHASE));
+		for(int lane = 0; lane < LANES; lane += 4) {
+			__m128i sum = _mm_setzero_si128();
+			__m128i phase = _mm_setzero_si128();
+			for(int n = 0; n < b.pieces; ++n) {
+				// No gathers before AVX2
+				const uint16_t* i = b.indices[n] + lane;
+				sum = _mm_add_epi32(sum, _mm_setr_epi32(b.scores[i[0]], b.scores[i[1]],
+						b.scores[i[2]], b.scores[i[3]]));
+				phase = _mm_add_epi32(phase, _mm_setr_epi32(b.phases[i[0] / SQUARE_COUNT],
+						b.phases[i[1] / SQUARE_COUNT], b.phases[i[2] / SQUARE_COUNT], b.phases[i[3] / SQUARE_COUNT]));
+			}
+			const __m128i endgame = _mm_srai_epi32(_mm_slli_epi32(sum, 16), 16);
+			const __m128i midgame = _mm_srai_epi32(_mm_sub_epi32(sum, endgame), 16);
+			phase = _mm_min_epi32(phase, _mm_set1_epi32(MAX_PHASE));
+			const __m128i blended = _mm_add_epi32(_mm_mullo_epi32(midgame, phase),
+					_mm_mullo_epi32(endgame, _mm_sub_epi32(_mm_set1_epi32(MAX_PHASE), phase)));
+			const __m128i score = _mm_cvttps_epi32(_mm_div_ps(_mm_cvtepi32_ps(blended), max_phase));
+			const __m128i sign = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b.signs + lane));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + lane), _mm_sign_epi32(score, sign));
+		}
+	}
+
+	__attribute__((target("avx2")))
+	void scoreAVX2(const Block& b, int* out) {
+		const __m256 max_phase = _mm256_set1_ps(static_cast<float>(MAX_PHASE));
+		for(int lane = 0; lane < LANES; lane += 8) {
+			__m256i sum = _mm256_setzero_si256();
+			__m256i phase = _mm256_setzero_si256();
+			for(int n = 0; n < b.pieces; ++n) {
+				const __m256i index = _mm256_cvtepu16_epi32(
+						_mm_loadu_si128(reinterpret_cast<const __m128i*>(b.indices[n] + lane)));
+				sum = _mm256_add_epi32(sum, _mm256_i32gather_epi32(b.scores, index, 4));
+				phase = _mm256_add_epi32(phase, _mm256_i32gather_epi32(b.phases, _mm256_srli_epi32(index, 6), 4));
+			}
+			const __m256i endgame = _mm256_srai_epi32(_mm256_slli_epi32(sum, 16), 16);
+			const __m256i midgame = _mm256_srai_epi32(_mm256_sub_epi32(sum, endgame), 16);
+			phase = _mm256_min_epi32(phase, _mm256_set1_epi32(MAX_PHASE));
+			const __m256i blended = _mm256_add_epi32(_mm256_mullo_epi32(midgame, phase),
+					_mm256_mullo_epi32(endgame, _mm256_sub_epi32(_mm256_set1_epi32(MAX_PHASE), phase)));
+			const __m256i score = _mm256_cvttps_epi32(_mm256_div_ps(_mm256_cvtepi32_ps(blended), max_phase));
+			const __m256i sign = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b.signs + lane));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + lane), _mm256_sign_epi32(score, sign));
+		}
+	}
+#endif
+
+	/// Indexed by Simd.
+	const Kernel KERNELS[] = {
+		scoreScalar,
+#ifdef SMARTCHESS_X86_SIMD
+		scoreSSE41,
+		scoreAVX2,
+#endif
+	};
+
+	inline Kernel getKernel(Simd simd) {
+		const size_t i = static_cast<size_t>(simd);
+		return KERNELS[i < sizeof(KERNELS) / sizeof(KERNELS[0]) ? i : 0];
+	}
+}
+
+BatchEvaluator::BatchEvaluator() : mSimd(getBestSimd()) {
+	static_assert(SQUARE_COUNT == 64, "the kernels divide table indices by 64 with a shift");
+	const PieceSquareTable& table = PieceSquareTable::instance();
+	for(int t = 0; t <= PIECE_TYPES; ++t) {
+		const PieceType type = static_cast<PieceType>(t);
+		for(int sq = 0; sq < SQUARE_COUNT; ++sq)
+			mScores[t * SQUARE_COUNT + sq] = t < PIECE_TYPES ? pack(table.getScore(type, sq)) : 0;
+		mPhases[t] = t < PIECE_TYPES ? table.getPhase(type) : 0;
+	}
+}
+
+void BatchEvaluator::setSimd(Simd simd) {
+	mSimd = min(simd, getBestSimd());
+}
+
+int BatchEvaluator::transpose(const PackedPosition* positions, int count) {
+	int most = 0;
+	for(int lane = 0; lane < LANES; ++lane) {
+		int n = 0;
+		if(lane < count) {
+			const PackedPosition& p = positions[lane];
+			uint64_t occupancy = p.occupancy;
+			for(; occupancy && n < MAX_PIECES; occupancy &= occupancy - 1, ++n) {
+				const int type = static_cast<int>(p.getPieceType(n));
+				// Damaged records score garbage but stay inside the table
+				mIndices[n][lane] = type < PIECE_TYPES
+						? static_cast<uint16_t>(type * SQUARE_COUNT + __builtin_ctzll(occupancy)) : EMPTY_INDEX;
+			}
+			mSigns[lane] = p.isBlackToMove() ? -1 : 1;
+		} else {
+			mSigns[lane] = 1;
+		}
+		most = max(most, n);
+		for(; n < MAX_PIECES; ++n)
+			mIndices[n][lane] = EMPTY_INDEX;
+	}
+	return most;
+}
+
+void BatchEvaluator::evaluate(const PackedPosition* positions, size_t count, int* scores) {
+	const Kernel kernel = getKernel(mSimd);
+	int out[LANES];
+	for(size_t first = 0; first < count; first += LANES) {
+		const int lanes = static_cast<int>(min<size_t>(LANES, count - first));
+		Block block;
+		block.pieces = transpose(positions + first, lanes);
+		block.indices = mIndices;
+		block.signs = mSigns;
+		block.scores = mScores;
+		block.phases = mPhases;
+		kernel(block, out);
+		copy(out, out + lanes, scores + first);
+	}
+}
+
+} /* namespace sch */
@@ -0,0 +1,91 @@
+//===-- smart-chess/BatchEvaluation.h ---------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file BatchEvaluation.h
+/// \brief Evaluation of many unrelated positions in one call.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef BATCHEVALUATION_H_
+#define BATCHEVALUATION_H_
+
+#include <cstddef>
+#include <cstdint>
+#include "PackedPosition.h"
+#include "Simd.h"
+
+namespace sch {
+
+/**
+ * Scores whole batches of unrelated positions, e.g. the records of a
+ * training set, without setting up a BoardState for each of them.
+ *
+ * The positions are transposed LANES at a time into a structure of arrays:
+ * one row per piece slot holding the table index of that piece in every
+ * position. The kernels then walk the rows and score LANES positions side by
+ * side, with AVX2 gathers or SSE4.1 when the CPU has them (see Simd).
+ *
+ * The scores are exactly those of evaluate(). An evaluator keeps the
+ * transposed block between calls, use one per thread.
+ */
+class BatchEvaluator {
+public:
+	/// Positions scored side by side.
+	static const int LANES = 64;
+	/// The most pieces a PackedPosition holds.
+	static const int MAX_PIECES = 32;
+	/// One per PieceType plus an empty one.
+	static const int TABLE_ROWS = static_cast<int>(PieceType::UNDEFINED) + 1;
+
+	BatchEvaluator();
+
+	/// Uses @b simd, or the best supported one below it.
+	void setSimd(Simd simd);
+	Simd getSimd() const { return mSimd; }
+
+	/**
+	 * Writes to @b scores the score evaluate() gives to each of the @b count
+	 * @b positions, from the point of view of their side to move.
+	 */
+	void evaluate(const PackedPosition* positions, size_t count, int* scores);
+
+private:
+	Simd mSimd;
+	/// Midgame and endgame values of every (PieceType, square), packed in one int32_t (see pack()).
+	int32_t mScores[TABLE_ROWS * SQUARE_COUNT];
+	/// The game phase weight of every PieceType.
+	int32_t mPhases[TABLE_ROWS];
+	/// mScores index of the n-th piece of every position, an empty row when it has fewer pieces.
+	uint16_t mIndices[MAX_PIECES][LANES];
+	/// 1 with white to move, -1 with black.
+	int32_t mSigns[LANES];
+
+	/// Fills the block with @b count <= LANES positions, returns the most pieces among them.
+	int transpose(const PackedPosition* positions, int count);
+};
+
+} /* namespace sch */
+
+#endif /* BATCHEVALUATION_H_ */
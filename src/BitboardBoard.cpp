@@ -0,0 +1,368 @@
+//===-- smart-chess/BitboardBoard.cpp ---------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file BitboardBoard.cpp
+/// \brief Board backend on one bitboard per piece type.
+///
+//===----------------------------------------------------------------------===//
+
+#include "BitboardBoard.h"
+#include "Attacks.h"
+#include "Zobrist.h"
+#include <cstdlib>
+
+using namespace std;
+
+namespace sch {
+
+namespace {
+	/// Row and column steps of the straight directions first, then the diagonal ones.
+	const int DIRECTIONS[8][2] = {
+		{ -1, 0 }, { 1, 0 }, { 0, 1 }, { 0, -1 },
+		{ -1, 1 }, { -1, -1 }, { 1, 1 }, { 1, -1 }
+	};
+
+	inline uint64_t bit(int square) { return uint64_t(1) << square; }
+
+	struct AttackTables {
+		uint64_t knight[SQUARE_COUNT];
+		uint64_t king[SQUARE_COUNT];
+		uint64_t pawn[2][SQUARE_COUNT]; //!< Attacked by a white, black pawn on the square
+		uint64_t rays[8][SQUARE_COUNT]; //!< Empty board rays, square excluded
+
+		AttackTables() {
+			for(int sq = 0; sq < SQUARE_COUNT; ++sq) {
+				knight[sq] = AttackGenerator::getKnightAttacks(bit(sq));
+				king[sq] = AttackGenerator::getKingAttacks(bit(sq));
+				pawn[0][sq] = AttackGenerator::getPawnAttacks(bit(sq), true);
+				pawn[1][sq] = AttackGenerator::getPawnAttacks(bit(sq), false);
+				for(int d = 0; d < 8; ++d) {
+					rays[d][sq] = 0;
+					int row = sq / MAX_COL + DIRECTIONS[d][0];
+					int col = sq % MAX_COL + DIRECTIONS[d][1];
+					for(; row >= 0 && row < MAX_ROW && col >= 0 && col < MAX_COL;
+							row += DIRECTIONS[d][0], col += DIRECTIONS[d][1])
+						rays[d][sq] |= bit(row * MAX_COL + col);
+				}
+			}
+		}
+	};
+
+	const AttackTables& getTables() {
+		static const AttackTables tables;
+		return tables;
+	}
+
+	/// The ray of direction @b d from @b square, up to and including its first blocker.
+	inline uint64_t getRay(const AttackTables& t, int d, int square, uint64_t occupied) {
+		uint64_t ray = t.rays[d][square];
+		const uint64_t blockers = ray & occupied;
+		if(blockers) {
+			// Directions that move down the board reach the lowest square index first
+			const bool increasing = DIRECTIONS[d][0] > 0 || (DIRECTIONS[d][0] == 0 && DIRECTIONS[d][1] > 0);
+			const int first = increasing ? __builtin_ctzll(blockers) : 63 - __builtin_clzll(blockers);
+			ray ^= t.rays[d][first];
+		}
+		return ray;
+	}
+
+	inline uint64_t getRookAttacks(const AttackTables& t, int square, uint64_t occupied) {
+		return getRay(t, 0, square, occupied) | getRay(t, 1, square, occupied)
+				| getRay(t, 2, square, occupied) | getRay(t, 3, square, occupied);
+	}
+
+	inline uint64_t getBishopAttacks(const AttackTables& t, int square, uint64_t occupied) {
+		return getRay(t, 4, square, occupied) | getRay(t, 5, square, occupied)
+				| getRay(t, 6, square, occupied) | getRay(t, 7, square, occupied);
+	}
+
+	/// The castling rights left after a move from or to @b square.
+	inline int castlingMask(int square) {
+		switch(square) {
+		case 0: return ~BoardState::BLACK_QUEEN_SIDE;
+		case 4: return ~(BoardState::BLACK_KING_SIDE | BoardState::BLACK_QUEEN_SIDE);
+		case 7: return ~BoardState::BLACK_KING_SIDE;
+		case 56: return ~BoardState::WHITE_QUEEN_SIDE;
+		case 60: return ~(BoardState::WHITE_KING_SIDE | BoardState::WHITE_QUEEN_SIDE);
+		case 63: return ~BoardState::WHITE_KING_SIDE;
+		}
+		return BoardState::ALL_CASTLING_RIGHTS;
+	}
+
+	inline uint16_t makeCode(int from, int to, int promotion_kind = 0) {
+		return static_cast<uint16_t>(from | (to << 6) | (promotion_kind << 12));
+	}
+}
+
+BitboardBoard::BitboardBoard()
+: mWhiteToMove(true), mCastlingRights(0), mEnPassant(-1), mHashKey(0), mHalfmoveClock(0),
+  mScore(), mPhase(0) {
+	for(int i = 0; i < PIECE_TYPES; ++i)
+		mPieces[i] = 0;
+	mColors[0] = mColors[1] = 0;
+	for(int sq = 0; sq < SQUARE_COUNT; ++sq)
+		mBoard[sq] = PieceType::UNDEFINED;
+}
+
+void BitboardBoard::load(const BoardState& state) {
+	for(int i = 0; i < PIECE_TYPES; ++i)
+		mPieces[i] = 0;
+	mColors[0] = mColors[1] = 0;
+	mScore = TaperedScore();
+	mPhase = 0;
+	for(int sq = 0; sq < SQUARE_COUNT; ++sq) {
+		mBoard[sq] = PieceType::UNDEFINED;
+		if(state.getPieceTypeAt(sq) != PieceType::UNDEFINED)
+			putPiece(sq, state.getPieceTypeAt(sq));
+	}
+	mWhiteToMove = state.getCurrentPlayer() == ChessPlayer::Color::WHITE;
+	mCastlingRights = state.getCastlingRights();
+	mEnPassant = state.getEnPassantSquare().isValid() ? toSquareIndex(state.getEnPassantSquare()) : -1;
+	mHalfmoveClock = state.getHalfmoveClock();
+	mHashKey = state.getHashKey();
+}
+
+void BitboardBoard::putPiece(int square, PieceType type) {
+	const PieceSquareTable& pst = PieceSquareTable::instance();
+	mBoard[square] = type;
+	mHashKey ^= Zobrist::instance().getPieceKey(type, square);
+	mPieces[static_cast<int>(type)] |= bit(square);
+	mColors[isWhitePieceType(type) ? 0 : 1] |= bit(square);
+	mScore += pst.getScore(type, square);
+	mPhase += pst.getPhase(type);
+}
+
+PieceType BitboardBoard::takePiece(int square) {
+	const PieceSquareTable& pst = PieceSquareTable::instance();
+	const PieceType type = mBoard[square];
+	mBoard[square] = PieceType::UNDEFINED;
+	mHashKey ^= Zobrist::instance().getPieceKey(type, square);
+	mPieces[static_cast<int>(type)] &= ~bit(square);
+	mColors[isWhitePieceType(type) ? 0 : 1] &= ~bit(square);
+	mScore -= pst.getScore(type, square);
+	mPhase -= pst.getPhase(type);
+	return type;
+}
+
+int BitboardBoard::getKingSquare(bool white) const {
+	return __builtin_ctzll(mPieces[static_cast<int>(makePieceType(KING_KIND, white))]);
+}
+
+bool BitboardBoard::isAttacked(int square, bool white, uint64_t occupied, uint64_t removed) const {
+	const AttackTables& t = getTables();
+	auto pieces = [&](int kind) { return mPieces[static_cast<int>(makePieceType(kind, white))] & ~removed; };
+	// A pawn of @b white attacks the square from where a pawn of the other color would attack
+	if(t.pawn[white ? 1 : 0][square] & pieces(PAWN_KIND))
+		return true;
+	if((t.knight[square] & pieces(KNIGHT_KIND)) || (t.king[square] & pieces(KING_KIND)))
+		return true;
+	const uint64_t queens = pieces(QUEEN_KIND);
+	return (getBishopAttacks(t, square, occupied) & (pieces(BISHOP_KIND) | queens))
+			|| (getRookAttacks(t, square, occupied) & (pieces(ROOK_KIND) | queens));
+}
+
+size_t BitboardBoard::getLegalMoves(uint16_t* out) const {
+	const AttackTables& t = getTables();
+	const bool white = mWhiteToMove;
+	const uint64_t own = mColors[white ? 0 : 1];
+	const uint64_t enemy = mColors[white ? 1 : 0];
+	const uint64_t occupied = own | enemy;
+	const int king = getKingSquare(white);
+	const bool in_check = isAttacked(king, !white, occupied, 0);
+	// The pinned pieces: the only own piece between the king and an enemy slider
+	uint64_t exposed = ~uint64_t(0);
+	if(!in_check) {
+		exposed = 0;
+		const uint64_t queens = mPieces[static_cast<int>(makePieceType(QUEEN_KIND, !white))];
+		for(int d = 0; d < 8; ++d) {
+			const uint64_t sliders = queens
+					| mPieces[static_cast<int>(makePieceType(d < 4 ? ROOK_KIND : BISHOP_KIND, !white))];
+			if(!(t.rays[d][king] & sliders))
+				continue;
+			const uint64_t blocker = getRay(t, d, king, occupied) & own;
+			if(blocker && (getRay(t, d, king, occupied ^ blocker) & sliders))
+				exposed |= blocker;
+		}
+	}
+	const uint64_t ep = mEnPassant >= 0 ? bit(mEnPassant) : 0;
+	size_t count = 0;
+
+	auto add = [&](int from, int to, int promotion_kind) {
+		if(from == king) {
+			if(isAttacked(to, !white, occupied ^ bit(from), bit(to)))
+				return;
+		} else if((exposed & bit(from)) || bit(to) == ep) {
+			uint64_t removed = bit(to);
+			if(bit(to) == ep && getPieceKind(mBoard[from]) == PAWN_KIND)
+				removed = bit(from / MAX_COL * MAX_COL + to % MAX_COL);
+			const uint64_t after = ((occupied ^ bit(from)) | bit(to)) & ~(removed & ~bit(to));
+			if(isAttacked(king, !white, after, removed))
+				return;
+		}
+		out[count++] = makeCode(from, to, promotion_kind);
+	};
+	auto addAll = [&](int from, uint64_t targets) {
+		for(; targets; targets &= targets - 1)
+			add(from, __builtin_ctzll(targets), 0);
+	};
+
+	for(uint64_t pawns = mPieces[static_cast<int>(makePieceType(PAWN_KIND, white))]; pawns; pawns &= pawns - 1) {
+		const int from = __builtin_ctzll(pawns);
+		const int forward = white ? -MAX_COL : MAX_COL;
+		const int last_row = white ? 0 : MAX_ROW - 1;
+		const int start_row = white ? MAX_ROW - 2 : 1;
+		uint64_t targets = t.pawn[white ? 0 : 1][from] & (enemy | ep);
+		if(!(occupied & bit(from + forward))) {
+			targets |= bit(from + forward);
+			if(from / MAX_COL == start_row && !(occupied & bit(from + 2 * forward)))
+				targets |= bit(from + 2 * forward);
+		}
+		for(; targets; targets &= targets - 1) {
+			const int to = __builtin_ctzll(targets);
+			if(to / MAX_COL == last_row) {
+				for(int kind = QUEEN_KIND; kind <= KNIGHT_KIND; ++kind)
+					add(from, to, kind);
+			} else {
+				add(from, to, 0);
+			}
+		}
+	}
+
+	for(uint64_t knights = mPieces[static_cast<int>(makePieceType(KNIGHT_KIND, white))]; knights; knights &= knights - 1) {
+		const int from = __builtin_ctzll(knights);
+		addAll(from, t.knight[from] & ~own);
+	}
+
+	const uint64_t queens = mPieces[static_cast<int>(makePieceType(QUEEN_KIND, white))];
+	for(uint64_t sliders = mPieces[static_cast<int>(makePieceType(BISHOP_KIND, white))] | queens;
+			sliders; sliders &= sliders - 1) {
+		const int from = __builtin_ctzll(sliders);
+		addAll(from, getBishopAttacks(t, from, occupied) & ~own);
+	}
+	for(uint64_t sliders = mPieces[static_cast<int>(makePieceType(ROOK_KIND, white))] | queens;
+			sliders; sliders &= sliders - 1) {
+		const int from = __builtin_ctzll(sliders);
+		addAll(from, getRookAttacks(t, from, occupied) & ~own);
+	}
+
+	addAll(king, t.king[king] & ~own);
+
+	// Castling, the squares the king crosses must be empty and safe
+	const int king_side = white ? BoardState::WHITE_KING_SIDE : BoardState::BLACK_KING_SIDE;
+	const int queen_side = white ? BoardState::WHITE_QUEEN_SIDE : BoardState::BLACK_QUEEN_SIDE;
+	if((mCastlingRights & (king_side | queen_side)) && !in_check) {
+		if((mCastlingRights & king_side) && !(occupied & (bit(king + 1) | bit(king + 2)))
+				&& !isAttacked(king + 1, !white, occupied, 0) && !isAttacked(king + 2, !white, occupied, 0))
+			out[count++] = makeCode(king, king + 2);
+		if((mCastlingRights & queen_side) && !(occupied & (bit(king - 1) | bit(king - 2) | bit(king - 3)))
+				&& !isAttacked(king - 1, !white, occupied, 0) && !isAttacked(king - 2, !white, occupied, 0))
+			out[count++] = makeCode(king, king - 2);
+	}
+	return count;
+}
+
+void BitboardBoard::makeMove(uint16_t code, Undo& undo) {
+	const int from = code & 63;
+	const int to = (code >> 6) & 63;
+	const int promotion = code >> 12;
+	const bool white = mWhiteToMove;
+	const int kind = getPieceKind(mBoard[from]);
+
+	undo.castlingRights = mCastlingRights;
+	undo.enPassant = mEnPassant;
+	undo.halfmoveClock = mHalfmoveClock;
+	undo.hashKey = mHashKey;
+
+	const int captured_at = kind == PAWN_KIND && to == mEnPassant ? from / MAX_COL * MAX_COL + to % MAX_COL : to;
+	undo.captured = mBoard[captured_at] != PieceType::UNDEFINED ? takePiece(captured_at) : PieceType::UNDEFINED;
+
+	const PieceType type = takePiece(from);
+	putPiece(to, promotion ? makePieceType(promotion, white) : type);
+
+	if(kind == KING_KIND && abs(to - from) == 2) {
+		const bool king_side = to > from;
+		putPiece(king_side ? to - 1 : to + 1, takePiece(king_side ? to + 1 : to - 2));
+	}
+
+	const Zobrist& z = Zobrist::instance();
+	mHashKey ^= z.getCastlingKey(mCastlingRights);
+	mCastlingRights &= castlingMask(from) & castlingMask(to);
+	mHashKey ^= z.getCastlingKey(mCastlingRights);
+
+	// As BoardState: only kept when a pawn of the other side can capture
+	if(mEnPassant >= 0)
+		mHashKey ^= z.getEnPassantKey(static_cast<Column>(mEnPassant % MAX_COL));
+	mEnPassant = -1;
+	if(kind == PAWN_KIND && abs(to - from) == 2 * MAX_COL) {
+		const int ep = (from + to) / 2;
+		if(getTables().pawn[white ? 0 : 1][ep] & mPieces[static_cast<int>(makePieceType(PAWN_KIND, !white))]) {
+			mEnPassant = ep;
+			mHashKey ^= z.getEnPassantKey(static_cast<Column>(ep % MAX_COL));
+		}
+	}
+
+	mHalfmoveClock = kind == PAWN_KIND || undo.captured != PieceType::UNDEFINED ? 0 : mHalfmoveClock + 1;
+	mWhiteToMove = !white;
+	mHashKey ^= z.getSideKey();
+}
+
+void BitboardBoard::unmakeMove(uint16_t code, const Undo& undo) {
+	const int from = code & 63;
+	const int to = (code >> 6) & 63;
+	const int promotion = code >> 12;
+	mWhiteToMove = !mWhiteToMove;
+	const bool white = mWhiteToMove;
+
+	const PieceType moved = takePiece(to);
+	const int kind = promotion ? PAWN_KIND : getPieceKind(moved);
+	putPiece(from, promotion ? makePieceType(PAWN_KIND, white) : moved);
+
+	if(kind == KING_KIND && abs(to - from) == 2) {
+		const bool king_side = to > from;
+		putPiece(king_side ? to + 1 : to - 2, takePiece(king_side ? to - 1 : to + 1));
+	}
+
+	if(undo.captured != PieceType::UNDEFINED) {
+		const int captured_at = kind == PAWN_KIND && to == undo.enPassant
+				? from / MAX_COL * MAX_COL + to % MAX_COL : to;
+		putPiece(captured_at, undo.captured);
+	}
+
+	mCastlingRights = undo.castlingRights;
+	mEnPassant = undo.enPassant;
+	mHalfmoveClock = undo.halfmoveClock;
+	mHashKey = undo.hashKey;
+}
+
+bool BitboardBoard::isInCheck() const {
+	return isAttacked(getKingSquare(mWhiteToMove), !mWhiteToMove, getOccupied(), 0);
+}
+
+int BitboardBoard::evaluate() const {
+	const int score = blendScore(mScore, mPhase);
+	return mWhiteToMove ? score : -score;
+}
+
+} /* namespace sch */
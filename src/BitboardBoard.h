@@ -0,0 +1,115 @@
+//===-- smart-chess/BitboardBoard.h -----------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file BitboardBoard.h
+/// \brief Board backend on one bitboard per piece type.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef BITBOARDBOARD_H_
+#define BITBOARDBOARD_H_
+
+#include <cstddef>
+#include <cstdint>
+#include "BoardState.h"
+#include "Evaluation.h"
+
+namespace sch {
+
+/**
+ * One 64 bit set per piece type and per color, bit n for square n, plus a
+ * mailbox to tell what stands on a square. Attacks come from precomputed
+ * tables, sliders use the classical ray approach: the ray of a direction is
+ * cut at its first blocker, found with a bit scan.
+ *
+ * Moves are legal when generated: a move is tested against the attacks on
+ * the king only when the king is in check, the piece moved is the king, it
+ * captures en passant or it is pinned.
+ *
+ * A backend for the templated algorithms, see BoardTraits.
+ */
+class BitboardBoard {
+public:
+	struct Undo {
+		PieceType captured;
+		int castlingRights;
+		int enPassant;
+		int halfmoveClock;
+		uint64_t hashKey;
+	};
+
+	static const char* getName() { return "bitboard"; }
+
+	BitboardBoard();
+
+	/// Copies the position of @b state, its history is not needed.
+	void load(const BoardState& state);
+
+	/// Writes the legal moves as BoardState::encodeMove() codes, @b out needs room for MAX_MOVES.
+	size_t getLegalMoves(uint16_t* out) const;
+
+	void makeMove(uint16_t code, Undo& undo);
+	void unmakeMove(uint16_t code, const Undo& undo);
+
+	bool isInCheck() const;
+	/// Same score as sch::evaluate() gives the same position.
+	int evaluate() const;
+
+	PieceType getPieceTypeAt(int square) const { return mBoard[square]; }
+	uint64_t getPieceBitboard(PieceType type) const { return mPieces[static_cast<int>(type)]; }
+	uint64_t getOccupied() const { return mColors[0] | mColors[1]; }
+	int getKingSquare(bool white) const;
+	bool isWhiteToMove() const { return mWhiteToMove; }
+	int getHalfmoveClock() const { return mHalfmoveClock; }
+	/// The same key BoardState::getHashKey() gives the same position.
+	uint64_t getHashKey() const { return mHashKey; }
+
+private:
+	static const int PIECE_TYPES = static_cast<int>(PieceType::UNDEFINED);
+
+	uint64_t mPieces[PIECE_TYPES];
+	uint64_t mColors[2];   //!< White, black
+	PieceType mBoard[SQUARE_COUNT];
+	bool mWhiteToMove;
+	int mCastlingRights;   //!< BoardState::CastlingRight mask
+	int mEnPassant;        //!< Square a pawn can capture en passant, -1 when none
+	uint64_t mHashKey;
+	int mHalfmoveClock;
+	TaperedScore mScore;
+	int mPhase;
+
+	void putPiece(int square, PieceType type);
+	PieceType takePiece(int square);
+
+	/**
+	 * True when @b square is attacked by @b white pieces with the squares of
+	 * @b occupied as blockers, ignoring the pieces on @b removed.
+	 */
+	bool isAttacked(int square, bool white, uint64_t occupied, uint64_t removed) const;
+};
+
+} /* namespace sch */
+
+#endif /* BITBOARDBOARD_H_ */
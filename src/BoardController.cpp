@@ -21,12 +21,14 @@ namespace sch {
 BoardController::BoardController()
 : mState(),
   mSelectedPiece(nullptr),
-  mPlayers(){
-
+  mPlayers(),
+  mThinkingPlayer(nullptr),
+  mMoveFound(false) {
+	mMoveReady.connect(sigc::mem_fun(this, &BoardController::onMoveReady));
 }
 
 BoardController::~BoardController() {
-
+	stopThinking();
 }
 
 /**
@@ -37,17 +39,21 @@ BoardController::~BoardController() {
  */
 void BoardController::chessBoardClicked(BoardPosition pos)
 {
+	// The board belongs to the computer player until its move is played
+	if(mThinker.joinable())
+		return;
 	if(mState.isValidPosition(pos)) {
 		// 1st check if we clicked on a possible movement
 		if(auto selected_piece = mState.getSelectedPiece()) {
-			auto moves = selected_piece->getPossibleMoves(mState);
+			mMoveCache.sync(mState);
+			auto moves = mMoveCache.getMoves(selected_piece->getBoardPosition());
 			for(auto& move : moves) {
 				if(pos == move) {
 					cout << "Clicked on a possible move" << endl;
 					mState.moveTo(pos);
-
-					mState.switchPlayer();
-					mBoardStateUpdated(mState);
+					publishState();
+					if(checkGameOver())
+						return;
 
 					if(!mPlayer1->isHuman() || !mPlayer2->isHuman()) {
 						Glib::signal_idle().connect(sigc::mem_fun(this, &BoardController::mainGameLogic));
@@ -72,23 +78,28 @@ void BoardController::chessBoardClicked(BoardPosition pos)
 				cout << "Empty square" << endl;
 		}
 
-		mBoardStateUpdated(mState);
+		publishState();
 	}
 }
 
+bool BoardController::checkGameOver()
+{
+	const GameStatus status = mState.getGameStatus();
+	if(status == GameStatus::IN_PROGRESS)
+		return false;
+
+	cout << "Game over: " << toString(status);
+	if(status == GameStatus::CHECKMATE)
+		cout << ", " << (mState.getCurrentPlayer() == ChessPlayer::Color::WHITE ? "black" : "white") << " wins";
+	cout << endl;
+	mState.setGameInProgress(false);
+	mAlgorithmConnection.disconnect();
+	return true;
+}
+
 bool BoardController::isValidMove(const BoardState& s, const Move& m) const
 {
-	bool valid = false;
-	if(m.piece.get() != nullptr) {
-		auto moves = m.piece->getPossibleMoves(s);
-		for(auto& pos : moves) {
-			if(pos == m.final_pos) {
-				valid = true;
-				break;
-			}
-		}
-	}
-	return valid;
+	return m.piece.get() != nullptr && s.isLegal(m);
 }
 
 void BoardController::startGame(ChessPlayer* player1, ChessPlayer* player2) {
@@ -101,18 +112,23 @@ void BoardController::startGame(ChessPlayer* player1, ChessPlayer* player2) {
     mState.setCurrentPlayer(mPlayer1->getColor());
     mState.setGameInProgress();
 
-    mBoardStateUpdated(mState);
+    publishState();
 }
 
 void BoardController::endGame() {
 	cout << "BoardController::endGame" << endl;
+	const MoveCache::Stats& stats = mMoveCache.getStats();
+	cout << "Move cache: " << stats.hits << " hits, " << stats.regenerated << " piece lists generated, "
+	     << stats.kept << " kept" << endl;
+	mMoveCache.resetStats();
 
+	stopThinking();
 	mState.reset();
 	mHumanConnection.disconnect();
 	mAlgorithmConnection.disconnect();
 	mPlayers.clear();
 
-	mBoardStateUpdated(mState);
+	publishState();
 }
 
 void BoardController::resetGame() {
@@ -123,41 +139,67 @@ void BoardController::resetGame() {
 }
 
 	bool BoardController::mainGameLogic() {
-		Move move;
+		if(mThinker.joinable() || !mState.isGameInProgress())
+			return false;
 
+		ChessPlayer* player = nullptr;
 		if(mPlayer1 && mPlayer1->getColor() == mState.getCurrentPlayer())
-			move = mPlayer1->makeMove(mState);
-
-		if(mPlayer2  && mPlayer2->getColor() == mState.getCurrentPlayer())
-			move = mPlayer2->makeMove(mState);
-
-		if(isValidMove(mState, move)) {
-			auto target_square = mState.getSquareAt(move.piece->getBoardPosition());
-			if(mState.selectPieceAt(target_square)) {
-				auto moves = mState.getSelectedPiece()->getPossibleMoves(mState);
-				for(auto& possible_pos : moves) {
-					if(move.final_pos == possible_pos) {
-						cout << "Clicked on a possible move" << endl;
-						mState.moveTo(move.final_pos);
-
-						mState.switchPlayer();
-						mBoardStateUpdated(mState);
-						break;
-					}
-				}
-				mState.unselectPiece();
-			}
+			player = mPlayer1.get();
+		if(mPlayer2 && mPlayer2->getColor() == mState.getCurrentPlayer())
+			player = mPlayer2.get();
+		if(!player || player->isHuman())
+			return false;
+
+		// A search takes a second or more, the window must keep drawing
+		mThinkingPlayer = player;
+		mThinkingState = mState;
+		mMoveFound = false;
+		mThinker = std::thread([this] {
+			mThinkingMove = mThinkingPlayer->makeMove(mThinkingState);
+			mMoveFound = true;
+			mMoveReady.emit();
+		});
+		return false;
+	}
+
+	void BoardController::onMoveReady() {
+		// Left over from a search stopped by stopThinking()
+		if(!mThinker.joinable() || !mMoveFound)
+			return;
+		mThinker.join();
+		mThinkingPlayer = nullptr;
+
+		const Move move = mThinkingMove;
+		if(isValidMove(mThinkingState, move)) {
+			// The player answered with a piece of its own copy of the board
+			BoardState::UndoInfo undo;
+			mState.makeMove(mState.decodeMove(BoardState::encodeMove(move)), undo);
 		}
 
-		mBoardStateUpdated(mState);
+		publishState();
+		if(checkGameOver())
+			return;
+
+		// The other player may be a computer too
+		mainGameLogic();
+	}
 
-		// when playing only A.I. we should not disconnect this method
-		bool both_ai = (typeid(*mPlayer1.get()) != typeid(Human)) && (typeid(*mPlayer2.get()) != typeid(Human));
-		return both_ai;// when returning false means this method will be disconnected from the glib idle functions
+	void BoardController::stopThinking() {
+		if(!mThinker.joinable())
+			return;
+		mThinkingPlayer->stop();
+		mThinker.join();
+		mThinkingPlayer = nullptr;
+		mMoveFound = false;
 	}
 
+	void BoardController::publishState() {
+		// A click that only selects a piece finds the cache up to date
+		mMoveCache.sync(mState);
+		mBoardStateUpdated(mPublisher.publish(mState, mMoveCache));
+	}
 
-    sigc::signal<void, const BoardState&> BoardController::signalBoardStateUpdated() {
+    sigc::signal<void, std::shared_ptr<const PositionSnapshot>> BoardController::signalBoardStateUpdated() {
         return mBoardStateUpdated;
     }
 } /* namespace sch */
@@ -33,6 +33,12 @@
 
 #include "ChessPlayer.h"
 #include "BoardState.h"
+#include "MoveCache.h"
+#include "PositionSnapshot.h"
+#include <atomic>
+#include <thread>
+#include <glibmm/dispatcher.h>
+#include <sigc++/sigc++.h>
 
 namespace Gtk {
 	class Statusbar;
@@ -56,9 +62,20 @@ public:
 	void endGame();
 	void resetGame();
 
+	/**
+	 * Starts the search of the computer player to move on a worker thread.
+	 * Its move is played from the main loop once it is found, and the next
+	 * computer player starts thinking then.
+	 *
+	 * @return False, so that it can be connected to Glib::signal_idle().
+	 */
 	bool mainGameLogic();
 
-    sigc::signal<void,const BoardState&> signalBoardStateUpdated();
+    /// Emitted with a new snapshot every time the board changes.
+    sigc::signal<void, std::shared_ptr<const PositionSnapshot>> signalBoardStateUpdated();
+
+    /// The position as of the last update, safe to call from any thread.
+    std::shared_ptr<const PositionSnapshot> getSnapshot() const { return mPublisher.get(); }
 private:
 	BoardState 	mState;
 	std::unique_ptr<ChessPlayer>	mPlayer1;
@@ -67,9 +84,32 @@ private:
 	std::vector<std::unique_ptr<ChessPlayer>> mPlayers;
 	sigc::connection mAlgorithmConnection; // Connection to the algorithm logic.
 	sigc::connection mHumanConnection; // Connection to the game logic.
-    sigc::signal<void, const BoardState&> mBoardStateUpdated;
+    sigc::signal<void, std::shared_ptr<const PositionSnapshot>> mBoardStateUpdated;
+    SnapshotPublisher mPublisher;
+	/// The legal moves of mState, shared by the click and game logic.
+	MoveCache mMoveCache;
+
+	/// Runs ChessPlayer::makeMove() of a computer player off the main loop.
+	std::thread mThinker;
+	ChessPlayer* mThinkingPlayer;
+	BoardState mThinkingState; //!< The copy of mState the player thinks on
+	Move mThinkingMove;        //!< Written by mThinker before mMoveReady
+	std::atomic<bool> mMoveFound;
+	/// Emitted by mThinker, runs onMoveReady() in the main loop.
+	Glib::Dispatcher mMoveReady;
+
+	void onMoveReady();
+
+	/// Stops the player thinking, if any, and waits for it. Its move is dropped.
+	void stopThinking();
 
 	bool isValidMove(const BoardState& s, const Move& m) const;
+
+	/// Publishes a snapshot of mState and tells the listeners about it.
+	void publishState();
+
+	/// Stops the game when it is over, see BoardState::getGameStatus().
+	bool checkGameOver();
 };
 
 } /* namespace sch */
@@ -29,29 +29,228 @@
 //===----------------------------------------------------------------------===//
 
 #include "BoardState.h"
+#include "Zobrist.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <sstream>
 
 using namespace std;
 
 namespace sch {
 
+const char* const BoardState::START_FEN =
+		"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+namespace {
+	const int KNIGHT_JUMPS[8][2] = {
+		{-2,-1}, {-2,1}, {-1,-2}, {-1,2}, {1,-2}, {1,2}, {2,-1}, {2,1}
+	};
+	/// The straight directions come first, then the diagonal ones.
+	const int DIRECTIONS[8][2] = {
+		{-1,0}, {1,0}, {0,-1}, {0,1}, {-1,-1}, {-1,1}, {1,-1}, {1,1}
+	};
+
+	inline bool isOnBoard(int row, int col) {
+		return row >= 0 && row < MAX_ROW && col >= 0 && col < MAX_COL;
+	}
+
+	inline int sign(int x) { return (x > 0) - (x < 0); }
+
+	/// True when @b c lies on the ray that starts at @b a and goes through @b b.
+	bool isOnRay(int a, int b, int c) {
+		const int br = b / MAX_COL - a / MAX_COL, bc = b % MAX_COL - a % MAX_COL;
+		const int cr = c / MAX_COL - a / MAX_COL, cc = c % MAX_COL - a % MAX_COL;
+		const bool line = cr == 0 || cc == 0 || cr == cc || cr == -cc;
+		return c != a && line && sign(br) == sign(cr) && sign(bc) == sign(cc);
+	}
+
+	/// True when @b c lies strictly between @b a and @b b, on a straight or diagonal line.
+	bool isBetween(int a, int b, int c) {
+		const int br = b / MAX_COL - a / MAX_COL, bc = b % MAX_COL - a % MAX_COL;
+		const int cr = c / MAX_COL - a / MAX_COL, cc = c % MAX_COL - a % MAX_COL;
+		const bool line = br == 0 || bc == 0 || br == bc || br == -bc;
+		return line && isOnRay(a, b, c) && max(abs(cr), abs(cc)) < max(abs(br), abs(bc));
+	}
+
+	/// True when a piece of @b type slides along DIRECTIONS[@b d] (or its opposite).
+	inline bool slidesAlong(PieceType type, int d) {
+		const int kind = getPieceKind(type);
+		return kind == QUEEN_KIND || kind == (d < 4 ? ROOK_KIND : BISHOP_KIND);
+	}
+
+	/// The castling rights that survive a move from or to each square.
+	int castlingMask(int square) {
+		switch(square) {
+		case 0: return ~BoardState::BLACK_QUEEN_SIDE; // A8
+		case 4: return ~(BoardState::BLACK_KING_SIDE | BoardState::BLACK_QUEEN_SIDE); // E8
+		case 7: return ~BoardState::BLACK_KING_SIDE; // H8
+		case 56: return ~BoardState::WHITE_QUEEN_SIDE; // A1
+		case 60: return ~(BoardState::WHITE_KING_SIDE | BoardState::WHITE_QUEEN_SIDE); // E1
+		case 63: return ~BoardState::WHITE_KING_SIDE; // H1
+		default: return BoardState::ALL_CASTLING_RIGHTS;
+		}
+	}
+
+	inline PieceType pieceAt(const PieceType* board, int row, int col) {
+		if(row < 0 || row >= MAX_ROW || col < 0 || col >= MAX_COL)
+			return PieceType::UNDEFINED;
+		return board[row * MAX_COL + col];
+	}
+
+	/// Walks from (row,col) in direction (dr,dc) and returns the first piece found.
+	PieceType firstPieceInRay(const PieceType* board, int row, int col, int dr, int dc) {
+		for(row += dr, col += dc; row >= 0 && row < MAX_ROW && col >= 0 && col < MAX_COL;
+				row += dr, col += dc) {
+			if(board[row * MAX_COL + col] != PieceType::UNDEFINED)
+				return board[row * MAX_COL + col];
+		}
+		return PieceType::UNDEFINED;
+	}
+
+	/**
+	 * Returns true if any piece of the given color on @b board attacks
+	 * @b square. Instead of generating the moves of every enemy piece it looks
+	 * outwards from @b square and stops at the first attacker found.
+	 */
+	bool isAttacked(const PieceType* board, int square, bool by_white) {
+		const int row = square / MAX_COL;
+		const int col = square % MAX_COL;
+
+		// White pawns move towards row 0, so they attack from the row below
+		const PieceType pawn = makePieceType(PAWN_KIND, by_white);
+		const int pawn_row = by_white ? row + 1 : row - 1;
+		if(pieceAt(board, pawn_row, col - 1) == pawn || pieceAt(board, pawn_row, col + 1) == pawn)
+			return true;
+
+		static const int KNIGHT_DELTAS[8][2] = {
+			{-2,-1}, {-2,1}, {-1,-2}, {-1,2}, {1,-2}, {1,2}, {2,-1}, {2,1}
+		};
+		const PieceType knight = makePieceType(KNIGHT_KIND, by_white);
+		for(auto& d : KNIGHT_DELTAS)
+			if(pieceAt(board, row + d[0], col + d[1]) == knight)
+				return true;
+
+		const PieceType king = makePieceType(KING_KIND, by_white);
+		for(int dr = -1; dr <= 1; ++dr)
+			for(int dc = -1; dc <= 1; ++dc)
+				if((dr || dc) && pieceAt(board, row + dr, col + dc) == king)
+					return true;
+
+		const PieceType queen = makePieceType(QUEEN_KIND, by_white);
+		const PieceType rook = makePieceType(ROOK_KIND, by_white);
+		const PieceType bishop = makePieceType(BISHOP_KIND, by_white);
+		static const int STRAIGHT[4][2] = { {-1,0}, {1,0}, {0,-1}, {0,1} };
+		static const int DIAGONAL[4][2] = { {-1,-1}, {-1,1}, {1,-1}, {1,1} };
+		for(auto& d : STRAIGHT) {
+			PieceType p = firstPieceInRay(board, row, col, d[0], d[1]);
+			if(p == rook || p == queen)
+				return true;
+		}
+		for(auto& d : DIAGONAL) {
+			PieceType p = firstPieceInRay(board, row, col, d[0], d[1]);
+			if(p == bishop || p == queen)
+				return true;
+		}
+		return false;
+	}
+
+	/// The squares (as bits, see toSquareIndex) of the pieces of both colors attacking @b square.
+	uint64_t findAttackers(const PieceType* board, int square) {
+		const int row = square / MAX_COL;
+		const int col = square % MAX_COL;
+		uint64_t attackers = 0;
+		auto check = [&](int r, int c, int kind, bool white) {
+			if(pieceAt(board, r, c) == makePieceType(kind, white))
+				attackers |= uint64_t(1) << (r * MAX_COL + c);
+		};
+
+		for(int dc = -1; dc <= 1; dc += 2) {
+			check(row + 1, col + dc, PAWN_KIND, true);
+			check(row - 1, col + dc, PAWN_KIND, false);
+		}
+
+		static const int KNIGHT_DELTAS[8][2] = {
+			{-2,-1}, {-2,1}, {-1,-2}, {-1,2}, {1,-2}, {1,2}, {2,-1}, {2,1}
+		};
+		for(auto& d : KNIGHT_DELTAS) {
+			check(row + d[0], col + d[1], KNIGHT_KIND, true);
+			check(row + d[0], col + d[1], KNIGHT_KIND, false);
+		}
+
+		for(int dr = -1; dr <= 1; ++dr) {
+			for(int dc = -1; dc <= 1; ++dc) {
+				if(!dr && !dc)
+					continue;
+				check(row + dr, col + dc, KING_KIND, true);
+				check(row + dr, col + dc, KING_KIND, false);
+
+				// The first piece of the ray attacks when it slides that way
+				const int slider = dr && dc ? BISHOP_KIND : ROOK_KIND;
+				for(int r = row + dr, c = col + dc; r >= 0 && r < MAX_ROW && c >= 0 && c < MAX_COL;
+						r += dr, c += dc) {
+					const PieceType t = board[r * MAX_COL + c];
+					if(t == PieceType::UNDEFINED)
+						continue;
+					const int kind = getPieceKind(t);
+					if(kind == slider || kind == QUEEN_KIND)
+						attackers |= uint64_t(1) << (r * MAX_COL + c);
+					break;
+				}
+			}
+		}
+		return attackers;
+	}
+
+	PieceType pieceTypeFromFEN(char c) {
+		switch(c) {
+		case 'K': return PieceType::WHITE_KING;
+		case 'Q': return PieceType::WHITE_QUEEN;
+		case 'R': return PieceType::WHITE_ROOK;
+		case 'B': return PieceType::WHITE_BISHOP;
+		case 'N': return PieceType::WHITE_KNIGHT;
+		case 'P': return PieceType::WHITE_PAWN;
+		case 'k': return PieceType::BLACK_KING;
+		case 'q': return PieceType::BLACK_QUEEN;
+		case 'r': return PieceType::BLACK_ROOK;
+		case 'b': return PieceType::BLACK_BISHOP;
+		case 'n': return PieceType::BLACK_KNIGHT;
+		case 'p': return PieceType::BLACK_PAWN;
+		default: return PieceType::UNDEFINED;
+		}
+	}
+
+	/// True if a pawn of the side to move could capture on @b ep right after the double push.
+	bool canCaptureEnPassant(const PieceType* board, BoardPosition ep, bool white_to_move) {
+		const int pawn_row = white_to_move ? ep.row + 1 : ep.row - 1;
+		const PieceType pawn = makePieceType(PAWN_KIND, white_to_move);
+		return pieceAt(board, pawn_row, ep.column - 1) == pawn
+				|| pieceAt(board, pawn_row, ep.column + 1) == pawn;
+	}
+}
+
 BoardState::BoardState()
-: mWhitePieces(), mBlackPieces(), mWhiteHostages(), mBlackHostages(),
-  mSquares(), mCurrentPlayer(ChessPlayer::Color::WHITE), mGameInProgress(false),
-  mSelectedPiece(nullptr) {
+: mWhitePieces(), mBlackPieces(), mWhiteHostages(), mBlackHostages(), mSparePieces(),
+  mSelectedPiece(nullptr), mSquares(), mCurrentPlayer(ChessPlayer::Color::WHITE),
+  mGameInProgress(false), mHashKey(0), mPieceSquareScore(), mPhase(0),
+  mCastlingRights(ALL_CASTLING_RIGHTS), mEnPassant(),
+  mHalfmoveClock(0), mFullmoveNumber(1) {
 	reset();
-	cout << "BoardState Constructor" << endl;
 }
 
 BoardState::BoardState(const BoardState& rhs)
 : mCurrentPlayer(rhs.mCurrentPlayer)
 {
 	copy(rhs);
-	clog << "BoardState COPY Constructor" << endl;
 }
 
 BoardState::BoardState(BoardState&& rhs)
-        : mCurrentPlayer{rhs.mCurrentPlayer}, mGameInProgress(rhs.mGameInProgress)
+        : mCurrentPlayer{rhs.mCurrentPlayer}, mGameInProgress(rhs.mGameInProgress),
+          mHashKey(rhs.mHashKey), mPieceSquareScore(rhs.mPieceSquareScore), mPhase(rhs.mPhase),
+          mCastlingRights(rhs.mCastlingRights),
+          mEnPassant(rhs.mEnPassant), mHalfmoveClock(rhs.mHalfmoveClock),
+          mFullmoveNumber(rhs.mFullmoveNumber)
 {
 	mWhitePieces.swap(rhs.mWhitePieces);
 
@@ -61,48 +260,77 @@ BoardState::BoardState(BoardState&& rhs)
 
 	mBlackHostages.swap(rhs.mBlackHostages);
 
+	mSparePieces.swap(rhs.mSparePieces);
+
 	mSquares.swap(rhs.mSquares);
 
-	assert(mWhitePieces.size() == 16);
-	assert(mBlackPieces.size() == 16);
-	clog << "BoardState MOVE Constructor" << endl;
+	mSelectedPiece.swap(rhs.mSelectedPiece);
+
+	mHistory.swap(rhs.mHistory);
+
+	memcpy(mBoard, rhs.mBoard, sizeof(mBoard));
+	mKingSquare[0] = rhs.mKingSquare[0];
+	mKingSquare[1] = rhs.mKingSquare[1];
+	memcpy(mBitboards, rhs.mBitboards, sizeof(mBitboards));
+	mOccupied = rhs.mOccupied;
+	memcpy(mAttackCounts, rhs.mAttackCounts, sizeof(mAttackCounts));
+	mAttacks[0] = rhs.mAttacks[0];
+	mAttacks[1] = rhs.mAttacks[1];
+	mPinned[0] = rhs.mPinned[0];
+	mPinned[1] = rhs.mPinned[1];
 }
 
 BoardState& BoardState::operator = (const BoardState& rhs)
 {
-	copy(rhs);
-	clog << "BoardState ASSIGNMENT OPERATOR" << endl;
+	if(this != &rhs)
+		copy(rhs);
 	return *this;
 }
 
-std::shared_ptr<ChessPiece>  BoardState::copyPiece(std::shared_ptr<ChessPiece> piece) {
-	std::shared_ptr<ChessPiece> ptr {nullptr};
-	switch(piece->getPieceType()) {
+std::shared_ptr<ChessPiece> BoardState::createPiece(PieceType type, BoardPosition pos) {
+	switch(type) {
 	case PieceType::WHITE_KING:
 	case PieceType::BLACK_KING:
-		ptr = make_shared<King>(BoardPosition(ONE, E), PieceType::WHITE_KING);
-		break;
+		return make_shared<King>(pos, type);
 	case PieceType::WHITE_QUEEN:
 	case PieceType::BLACK_QUEEN:
-		ptr = make_shared<Queen>(BoardPosition(ONE, E), PieceType::WHITE_KING);
-		break;
+		return make_shared<Queen>(pos, type);
 	case PieceType::WHITE_KNIGHT:
 	case PieceType::BLACK_KNIGHT:
-		ptr = make_shared<Knight>(BoardPosition(ONE, E), PieceType::WHITE_KING);
-		break;
+		return make_shared<Knight>(pos, type);
 	case PieceType::WHITE_ROOK:
 	case PieceType::BLACK_ROOK:
-		ptr = make_shared<Rook>(BoardPosition(ONE, E), PieceType::WHITE_KING);
-		break;
+		return make_shared<Rook>(pos, type);
 	case PieceType::WHITE_BISHOP:
 	case PieceType::BLACK_BISHOP:
-		ptr = make_shared<Bishop>(BoardPosition(ONE, E), PieceType::WHITE_KING);
-		break;
+		return make_shared<Bishop>(pos, type);
 	case PieceType::WHITE_PAWN:
 	case PieceType::BLACK_PAWN:
-		ptr = make_shared<Pawn>(BoardPosition(ONE, E), PieceType::WHITE_KING);
+		return make_shared<Pawn>(pos, type);
+	case PieceType::UNDEFINED:
 		break;
 	}
+	return nullptr;
+}
+
+std::shared_ptr<ChessPiece> BoardState::createPromotedPiece(PieceType type, BoardPosition pos) {
+	for(auto& spare : mSparePieces) {
+		// Only reuse pieces nobody else is looking at, e.g. through an UndoInfo
+		if(spare->getPieceType() == type && spare.use_count() == 1) {
+			shared_ptr<ChessPiece> piece;
+			piece.swap(spare);
+			spare.swap(mSparePieces.back());
+			mSparePieces.pop_back();
+			piece->setPosition(pos);
+			piece->setSelected(false);
+			return piece;
+		}
+	}
+	return createPiece(type, pos);
+}
+
+std::shared_ptr<ChessPiece>  BoardState::copyPiece(std::shared_ptr<ChessPiece> piece) {
+	std::shared_ptr<ChessPiece> ptr = createPiece(piece->getPieceType(), piece->getBoardPosition());
 	*ptr = *piece;
 	return ptr;
 }
@@ -110,6 +338,11 @@ std::shared_ptr<ChessPiece>  BoardState::copyPiece(std::shared_ptr<ChessPiece> p
 void BoardState::copy(const BoardState& rhs) {
 	mCurrentPlayer = rhs.mCurrentPlayer;
     mGameInProgress = rhs.mGameInProgress;
+	mCastlingRights = rhs.mCastlingRights;
+	mEnPassant = rhs.mEnPassant;
+	mHalfmoveClock = rhs.mHalfmoveClock;
+	mFullmoveNumber = rhs.mFullmoveNumber;
+	mSelectedPiece.reset();
 
 	mWhitePieces.clear();
 	for(auto piece : rhs.mWhitePieces)
@@ -127,13 +360,22 @@ void BoardState::copy(const BoardState& rhs) {
 	for(auto piece : rhs.mBlackHostages)
 		mBlackHostages.push_back(copyPiece(piece));
 
+	// The squares must point to our own copies, not to the pieces of rhs
 	mSquares.clear();
-	for(auto sq : rhs.mSquares)
-		mSquares.push_back(BoardSquare(sq));
+	initSquares();
+	bindPiecesToSquares();
+	mHashKey = rhs.mHashKey;
+	mHistory = rhs.mHistory;
+
+	for(auto& piece : mWhitePieces)
+		if(piece->isSelected())
+			mSelectedPiece = piece;
+	for(auto& piece : mBlackPieces)
+		if(piece->isSelected())
+			mSelectedPiece = piece;
 }
 
 BoardState::~BoardState() {
-	clog << "BoardState Destructor" << endl;
 }
 
 void BoardState::initWhitePieces() {
@@ -164,64 +406,352 @@ void BoardState::initBlackPieces() {
 }
 
 void BoardState::initSquares() {
-	for(int i = 0; i < Column::MAX_COL; ++i) {
-		for(int j = 0; j < Row::MAX_ROW; ++j) {
+	// Row by row, so a square can be found at toSquareIndex(pos)
+	for(int j = 0; j < Row::MAX_ROW; ++j) {
+		for(int i = 0; i < Column::MAX_COL; ++i) {
 			mSquares.push_back(BoardSquare(BoardPosition(Row(j),Column(i))));
 		}
 	}
 	// Used for special cases
 	mSquares.push_back(BoardSquare(BoardPosition(Row::MAX_ROW, Column::MAX_COL)));
+
+	for(auto& type : mBoard)
+		type = PieceType::UNDEFINED;
 }
 
 
 void BoardState::bindPiecesToSquares()
 {
-	for(auto p : mWhitePieces) {
-		for(auto& s : mSquares) {
-			if(s.getBoardPosition() == p->getBoardPosition())
-				s.setPiece(p);
-		}
-	}
+	mPieceSquareScore = TaperedScore();
+	mPhase = 0;
+	for(auto& type : mBoard)
+		type = PieceType::UNDEFINED;
+	memset(mBitboards, 0, sizeof(mBitboards));
+	mOccupied = 0;
+	memset(mAttackCounts, 0, sizeof(mAttackCounts));
+	mAttacks[0] = mAttacks[1] = 0;
 
-	for(auto p : mBlackPieces) {
-		for(auto& s : mSquares) {
-			if(s.getBoardPosition() == p->getBoardPosition())
-				s.setPiece(p);
+	// Every piece first, then the attacks of each on the final board: adding
+	// them one at a time with putPiece() would also redo the rays they cut
+	const PieceSquareTable& pst = PieceSquareTable::instance();
+	for(const auto* pieces : { &mWhitePieces, &mBlackPieces }) {
+		for(auto& piece : *pieces) {
+			const int sq = toSquareIndex(piece->getBoardPosition());
+			const PieceType type = piece->getPieceType();
+			mSquares[sq].setPiece(piece);
+			mBoard[sq] = type;
+			mBitboards[static_cast<int>(type)] |= uint64_t(1) << sq;
+			mOccupied |= uint64_t(1) << sq;
+			mPieceSquareScore += pst.getScore(type, sq);
+			mPhase += pst.getPhase(type);
+			if(getPieceKind(type) == KING_KIND)
+				mKingSquare[piece->isWhite() ? 0 : 1] = sq;
 		}
 	}
+	for(uint64_t occupied = mOccupied; occupied; occupied &= occupied - 1) {
+		const int sq = __builtin_ctzll(occupied);
+		updateAttacks(sq, mBoard[sq], 1);
+	}
+
+	updatePins();
 }
 
 void BoardState::reset() {
 	mGameInProgress = false;
+	mSelectedPiece.reset();
 	mSquares.clear();
 	initSquares();
 	mWhitePieces.clear();
 	initWhitePieces();
 	mBlackPieces.clear();
 	initBlackPieces();
+	mWhiteHostages.clear();
+	mBlackHostages.clear();
 	bindPiecesToSquares();
+	mCastlingRights = ALL_CASTLING_RIGHTS;
+	mEnPassant = BoardPosition();
+	mHalfmoveClock = 0;
+	mFullmoveNumber = 1;
+	mHashKey = computeHashKey();
+	mHistory.assign(1, mHashKey);
 	assert(!mWhitePieces.empty());
 	assert(!mBlackPieces.empty());
 }
 
+uint64_t BoardState::computeHashKey() const {
+	const Zobrist& z = Zobrist::instance();
+	uint64_t key = 0;
+	for(auto p : mWhitePieces)
+		key ^= z.getPieceKey(p->getPieceType(), p->getBoardPosition());
+	for(auto p : mBlackPieces)
+		key ^= z.getPieceKey(p->getPieceType(), p->getBoardPosition());
+	if(mCurrentPlayer == ChessPlayer::Color::BLACK)
+		key ^= z.getSideKey();
+	key ^= z.getCastlingKey(mCastlingRights);
+	if(mEnPassant.isValid())
+		key ^= z.getEnPassantKey(mEnPassant.column);
+	return key;
+}
+
+void BoardState::loadFEN(const char* fen, size_t length) {
+	const char* p = fen;
+	const char* const end = fen + length;
+	auto skipSpaces = [&p, end]() {
+		while(p < end && (*p == ' ' || *p == '\t'))
+			++p;
+	};
+	auto fail = [fen, length](const char* reason) {
+		throw FENException(string(fen, length), reason);
+	};
+	auto readNumber = [&p, end, &fail](int fallback) {
+		if(p >= end)
+			return fallback;
+		if(*p < '0' || *p > '9')
+			fail("invalid move counter");
+		int n = 0;
+		while(p < end && *p >= '0' && *p <= '9' && n < 100000000)
+			n = n * 10 + (*p++ - '0');
+		return n;
+	};
+
+	PieceType board[SQUARE_COUNT];
+	for(auto& type : board)
+		type = PieceType::UNDEFINED;
+
+	skipSpaces();
+	int row = 0, col = 0;
+	int kings[2] = {0, 0};
+	int king_squares[2] = {0, 0};
+	int pieces[2] = {0, 0};
+	for(; p < end && *p != ' ' && *p != '\t'; ++p) {
+		const char c = *p;
+		if(c == '/') {
+			if(col != MAX_COL)
+				fail("incomplete row");
+			++row;
+			col = 0;
+		} else if(c >= '1' && c <= '8') {
+			col += c - '0';
+		} else {
+			PieceType type = pieceTypeFromFEN(c);
+			if(type == PieceType::UNDEFINED)
+				throw FENException(string(fen, length), string("unknown piece '") + c + "'");
+			if(row >= MAX_ROW || col >= MAX_COL)
+				fail("too many squares");
+			const int side = isWhitePieceType(type) ? 0 : 1;
+			if(getPieceKind(type) == KING_KIND) {
+				++kings[side];
+				king_squares[side] = row * MAX_COL + col;
+			} else if(getPieceKind(type) == PAWN_KIND && (row == 0 || row == MAX_ROW - 1)) {
+				fail("pawn on the first or last rank");
+			}
+			++pieces[side];
+			board[row * MAX_COL + col] = type;
+			++col;
+		}
+		if(col > MAX_COL)
+			fail("too many squares");
+	}
+	if(row != MAX_ROW - 1 || col != MAX_COL)
+		fail("expected 8 rows of 8 squares");
+	if(kings[0] != 1 || kings[1] != 1)
+		fail("each side needs exactly one king");
+	if(pieces[0] > 16 || pieces[1] > 16)
+		fail("more than 16 pieces of one color");
+
+	skipSpaces();
+	if(p >= end)
+		fail("missing fields");
+	if((*p != 'w' && *p != 'b') || (p + 1 < end && p[1] != ' ' && p[1] != '\t'))
+		fail("side to move must be 'w' or 'b'");
+	const bool white_to_move = *p++ == 'w';
+	// Otherwise the side to move could capture the king
+	if(isAttacked(board, king_squares[white_to_move ? 1 : 0], white_to_move))
+		fail("the side not to move is in check");
+
+	skipSpaces();
+	int rights = 0;
+	if(p < end && *p == '-') {
+		++p;
+	} else {
+		for(; p < end && *p != ' ' && *p != '\t'; ++p) {
+			switch(*p) {
+			case 'K': rights |= WHITE_KING_SIDE; break;
+			case 'Q': rights |= WHITE_QUEEN_SIDE; break;
+			case 'k': rights |= BLACK_KING_SIDE; break;
+			case 'q': rights |= BLACK_QUEEN_SIDE; break;
+			default: fail("invalid castling rights");
+			}
+		}
+	}
+	// Drop the rights that the placement contradicts
+	if(board[60] != PieceType::WHITE_KING) rights &= ~(WHITE_KING_SIDE | WHITE_QUEEN_SIDE);
+	if(board[63] != PieceType::WHITE_ROOK) rights &= ~WHITE_KING_SIDE;
+	if(board[56] != PieceType::WHITE_ROOK) rights &= ~WHITE_QUEEN_SIDE;
+	if(board[4] != PieceType::BLACK_KING) rights &= ~(BLACK_KING_SIDE | BLACK_QUEEN_SIDE);
+	if(board[7] != PieceType::BLACK_ROOK) rights &= ~BLACK_KING_SIDE;
+	if(board[0] != PieceType::BLACK_ROOK) rights &= ~BLACK_QUEEN_SIDE;
+
+	skipSpaces();
+	BoardPosition ep;
+	if(p < end && *p == '-') {
+		++p;
+	} else if(p < end) {
+		if(end - p < 2 || p[0] < 'a' || p[0] > 'h' || (p[1] != '3' && p[1] != '6')
+				|| (end - p > 2 && p[2] != ' ' && p[2] != '\t'))
+			fail("invalid en passant square");
+		// The square a pawn of the other side just jumped over
+		if(p[1] != (white_to_move ? '6' : '3'))
+			fail("en passant square on the wrong rank");
+		ep = BoardPosition(MAX_ROW - (p[1] - '0'), p[0] - 'a');
+		p += 2;
+		const int towards_pawn = white_to_move ? 1 : -1;
+		if(pieceAt(board, ep.row + towards_pawn, ep.column) != makePieceType(PAWN_KIND, !white_to_move)
+				|| pieceAt(board, ep.row, ep.column) != PieceType::UNDEFINED
+				|| pieceAt(board, ep.row - towards_pawn, ep.column) != PieceType::UNDEFINED)
+			fail("no pawn just moved two squares past the en passant square");
+		// Same convention as makeMove: only kept when a capture is possible
+		if(!canCaptureEnPassant(board, ep, white_to_move))
+			ep = BoardPosition();
+	}
+
+	skipSpaces();
+	const int halfmove = readNumber(0);
+	skipSpaces();
+	const int fullmove = max(1, readNumber(1));
+
+	// Everything was valid, now rebuild the state. The pieces we already have
+	// are put on their new squares, new ones are only created when neither
+	// the pieces nor the spares have one.
+	mSelectedPiece.reset();
+	mWhitePieces.insert(mWhitePieces.end(), mWhiteHostages.begin(), mWhiteHostages.end());
+	mBlackPieces.insert(mBlackPieces.end(), mBlackHostages.begin(), mBlackHostages.end());
+	mWhiteHostages.clear();
+	mBlackHostages.clear();
+
+	size_t used[2] = {0, 0};
+	auto place = [this, &used](PieceType type, int sq) {
+		const int side = isWhitePieceType(type) ? 0 : 1;
+		auto& pieces = side == 0 ? mWhitePieces : mBlackPieces;
+		size_t i = used[side];
+		while(i < pieces.size() && pieces[i]->getPieceType() != type)
+			++i;
+		if(i == pieces.size())
+			pieces.push_back(createPromotedPiece(type, toBoardPosition(sq)));
+		swap(pieces[used[side]], pieces[i]);
+		auto& piece = pieces[used[side]++];
+		piece->setPosition(toBoardPosition(sq));
+		piece->setSelected(false);
+	};
+	// Keep the kings first, like initWhitePieces() and initBlackPieces()
+	for(int sq = 0; sq < SQUARE_COUNT; ++sq)
+		if(board[sq] != PieceType::UNDEFINED && getPieceKind(board[sq]) == KING_KIND)
+			place(board[sq], sq);
+	for(int sq = 0; sq < SQUARE_COUNT; ++sq)
+		if(board[sq] != PieceType::UNDEFINED && getPieceKind(board[sq]) != KING_KIND)
+			place(board[sq], sq);
+	// Left over pieces wait for the next position that needs them
+	for(int side = 0; side < 2; ++side) {
+		auto& pieces = side == 0 ? mWhitePieces : mBlackPieces;
+		for(size_t i = used[side]; i < pieces.size() && mSparePieces.size() < MAX_SPARE_PIECES; ++i)
+			mSparePieces.push_back(pieces[i]);
+		pieces.resize(used[side]);
+	}
+
+	for(auto& square : mSquares)
+		square.setPiece(nullptr);
+	for(auto& type : mBoard)
+		type = PieceType::UNDEFINED;
+	bindPiecesToSquares();
+
+	mCurrentPlayer = white_to_move ? ChessPlayer::Color::WHITE : ChessPlayer::Color::BLACK;
+	mCastlingRights = rights;
+	mEnPassant = ep;
+	mHalfmoveClock = halfmove;
+	mFullmoveNumber = fullmove;
+	mHashKey = computeHashKey();
+	mHistory.assign(1, mHashKey);
+}
+
+BoardState BoardState::fromFEN(const std::string& fen) {
+	BoardState state;
+	state.loadFEN(fen);
+	return state;
+}
+
+size_t BoardState::writeFEN(char* out) const {
+	static const char PIECE_LETTERS[] = "KkQqRrBbNnPp";
+	char* p = out;
+
+	for(int row = 0; row < MAX_ROW; ++row) {
+		int empty = 0;
+		for(int col = 0; col < MAX_COL; ++col) {
+			const PieceType type = mBoard[row * MAX_COL + col];
+			if(type == PieceType::UNDEFINED) {
+				++empty;
+				continue;
+			}
+			if(empty)
+				*p++ = static_cast<char>('0' + empty);
+			empty = 0;
+			*p++ = PIECE_LETTERS[static_cast<int>(type)];
+		}
+		if(empty)
+			*p++ = static_cast<char>('0' + empty);
+		if(row + 1 < MAX_ROW)
+			*p++ = '/';
+	}
+
+	*p++ = ' ';
+	*p++ = mCurrentPlayer == ChessPlayer::Color::WHITE ? 'w' : 'b';
+	*p++ = ' ';
+	if(!mCastlingRights)
+		*p++ = '-';
+	if(mCastlingRights & WHITE_KING_SIDE) *p++ = 'K';
+	if(mCastlingRights & WHITE_QUEEN_SIDE) *p++ = 'Q';
+	if(mCastlingRights & BLACK_KING_SIDE) *p++ = 'k';
+	if(mCastlingRights & BLACK_QUEEN_SIDE) *p++ = 'q';
+	*p++ = ' ';
+	if(mEnPassant.isOnBoard()) {
+		*p++ = static_cast<char>('a' + mEnPassant.column);
+		*p++ = static_cast<char>('0' + (MAX_ROW - mEnPassant.row));
+	} else {
+		*p++ = '-';
+	}
+
+	auto writeNumber = [&p](int n) {
+		char digits[12];
+		int count = 0;
+		do {
+			digits[count++] = static_cast<char>('0' + n % 10);
+			n /= 10;
+		} while(n > 0 && count < 11);
+		while(count)
+			*p++ = digits[--count];
+	};
+	*p++ = ' ';
+	writeNumber(mHalfmoveClock);
+	*p++ = ' ';
+	writeNumber(mFullmoveNumber);
+	*p = '\0';
+	return static_cast<size_t>(p - out);
+}
+
+std::string BoardState::toFEN() const {
+	char fen[MAX_FEN_LENGTH];
+	return string(fen, writeFEN(fen));
+}
+
 /**
  * Checks whether the BoardSqare @b sq is valid.
  *
- * This is done by comparing @b sq with all the BoardSqaures in the current
- * BoardState.
- *
  * @param[in] sq The BoardSquare we want to check.
  *
  * @return True when the BoardSquare is valid and inside the valid BoardSquares
  * in a chess board.
  */
 bool BoardState::isValidPosition(const BoardSquare& sq) const {
-	sch::BoardPosition board_position = sq.getBoardPosition();
-	for(auto& s : mSquares) {
-		if (s.getBoardPosition() == board_position)
-			return true;
-	}
-	return false;
+	return sq.getBoardPosition().isOnBoard();
 }
 
 bool BoardState::selectPieceAt(const BoardSquare& s) {
@@ -255,8 +785,11 @@ shared_ptr<ChessPiece> BoardState::getPieceAt(BoardSquare sq) const
 }
 
 bool BoardState::hasPieceAt(const BoardSquare& s) const {
+	const BoardPosition pos = s.getBoardPosition();
+	if(pos.isOnBoard())
+		return mBoard[toSquareIndex(pos)] != PieceType::UNDEFINED;
 	try {
-		return getSquareAt(s.getBoardPosition()).hasPiece();
+		return getSquareAt(pos).hasPiece();
 	} catch(const BoardPositionException& e) {
 		cerr << "WARNING: " << e.what() << endl;
 	}
@@ -265,35 +798,95 @@ bool BoardState::hasPieceAt(const BoardSquare& s) const {
 
 const BoardSquare& BoardState::getSquareAt(BoardPosition pos) const
 {
-	for(auto& s : mSquares) {
-		if(s.getBoardPosition() == pos)
-			return s;
-	}
+	if(pos.isOnBoard())
+		return mSquares[toSquareIndex(pos)];
+	if(pos == BoardPosition())
+		return mSquares.back();
 
 	throw BoardPositionException(pos);
 }
 
 BoardSquare& BoardState::getSquareAt(BoardPosition pos)
 {
-	for(auto& s : mSquares) {
-		if(s.getBoardPosition() == pos)
-			return s;
-	}
+	if(pos.isOnBoard())
+		return mSquares[toSquareIndex(pos)];
+	if(pos == BoardPosition())
+		return mSquares.back();
 
 	throw BoardPositionException(pos);
 }
 
 bool BoardState::isCheckmate() const
 {
-	assert(false && "Implement this method.");
-	return false;
+	return isInCheck() && !hasAnyLegalMove();
 }
 
 
 bool BoardState::isStalemate() const
 {
-	assert(false && "Implement this method.");
-	return false;
+	return !isInCheck() && !hasAnyLegalMove();
+}
+
+int BoardState::getRepetitionCount() const
+{
+	// Only positions since the last capture or pawn move can come back, and
+	// only those with the same player to move
+	const size_t size = mHistory.size();
+	const size_t reversible = min(static_cast<size_t>(mHalfmoveClock), size - 1);
+	int count = 0;
+	for(size_t back = 4; back <= reversible; back += 2)
+		if(mHistory[size - 1 - back] == mHashKey)
+			++count;
+	return count;
+}
+
+bool BoardState::isInsufficientMaterial() const
+{
+	auto both = [this](PieceType white) {
+		return getPieceBitboard(white) | getPieceBitboard(static_cast<PieceType>(static_cast<int>(white) + 1));
+	};
+	if(both(PieceType::WHITE_PAWN) | both(PieceType::WHITE_ROOK) | both(PieceType::WHITE_QUEEN))
+		return false;
+
+	const uint64_t knights = both(PieceType::WHITE_KNIGHT);
+	const uint64_t bishops = both(PieceType::WHITE_BISHOP);
+	const uint64_t minors = knights | bishops;
+	// A lone minor piece, or bishops that all run on the same square color
+	const uint64_t LIGHT_SQUARES = 0xAA55AA55AA55AA55ULL; // A8 is light
+	return !(minors & (minors - 1))
+			|| (!knights && (!(bishops & LIGHT_SQUARES) || !(bishops & ~LIGHT_SQUARES)));
+}
+
+GameStatus BoardState::getGameStatus() const
+{
+	return getGameStatus(hasAnyLegalMove());
+}
+
+GameStatus BoardState::getGameStatus(bool has_legal_move) const
+{
+	// Mate on the last move still counts, so the moves come first
+	if(!has_legal_move)
+		return isInCheck() ? GameStatus::CHECKMATE : GameStatus::STALEMATE;
+	if(mHalfmoveClock >= 100)
+		return GameStatus::FIFTY_MOVE_RULE;
+	if(getRepetitionCount() >= 2)
+		return GameStatus::THREEFOLD_REPETITION;
+	if(isInsufficientMaterial())
+		return GameStatus::INSUFFICIENT_MATERIAL;
+	return GameStatus::IN_PROGRESS;
+}
+
+const char* toString(GameStatus status)
+{
+	switch(status) {
+	case GameStatus::CHECKMATE: return "Checkmate";
+	case GameStatus::STALEMATE: return "Stalemate";
+	case GameStatus::FIFTY_MOVE_RULE: return "Fifty-move rule";
+	case GameStatus::THREEFOLD_REPETITION: return "Threefold repetition";
+	case GameStatus::INSUFFICIENT_MATERIAL: return "Insufficient material";
+	case GameStatus::IN_PROGRESS: break;
+	}
+	return "In progress";
 }
 
 std::vector<std::shared_ptr<ChessPiece>> BoardState::getPiecesThatCanBeMoved() const
@@ -302,52 +895,697 @@ std::vector<std::shared_ptr<ChessPiece>> BoardState::getPiecesThatCanBeMoved() c
 
 	if(getCurrentPlayer() == ChessPlayer::Color::WHITE) {
 		for(auto p : mWhitePieces)
-			if(p->canMove(*this))
+			if(canMove(*p))
 				moves.push_back(p);
 	} else {
 		for(auto p : mBlackPieces)
-			if(p->canMove(*this))
+			if(canMove(*p))
 				moves.push_back(p);
 	}
 
 	return moves;
 }
 
+std::vector<Move> BoardState::getLegalMoves() const
+{
+	uint16_t codes[MAX_MOVES];
+	const size_t count = getLegalMoveCodes(codes);
+
+	std::vector<Move> moves;
+	moves.reserve(count);
+	for(size_t i = 0; i < count; ++i)
+		moves.push_back(decodeMove(codes[i]));
+	return moves;
+}
+
+size_t BoardState::getLegalMoveCodes(uint16_t* out) const
+{
+	size_t count = 0;
+	forEachLegalMove(mCurrentPlayer, -1, [&](uint16_t code) {
+		out[count++] = code;
+		return true;
+	});
+	sort(out, out + count);
+	return count;
+}
+
+bool BoardState::hasAnyLegalMove() const
+{
+	return !forEachLegalMove(mCurrentPlayer, -1, [](uint16_t) { return false; });
+}
+
+bool BoardState::canMove(const ChessPiece& piece) const
+{
+	const BoardPosition pos = piece.getBoardPosition();
+	return !forEachLegalMove(piece.getColor(), toSquareIndex(pos), [](uint16_t) { return false; });
+}
+
+int BoardState::mobilityCount(const ChessPiece& piece) const
+{
+	int count = 0;
+	forEachLegalMove(piece.getColor(), toSquareIndex(piece.getBoardPosition()), [&](uint16_t) {
+		++count;
+		return true;
+	});
+	return count;
+}
+
+bool BoardState::isLegal(const Move& m) const
+{
+	if(!m.initial_pos.isOnBoard() || !m.final_pos.isOnBoard())
+		return false;
+	const int from = toSquareIndex(m.initial_pos);
+	const int to = toSquareIndex(m.final_pos);
+	const PieceType type = mBoard[from];
+	const PieceType target = mBoard[to];
+	const bool white = (mCurrentPlayer == ChessPlayer::Color::WHITE);
+	if(from == to || type == PieceType::UNDEFINED || isWhitePieceType(type) != white)
+		return false;
+	if(m.piece && m.piece->getPieceType() != type)
+		return false;
+	if(target != PieceType::UNDEFINED && (isWhitePieceType(target) == white || getPieceKind(target) == KING_KIND))
+		return false;
+
+	const int kind = getPieceKind(type);
+	const int dr = m.final_pos.row - m.initial_pos.row;
+	const int dc = m.final_pos.column - m.initial_pos.column;
+
+	// A pawn reaching the last row must say what it becomes, nothing else may
+	const bool promotes = kind == PAWN_KIND && m.final_pos.row == (white ? Row::EIGHT : Row::ONE);
+	if(promotes != (m.promotion != PieceType::UNDEFINED))
+		return false;
+	if(promotes && (getPieceKind(m.promotion) < QUEEN_KIND || getPieceKind(m.promotion) > KNIGHT_KIND
+			|| isWhitePieceType(m.promotion) != white))
+		return false;
+
+	// Can the piece go there on this board?
+	bool en_passant = false;
+	switch(kind) {
+	case PAWN_KIND: {
+		const int forward = white ? -1 : 1;
+		if(dc == 0) {
+			const bool double_step = dr == 2 * forward && m.initial_pos.row == (white ? Row::TWO : Row::SEVEN)
+					&& mBoard[from + forward * MAX_COL] == PieceType::UNDEFINED;
+			if(target != PieceType::UNDEFINED || (dr != forward && !double_step))
+				return false;
+		} else {
+			if(dr != forward || abs(dc) != 1)
+				return false;
+			if(target == PieceType::UNDEFINED) {
+				if(!(m.final_pos == mEnPassant))
+					return false;
+				en_passant = true;
+			}
+		}
+		break;
+	}
+	case KNIGHT_KIND:
+		if(dr * dr + dc * dc != 5)
+			return false;
+		break;
+	case KING_KIND: {
+		if(dr == 0 && abs(dc) == 2)
+			return from == (white ? 60 : 4) && canCastle(mCurrentPlayer, dc > 0); // E1 or E8
+		if(abs(dr) > 1 || abs(dc) > 1)
+			return false;
+		// The attack maps count the king as a blocker, look at the target without it
+		PieceType board[SQUARE_COUNT];
+		memcpy(board, mBoard, sizeof(board));
+		board[from] = PieceType::UNDEFINED;
+		board[to] = type;
+		return !isAttacked(board, to, !white);
+	}
+	default: {
+		const bool straight = dr == 0 || dc == 0;
+		const bool diagonal = abs(dr) == abs(dc);
+		if(!((straight && kind != BISHOP_KIND) || (diagonal && kind != ROOK_KIND)))
+			return false;
+		const int step = sign(dr) * MAX_COL + sign(dc);
+		for(int sq = from + step; sq != to; sq += step)
+			if(mBoard[sq] != PieceType::UNDEFINED)
+				return false;
+		break;
+	}
+	}
+
+	// Does it leave the king in check?
+	const int own = white ? 0 : 1;
+	const int king = mKingSquare[own];
+	if(en_passant) {
+		// Two pawns leave the row at once, too rare to be worth a shortcut
+		PieceType board[SQUARE_COUNT];
+		memcpy(board, mBoard, sizeof(board));
+		board[m.initial_pos.row * MAX_COL + m.final_pos.column] = PieceType::UNDEFINED;
+		board[from] = PieceType::UNDEFINED;
+		board[to] = type;
+		return !isAttacked(board, king, !white);
+	}
+	if((mPinned[own] >> from & 1) && !isOnRay(king, from, to))
+		return false;
+
+	switch(mAttackCounts[1 - own][king]) {
+	case 0:
+		return true;
+	case 1: {
+		// Capture the checker or step in between
+		uint64_t checkers = findAttackers(mBoard, king);
+		for(; checkers; checkers &= checkers - 1) {
+			const int checker = __builtin_ctzll(checkers);
+			if(isWhitePieceType(mBoard[checker]) != white)
+				return to == checker || isBetween(king, checker, to);
+		}
+		return false;
+	}
+	default:
+		// Only the king can get out of a double check
+		return false;
+	}
+}
+
+uint64_t BoardState::getLegalTargets(int square) const
+{
+	const PieceType type = mBoard[square];
+	if(type == PieceType::UNDEFINED)
+		return 0;
+	const ChessPlayer::Color color = isWhitePieceType(type) ? ChessPlayer::Color::WHITE : ChessPlayer::Color::BLACK;
+	uint64_t targets = 0;
+	forEachLegalMove(color, square, [&](uint16_t code) {
+		targets |= uint64_t(1) << ((code >> 6) & 63);
+		return true;
+	});
+	return targets;
+}
+
+bool BoardState::isSquareAttacked(int square, ChessPlayer::Color by) const
+{
+	return getAttacks(by) >> square & 1;
+}
+
+uint64_t BoardState::attackersOf(int square) const
+{
+	return findAttackers(mBoard, square);
+}
+
+template<typename Visitor>
+bool BoardState::forEachLegalMove(ChessPlayer::Color color, int only_from, Visitor visit) const
+{
+	static const int KNIGHT_DELTAS[8][2] = {
+		{-2,-1}, {-2,1}, {-1,-2}, {-1,2}, {1,-2}, {1,2}, {2,-1}, {2,1}
+	};
+	static const int KING_DELTAS[8][2] = {
+		{-1,-1}, {-1,0}, {-1,1}, {0,-1}, {0,1}, {1,-1}, {1,0}, {1,1}
+	};
+
+	const bool white = (color == ChessPlayer::Color::WHITE);
+	bool stopped = false;
+
+	// Every candidate is tried on a scratch board, restored right after
+	PieceType board[SQUARE_COUNT];
+	memcpy(board, mBoard, sizeof(board));
+	// Only the player to move can capture en passant
+	const int ep_sq = mEnPassant.isOnBoard() && color == mCurrentPlayer ? toSquareIndex(mEnPassant) : -1;
+	const int own = white ? 0 : 1;
+	const bool in_check = mAttacks[1 - own] >> mKingSquare[own] & 1;
+
+	auto add = [&](int from, int to, int promotion_kind) {
+		if(stopped)
+			return;
+		const PieceType type = board[from];
+		const PieceType target = board[to];
+		int captured_sq = to;
+		if(to == ep_sq && getPieceKind(type) == PAWN_KIND)
+			captured_sq = (from / MAX_COL) * MAX_COL + to % MAX_COL;
+		const PieceType captured = board[captured_sq];
+
+		// Out of check, only king moves, pinned pieces and en passant can expose the king
+		if(!in_check && captured_sq == to && getPieceKind(type) != KING_KIND && !(mPinned[own] >> from & 1)) {
+			stopped = !visit(static_cast<uint16_t>(from | (to << 6) | (promotion_kind << 12)));
+			return;
+		}
+
+		board[captured_sq] = PieceType::UNDEFINED;
+		board[to] = type;
+		board[from] = PieceType::UNDEFINED;
+		const int king_sq = getPieceKind(type) == KING_KIND ? to : mKingSquare[white ? 0 : 1];
+		const bool illegal = isAttacked(board, king_sq, !white);
+		board[from] = type;
+		board[to] = target;
+		board[captured_sq] = captured;
+
+		if(!illegal)
+			stopped = !visit(static_cast<uint16_t>(from | (to << 6) | (promotion_kind << 12)));
+	};
+	auto isEnemy = [white](PieceType t) {
+		return t != PieceType::UNDEFINED && isWhitePieceType(t) != white;
+	};
+	auto addRays = [&](int from, int row, int col, int first, int last) {
+		static const int RAYS[8][2] = {
+			{-1,0}, {1,0}, {0,-1}, {0,1}, {-1,-1}, {-1,1}, {1,-1}, {1,1}
+		};
+		for(int d = first; d < last; ++d) {
+			for(int r = row + RAYS[d][0], c = col + RAYS[d][1];
+					r >= 0 && r < MAX_ROW && c >= 0 && c < MAX_COL;
+					r += RAYS[d][0], c += RAYS[d][1]) {
+				const PieceType t = board[r * MAX_COL + c];
+				if(t == PieceType::UNDEFINED) {
+					add(from, r * MAX_COL + c, 0);
+					continue;
+				}
+				if(isEnemy(t))
+					add(from, r * MAX_COL + c, 0);
+				break;
+			}
+		}
+	};
+
+	const int forward = white ? -1 : 1;
+	const int start_row = white ? Row::TWO : Row::SEVEN;
+	const int last_row = white ? Row::EIGHT : Row::ONE;
+
+	const int first = only_from < 0 ? 0 : only_from;
+	const int last = only_from < 0 ? SQUARE_COUNT : only_from + 1;
+	for(int from = first; from < last && !stopped; ++from) {
+		const PieceType type = mBoard[from];
+		if(type == PieceType::UNDEFINED || isWhitePieceType(type) != white)
+			continue;
+		const int row = from / MAX_COL;
+		const int col = from % MAX_COL;
+
+		switch(getPieceKind(type)) {
+		case PAWN_KIND: {
+			const int r = row + forward;
+			auto addPawn = [&](int to) {
+				if(r == last_row) {
+					for(int kind = QUEEN_KIND; kind <= KNIGHT_KIND; ++kind)
+						add(from, to, kind);
+				} else {
+					add(from, to, 0);
+				}
+			};
+			if(board[r * MAX_COL + col] == PieceType::UNDEFINED) {
+				addPawn(r * MAX_COL + col);
+				const int r2 = r + forward;
+				if(row == start_row && board[r2 * MAX_COL + col] == PieceType::UNDEFINED)
+					add(from, r2 * MAX_COL + col, 0);
+			}
+			for(int c = col - 1; c <= col + 1; c += 2) {
+				if(c < 0 || c >= MAX_COL)
+					continue;
+				const int to = r * MAX_COL + c;
+				if(isEnemy(board[to]) || to == ep_sq)
+					addPawn(to);
+			}
+			break;
+		}
+		case KNIGHT_KIND:
+			for(auto& d : KNIGHT_DELTAS) {
+				const int r = row + d[0], c = col + d[1];
+				if(r >= 0 && r < MAX_ROW && c >= 0 && c < MAX_COL) {
+					const PieceType t = board[r * MAX_COL + c];
+					if(t == PieceType::UNDEFINED || isEnemy(t))
+						add(from, r * MAX_COL + c, 0);
+				}
+			}
+			break;
+		case BISHOP_KIND:
+			addRays(from, row, col, 4, 8);
+			break;
+		case ROOK_KIND:
+			addRays(from, row, col, 0, 4);
+			break;
+		case QUEEN_KIND:
+			addRays(from, row, col, 0, 8);
+			break;
+		case KING_KIND:
+			for(auto& d : KING_DELTAS) {
+				const int r = row + d[0], c = col + d[1];
+				if(r >= 0 && r < MAX_ROW && c >= 0 && c < MAX_COL) {
+					const PieceType t = board[r * MAX_COL + c];
+					if(t == PieceType::UNDEFINED || isEnemy(t))
+						add(from, r * MAX_COL + c, 0);
+				}
+			}
+			if(!stopped && canCastle(color, true))
+				stopped = !visit(static_cast<uint16_t>(from | ((from + 2) << 6)));
+			if(!stopped && canCastle(color, false))
+				stopped = !visit(static_cast<uint16_t>(from | ((from - 2) << 6)));
+			break;
+		}
+	}
+	return !stopped;
+}
+
+bool BoardState::isInCheck() const
+{
+	const int color = mCurrentPlayer == ChessPlayer::Color::WHITE ? 0 : 1;
+	return mAttacks[1 - color] >> mKingSquare[color] & 1;
+}
+
+bool BoardState::canCastle(ChessPlayer::Color c, bool king_side) const
+{
+	const bool white = (c == ChessPlayer::Color::WHITE);
+	const int right = white ? (king_side ? WHITE_KING_SIDE : WHITE_QUEEN_SIDE)
+			: (king_side ? BLACK_KING_SIDE : BLACK_QUEEN_SIDE);
+	if(!(mCastlingRights & right))
+		return false;
+
+	const int row = white ? Row::ONE : Row::EIGHT;
+	const int base = row * MAX_COL;
+	if(mBoard[base + E] != makePieceType(KING_KIND, white)
+			|| mBoard[base + (king_side ? H : A)] != makePieceType(ROOK_KIND, white))
+		return false;
+
+	// The squares between king and rook must be empty
+	const int first = king_side ? F : B;
+	const int last = king_side ? G : D;
+	for(int col = first; col <= last; ++col)
+		if(mBoard[base + col] != PieceType::UNDEFINED)
+			return false;
+
+	// The king can not castle out of, through or into check
+	const int step = king_side ? 1 : -1;
+	const uint64_t attacks = mAttacks[white ? 1 : 0];
+	for(int col = E; col != E + 3 * step; col += step)
+		if(attacks >> (base + col) & 1)
+			return false;
+
+	return true;
+}
+
+uint16_t BoardState::encodeMove(const Move& m)
+{
+	const int promotion = (m.promotion == PieceType::UNDEFINED) ? 0 : getPieceKind(m.promotion);
+	return static_cast<uint16_t>(toSquareIndex(m.initial_pos)
+			| (toSquareIndex(m.final_pos) << 6) | (promotion << 12));
+}
+
+Move BoardState::decodeMove(uint16_t code) const
+{
+	const int from = code & 0x3F;
+	const int to = (code >> 6) & 0x3F;
+	const int promotion = code >> 12;
+	auto piece = mSquares[from].getPiece();
+	if(!piece)
+		return Move();
+	return Move(piece, toBoardPosition(to),
+			promotion ? makePieceType(promotion, piece->isWhite()) : PieceType::UNDEFINED);
+}
+
 	void BoardState::capture(shared_ptr<ChessPiece>& hostage)
 	{
 		if(hostage->isWhite()) {
-			auto it =find_if(mWhitePieces.begin(), mWhitePieces.end(), [&](const shared_ptr<ChessPiece>& p) {
-					return p->getBoardPosition() == hostage->getBoardPosition();
-					});
+			auto it =find(mWhitePieces.begin(), mWhitePieces.end(), hostage);
 			mWhitePieces.erase(it);
 			mWhiteHostages.push_back(hostage);
 		}
 		else {
-			auto it = find_if(mBlackPieces.begin(), mBlackPieces.end(), [&](const shared_ptr<ChessPiece>& p) {
-							return p->getBoardPosition() == hostage->getBoardPosition();
-							});
+			auto it = find(mBlackPieces.begin(), mBlackPieces.end(), hostage);
 			mBlackPieces.erase(it);
 			mBlackHostages.push_back(hostage);
 		}
 	}
 
-	void BoardState::moveTo(BoardPosition pos) {
-		if(mSelectedPiece) {
-			BoardSquare& old = getSquareAt(mSelectedPiece->getBoardPosition());
-			auto old_piece = old.removePiece();
+	void BoardState::release(shared_ptr<ChessPiece>& hostage)
+	{
+		auto& hostages = hostage->isWhite() ? mWhiteHostages : mBlackHostages;
+		auto& pieces = hostage->isWhite() ? mWhitePieces : mBlackPieces;
+		assert(!hostages.empty() && hostages.back() == hostage);
+		hostages.pop_back();
+		pieces.push_back(hostage);
+	}
 
-			assert(old_piece->getBoardPosition() == mSelectedPiece->getBoardPosition());
+	void BoardState::putPiece(const shared_ptr<ChessPiece>& piece)
+	{
+		const BoardPosition pos = piece->getBoardPosition();
+		const int sq = toSquareIndex(pos);
+		const PieceType type = piece->getPieceType();
+		mSquares[sq].setPiece(piece);
+		updateRaysThrough(sq, -1);
+		mBoard[sq] = type;
+		mBitboards[static_cast<int>(type)] |= uint64_t(1) << sq;
+		mOccupied |= uint64_t(1) << sq;
+		updateAttacks(sq, type, 1);
+		mHashKey ^= Zobrist::instance().getPieceKey(type, sq);
+		const PieceSquareTable& pst = PieceSquareTable::instance();
+		mPieceSquareScore += pst.getScore(type, sq);
+		mPhase += pst.getPhase(type);
+		if(getPieceKind(type) == KING_KIND)
+			mKingSquare[piece->isWhite() ? 0 : 1] = sq;
+	}
 
-			mSelectedPiece->setPosition(pos);
-			mSelectedPiece->setSelected(false);
+	shared_ptr<ChessPiece> BoardState::takePiece(BoardPosition pos)
+	{
+		const int sq = toSquareIndex(pos);
+		auto piece = mSquares[sq].removePiece();
+		mHashKey ^= Zobrist::instance().getPieceKey(mBoard[sq], sq);
+		const PieceSquareTable& pst = PieceSquareTable::instance();
+		mPieceSquareScore -= pst.getScore(mBoard[sq], sq);
+		mPhase -= pst.getPhase(mBoard[sq]);
+		updateAttacks(sq, mBoard[sq], -1);
+		mBitboards[static_cast<int>(mBoard[sq])] &= ~(uint64_t(1) << sq);
+		mOccupied &= ~(uint64_t(1) << sq);
+		mBoard[sq] = PieceType::UNDEFINED;
+		updateRaysThrough(sq, 1);
+		return piece;
+	}
+
+	void BoardState::changeAttackCount(int color, int square, int delta)
+	{
+		const uint64_t bit = uint64_t(1) << square;
+		const int count = (mAttackCounts[color][square] += delta);
+		mAttacks[color] = (mAttacks[color] & ~bit) | (count ? bit : 0);
+	}
+
+	void BoardState::updateAttacks(int square, PieceType type, int delta)
+	{
+		const bool white = isWhitePieceType(type);
+		const int color = white ? 0 : 1;
+		const int row = square / MAX_COL;
+		const int col = square % MAX_COL;
+		auto attack = [&](int r, int c) {
+			if(isOnBoard(r, c))
+				changeAttackCount(color, r * MAX_COL + c, delta);
+		};
+
+		int first = 0, last = 0; // Slider directions
+		switch(getPieceKind(type)) {
+		case PAWN_KIND:
+			attack(white ? row - 1 : row + 1, col - 1);
+			attack(white ? row - 1 : row + 1, col + 1);
+			break;
+		case KNIGHT_KIND:
+			for(auto& d : KNIGHT_JUMPS)
+				attack(row + d[0], col + d[1]);
+			break;
+		case KING_KIND:
+			for(auto& d : DIRECTIONS)
+				attack(row + d[0], col + d[1]);
+			break;
+		case BISHOP_KIND: first = 4; last = 8; break;
+		case ROOK_KIND: first = 0; last = 4; break;
+		case QUEEN_KIND: first = 0; last = 8; break;
+		}
 
-			BoardSquare& sq = getSquareAt(pos);
-			// Check if we are capturing an enemy piece
-			if(sq.hasPiece() && sq.getPiece()->getColor() != mSelectedPiece->getColor()) {
-				auto captured_piece = sq.removePiece();
-				capture(captured_piece);
+		for(int d = first; d < last; ++d) {
+			for(int r = row + DIRECTIONS[d][0], c = col + DIRECTIONS[d][1]; isOnBoard(r, c);
+					r += DIRECTIONS[d][0], c += DIRECTIONS[d][1]) {
+				changeAttackCount(color, r * MAX_COL + c, delta);
+				if(mBoard[r * MAX_COL + c] != PieceType::UNDEFINED)
+					break;
 			}
-			sq.setPiece(mSelectedPiece);
+		}
+	}
+
+	void BoardState::updateRaysThrough(int square, int delta)
+	{
+		const int row = square / MAX_COL;
+		const int col = square % MAX_COL;
+		for(int d = 0; d < 8; ++d) {
+			const int dr = DIRECTIONS[d][0], dc = DIRECTIONS[d][1];
+			// The first piece behind the square, looking against the direction
+			PieceType slider = PieceType::UNDEFINED;
+			for(int r = row - dr, c = col - dc; isOnBoard(r, c); r -= dr, c -= dc) {
+				slider = mBoard[r * MAX_COL + c];
+				if(slider != PieceType::UNDEFINED)
+					break;
+			}
+			if(slider == PieceType::UNDEFINED || !slidesAlong(slider, d))
+				continue;
+
+			const int color = isWhitePieceType(slider) ? 0 : 1;
+			for(int r = row + dr, c = col + dc; isOnBoard(r, c); r += dr, c += dc) {
+				changeAttackCount(color, r * MAX_COL + c, delta);
+				if(mBoard[r * MAX_COL + c] != PieceType::UNDEFINED)
+					break;
+			}
+		}
+	}
+
+	void BoardState::updatePins()
+	{
+		mPinned[0] = mPinned[1] = 0;
+		for(int color = 0; color < 2; ++color) {
+			const int king = mKingSquare[color];
+			if(mBoard[king] != makePieceType(KING_KIND, color == 0))
+				continue;
+			const int row = king / MAX_COL;
+			const int col = king % MAX_COL;
+			for(int d = 0; d < 8; ++d) {
+				int blocker = -1;
+				for(int r = row + DIRECTIONS[d][0], c = col + DIRECTIONS[d][1]; isOnBoard(r, c);
+						r += DIRECTIONS[d][0], c += DIRECTIONS[d][1]) {
+					const PieceType t = mBoard[r * MAX_COL + c];
+					if(t == PieceType::UNDEFINED)
+						continue;
+					const bool own = isWhitePieceType(t) == (color == 0);
+					if(blocker < 0 && own) {
+						blocker = r * MAX_COL + c;
+						continue;
+					}
+					if(blocker >= 0 && !own && slidesAlong(t, d))
+						mPinned[color] |= uint64_t(1) << blocker;
+					break;
+				}
+			}
+		}
+	}
+
+	void BoardState::doMove(const Move& m, UndoInfo& undo)
+	{
+		const Zobrist& z = Zobrist::instance();
+		const shared_ptr<ChessPiece>& piece = m.piece;
+		const BoardPosition from = piece->getBoardPosition();
+		const BoardPosition to = m.final_pos;
+		const int kind = getPieceKind(piece->getPieceType());
+		const bool white = piece->isWhite();
+
+		undo.captured = nullptr;
+		undo.promoted = nullptr;
+		undo.enPassant = mEnPassant;
+		undo.castlingRights = mCastlingRights;
+		undo.halfmoveClock = mHalfmoveClock;
+		undo.fullmoveNumber = mFullmoveNumber;
+		undo.hashKey = mHashKey;
+
+		// Check if we are capturing an enemy piece, en passant included
+		BoardPosition captured_at = to;
+		if(kind == PAWN_KIND && to == mEnPassant)
+			captured_at = BoardPosition(from.row, to.column);
+		if(mBoard[toSquareIndex(captured_at)] != PieceType::UNDEFINED) {
+			undo.captured = takePiece(captured_at);
+			capture(undo.captured);
+		}
+
+		takePiece(from);
+		piece->setPosition(to);
+		putPiece(piece);
+
+		// Castling also moves the rook
+		if(kind == KING_KIND && abs(to.column - from.column) == 2) {
+			const bool king_side = to.column == Column::G;
+			auto rook = takePiece(BoardPosition(from.row, king_side ? Column::H : Column::A));
+			rook->setPosition(BoardPosition(from.row, king_side ? Column::F : Column::D));
+			putPiece(rook);
+		}
+
+		if(m.promotion != PieceType::UNDEFINED) {
+			takePiece(to);
+			auto& pieces = white ? mWhitePieces : mBlackPieces;
+			pieces.erase(find(pieces.begin(), pieces.end(), piece));
+			undo.promoted = createPromotedPiece(m.promotion, to);
+			pieces.push_back(undo.promoted);
+			putPiece(undo.promoted);
+		}
+
+		mHashKey ^= z.getCastlingKey(mCastlingRights);
+		mCastlingRights &= castlingMask(toSquareIndex(from)) & castlingMask(toSquareIndex(to));
+		mHashKey ^= z.getCastlingKey(mCastlingRights);
+
+		if(mEnPassant.isValid())
+			mHashKey ^= z.getEnPassantKey(mEnPassant.column);
+		mEnPassant = BoardPosition();
+		if(kind == PAWN_KIND && abs(to.row - from.row) == 2) {
+			BoardPosition ep((from.row + to.row) / 2, from.column);
+			if(canCaptureEnPassant(mBoard, ep, !white)) {
+				mEnPassant = ep;
+				mHashKey ^= z.getEnPassantKey(ep.column);
+			}
+		}
+
+		if(kind == PAWN_KIND || undo.captured)
+			mHalfmoveClock = 0;
+		else
+			++mHalfmoveClock;
+
+		updatePins();
+	}
+
+	void BoardState::undoMove(const Move& m, const UndoInfo& undo)
+	{
+		const shared_ptr<ChessPiece>& piece = m.piece;
+		const BoardPosition from = m.initial_pos;
+		const BoardPosition to = m.final_pos;
+
+		if(undo.promoted) {
+			takePiece(to);
+			auto& pieces = piece->isWhite() ? mWhitePieces : mBlackPieces;
+			pieces.erase(find(pieces.begin(), pieces.end(), undo.promoted));
+			pieces.push_back(piece);
+			if(mSparePieces.size() < MAX_SPARE_PIECES)
+				mSparePieces.push_back(undo.promoted);
+		} else {
+			takePiece(to);
+		}
+		piece->setPosition(from);
+		putPiece(piece);
+
+		if(getPieceKind(piece->getPieceType()) == KING_KIND && abs(to.column - from.column) == 2) {
+			const bool king_side = to.column == Column::G;
+			auto rook = takePiece(BoardPosition(from.row, king_side ? Column::F : Column::D));
+			rook->setPosition(BoardPosition(from.row, king_side ? Column::H : Column::A));
+			putPiece(rook);
+		}
+
+		if(undo.captured) {
+			shared_ptr<ChessPiece> captured = undo.captured;
+			release(captured);
+			putPiece(captured);
+		}
+
+		mEnPassant = undo.enPassant;
+		mCastlingRights = undo.castlingRights;
+		mHalfmoveClock = undo.halfmoveClock;
+		mFullmoveNumber = undo.fullmoveNumber;
+		mHashKey = undo.hashKey;
+		updatePins();
+	}
+
+	void BoardState::makeMove(const Move& m, UndoInfo& undo)
+	{
+		doMove(m, undo);
+		switchPlayer();
+		mHistory.push_back(mHashKey);
+	}
+
+	void BoardState::unmakeMove(const Move& m, const UndoInfo& undo)
+	{
+		assert(mHistory.size() > 1);
+		mHistory.pop_back();
+		switchPlayer();
+		undoMove(m, undo);
+	}
+
+	void BoardState::moveTo(BoardPosition pos) {
+		if(mSelectedPiece) {
+			// A pawn reaching the last row is always promoted to a queen
+			PieceType promotion = PieceType::UNDEFINED;
+			if(getPieceKind(mSelectedPiece->getPieceType()) == PAWN_KIND
+					&& (pos.row == Row::EIGHT || pos.row == Row::ONE))
+				promotion = makePieceType(QUEEN_KIND, mSelectedPiece->isWhite());
+
+			UndoInfo undo;
+			mSelectedPiece->setSelected(false);
+			makeMove(Move(mSelectedPiece, pos, promotion), undo);
 
 			mSelectedPiece.reset();
 		}
@@ -356,16 +1594,27 @@ std::vector<std::shared_ptr<ChessPiece>> BoardState::getPiecesThatCanBeMoved() c
     void BoardState::switchPlayer() {
         if(mCurrentPlayer == ChessPlayer::Color::WHITE)
             mCurrentPlayer = ChessPlayer::Color::BLACK;
-        else if(mCurrentPlayer == ChessPlayer::Color::BLACK)
+        else if(mCurrentPlayer == ChessPlayer::Color::BLACK) {
             mCurrentPlayer = ChessPlayer::Color::WHITE;
+            ++mFullmoveNumber;
+        }
+
+        mHashKey ^= Zobrist::instance().getSideKey();
+    }
 
+    void BoardState::setCurrentPlayer(ChessPlayer::Color c) {
+        if(c != mCurrentPlayer)
+            mHashKey ^= Zobrist::instance().getSideKey();
+        mCurrentPlayer = c;
+        if(!mHistory.empty())
+            mHistory.back() = mHashKey;
     }
 
-    bool BoardState::isGameInProgress() {
+    bool BoardState::isGameInProgress() const {
         return mGameInProgress;
     }
 
-    std::shared_ptr<ChessPiece> BoardState::getSelectedPiece() {
+    std::shared_ptr<ChessPiece> BoardState::getSelectedPiece() const {
     	return mSelectedPiece;
     }
 } /* namespace sch */
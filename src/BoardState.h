@@ -33,15 +33,57 @@
 
 #include <vector>
 #include <memory>
+#include <string>
+#include <cstdint>
 #include <assert.h>
 #include "ChessPiece.h"
 #include "ChessPlayer.h"
+#include "Evaluation.h"
 
 namespace sch {
 
+/// Whether a game can go on, and why not.
+enum class GameStatus {
+	IN_PROGRESS,
+	CHECKMATE,
+	STALEMATE,
+	FIFTY_MOVE_RULE,
+	THREEFOLD_REPETITION,
+	INSUFFICIENT_MATERIAL
+};
+
+/// "Checkmate", "Fifty-move rule", ...
+const char* toString(GameStatus status);
+
 class BoardState {
 	friend class BoardController;
 public:
+	/// Bit mask values for the castling rights still available.
+	enum CastlingRight {
+		WHITE_KING_SIDE = 1,
+		WHITE_QUEEN_SIDE = 2,
+		BLACK_KING_SIDE = 4,
+		BLACK_QUEEN_SIDE = 8,
+		ALL_CASTLING_RIGHTS = 15
+	};
+
+	/// Everything makeMove() changes that unmakeMove() cannot work out from the Move.
+	struct UndoInfo {
+		std::shared_ptr<ChessPiece> captured; //!< Null when nothing was captured
+		std::shared_ptr<ChessPiece> promoted; //!< The piece a pawn became, if any
+		BoardPosition enPassant;
+		int castlingRights;
+		int halfmoveClock;
+		int fullmoveNumber;
+		uint64_t hashKey;
+	};
+
+	/// Forsyth-Edwards Notation of the initial position.
+	static const char* const START_FEN;
+
+	/// Room needed by writeFEN(), terminating null included.
+	static const size_t MAX_FEN_LENGTH = 128;
+
 	BoardState();
 	BoardState(const BoardState& rhs);
 	BoardState(BoardState&& rhs);
@@ -63,6 +105,32 @@ public:
 	/// Returns true if the current state is a stalemate
 	bool isStalemate() const;
 
+	/**
+	 * How many times the current position was reached before with the same
+	 * player to move, castling rights and en passant square. Every position
+	 * since loadFEN() is remembered, but only those since the last capture or
+	 * pawn move are looked at.
+	 */
+	int getRepetitionCount() const;
+
+	/// True when the position was reached before, enough for a search to call it a draw.
+	bool isRepetition() const { return getRepetitionCount() > 0; }
+
+	/// The hash key of every position since loadFEN(), the current one last.
+	const std::vector<uint64_t>& getHistory() const { return mHistory; }
+
+	/**
+	 * True when neither side can mate whatever happens: kings alone, with a
+	 * single knight or bishop, or with bishops all on squares of one color.
+	 */
+	bool isInsufficientMaterial() const;
+
+	/// Checkmate and stalemate first, then the draws, in constant time but for the repetition scan.
+	GameStatus getGameStatus() const;
+
+	/// The same, for a caller that already knows whether the side to move has a legal move.
+	GameStatus getGameStatus(bool has_legal_move) const;
+
 	/**
 	 * This method checks the current state of the game and returns a vector
 	 * with only the ChessPieces that can be moved right now.
@@ -73,7 +141,156 @@ public:
 	std::vector<std::shared_ptr<ChessPiece>> getPiecesThatCanBeMoved() const;
 
 	/**
-	 * Moves the current selected piece to the BoardPosition pos.
+	 * Every legal move of the current player: castling, en passant and one
+	 * Move per promotion piece included, and no move that leaves the own king
+	 * in check.
+	 */
+	std::vector<Move> getLegalMoves() const;
+
+	/// More than the legal moves of any chess position.
+	static const size_t MAX_MOVES = 256;
+
+	/**
+	 * Writes the encodeMove() code of every legal move of the current player
+	 * to @b out, which must have room for MAX_MOVES codes, sorted in
+	 * increasing order. It works on the piece types alone and is the fast
+	 * path behind getLegalMoves().
+	 *
+	 * @return The number of legal moves.
+	 */
+	size_t getLegalMoveCodes(uint16_t* out) const;
+
+	/// Returns true if the king of the current player is attacked.
+	bool isInCheck() const;
+
+	/**
+	 * Returns true when @b m, which may come from anywhere (another engine,
+	 * the network, a hash table), is a legal move of the current player in
+	 * this position. Only the squares and the promotion of @b m are looked
+	 * at, plus the type of its piece when it has one.
+	 *
+	 * It reads the attack maps and pin masks instead of generating moves, so
+	 * it takes constant time. Pass decodeMove(encodeMove(m)) to makeMove()
+	 * when @b m names a piece of another BoardState.
+	 */
+	bool isLegal(const Move& m) const;
+
+	/*
+	 * Queries answered straight from the board, without building move lists.
+	 * Those about moves stop at the first legal move when that settles the
+	 * answer.
+	 */
+
+	/// True when the current player has at least one legal move.
+	bool hasAnyLegalMove() const;
+
+	/// True when @b piece, of either color, has a legal move as if it were its turn.
+	bool canMove(const ChessPiece& piece) const;
+
+	/// The number of legal moves of @b piece as if it were its turn, one per promotion piece.
+	int mobilityCount(const ChessPiece& piece) const;
+
+	/**
+	 * The squares the piece on @b square can legally move to as if it were
+	 * its turn, bit n for square n; 0 for an empty square.
+	 */
+	uint64_t getLegalTargets(int square) const;
+
+	/// True when a piece of color @b by attacks @b square (see toSquareIndex).
+	bool isSquareAttacked(int square, ChessPlayer::Color by) const;
+
+	/*
+	 * The attack maps below are kept up to date on every move: placing or
+	 * removing a piece only updates its own attacks and the slider rays
+	 * passing through its square. Reading them takes constant time.
+	 */
+
+	/// Every square attacked by the pieces of color @b c, bit n for square n.
+	uint64_t getAttacks(ChessPlayer::Color c) const {
+		return mAttacks[c == ChessPlayer::Color::WHITE ? 0 : 1];
+	}
+
+	/// How many pieces of color @b c attack @b square.
+	int getAttackerCount(int square, ChessPlayer::Color c) const {
+		return mAttackCounts[c == ChessPlayer::Color::WHITE ? 0 : 1][square];
+	}
+
+	/**
+	 * The pieces of color @b c that stand between their king and an enemy
+	 * slider, and may only move along that line. Updated after every move.
+	 */
+	uint64_t getPinnedPieces(ChessPlayer::Color c) const {
+		return mPinned[c == ChessPlayer::Color::WHITE ? 0 : 1];
+	}
+
+	/**
+	 * The pieces of both colors attacking @b square, as a mask with bit n set
+	 * for a piece on square n. Pinned pieces count as attackers.
+	 */
+	uint64_t attackersOf(int square) const;
+
+	/**
+	 * Returns true when the king of color @b c can castle right now: the right
+	 * was not lost, the squares between king and rook are empty and the king
+	 * does not start, pass or end on an attacked square.
+	 */
+	bool canCastle(ChessPlayer::Color c, bool king_side) const;
+
+	/**
+	 * Plays @b m, which must be a legal move of the current player, and
+	 * switches the current player. Everything needed to take the move back
+	 * is stored in @b undo.
+	 */
+	void makeMove(const Move& m, UndoInfo& undo);
+
+	/// Takes back @b m, which must be the last move played with makeMove().
+	void unmakeMove(const Move& m, const UndoInfo& undo);
+
+	/**
+	 * Sets up the position described by the Forsyth-Edwards Notation string
+	 * @b fen. The castling, en passant and move counter fields are optional.
+	 *
+	 * The text is parsed in place and the ChessPiece objects already owned by
+	 * this BoardState are reused, so loading positions over and over does
+	 * not allocate memory.
+	 *
+	 * @throw FENException When @b fen is malformed or the position cannot
+	 * happen: not one king per side, more than 16 pieces of a color, a pawn
+	 * on the first or last rank, or the side not to move in check. The
+	 * BoardState is left untouched in that case.
+	 */
+	void loadFEN(const char* fen, size_t length);
+
+	void loadFEN(const std::string& fen) { loadFEN(fen.data(), fen.size()); }
+
+	/// A new BoardState in the position @b fen, see loadFEN().
+	static BoardState fromFEN(const std::string& fen);
+
+	/**
+	 * Writes the Forsyth-Edwards Notation of the position to @b out, which
+	 * must have room for MAX_FEN_LENGTH characters.
+	 *
+	 * The en passant square is only written when a capture there is
+	 * possible, the same convention getEnPassantSquare() follows.
+	 *
+	 * @return The length of the FEN, not counting the terminating null.
+	 */
+	size_t writeFEN(char* out) const;
+
+	std::string toFEN() const;
+
+	/**
+	 * Packs the squares and promotion of @b m into 16 bits, handy to store
+	 * moves in tables shared between BoardStates.
+	 */
+	static uint16_t encodeMove(const Move& m);
+
+	/// Returns the Move encoded by encodeMove() for a piece of this BoardState.
+	Move decodeMove(uint16_t code) const;
+
+	/**
+	 * Moves the current selected piece to the BoardPosition pos, and gives
+	 * the turn to the other player like makeMove().
 	 *
 	 * If there is an opponent's piece it will be captured.
 	 */
@@ -97,9 +314,52 @@ public:
 
 	ChessPlayer::Color getCurrentPlayer() const { return mCurrentPlayer; }
 
-    bool isGameInProgress();
+	/**
+	 * The Zobrist hash of the current position: piece placement and side to
+	 * move. It is kept up to date incrementally on every move.
+	 */
+	uint64_t getHashKey() const { return mHashKey; }
+
+	/**
+	 * The material and piece-square values (see PieceSquareTable) of the
+	 * white pieces minus those of the black pieces. Like the hash key it is
+	 * kept up to date on every move.
+	 */
+	const TaperedScore& getPieceSquareScore() const { return mPieceSquareScore; }
+
+	/// MAX_PHASE (see EvalWeights.h) at the start of a game, down to 0 with only kings and pawns left.
+	int getPhase() const { return mPhase; }
+
+	/// The castling rights still available, a mask of CastlingRight values.
+	int getCastlingRights() const { return mCastlingRights; }
+
+	/**
+	 * The square a pawn just jumped over, valid only when the current player
+	 * has a pawn that can capture there en passant.
+	 */
+	BoardPosition getEnPassantSquare() const { return mEnPassant; }
+
+	/// Moves since the last capture or pawn move, for the fifty-move rule.
+	int getHalfmoveClock() const { return mHalfmoveClock; }
+
+	int getFullmoveNumber() const { return mFullmoveNumber; }
 
-    std::shared_ptr<ChessPiece> getSelectedPiece();
+	/// The type of the piece at @b square (see toSquareIndex), UNDEFINED if empty.
+	PieceType getPieceTypeAt(int square) const { return mBoard[square]; }
+
+	/// The squares of the pieces of @b type, bit n for square n.
+	uint64_t getPieceBitboard(PieceType type) const { return mBitboards[static_cast<int>(type)]; }
+
+	/// The squares with a piece of any color.
+	uint64_t getOccupied() const { return mOccupied; }
+
+	BoardPosition getKingPosition(ChessPlayer::Color c) const {
+		return toBoardPosition(mKingSquare[c == ChessPlayer::Color::WHITE ? 0 : 1]);
+	}
+
+    bool isGameInProgress() const;
+
+    std::shared_ptr<ChessPiece> getSelectedPiece() const;
 
     ChessPlayer::Color getCurrentPlayer() { return mCurrentPlayer; }
 private:
@@ -115,6 +375,11 @@ private:
 	/// Black pieces captured by white player
 	std::vector<std::shared_ptr<ChessPiece>> mBlackHostages;
 
+	/// Pieces of promotions taken back, reused by the next promotions
+	/// so that searching them does not allocate.
+	std::vector<std::shared_ptr<ChessPiece>> mSparePieces;
+	static const size_t MAX_SPARE_PIECES = 32;
+
 	/// The current selected ChessPiece
 	std::shared_ptr<ChessPiece> mSelectedPiece;
 
@@ -124,6 +389,38 @@ private:
 	ChessPlayer::Color mCurrentPlayer;
     bool mGameInProgress;
 
+	uint64_t mHashKey;
+
+	TaperedScore mPieceSquareScore;
+	int mPhase;
+
+	static const int PIECE_TYPES = static_cast<int>(PieceType::UNDEFINED);
+
+	/// The type of the piece on every square, mirrors mSquares for quick lookups.
+	PieceType mBoard[SQUARE_COUNT];
+
+	/// The same placement as mBoard, one bitboard per PieceType.
+	uint64_t mBitboards[PIECE_TYPES];
+	uint64_t mOccupied;
+
+	/// Where the white [0] and black [1] kings are.
+	int mKingSquare[2];
+
+	/// White [0] and black [1] attackers of every square.
+	uint8_t mAttackCounts[2][SQUARE_COUNT];
+	/// The squares with an attacker in mAttackCounts.
+	uint64_t mAttacks[2];
+	/// Pieces pinned to the white [0] and black [1] king.
+	uint64_t mPinned[2];
+
+	int mCastlingRights;
+	BoardPosition mEnPassant;
+	int mHalfmoveClock;
+	int mFullmoveNumber;
+
+	/// The hash key of every position since loadFEN(), the current one last.
+	std::vector<uint64_t> mHistory;
+
     /**
 	 * The ChessPiece pointed to by hostage is removed from the vector of
 	 * currently active pieces and added to the captured vector
@@ -136,6 +433,9 @@ private:
 	 */
 	void capture(std::shared_ptr<ChessPiece>& hostage); // method accessed by BoardController because it's a friend
 
+	/// Puts back in play the last piece captured with capture().
+	void release(std::shared_ptr<ChessPiece>& hostage);
+
 	void switchPlayer(); // method accessed by BoardController because it's a friend
 
 	void setGameInProgress(bool in_progress=true) {mGameInProgress=in_progress;} // method accessed by BoardController because it's a friend
@@ -144,16 +444,54 @@ private:
 	void initBlackPieces();
 	void initSquares();
 
-	/// Every square in the board can point to a ChessPiece.
+	/// Every square in the board can point to a ChessPiece. The score is computed from scratch.
 	void bindPiecesToSquares();
 	void reset();
 
-	void setCurrentPlayer(ChessPlayer::Color c) { mCurrentPlayer = c; }
+	void setCurrentPlayer(ChessPlayer::Color c);
+
+	/// Computes the hash key from scratch, used after (re)building the board.
+	uint64_t computeHashKey() const;
 
 	void copy(const BoardState& rhs);
 	std::shared_ptr<ChessPiece>  copyPiece(std::shared_ptr<ChessPiece> piece);
+	static std::shared_ptr<ChessPiece> createPiece(PieceType type, BoardPosition pos);
+	/// Like createPiece(), but takes a spare piece when there is one.
+	std::shared_ptr<ChessPiece> createPromotedPiece(PieceType type, BoardPosition pos);
 
 	BoardSquare& getSquareAt(BoardPosition pos);
+
+	/// Places @b piece on its square, keeping mBoard, the hash key and the score in sync.
+	void putPiece(const std::shared_ptr<ChessPiece>& piece);
+
+	/// Removes the piece at @b pos from its square, keeping mBoard, the hash key and the score in sync.
+	std::shared_ptr<ChessPiece> takePiece(BoardPosition pos);
+
+	/**
+	 * Calls @b visit with the encodeMove() code of every legal move of the
+	 * pieces of @b color, only those on square @b only_from unless it is -1,
+	 * until @b visit returns false.
+	 *
+	 * @return False when @b visit stopped the walk.
+	 */
+	template<typename Visitor>
+	bool forEachLegalMove(ChessPlayer::Color color, int only_from, Visitor visit) const;
+
+	void changeAttackCount(int color, int square, int delta);
+	/// Adds @b delta to the counts of the squares a piece of @b type on @b square attacks.
+	void updateAttacks(int square, PieceType type, int delta);
+	/**
+	 * Adds @b delta to the counts of the squares beyond @b square for every
+	 * slider whose ray reaches it: -1 when a piece is put there and blocks
+	 * them, 1 when it is taken away.
+	 */
+	void updateRaysThrough(int square, int delta);
+	/// Finds the pinned pieces of both colors from scratch.
+	void updatePins();
+
+	/// Moves the pieces, updates castling rights, en passant and the clocks, but not the player.
+	void doMove(const Move& m, UndoInfo& undo);
+	void undoMove(const Move& m, const UndoInfo& undo);
 };
 
 } /* namespace sch */
@@ -0,0 +1,128 @@
+//===-- smart-chess/BoardTraits.h -------------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file BoardTraits.h
+/// \brief Compile time interface between the engine algorithms and a board representation.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef BOARDTRAITS_H_
+#define BOARDTRAITS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include "BoardState.h"
+#include "Evaluation.h"
+
+namespace sch {
+
+/**
+ * How the templated algorithms (perft() and BasicSearch) talk to a board
+ * backend, so that different board representations run exactly the same
+ * code on top of them.
+ *
+ * Moves are always the 16 bit codes of BoardState::encodeMove(). By default
+ * the traits forward to members of @b Board, which must provide:
+ *
+ *  - A copyable @b Undo type with whatever unmakeMove() needs.
+ *  - static const char* getName();
+ *  - void load(const BoardState& state);
+ *  - size_t getLegalMoves(uint16_t* out) const; room for BoardState::MAX_MOVES
+ *  - void makeMove(uint16_t code, Undo& undo);
+ *  - void unmakeMove(uint16_t code, const Undo& undo);
+ *  - bool isInCheck() const;
+ *  - int evaluate() const; same score as sch::evaluate()
+ *  - PieceType getPieceTypeAt(int square) const;
+ *  - int getKingSquare(bool white) const;
+ *  - bool isWhiteToMove() const;
+ *  - int getHalfmoveClock() const;
+ *  - uint64_t getHashKey() const; the same key as BoardState::getHashKey()
+ *
+ * A class with a different interface gets a specialization instead, as
+ * BoardState has below. The GUI and the players hold BoardState objects;
+ * which backend their Search runs on is chosen by the Search typedef.
+ */
+template<typename Board>
+struct BoardTraits {
+	typedef typename Board::Undo Undo;
+
+	static const char* getName() { return Board::getName(); }
+	static void load(Board& board, const BoardState& state) { board.load(state); }
+	static size_t getLegalMoves(const Board& board, uint16_t* out) { return board.getLegalMoves(out); }
+	static void makeMove(Board& board, uint16_t code, Undo& undo) { board.makeMove(code, undo); }
+	static void unmakeMove(Board& board, uint16_t code, const Undo& undo) { board.unmakeMove(code, undo); }
+	static bool isInCheck(const Board& board) { return board.isInCheck(); }
+	static int evaluate(const Board& board) { return board.evaluate(); }
+	static PieceType getPieceTypeAt(const Board& board, int square) { return board.getPieceTypeAt(square); }
+	static int getKingSquare(const Board& board, bool white) { return board.getKingSquare(white); }
+	static bool isWhiteToMove(const Board& board) { return board.isWhiteToMove(); }
+	static int getHalfmoveClock(const Board& board) { return board.getHalfmoveClock(); }
+	static uint64_t getHashKey(const Board& board) { return board.getHashKey(); }
+};
+
+/**
+ * The BoardState itself: a vector of squares pointing to ChessPiece objects,
+ * kept in sync with a mailbox, bitboards and attack maps.
+ */
+template<>
+struct BoardTraits<BoardState> {
+	/// unmakeMove() needs the Move, and a promoted pawn is no longer on the board.
+	struct Undo {
+		BoardState::UndoInfo info;
+		Move move;
+	};
+
+	static const char* getName() { return "boardstate"; }
+	static void load(BoardState& board, const BoardState& state) { board = state; }
+	static size_t getLegalMoves(const BoardState& board, uint16_t* out) { return board.getLegalMoveCodes(out); }
+
+	static void makeMove(BoardState& board, uint16_t code, Undo& undo) {
+		undo.move = board.decodeMove(code);
+		board.makeMove(undo.move, undo.info);
+	}
+
+	static void unmakeMove(BoardState& board, uint16_t, const Undo& undo) {
+		board.unmakeMove(undo.move, undo.info);
+	}
+
+	static bool isInCheck(const BoardState& board) { return board.isInCheck(); }
+	static int evaluate(const BoardState& board) { return sch::evaluate(board); }
+	static PieceType getPieceTypeAt(const BoardState& board, int square) { return board.getPieceTypeAt(square); }
+
+	static int getKingSquare(const BoardState& board, bool white) {
+		return toSquareIndex(board.getKingPosition(white ? ChessPlayer::Color::WHITE : ChessPlayer::Color::BLACK));
+	}
+
+	static bool isWhiteToMove(const BoardState& board) {
+		return board.getCurrentPlayer() == ChessPlayer::Color::WHITE;
+	}
+
+	static int getHalfmoveClock(const BoardState& board) { return board.getHalfmoveClock(); }
+	static uint64_t getHashKey(const BoardState& board) { return board.getHashKey(); }
+};
+
+} /* namespace sch */
+
+#endif /* BOARDTRAITS_H_ */
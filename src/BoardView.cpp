@@ -29,6 +29,8 @@
 //===----------------------------------------------------------------------===//
 #include "BoardView.h"
 #include "BoardController.h"
+#include "ImageLoader.h"
+#include <gdkmm/general.h>
 #include <iostream>
 #include <assert.h>
 
@@ -87,7 +89,7 @@ BoardPosition BoardView::calculateBoardPosition(double x, double y)
 
 bool BoardView::clickReleased(GdkEventButton* event)
 {
-	if(false == mCurrentState.isGameInProgress())
+	if(!mSnapshot || false == mSnapshot->isGameInProgress())
 		return false;
 
     if(event->button == 1)  {// 1 is left mouse
@@ -211,18 +213,17 @@ void BoardView::drawSquares(const Cairo::RefPtr<Cairo::Context>& ctx,
 	}
 }
 
-void BoardView::drawPiece(const Cairo::RefPtr<Cairo::Context>& ctx, const ChessPiece& p)
+void BoardView::drawPiece(const Cairo::RefPtr<Cairo::Context>& ctx, PieceType type, BoardPosition pos)
 {
 	ctx->save();
-	auto image = ImageLoader::instance().getImage(p.getPieceType());
+	auto image = ImageLoader::instance().getImage(type);
 	image = image->scale_simple(mSquareWidth, mSquareHeight, Gdk::InterpType::INTERP_HYPER);
-	BoardPosition pos = p.getBoardPosition();
 	Gdk::Cairo::set_source_pixbuf(ctx, image, (BORDER_WIDTH/2) + mSquareWidth*pos.column, (BORDER_WIDTH/2) + mSquareHeight*pos.row);
 	ctx->save();
 	ctx->paint();
 	ctx->restore();
 
-	if(p.isSelected()) {
+	if(pos == mSnapshot->getSelectedPosition()) {
 		// Draw a fancy blue square when the piece is selected
 		const double LINE_W = 8.0;
 		const double orig_x = (BORDER_WIDTH/2) + mSquareWidth*pos.column + (LINE_W/2);
@@ -239,7 +240,7 @@ void BoardView::drawPiece(const Cairo::RefPtr<Cairo::Context>& ctx, const ChessP
 		ctx->stroke();
 		ctx->restore();
 		// draw the possible squares that this piece can move to
-		vector<BoardPosition> options = p.getPossibleMoves(mCurrentState);
+		vector<BoardPosition> options = mSnapshot->getMoves(pos);
 
 		ctx->set_source_rgba(0, 0.0, 0.9, 0.75);
 		for(BoardPosition p : options) {
@@ -259,11 +260,11 @@ void BoardView::drawPiece(const Cairo::RefPtr<Cairo::Context>& ctx, const ChessP
 	ctx->restore();
 }
 
-void BoardView::force_redraw(const BoardState &ptr) {
+void BoardView::force_redraw(std::shared_ptr<const PositionSnapshot> snapshot) {
 	Glib::RefPtr<Gdk::Window> win = get_window();
 	if (win)
 	{
-        mCurrentState = ptr;
+        mSnapshot = snapshot;
 		Gdk::Rectangle r(0, 0, get_allocation().get_width(), get_allocation().get_height());
 		win->invalidate_rect(r, false);
 	}
@@ -277,59 +278,15 @@ bool BoardView::on_draw(const Cairo::RefPtr<Cairo::Context>& ctx) {
 	drawBorders(ctx, mBoardWidth, mBoardHeight);
 	drawSquares(ctx, mBoardWidth, mBoardHeight);
 
-	if(mCurrentState.isGameInProgress()) {
-		auto black_pieces = mCurrentState.getBlackPieces();
-		for(auto p : black_pieces)
-			drawPiece(ctx, *p);
-
-		auto white_pieces = mCurrentState.getWhitePieces();
-		for(auto p : white_pieces)
-			drawPiece(ctx, *p);
+	if(mSnapshot && mSnapshot->isGameInProgress()) {
+		for(int sq = 0; sq < SQUARE_NUM * SQUARE_NUM; ++sq) {
+			const PieceType type = mSnapshot->getPieceTypeAt(sq);
+			if(type != PieceType::UNDEFINED)
+				drawPiece(ctx, type, toBoardPosition(sq));
+		}
 	}
 
 	return true;
 }
 
-std::ostream& operator <<(std::ostream& os, Row r)
-{
-	switch (r) {
-	case Row::ONE: os << 1; break;
-	case Row::TWO: os << 2; break;
-	case Row::THREE: os << 3; break;
-	case Row::FOUR: os << 4; break;
-	case Row::FIVE: os << 5; break;
-	case Row::SIX: os << 6; break;
-	case Row::SEVEN: os << 7; break;
-	case Row::EIGHT: os << 8; break;
-	default:
-		os << "<Invalid BoardRow(" << int(r) << ")>";
-		break;
-	}
-	return os;
-}
-std::ostream& operator <<(std::ostream& os, Column c)
-{
-	switch(c) {
-	case Column::A: os << "A"; break;
-	case Column::B: os << "B"; break;
-	case Column::C: os << "C"; break;
-	case Column::D: os << "D"; break;
-	case Column::E: os << "E"; break;
-	case Column::F: os << "F"; break;
-	case Column::G: os << "G"; break;
-	case Column::H: os << "H"; break;
-	default:
-		os << "<Invalid BoardColumn(" << int(c) << ")>";
-		break;
-	}
-	return os;
-}
-
-std::ostream& operator <<(std::ostream& os, Move m)
-{
-	os << "Move : "<<m.piece->getPieceType() << " to "
-		<< m.final_pos.column << m.final_pos.row << endl;
-	return os;
-}
-
 } /* namespace sch */
@@ -33,7 +33,7 @@
 
 #include <gtkmm/drawingarea.h>
 #include "Util.h"
-#include "BoardState.h"
+#include "PositionSnapshot.h"
 
 namespace sch {
 
@@ -50,7 +50,8 @@ public:
 
 	sigc::signal<void, BoardPosition> signalClickedReleased();
 
-	void force_redraw(const BoardState &ptr);
+	/// Draws @b snapshot from now on, the view keeps a reference instead of a copy.
+	void force_redraw(std::shared_ptr<const PositionSnapshot> snapshot);
 private:
 	static const int SQUARE_NUM = 8;
 	static const int MIN_BOARD_W = 400;
@@ -61,7 +62,8 @@ private:
 	int mBoardHeight;
 	int mSquareWidth;
 	int mSquareHeight;
-    BoardState mCurrentState;
+    /// What is drawn, null until the first update.
+    std::shared_ptr<const PositionSnapshot> mSnapshot;
 
     sigc::signal<void, BoardPosition> mSignalClickReleased;
 
@@ -72,7 +74,7 @@ private:
 
 	bool clickReleased(GdkEventButton* event);
 
-	void drawPiece(const Cairo::RefPtr<Cairo::Context>& ctx, const ChessPiece& p);
+	void drawPiece(const Cairo::RefPtr<Cairo::Context>& ctx, PieceType type, BoardPosition pos);
 
 
 	BoardPosition calculateBoardPosition(double x, double y);
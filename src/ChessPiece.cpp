@@ -59,7 +59,7 @@ std::ostream& operator << (std::ostream& os, PieceType t)
 
     ChessPiece::ChessPiece(BoardPosition p, PieceType color)
             : mPieceType(color),  mPosition(p),
-              mSelected(false), mMovedOnce(false) {
+              mSelected(false) {
 
     }
 
@@ -80,7 +80,6 @@ void ChessPiece::copy(const ChessPiece& rhs) {
 	mPieceType = rhs.mPieceType;
 	mPosition = rhs.mPosition;
 	mSelected = rhs.mSelected;
-	mMovedOnce = rhs.mMovedOnce;
 }
 
 bool ChessPiece::isWhite() const{
@@ -101,13 +100,17 @@ bool ChessPiece::isBlack() const{
 	return !isWhite();
 }
 
-ChessPlayer::Color ChessPiece::getColor() {
+ChessPlayer::Color ChessPiece::getColor() const {
 	if(isWhite())
 		return ChessPlayer::Color::WHITE;
 	else
 		return ChessPlayer::Color::BLACK;
 }
 
+bool ChessPiece::canMove(const BoardState& s) const {
+	return s.canMove(*this);
+}
+
 std::vector<BoardPosition> ChessPiece::getHorizontalVerticalMoves(const BoardState& s) const {
 	vector<BoardPosition> moves;
 	BoardPosition current = getBoardPosition();
@@ -256,6 +259,12 @@ vector<BoardPosition> King::getPossibleMoves(const BoardState& s) const {
 			moves.push_back(p8);
 	}
 
+	// Castling is reported as the two squares move of the king
+	if(s.canCastle(getColor(), true))
+		moves.push_back(BoardPosition(p0.row, Column::G));
+	if(s.canCastle(getColor(), false))
+		moves.push_back(BoardPosition(p0.row, Column::C));
+
 	return moves;
 }
 
@@ -343,12 +352,18 @@ vector<BoardPosition> Pawn::getPossibleMoves(const BoardState& s) const {
 	else
 		direction = 1;
 	BoardPosition pos = getBoardPosition();
+	// A pawn in its initial row has not been moved yet
+	const Row initial_row = isWhite() ? Row::TWO : Row::SEVEN;
+	// The en passant square only concerns the pawns of the side to capture
+	BoardPosition en_passant = s.getEnPassantSquare();
+	if(en_passant.isValid() && en_passant.row != (isWhite() ? Row::SIX : Row::THREE))
+		en_passant = BoardPosition();
 
 	BoardPosition pos_1(Row(pos.row + direction), pos.column);
-	if(s.hasPieceAt(pos_1) == false) {
+	if(pos_1.isOnBoard() && s.hasPieceAt(pos_1) == false) {
 		moves.push_back(pos_1);
 
-		if(!mMovedOnce) {
+		if(pos.row == initial_row) {
 			BoardPosition pos_2(Row(pos.row + (direction*2)), pos.column);
 			if(s.hasPieceAt(pos_2) == false)
 				moves.push_back(pos_2);
@@ -356,12 +371,18 @@ vector<BoardPosition> Pawn::getPossibleMoves(const BoardState& s) const {
 	}
 
 	BoardPosition pos_3(Row(pos.row + direction), Column(pos.column-1));
-	if(s.hasPieceAt(pos_3) && isWhite() != s.getPieceAt(pos_3)->isWhite())
-		moves.push_back(pos_3);
+	if(pos_3.isOnBoard()) {
+		if((s.hasPieceAt(pos_3) && isWhite() != s.getPieceAt(pos_3)->isWhite())
+				|| pos_3 == en_passant)
+			moves.push_back(pos_3);
+	}
 
 	BoardPosition pos_4(Row(pos.row + direction), Column(pos.column+1));
-	if(s.hasPieceAt(pos_4) && isWhite() != s.getPieceAt(pos_4)->isWhite())
-		moves.push_back(pos_4);
+	if(pos_4.isOnBoard()) {
+		if((s.hasPieceAt(pos_4) && isWhite() != s.getPieceAt(pos_4)->isWhite())
+				|| pos_4 == en_passant)
+			moves.push_back(pos_4);
+	}
 
 	return moves;
 }
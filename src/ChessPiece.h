@@ -33,8 +33,7 @@
 
 #include "Util.h"
 #include "ChessPlayer.h"
-#include <gdkmm.h>
-#include <map>
+#include <vector>
 
 namespace sch {
 
@@ -55,28 +54,25 @@ public:
 
 	BoardPosition getBoardPosition() const { return mPosition; }
 	PieceType getPieceType() const { return mPieceType; }
-	ChessPlayer::Color getColor();
+	ChessPlayer::Color getColor() const;
 
 	void setSelected(bool s = true) { mSelected = s;}
 	bool isSelected() const { return mSelected; }
 
 	virtual std::vector<BoardPosition> getPossibleMoves(const BoardState& s) const = 0;
-	bool canMove(const BoardState& s) const { return getPossibleMoves(s).size(); }
+	/// True when the piece has a legal move, see BoardState::canMove().
+	bool canMove(const BoardState& s) const;
 
 protected:
 	PieceType mPieceType;
     BoardPosition mPosition;
 	bool mSelected; //!< If selected by the user
 
-	// Used internally to detect special conditions for each piece which
-	// movement depends on whether the piece has been moved or not
-	bool mMovedOnce;
-
 	std::vector<BoardPosition> getHorizontalVerticalMoves(const BoardState& s) const;
 	std::vector<BoardPosition> getDiagonalMoves(const BoardState& s) const;
 
 	friend class BoardState; // BoardState accesses the setPosition method.
-	void setPosition(BoardPosition pos) { mPosition = pos; mMovedOnce = true;}
+	void setPosition(BoardPosition pos) { mPosition = pos; }
 
 private:
 	void copy(const ChessPiece& rhs);
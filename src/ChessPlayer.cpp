@@ -30,6 +30,8 @@
 
 #include "ChessPlayer.h"
 #include "BoardState.h"
+#include "MCTS.h"
+#include "Search.h"
 
 namespace sch {
 
@@ -51,7 +53,8 @@ namespace sch {
 		return Move();
 	}
 
-	Algorithm::Algorithm(Color color) : ChessPlayer(color) {
+	Algorithm::Algorithm(Color color, const SearchLimits& limits)
+	: ChessPlayer(color), mSearch(new Search()), mLimits(limits) {
 
 	}
 
@@ -61,27 +64,34 @@ namespace sch {
 
 	Move Algorithm::makeMove(const BoardState& state) {
 		assert(state.getCurrentPlayer() == getColor());
+		return mSearch->think(state, mLimits);
+	}
 
-		std::vector<std::shared_ptr<ChessPiece>> pieces;
+	void Algorithm::stop() {
+		mSearch->stop();
+	}
 
-		if(getColor() == ChessPlayer::Color::WHITE) {
-			pieces = state.getWhitePieces();
-		} else {
-			pieces = state.getBlackPieces();
-		}
+	MonteCarlo::MonteCarlo(Color color)
+	: ChessPlayer(color), mMCTS(new MCTS()), mLimits(SearchLimits::fromMoveTime(1000)) {
 
-		std::vector<BoardPosition> moves;
-		std::shared_ptr<ChessPiece> the_piece {nullptr};
+	}
 
-		for(auto piece : pieces) {
-			moves = piece->getPossibleMoves(state);
-			if(!moves.empty()) {
-				the_piece = piece;
-				break;
-			}
-		}
+	MonteCarlo::MonteCarlo(Color color, const MCTSConfig& config, const SearchLimits& limits)
+	: ChessPlayer(color), mMCTS(new MCTS(config)), mLimits(limits) {
+
+	}
+
+	MonteCarlo::~MonteCarlo() {
+
+	}
+
+	Move MonteCarlo::makeMove(const BoardState& state) {
+		assert(state.getCurrentPlayer() == getColor());
+		return mMCTS->think(state, mLimits);
+	}
 
-		return Move(the_piece, moves[0]);
+	void MonteCarlo::stop() {
+		mMCTS->stop();
 	}
 
 	std::ostream& operator << (std::ostream& os, ChessPlayer::Color c) {
@@ -31,11 +31,17 @@
 #ifndef CHESSPLAYER_H_
 #define CHESSPLAYER_H_
 
+#include <memory>
+#include "SearchLimits.h"
 #include "Util.h"
 
 namespace sch {
 
 class BoardState;
+class MCTS;
+struct MCTSConfig;
+template<typename Board> class BasicSearch;
+typedef BasicSearch<BoardState> Search;
 
 class ChessPlayer {
 public:
@@ -49,7 +55,14 @@ public:
 	virtual bool isHuman() { return false; }
 	Color getColor() const { return mColor; }
 
+	/**
+	 * Answers with a move for @b state. A player that thinks may take a
+	 * while, so BoardController calls this from a worker thread.
+	 */
 	virtual Move makeMove(const BoardState& state) = 0;
+
+	/// Asks a makeMove() running on another thread to return as soon as it can.
+	virtual void stop() {}
 private:
 	Color mColor;
 };
@@ -65,10 +78,41 @@ public:
 
 class Algorithm : public ChessPlayer {
 public:
-	Algorithm(Color color);
+	/// Searches for one second per move unless other @b limits are given.
+	Algorithm(Color color, const SearchLimits& limits = SearchLimits::fromMoveTime(1000));
 	virtual ~Algorithm();
 
 	Move makeMove(const BoardState& state);
+	void stop();
+
+	void setLimits(const SearchLimits& limits) { mLimits = limits; }
+	const SearchLimits& getLimits() const { return mLimits; }
+
+	Search& getSearch() { return *mSearch; }
+private:
+	std::unique_ptr<Search> mSearch;
+	SearchLimits mLimits;
+};
+
+/// Plays with a Monte Carlo tree search, keeping its tree from move to move.
+class MonteCarlo : public ChessPlayer {
+public:
+	/// Searches for one second per move on a single thread.
+	explicit MonteCarlo(Color color);
+	MonteCarlo(Color color, const MCTSConfig& config,
+			const SearchLimits& limits = SearchLimits::fromMoveTime(1000));
+	virtual ~MonteCarlo();
+
+	Move makeMove(const BoardState& state);
+	void stop();
+
+	void setLimits(const SearchLimits& limits) { mLimits = limits; }
+	const SearchLimits& getLimits() const { return mLimits; }
+
+	MCTS& getMCTS() { return *mMCTS; }
+private:
+	std::unique_ptr<MCTS> mMCTS;
+	SearchLimits mLimits;
 };
 
 std::ostream& operator << (std::ostream& os, ChessPlayer::Color c);
@@ -0,0 +1,77 @@
+//===-- smart-chess/EvalCache.cpp -------------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file EvalCache.cpp
+/// \brief Fixed size cache of static evaluations keyed by the position hash.
+///
+//===----------------------------------------------------------------------===//
+
+#include "EvalCache.h"
+
+namespace sch {
+
+EvalCache::EvalCache(size_t size_mb)
+: mTable(nullptr), mMask(0) {
+	resize(size_mb);
+}
+
+void EvalCache::resize(size_t size_mb) {
+	const size_t bytes = (size_mb ? size_mb : 1) * 1024 * 1024;
+	// Round down to a power of two so the slot is just key & mask
+	size_t entries = 1;
+	while(entries * 2 * sizeof(Entry) <= bytes)
+		entries *= 2;
+
+	mTable.reset(new Entry[entries]);
+	mMask = entries - 1;
+	clear();
+}
+
+void EvalCache::clear() {
+	for(size_t i = 0; i <= mMask; ++i) {
+		mTable[i].data.store(0, std::memory_order_relaxed);
+		mTable[i].check.store(0, std::memory_order_relaxed);
+	}
+}
+
+bool EvalCache::probe(uint64_t key, int& score) const {
+	const Entry& e = mTable[key & mMask];
+	const uint64_t data = e.data.load(std::memory_order_relaxed);
+	const uint64_t check = e.check.load(std::memory_order_relaxed);
+	if((check ^ data) != key)
+		return false;
+
+	score = static_cast<int32_t>(static_cast<uint32_t>(data));
+	return true;
+}
+
+void EvalCache::store(uint64_t key, int score) {
+	Entry& e = mTable[key & mMask];
+	const uint64_t data = static_cast<uint32_t>(static_cast<int32_t>(score));
+	e.data.store(data, std::memory_order_relaxed);
+	e.check.store(key ^ data, std::memory_order_relaxed);
+}
+
+} /* namespace sch */
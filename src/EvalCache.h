@@ -0,0 +1,94 @@
+//===-- smart-chess/EvalCache.h ---------------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file EvalCache.h
+/// \brief Fixed size cache of static evaluations keyed by the position hash.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef EVALCACHE_H_
+#define EVALCACHE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace sch {
+
+/**
+ * A small, lock-free cache mapping the Zobrist key of a position to its
+ * static evaluation.
+ *
+ * It is meant to be shared by every search thread. Each entry is two 64 bit
+ * words: the data word and the key XOR'ed with the data. A reader accepts an
+ * entry only when both words agree, so a torn write by a concurrent thread is
+ * seen as a miss instead of as a wrong score.
+ *
+ * The cache is sized independently of any transposition table and it never
+ * grows; new entries always replace the old ones in their slot. It keeps no
+ * statistics, so a probe writes nothing shared: the searchers count their own
+ * probes and hits, see BasicSearch::getEvalCacheHits().
+ */
+class EvalCache {
+public:
+	static const size_t DEFAULT_SIZE_MB = 4;
+
+	explicit EvalCache(size_t size_mb = DEFAULT_SIZE_MB);
+
+	EvalCache(const EvalCache&) = delete;
+	EvalCache& operator = (const EvalCache&) = delete;
+
+	/// Reallocates the table, dropping every cached score.
+	void resize(size_t size_mb);
+
+	/// Drops every cached score.
+	void clear();
+
+	/**
+	 * Looks up the evaluation of the position with hash @b key.
+	 *
+	 * @param[out] score The cached evaluation, only written on a hit.
+	 * @return True when @b key was found.
+	 */
+	bool probe(uint64_t key, int& score) const;
+
+	void store(uint64_t key, int score);
+
+	size_t getEntryCount() const { return mMask + 1; }
+
+private:
+	struct Entry {
+		std::atomic<uint64_t> data;
+		std::atomic<uint64_t> check; //!< key ^ data
+	};
+
+	std::unique_ptr<Entry[]> mTable;
+	size_t mMask;
+};
+
+} /* namespace sch */
+
+#endif /* EVALCACHE_H_ */
@@ -0,0 +1,183 @@
+//===-- smart-chess/EvalWeights.h -------------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file EvalWeights.h
+/// \brief Evaluation weights fitted by smartchess-tune.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef EVALWEIGHTS_H_
+#define EVALWEIGHTS_H_
+
+#include "Util.h"
+
+namespace sch {
+
+// Written by smartchess-tune, which also starts tuning from these values.
+
+/// Sum of the PHASE_WEIGHTS of the pieces at the start of a game.
+const int MAX_PHASE = 24;
+
+/// How much a piece counts towards the game phase, indexed by getPieceKind().
+const int PHASE_WEIGHTS[PIECE_KINDS] = { 0, 4, 2, 1, 1, 0 };
+
+/// Indexed by getPieceKind(): king, queen, rook, bishop, knight, pawn.
+const int MIDGAME_PIECE_VALUES[PIECE_KINDS] = { 0, 900, 500, 330, 320, 100 };
+const int ENDGAME_PIECE_VALUES[PIECE_KINDS] = { 0, 900, 500, 330, 320, 100 };
+
+/**
+ * Added to the value of a piece on a square. Indexed by getPieceKind() and
+ * the square (see toSquareIndex) as seen by white: black pieces use the
+ * square with the row flipped.
+ */
+const int MIDGAME_PIECE_SQUARE_VALUES[PIECE_KINDS][SQUARE_COUNT] = {
+	{ // king
+		 -30,  -40,  -40,  -50,  -50,  -40,  -40,  -30,
+		 -30,  -40,  -40,  -50,  -50,  -40,  -40,  -30,
+		 -30,  -40,  -40,  -50,  -50,  -40,  -40,  -30,
+		 -30,  -40,  -40,  -50,  -50,  -40,  -40,  -30,
+		 -20,  -30,  -30,  -40,  -40,  -30,  -30,  -20,
+		 -10,  -20,  -20,  -20,  -20,  -20,  -20,  -10,
+		  20,   20,    0,    0,    0,    0,   20,   20,
+		  20,   30,   10,    0,    0,   10,   30,   20,
+	},
+	{ // queen
+		 -20,  -10,  -10,   -5,   -5,  -10,  -10,  -20,
+		 -10,    0,    0,    0,    0,    0,    0,  -10,
+		 -10,    0,    5,    5,    5,    5,    0,  -10,
+		  -5,    0,    5,    5,    5,    5,    0,   -5,
+		   0,    0,    5,    5,    5,    5,    0,   -5,
+		 -10,    5,    5,    5,    5,    5,    0,  -10,
+		 -10,    0,    5,    0,    0,    0,    0,  -10,
+		 -20,  -10,  -10,   -5,   -5,  -10,  -10,  -20,
+	},
+	{ // rook
+		   0,    0,    0,    0,    0,    0,    0,    0,
+		   5,   10,   10,   10,   10,   10,   10,    5,
+		  -5,    0,    0,    0,    0,    0,    0,   -5,
+		  -5,    0,    0,    0,    0,    0,    0,   -5,
+		  -5,    0,    0,    0,    0,    0,    0,   -5,
+		  -5,    0,    0,    0,    0,    0,    0,   -5,
+		  -5,    0,    0,    0,    0,    0,    0,   -5,
+		   0,    0,    0,    5,    5,    0,    0,    0,
+	},
+	{ // bishop
+		 -20,  -10,  -10,  -10,  -10,  -10,  -10,  -20,
+		 -10,    0,    0,    0,    0,    0,    0,  -10,
+		 -10,    0,    5,   10,   10,    5,    0,  -10,
+		 -10,    5,    5,   10,   10,    5,    5,  -10,
+		 -10,    0,   10,   10,   10,   10,    0,  -10,
+		 -10,   10,   10,   10,   10,   10,   10,  -10,
+		 -10,    5,    0,    0,    0,    0,    5,  -10,
+		 -20,  -10,  -10,  -10,  -10,  -10,  -10,  -20,
+	},
+	{ // knight
+		 -50,  -40,  -30,  -30,  -30,  -30,  -40,  -50,
+		 -40,  -20,    0,    0,    0,    0,  -20,  -40,
+		 -30,    0,   10,   15,   15,   10,    0,  -30,
+		 -30,    5,   15,   20,   20,   15,    5,  -30,
+		 -30,    0,   15,   20,   20,   15,    0,  -30,
+		 -30,    5,   10,   15,   15,   10,    5,  -30,
+		 -40,  -20,    0,    5,    5,    0,  -20,  -40,
+		 -50,  -40,  -30,  -30,  -30,  -30,  -40,  -50,
+	},
+	{ // pawn
+		   0,    0,    0,    0,    0,    0,    0,    0,
+		  50,   50,   50,   50,   50,   50,   50,   50,
+		  10,   10,   20,   30,   30,   20,   10,   10,
+		   5,    5,   10,   25,   25,   10,    5,    5,
+		   0,    0,    0,   20,   20,    0,    0,    0,
+		   5,   -5,  -10,    0,    0,  -10,   -5,    5,
+		   5,   10,   10,  -20,  -20,   10,   10,    5,
+		   0,    0,    0,    0,    0,    0,    0,    0,
+	},
+};
+
+const int ENDGAME_PIECE_SQUARE_VALUES[PIECE_KINDS][SQUARE_COUNT] = {
+	{ // king
+		 -50,  -40,  -30,  -20,  -20,  -30,  -40,  -50,
+		 -30,  -20,  -10,    0,    0,  -10,  -20,  -30,
+		 -30,  -10,   20,   30,   30,   20,  -10,  -30,
+		 -30,  -10,   30,   40,   40,   30,  -10,  -30,
+		 -30,  -10,   30,   40,   40,   30,  -10,  -30,
+		 -30,  -10,   20,   30,   30,   20,  -10,  -30,
+		 -30,  -30,    0,    0,    0,    0,  -30,  -30,
+		 -50,  -30,  -30,  -30,  -30,  -30,  -30,  -50,
+	},
+	{ // queen
+		 -20,  -10,  -10,   -5,   -5,  -10,  -10,  -20,
+		 -10,    0,    0,    0,    0,    0,    0,  -10,
+		 -10,    0,    5,    5,    5,    5,    0,  -10,
+		  -5,    0,    5,    5,    5,    5,    0,   -5,
+		   0,    0,    5,    5,    5,    5,    0,   -5,
+		 -10,    5,    5,    5,    5,    5,    0,  -10,
+		 -10,    0,    5,    0,    0,    0,    0,  -10,
+		 -20,  -10,  -10,   -5,   -5,  -10,  -10,  -20,
+	},
+	{ // rook
+		   0,    0,    0,    0,    0,    0,    0,    0,
+		   5,   10,   10,   10,   10,   10,   10,    5,
+		  -5,    0,    0,    0,    0,    0,    0,   -5,
+		  -5,    0,    0,    0,    0,    0,    0,   -5,
+		  -5,    0,    0,    0,    0,    0,    0,   -5,
+		  -5,    0,    0,    0,    0,    0,    0,   -5,
+		  -5,    0,    0,    0,    0,    0,    0,   -5,
+		   0,    0,    0,    5,    5,    0,    0,    0,
+	},
+	{ // bishop
+		 -20,  -10,  -10,  -10,  -10,  -10,  -10,  -20,
+		 -10,    0,    0,    0,    0,    0,    0,  -10,
+		 -10,    0,    5,   10,   10,    5,    0,  -10,
+		 -10,    5,    5,   10,   10,    5,    5,  -10,
+		 -10,    0,   10,   10,   10,   10,    0,  -10,
+		 -10,   10,   10,   10,   10,   10,   10,  -10,
+		 -10,    5,    0,    0,    0,    0,    5,  -10,
+		 -20,  -10,  -10,  -10,  -10,  -10,  -10,  -20,
+	},
+	{ // knight
+		 -50,  -40,  -30,  -30,  -30,  -30,  -40,  -50,
+		 -40,  -20,    0,    0,    0,    0,  -20,  -40,
+		 -30,    0,   10,   15,   15,   10,    0,  -30,
+		 -30,    5,   15,   20,   20,   15,    5,  -30,
+		 -30,    0,   15,   20,   20,   15,    0,  -30,
+		 -30,    5,   10,   15,   15,   10,    5,  -30,
+		 -40,  -20,    0,    5,    5,    0,  -20,  -40,
+		 -50,  -40,  -30,  -30,  -30,  -30,  -40,  -50,
+	},
+	{ // pawn
+		   0,    0,    0,    0,    0,    0,    0,    0,
+		  80,   80,   80,   80,   80,   80,   80,   80,
+		  50,   50,   50,   50,   50,   50,   50,   50,
+		  30,   30,   30,   30,   30,   30,   30,   30,
+		  15,   15,   15,   15,   15,   15,   15,   15,
+		   5,    5,    5,    5,    5,    5,    5,    5,
+		   0,    0,    0,    0,    0,    0,    0,    0,
+		   0,    0,    0,    0,    0,    0,    0,    0,
+	},
+};
+
+} /* namespace sch */
+
+#endif /* EVALWEIGHTS_H_ */
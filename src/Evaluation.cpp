@@ -0,0 +1,75 @@
+//===-- smart-chess/Evaluation.cpp ------------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file Evaluation.cpp
+/// \brief Static evaluation of a BoardState.
+///
+//===----------------------------------------------------------------------===//
+
+#include "Evaluation.h"
+#include "BoardState.h"
+#include "EvalWeights.h"
+
+namespace sch {
+
+const PieceSquareTable& PieceSquareTable::instance() {
+	static PieceSquareTable m_instance;
+	return m_instance;
+}
+
+PieceSquareTable::PieceSquareTable() {
+	for(int t = 0; t < PIECE_TYPES; ++t) {
+		const PieceType type = static_cast<PieceType>(t);
+		const int kind = getPieceKind(type);
+		const bool white = isWhitePieceType(type);
+		for(int sq = 0; sq < SQUARE_COUNT; ++sq) {
+			const int relative = white ? sq : mirrorSquare(sq);
+			TaperedScore score(MIDGAME_PIECE_VALUES[kind] + MIDGAME_PIECE_SQUARE_VALUES[kind][relative],
+					ENDGAME_PIECE_VALUES[kind] + ENDGAME_PIECE_SQUARE_VALUES[kind][relative]);
+			mScores[t][sq] = white ? score : TaperedScore(-score.midgame, -score.endgame);
+		}
+		mPhases[t] = PHASE_WEIGHTS[kind];
+	}
+}
+
+int getPieceValue(PieceType type) {
+	if(type == PieceType::UNDEFINED)
+		return 0;
+	return MIDGAME_PIECE_VALUES[getPieceKind(type)];
+}
+
+int blendScore(const TaperedScore& s, int phase) {
+	// Promotions can take the phase over its initial value
+	if(phase > MAX_PHASE)
+		phase = MAX_PHASE;
+	return (s.midgame * phase + s.endgame * (MAX_PHASE - phase)) / MAX_PHASE;
+}
+
+int evaluate(const BoardState& state) {
+	const int score = blendScore(state.getPieceSquareScore(), state.getPhase());
+	return state.getCurrentPlayer() == ChessPlayer::Color::WHITE ? score : -score;
+}
+
+} /* namespace sch */
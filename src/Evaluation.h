@@ -0,0 +1,107 @@
+//===-- smart-chess/Evaluation.h --------------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file Evaluation.h
+/// \brief Static evaluation of a BoardState.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef EVALUATION_H_
+#define EVALUATION_H_
+
+#include "Util.h"
+
+namespace sch {
+
+class BoardState;
+
+/// A score in centipawns for the middle game and another one for the endgame.
+struct TaperedScore {
+	int midgame;
+	int endgame;
+
+	TaperedScore() : midgame(0), endgame(0) {}
+	TaperedScore(int mg, int eg) : midgame(mg), endgame(eg) {}
+
+	TaperedScore& operator += (const TaperedScore& rhs) {
+		midgame += rhs.midgame;
+		endgame += rhs.endgame;
+		return *this;
+	}
+
+	TaperedScore& operator -= (const TaperedScore& rhs) {
+		midgame -= rhs.midgame;
+		endgame -= rhs.endgame;
+		return *this;
+	}
+};
+
+/**
+ * The material plus piece-square value of every piece on every square, built
+ * once from EvalWeights.h. A BoardState adds up the entries of its pieces as
+ * they are put on and taken off the board, so it always knows its score.
+ */
+class PieceSquareTable {
+public:
+	static const PieceSquareTable& instance();
+
+	/// Positive for white pieces and negative for black ones.
+	const TaperedScore& getScore(PieceType type, int square) const {
+		return mScores[static_cast<int>(type)][square];
+	}
+
+	/// How much a piece of @b type counts towards the game phase.
+	int getPhase(PieceType type) const { return mPhases[static_cast<int>(type)]; }
+
+private:
+	static const int PIECE_TYPES = static_cast<int>(PieceType::UNDEFINED);
+
+	TaperedScore mScores[PIECE_TYPES][SQUARE_COUNT];
+	int mPhases[PIECE_TYPES];
+
+	PieceSquareTable();
+};
+
+/// Middle game value of a piece in centipawns, the king counts as 0.
+int getPieceValue(PieceType type);
+
+/**
+ * Blends the middle game and endgame halves of @b score by the game
+ * @b phase, which goes from MAX_PHASE (see EvalWeights.h) down to 0.
+ */
+int blendScore(const TaperedScore& score, int phase);
+
+/**
+ * Scores @b state in centipawns from the point of view of the current
+ * player: positive means the side to move is better.
+ *
+ * The middle game and endgame sums kept by the BoardState are blended by
+ * the game phase, so this takes constant time.
+ */
+int evaluate(const BoardState& state);
+
+} /* namespace sch */
+
+#endif /* EVALUATION_H_ */
@@ -0,0 +1,235 @@
+//===-- smart-chess/GameArchive.cpp -----------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file GameArchive.cpp
+/// \brief Compact binary storage of whole games.
+///
+//===----------------------------------------------------------------------===//
+
+#include "GameArchive.h"
+#include "Util.h"
+#include "Varint.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+namespace sch {
+
+namespace {
+	struct Header {
+		char magic[8];
+		uint32_t version;
+		uint32_t reserved;
+		uint64_t gameCount;
+		uint64_t tableOffset;
+	};
+
+	const char MAGIC[8] = { 'S', 'C', 'H', 'G', 'A', 'M', 'E', 'S' };
+	const uint32_t VERSION = 1;
+
+	/// Reads a varint length followed by that many bytes.
+	string readString(const uint8_t*& p, const uint8_t* end) {
+		const uint64_t length = min<uint64_t>(readVarint(p, end), end - p);
+		string s(reinterpret_cast<const char*>(p), length);
+		p += length;
+		return s;
+	}
+
+	void skipString(const uint8_t*& p, const uint8_t* end) {
+		p += min<uint64_t>(readVarint(p, end), end - p);
+	}
+}
+
+GameArchiveWriter::GameArchiveWriter(const std::string& path)
+: mPath(path), mOut(path, ios::binary | ios::trunc), mPosition(sizeof(Header)),
+  mOffsets(), mBuffer(), mState(), mBoard(), mClosed(false) {
+	if(!mOut)
+		throw FileException(path, "could not create the game archive");
+	// Rewritten by close() once the count and the table offset are known
+	Header header;
+	memset(&header, 0, sizeof(header));
+	mOut.write(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+GameArchiveWriter::~GameArchiveWriter() {
+	if(!mClosed) {
+		try {
+			close();
+		} catch(const FileException&) {
+			// Nothing sensible to do in a destructor
+		}
+	}
+}
+
+bool GameArchiveWriter::addGame(const PGNTags& tags, const std::vector<uint16_t>& moves) {
+	mBuffer.clear();
+	appendVarint(mBuffer, tags.size());
+	string fen = BoardState::START_FEN;
+	for(auto& tag : tags) {
+		appendVarint(mBuffer, tag.first.size());
+		mBuffer.insert(mBuffer.end(), tag.first.begin(), tag.first.end());
+		appendVarint(mBuffer, tag.second.size());
+		mBuffer.insert(mBuffer.end(), tag.second.begin(), tag.second.end());
+		if(tag.first == "FEN")
+			fen = tag.second;
+	}
+
+	try {
+		mState.loadFEN(fen);
+	} catch(const FENException&) {
+		return false;
+	}
+	mBoard.load(mState);
+
+	appendVarint(mBuffer, moves.size());
+	uint16_t codes[BoardState::MAX_MOVES];
+	BitboardBoard::Undo undo;
+	for(uint16_t move : moves) {
+		// The index in the sorted list is the number of smaller codes
+		const size_t count = mBoard.getLegalMoves(codes);
+		size_t index = 0;
+		bool legal = false;
+		for(size_t i = 0; i < count; ++i) {
+			index += codes[i] < move;
+			legal |= codes[i] == move;
+		}
+		if(!legal)
+			return false;
+		mBuffer.push_back(static_cast<uint8_t>(index));
+		mBoard.makeMove(move, undo);
+	}
+
+	mOffsets.push_back(mPosition);
+	mOut.write(reinterpret_cast<const char*>(mBuffer.data()), mBuffer.size());
+	mPosition += mBuffer.size();
+	return true;
+}
+
+void GameArchiveWriter::close() {
+	if(mClosed)
+		return;
+	mClosed = true;
+
+	// Keep the table 8 byte aligned so it can be read in place
+	const uint64_t padding = (8 - mPosition % 8) % 8;
+	const char zeros[8] = {0};
+	mOut.write(zeros, padding);
+
+	Header header;
+	memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.version = VERSION;
+	header.reserved = 0;
+	header.gameCount = mOffsets.size();
+	header.tableOffset = mPosition + padding;
+
+	mOut.write(reinterpret_cast<const char*>(mOffsets.data()), mOffsets.size() * sizeof(uint64_t));
+	mOut.seekp(0);
+	mOut.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	mOut.close();
+	if(!mOut)
+		throw FileException(mPath, "could not write the game archive");
+}
+
+GameArchive::GameArchive(const std::string& path)
+: mFile(path), mGameCount(0), mOffsets(nullptr), mData(nullptr) {
+	const size_t size = mFile.getSize();
+	Header header;
+	if(size < sizeof(header))
+		throw FileException(path, "not a game archive");
+	memcpy(&header, mFile.getData(), sizeof(header));
+	if(memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0)
+		throw FileException(path, "not a game archive");
+	if(header.version != VERSION)
+		throw FileException(path, "unsupported game archive version " + to_string(header.version));
+	if(header.tableOffset > size || header.gameCount > (size - header.tableOffset) / sizeof(uint64_t))
+		throw FileException(path, "truncated game archive");
+
+	mGameCount = header.gameCount;
+	mData = reinterpret_cast<const uint8_t*>(mFile.getData());
+	mOffsets = reinterpret_cast<const uint64_t*>(mData + header.tableOffset);
+}
+
+PGNTags GameArchive::getTags(uint64_t index) const {
+	const uint8_t* p = mData + mOffsets[index];
+	const uint8_t* end = mData + mFile.getSize();
+	PGNTags tags(readVarint(p, end));
+	for(auto& tag : tags) {
+		tag.first = readString(p, end);
+		tag.second = readString(p, end);
+	}
+	return tags;
+}
+
+std::vector<uint16_t> GameArchive::getMoves(uint64_t index) const {
+	BitboardBoard board;
+	vector<uint16_t> moves;
+	replay(index, board, [&moves](const BitboardBoard&, uint16_t move) { moves.push_back(move); });
+	return moves;
+}
+
+const uint8_t* GameArchive::findMoves(uint64_t index, const char*& fen, size_t& fen_length, size_t& count) const {
+	const uint8_t* p = mData + mOffsets[index];
+	const uint8_t* end = mData + mFile.getSize();
+
+	fen = nullptr;
+	fen_length = 0;
+	for(uint64_t tags = readVarint(p, end); tags > 0; --tags) {
+		const uint64_t length = readVarint(p, end);
+		const bool is_fen = length == 3 && p + 3 <= end && memcmp(p, "FEN", 3) == 0;
+		p += min<uint64_t>(length, end - p);
+		if(is_fen) {
+			fen_length = min<uint64_t>(readVarint(p, end), end - p);
+			fen = reinterpret_cast<const char*>(p);
+			p += fen_length;
+		} else {
+			skipString(p, end);
+		}
+	}
+
+	count = min<uint64_t>(readVarint(p, end), end - p);
+	return p;
+}
+
+uint16_t GameArchive::selectCode(const uint16_t* codes, size_t count, size_t index) {
+	// Counting is branch free: with a few dozen codes it beats sorting
+	for(size_t i = 0; i < count; ++i) {
+		size_t smaller = 0;
+		for(size_t j = 0; j < count; ++j)
+			smaller += codes[j] < codes[i];
+		if(smaller == index)
+			return codes[i];
+	}
+	return codes[index];
+}
+
+void GameArchive::setUp(BoardState& state, const char* fen, size_t fen_length) {
+	if(fen)
+		state.loadFEN(fen, fen_length);
+	else
+		state.loadFEN(BoardState::START_FEN, strlen(BoardState::START_FEN));
+}
+
+} /* namespace sch */
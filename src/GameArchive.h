@@ -0,0 +1,187 @@
+//===-- smart-chess/GameArchive.h -------------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file GameArchive.h
+/// \brief Compact binary storage of whole games.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef GAMEARCHIVE_H_
+#define GAMEARCHIVE_H_
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "BitboardBoard.h"
+#include "BoardState.h"
+#include "BoardTraits.h"
+#include "MappedFile.h"
+#include "PGNWriter.h"
+
+namespace sch {
+
+/**
+ * Writes a game archive: a binary file that stores every move as its index
+ * in the sorted list of legal moves (see BoardState::getLegalMoveCodes()),
+ * one byte per move.
+ *
+ * Layout, numbers in host byte order:
+ *   header: magic, version, game count, offset of the offset table
+ *   games:  varint tag count, then varint length and bytes of every tag
+ *           name and value, varint move count and one byte per move
+ *   offset table: the 64 bit file offset of every game
+ */
+class GameArchiveWriter {
+public:
+	/// @throw FileException When @b path cannot be created.
+	explicit GameArchiveWriter(const std::string& path);
+
+	/// Finishes the file if close() was not called.
+	~GameArchiveWriter();
+
+	GameArchiveWriter(const GameArchiveWriter&) = delete;
+	GameArchiveWriter& operator = (const GameArchiveWriter&) = delete;
+
+	/**
+	 * Appends a game. The moves are replayed from the FEN tag, or from the
+	 * initial position when there is none.
+	 *
+	 * @param moves Packed with BoardState::encodeMove().
+	 * @return False, and nothing is written, when the FEN or a move is not legal.
+	 */
+	bool addGame(const PGNTags& tags, const std::vector<uint16_t>& moves);
+
+	/**
+	 * Writes the offset table and the final header.
+	 *
+	 * @throw FileException When the file could not be written.
+	 */
+	void close();
+
+	uint64_t getGameCount() const { return mOffsets.size(); }
+
+private:
+	std::string mPath;
+	std::ofstream mOut;
+	uint64_t mPosition; //!< Where the next game goes
+	std::vector<uint64_t> mOffsets;
+	std::vector<uint8_t> mBuffer;
+	BoardState mState;    //!< Reads the FEN tag
+	BitboardBoard mBoard; //!< Checks and indexes the moves
+	bool mClosed;
+};
+
+/**
+ * Random access to the games of an archive written by GameArchiveWriter.
+ * The file is memory mapped; tags and moves are decoded on demand.
+ */
+class GameArchive {
+public:
+	/// @throw FileException When @b path is not a game archive.
+	explicit GameArchive(const std::string& path);
+
+	uint64_t getGameCount() const { return mGameCount; }
+
+	PGNTags getTags(uint64_t index) const;
+
+	/**
+	 * Replays game @b index on @b board, any backend of BoardTraits, which is
+	 * first set to the starting position of the game. @b visit(board, move)
+	 * is called before every move is made, with the move packed as by
+	 * BoardState::encodeMove().
+	 *
+	 * Every move costs a legal move generation, so this runs at the speed
+	 * of the board: a few million moves per second on a BitboardBoard,
+	 * several times less on a BoardState, which toSAN() needs.
+	 *
+	 * @return The number of moves replayed.
+	 */
+	template<class Board, class Visitor>
+	size_t replay(uint64_t index, Board& board, Visitor visit) const {
+		typedef BoardTraits<Board> Traits;
+		const char* fen;
+		size_t fen_length, count;
+		const uint8_t* p = findMoves(index, fen, fen_length, count);
+		setUp(board, fen, fen_length);
+
+		uint16_t codes[BoardState::MAX_MOVES];
+		typename Traits::Undo undo;
+		for(size_t i = 0; i < count; ++i) {
+			const size_t legal = Traits::getLegalMoves(board, codes);
+			if(p[i] >= legal)
+				return i; // A damaged file, stop at the last good move
+			const uint16_t code = selectCode(codes, legal, p[i]);
+			visit(static_cast<const Board&>(board), code);
+			Traits::makeMove(board, code, undo);
+		}
+		return count;
+	}
+
+	/// The moves of game @b index, packed as by BoardState::encodeMove().
+	std::vector<uint16_t> getMoves(uint64_t index) const;
+
+private:
+	MappedFile mFile;
+	uint64_t mGameCount;
+	const uint64_t* mOffsets;
+	const uint8_t* mData;
+
+	/**
+	 * The code with @b index smaller ones among the @b count unsorted
+	 * @b codes: what the index of a move in the sorted list means.
+	 */
+	static uint16_t selectCode(const uint16_t* codes, size_t count, size_t index);
+
+	/**
+	 * Finds the FEN tag of game @b index, @b fen is null when it has none,
+	 * and returns its move bytes.
+	 */
+	const uint8_t* findMoves(uint64_t index, const char*& fen, size_t& fen_length, size_t& count) const;
+
+	/// Sets @b state to the starting position @b fen, the initial one when null.
+	static void setUp(BoardState& state, const char* fen, size_t fen_length);
+
+	template<class Board>
+	static void setUp(Board& board, const char* fen, size_t fen_length) {
+		if(fen) {
+			BoardState state;
+			setUp(state, fen, fen_length);
+			BoardTraits<Board>::load(board, state);
+		} else {
+			// Most games have no FEN: copy the initial position, built once
+			static const Board start = [] {
+				Board b;
+				BoardTraits<Board>::load(b, BoardState());
+				return b;
+			}();
+			board = start;
+		}
+	}
+};
+
+} /* namespace sch */
+
+#endif /* GAMEARCHIVE_H_ */
@@ -0,0 +1,66 @@
+//===-- smart-chess/ImageLoader.cpp -----------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file ImageLoader.cpp
+/// \brief Loads the images used to draw the chess pieces.
+///
+//===----------------------------------------------------------------------===//
+
+#include "ImageLoader.h"
+
+#include "SmartChessConfig.h"
+
+namespace sch {
+
+    ImageLoader &ImageLoader::instance() {
+        static ImageLoader m_instance;
+        return m_instance;
+    }
+
+    void ImageLoader::loadImages(std::string data_dir) {
+        images[PieceType::WHITE_KING] = Gdk::Pixbuf::create_from_file(data_dir + "/kingw.gif");
+        images[PieceType::WHITE_QUEEN] = Gdk::Pixbuf::create_from_file(data_dir + "/queenw.gif");
+        images[PieceType::WHITE_ROOK] = Gdk::Pixbuf::create_from_file(data_dir + "/rookw.gif");
+        images[PieceType::WHITE_BISHOP] = Gdk::Pixbuf::create_from_file(data_dir +"/bishopw.gif");
+        images[PieceType::WHITE_KNIGHT] = Gdk::Pixbuf::create_from_file(data_dir + "/knightw.gif");
+        images[PieceType::WHITE_PAWN] = Gdk::Pixbuf::create_from_file(data_dir + "/pawnw.gif");
+
+        images[PieceType::BLACK_KING] = Gdk::Pixbuf::create_from_file(data_dir + "/kingb.gif");
+        images[PieceType::BLACK_QUEEN] = Gdk::Pixbuf::create_from_file(data_dir + "/queenb.gif");
+        images[PieceType::BLACK_ROOK] = Gdk::Pixbuf::create_from_file(data_dir + "/rookb.gif");
+        images[PieceType::BLACK_BISHOP] = Gdk::Pixbuf::create_from_file(data_dir + "/bishopb.gif");
+        images[PieceType::BLACK_KNIGHT] = Gdk::Pixbuf::create_from_file(data_dir + "/knightb.gif");
+        images[PieceType::BLACK_PAWN] = Gdk::Pixbuf::create_from_file(data_dir + "/pawnb.gif");
+    }
+
+    ImageLoader::ImageLoader() {
+        loadImages(SMARTCHESS_DATA_DIR);
+    }
+
+    Glib::RefPtr<Gdk::Pixbuf> ImageLoader::getImage(PieceType type) {
+        return images[type];
+    }
+
+} /* namespace sch */
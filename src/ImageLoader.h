@@ -0,0 +1,56 @@
+//===-- smart-chess/ImageLoader.h -------------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file ImageLoader.h
+/// \brief Loads the images used to draw the chess pieces.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef IMAGELOADER_H_
+#define IMAGELOADER_H_
+
+#include <map>
+#include <string>
+#include <gdkmm/pixbuf.h>
+#include "Util.h"
+
+namespace sch {
+
+    class ImageLoader {
+    public:
+        static ImageLoader& instance();
+
+        /// @note Call only once at the beginning of the program.
+        void loadImages(std::string data_dir);
+        Glib::RefPtr<Gdk::Pixbuf> getImage(PieceType type);
+    private:
+        std::map<PieceType, Glib::RefPtr<Gdk::Pixbuf>> images;
+
+        ImageLoader();
+    };
+
+} /* namespace sch */
+
+#endif /* IMAGELOADER_H_ */
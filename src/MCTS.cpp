@@ -0,0 +1,466 @@
+//===-- smart-chess/MCTS.cpp ------------------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file MCTS.cpp
+/// \brief Monte Carlo tree search, the alternative to the alpha-beta Search.
+///
+//===----------------------------------------------------------------------===//
+
+#include "MCTS.h"
+#include "Evaluation.h"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+using namespace std;
+
+namespace sch {
+
+namespace {
+	/// Centipawns of evaluate() for a result of tanh(1), about 0.76.
+	const float EVAL_SCALE = 300.0f;
+
+	float toResult(int score) {
+		return tanh(score / EVAL_SCALE);
+	}
+
+	/// xorshift64*, good enough to pick random moves.
+	uint64_t nextRandom(uint64_t& s) {
+		s ^= s >> 12;
+		s ^= s << 25;
+		s ^= s >> 27;
+		return s * 2685821657736338717ULL;
+	}
+
+	/// Draws the tree cannot see from the moves alone.
+	bool isDraw(const BoardState& state) {
+		return state.getHalfmoveClock() >= 100 || state.isRepetition() || state.isInsufficientMaterial();
+	}
+}
+
+const uint32_t MCTS::NO_NODE;
+const int MCTS::MAX_DEPTH;
+const int64_t MCTS::VALUE_SCALE;
+
+MCTS::MCTS(const MCTSConfig& config)
+: mConfig(config), mPolicy(), mBatcher(), mNodes(), mNodeCount(0), mRoot(NO_NODE), mRootState(), mHasTree(false),
+  mStop(false), mIterations(0), mMaxDepth(0), mLimits(), mStartTime(), mTimeLimit(0), mStats() {
+}
+
+MCTS::~MCTS() {
+}
+
+void MCTS::setConfig(const MCTSConfig& config) {
+	if(config.poolSize != mConfig.poolSize) {
+		mNodes.reset();
+		clear();
+	}
+	mConfig = config;
+	mConfig.threads = max(1, mConfig.threads);
+}
+
+void MCTS::setPolicy(std::shared_ptr<const PolicyNetwork> network) {
+	if(network != mPolicy)
+		clear();
+	mPolicy = network;
+}
+
+void MCTS::clear() {
+	mHasTree = false;
+	mNodeCount = 0;
+	mRoot = NO_NODE;
+}
+
+Move MCTS::think(const BoardState& root, const SearchLimits& limits) {
+	mStartTime = Clock::now();
+	mLimits = limits;
+	mStop = false;
+	mIterations = 0;
+	mMaxDepth = 0;
+	mStats = MCTSStats();
+	allocateTime(root);
+
+	uint16_t codes[BoardState::MAX_MOVES];
+	const size_t count = root.getLegalMoveCodes(codes);
+	if(count == 0)
+		return Move();
+
+	if(!mNodes)
+		mNodes.reset(new Node[mConfig.poolSize]);
+
+	if(!mConfig.reuseTree || !mHasTree || !reuseTree(root)) {
+		mRoot = 0;
+		mNodeCount = 1;
+		Node& node = mNodes[0];
+		node.value = 0;
+		node.visits = 0;
+		node.prior = 1;
+		node.move = 0;
+		node.childCount = 0;
+		node.state = UNEXPANDED;
+	}
+	mRootState = root;
+	mHasTree = true;
+	mStats.reusedNodes = mNodeCount;
+
+	if(count == 1)
+		return root.decodeMove(codes[0]);
+
+	if(mPolicy) {
+		// A thread waits for its priors, so a batch never holds more positions than threads
+		const size_t batch_size = static_cast<size_t>(max(1, min(mConfig.batchSize, mConfig.threads)));
+		mBatcher.reset(new PolicyBatcher(*mPolicy, batch_size, chrono::microseconds(mConfig.batchWait)));
+	}
+
+	vector<thread> helpers;
+	for(int i = 1; i < mConfig.threads; ++i)
+		helpers.emplace_back(&MCTS::work, this, i);
+	work(0);
+	mStop = true;
+	for(auto& t : helpers)
+		t.join();
+
+	if(mBatcher) {
+		mStats.batches = mBatcher->getBatches();
+		mBatcher.reset();
+	}
+
+	mStats.iterations = mIterations;
+	mStats.nodes = min<size_t>(mNodeCount, mConfig.poolSize);
+	mStats.maxDepth = mMaxDepth;
+	mStats.time = elapsed();
+
+	const Node& node = mNodes[mRoot];
+	if(node.state != EXPANDED)
+		return root.decodeMove(codes[0]);
+
+	// The most visited move is the most reliable one, its average may be
+	// based on a handful of visits.
+	uint32_t best = node.firstChild;
+	for(uint32_t i = node.firstChild; i < node.firstChild + node.childCount; ++i) {
+		if(mNodes[i].visits > mNodes[best].visits)
+			best = i;
+	}
+	return root.decodeMove(mNodes[best].move);
+}
+
+float MCTS::getRootValue() const {
+	if(mRoot == NO_NODE)
+		return 0;
+	const Node& node = mNodes[mRoot];
+	const uint32_t visits = node.visits;
+	// The root stores results for the player who moved into it
+	return visits ? -static_cast<float>(node.value) / (VALUE_SCALE * visits) : 0;
+}
+
+bool MCTS::reuseTree(const BoardState& root) {
+	const uint32_t node = findNode(root);
+	if(node == NO_NODE)
+		return false;
+	compact(node);
+	return true;
+}
+
+uint32_t MCTS::findNode(const BoardState& position) const {
+	const uint64_t key = position.getHashKey();
+	if(mRootState.getHashKey() == key)
+		return mRoot;
+
+	const Node& root = mNodes[mRoot];
+	if(root.state != EXPANDED)
+		return NO_NODE;
+
+	BoardState state(mRootState);
+	for(uint32_t i = root.firstChild; i < root.firstChild + root.childCount; ++i) {
+		const Node& child = mNodes[i];
+		const Move m = state.decodeMove(child.move);
+		BoardState::UndoInfo undo;
+		state.makeMove(m, undo);
+		if(state.getHashKey() == key)
+			return i;
+		if(child.state == EXPANDED) {
+			for(uint32_t j = child.firstChild; j < child.firstChild + child.childCount; ++j) {
+				const Move reply = state.decodeMove(mNodes[j].move);
+				BoardState::UndoInfo reply_undo;
+				state.makeMove(reply, reply_undo);
+				const bool found = state.getHashKey() == key;
+				state.unmakeMove(reply, reply_undo);
+				if(found)
+					return j;
+			}
+		}
+		state.unmakeMove(m, undo);
+	}
+	return NO_NODE;
+}
+
+void MCTS::compact(uint32_t root) {
+	// Breadth first, so that the children of every node stay contiguous.
+	// The subtree goes to a scratch copy first: it may overlap its new place.
+	vector<uint32_t> order(1, root);
+	for(size_t i = 0; i < order.size(); ++i) {
+		const Node& node = mNodes[order[i]];
+		if(node.state == EXPANDED) {
+			for(uint32_t c = 0; c < node.childCount; ++c)
+				order.push_back(node.firstChild + c);
+		}
+	}
+
+	struct Copy {
+		int64_t value;
+		uint32_t visits;
+		float prior;
+		uint16_t move;
+		uint8_t childCount;
+		uint8_t state;
+	};
+	vector<Copy> copies(order.size());
+	for(size_t i = 0; i < order.size(); ++i) {
+		const Node& node = mNodes[order[i]];
+		copies[i] = Copy{ node.value, node.visits, node.prior, node.move, node.childCount, node.state };
+	}
+
+	uint32_t next = 1;
+	for(size_t i = 0; i < copies.size(); ++i) {
+		const Copy& c = copies[i];
+		Node& node = mNodes[i];
+		node.value = c.value;
+		node.visits = c.visits;
+		node.prior = c.prior;
+		node.move = c.move;
+		node.childCount = c.childCount;
+		node.state = c.state;
+		if(c.state == EXPANDED) {
+			node.firstChild = next;
+			next += c.childCount;
+		}
+	}
+	mRoot = 0;
+	mNodeCount = static_cast<uint32_t>(copies.size());
+}
+
+void MCTS::work(int id) {
+	Walker w;
+	w.state = mRootState;
+	w.random = (mConfig.seed + id) * 0x9E3779B97F4A7C15ULL | 1;
+	w.path.resize(MAX_DEPTH + 1);
+	const size_t plies = MAX_DEPTH + (mConfig.leaf == LeafEvaluation::PLAYOUT ? mConfig.playoutPlies : 0);
+	w.moves.resize(plies);
+	w.undos.resize(plies);
+	w.maxDepth = 0;
+
+	do {
+		iterate(w);
+		const uint64_t iterations = ++mIterations;
+		if(mLimits.nodes > 0 && iterations >= mLimits.nodes && !mLimits.infinite && !mLimits.ponder)
+			mStop = true;
+		if(id == 0 && (iterations & 63) == 0)
+			checkLimits();
+	} while(!mStop);
+
+	int depth = mMaxDepth;
+	while(w.maxDepth > depth && !mMaxDepth.compare_exchange_weak(depth, w.maxDepth))
+		;
+}
+
+void MCTS::iterate(Walker& w) {
+	const int virtual_loss = mConfig.virtualLoss;
+	int ply = 0;
+	uint32_t index = mRoot;
+	w.path[0] = index;
+	float value;
+
+	for(;;) {
+		Node& node = mNodes[index];
+		const uint8_t state = node.state.load(memory_order_acquire);
+		if(state == CHECKMATED || state == STALEMATED) {
+			value = state == CHECKMATED ? -1.0f : 0.0f;
+			break;
+		}
+		if(ply > 0 && isDraw(w.state)) {
+			value = 0;
+			break;
+		}
+		if(state != EXPANDED || ply == MAX_DEPTH) {
+			// Most leaves are only visited once, their children would be
+			// wasted: the first visit only evaluates them.
+			const bool visited = ply == 0 || node.visits.load(memory_order_relaxed) > static_cast<uint32_t>(virtual_loss);
+			if(state == UNEXPANDED && visited && ply < MAX_DEPTH && expand(node, w.state) && node.state != EXPANDED)
+				continue; // No legal move, it just became final
+			value = evaluateLeaf(w, ply);
+			break;
+		}
+
+		index = selectChild(node);
+		w.moves[ply] = w.state.decodeMove(mNodes[index].move);
+		w.state.makeMove(w.moves[ply], w.undos[ply]);
+		w.path[++ply] = index;
+	}
+	w.maxDepth = max(w.maxDepth, ply);
+
+	// value is for the side to move at the leaf, every node stores the
+	// results of the player who moved into it.
+	for(int i = ply; i >= 0; --i) {
+		value = -value;
+		Node& node = mNodes[w.path[i]];
+		const int64_t result = static_cast<int64_t>(value * VALUE_SCALE);
+		if(i > 0) {
+			node.value.fetch_add(result + virtual_loss * VALUE_SCALE, memory_order_relaxed);
+			node.visits.fetch_add(static_cast<uint32_t>(1 - virtual_loss), memory_order_relaxed);
+		} else {
+			node.value.fetch_add(result, memory_order_relaxed);
+			node.visits.fetch_add(1, memory_order_relaxed);
+		}
+	}
+
+	for(int i = ply - 1; i >= 0; --i)
+		w.state.unmakeMove(w.moves[i], w.undos[i]);
+}
+
+uint32_t MCTS::selectChild(const Node& parent) {
+	const uint32_t parent_visits = max<uint32_t>(1, parent.visits.load(memory_order_relaxed));
+	const float c = mConfig.exploration;
+	const bool uct = mConfig.formula == SelectionFormula::UCT;
+	const float exploration = uct ? sqrt(log(static_cast<float>(parent_visits))) : sqrt(static_cast<float>(parent_visits));
+
+	uint32_t best = parent.firstChild;
+	float best_score = -INFINITY;
+	for(uint32_t i = parent.firstChild; i < parent.firstChild + parent.childCount; ++i) {
+		const Node& child = mNodes[i];
+		const uint32_t visits = child.visits.load(memory_order_relaxed);
+		const float q = visits ? static_cast<float>(child.value.load(memory_order_relaxed)) / (VALUE_SCALE * visits) : 0.0f;
+		float score;
+		if(uct)
+			score = visits ? q + c * exploration / sqrt(static_cast<float>(visits)) : INFINITY;
+		else
+			score = q + c * child.prior * exploration / (1 + visits);
+		if(score > best_score) {
+			best_score = score;
+			best = i;
+			if(score == INFINITY)
+				break;
+		}
+	}
+
+	Node& child = mNodes[best];
+	child.visits.fetch_add(mConfig.virtualLoss, memory_order_relaxed);
+	child.value.fetch_sub(mConfig.virtualLoss * VALUE_SCALE, memory_order_relaxed);
+	return best;
+}
+
+bool MCTS::expand(Node& node, const BoardState& state) {
+	uint8_t expected = UNEXPANDED;
+	if(!node.state.compare_exchange_strong(expected, EXPANDING, memory_order_acquire))
+		return false;
+
+	uint16_t codes[BoardState::MAX_MOVES];
+	const size_t count = state.getLegalMoveCodes(codes);
+	if(count == 0) {
+		node.state.store(state.isInCheck() ? CHECKMATED : STALEMATED, memory_order_release);
+		return true;
+	}
+
+	const uint32_t first = mNodeCount.fetch_add(static_cast<uint32_t>(count), memory_order_relaxed);
+	if(static_cast<uint64_t>(first) + count > mConfig.poolSize) {
+		mStop = true;
+		node.state.store(UNEXPANDED, memory_order_release);
+		return false;
+	}
+
+	float priors[BoardState::MAX_MOVES];
+	if(mBatcher) {
+		PolicyNetwork::Input input;
+		PolicyNetwork::encode(state, codes, count, input);
+		mBatcher->evaluate(input, priors);
+	} else {
+		fill(priors, priors + count, 1.0f / count);
+	}
+
+	for(size_t i = 0; i < count; ++i) {
+		Node& child = mNodes[first + i];
+		child.value.store(0, memory_order_relaxed);
+		child.visits.store(0, memory_order_relaxed);
+		child.prior = priors[i];
+		child.move = codes[i];
+		child.childCount = 0;
+		child.state.store(UNEXPANDED, memory_order_relaxed);
+	}
+	node.firstChild = first;
+	node.childCount = static_cast<uint8_t>(count);
+	node.state.store(EXPANDED, memory_order_release);
+	return true;
+}
+
+float MCTS::evaluateLeaf(Walker& w, int ply) {
+	if(mConfig.leaf == LeafEvaluation::STATIC)
+		return toResult(sch::evaluate(w.state));
+
+	uint16_t codes[BoardState::MAX_MOVES];
+	const int end = ply + mConfig.playoutPlies;
+	int last = ply;
+	float value;
+	for(;;) {
+		if(last > ply && isDraw(w.state)) {
+			value = 0;
+			break;
+		}
+		if(last == end) {
+			value = toResult(sch::evaluate(w.state));
+			break;
+		}
+		const size_t count = w.state.getLegalMoveCodes(codes);
+		if(count == 0) {
+			value = w.state.isInCheck() ? -1.0f : 0.0f;
+			break;
+		}
+		w.moves[last] = w.state.decodeMove(codes[nextRandom(w.random) % count]);
+		w.state.makeMove(w.moves[last], w.undos[last]);
+		++last;
+	}
+
+	for(int i = last - 1; i >= ply; --i)
+		w.state.unmakeMove(w.moves[i], w.undos[i]);
+	// value is for the side to move at the end of the playout
+	return (last - ply) % 2 ? -value : value;
+}
+
+void MCTS::allocateTime(const BoardState& root) {
+	mTimeLimit = 0;
+	if(mLimits.infinite || mLimits.ponder)
+		return;
+	// The same budget as a Search, which can stop any time as well
+	mTimeLimit = mLimits.getTimeBudget(root.getCurrentPlayer() == ChessPlayer::Color::WHITE).target;
+}
+
+int64_t MCTS::elapsed() const {
+	return chrono::duration_cast<chrono::milliseconds>(Clock::now() - mStartTime).count();
+}
+
+void MCTS::checkLimits() {
+	if(mTimeLimit > 0 && elapsed() >= mTimeLimit)
+		mStop = true;
+}
+
+} /* namespace sch */
@@ -0,0 +1,226 @@
+//===-- smart-chess/MCTS.h --------------------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file MCTS.h
+/// \brief Monte Carlo tree search, the alternative to the alpha-beta Search.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef MCTS_H_
+#define MCTS_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "BoardState.h"
+#include "PolicyNetwork.h"
+#include "SearchLimits.h"
+
+namespace sch {
+
+/// How the value of a new leaf of the tree is estimated.
+enum class LeafEvaluation {
+	STATIC,  //!< evaluate() of the leaf, squashed into [-1, 1]
+	PLAYOUT  //!< Random moves up to MCTSConfig::playoutPlies, then as STATIC
+};
+
+/// How a child of a node is chosen on the way down the tree.
+enum class SelectionFormula {
+	UCT,  //!< Q + c * sqrt(ln N / n), every child is tried once first
+	PUCT  //!< Q + c * P * sqrt(N) / (1 + n), P being the prior of the move
+};
+
+struct MCTSConfig {
+	int threads;
+	SelectionFormula formula;
+	float exploration;      //!< c in the selection formula
+	LeafEvaluation leaf;
+	int playoutPlies;
+	/// Losses a thread adds to every node on its path, so that the other
+	/// threads look elsewhere until it backs up the real result.
+	int virtualLoss;
+	size_t poolSize;        //!< Nodes of the tree, the search stops when they run out
+	bool reuseTree;         //!< Keep the subtree of the position given to the next think()
+	uint64_t seed;          //!< Of the random playouts
+	/// Positions of the threads run together through the policy network, at most one per thread.
+	int batchSize;
+	/// Microseconds a thread waits for the others to fill a batch.
+	int batchWait;
+
+	MCTSConfig()
+	: threads(1), formula(SelectionFormula::PUCT), exploration(1.5f),
+	  leaf(LeafEvaluation::STATIC), playoutPlies(16), virtualLoss(3),
+	  poolSize(1 << 22), reuseTree(true), seed(1), batchSize(16), batchWait(200) {}
+};
+
+/// What the last think() did.
+struct MCTSStats {
+	uint64_t iterations;  //!< Leaves evaluated
+	size_t nodes;         //!< Nodes of the tree at the end
+	size_t reusedNodes;   //!< Nodes kept from the previous search
+	int maxDepth;         //!< Deepest leaf, in plies from the root
+	int64_t time;         //!< Milliseconds
+	uint64_t batches;     //!< Forward passes of the policy network
+};
+
+/**
+ * Monte Carlo tree search: every iteration walks down the tree choosing
+ * children by their average result and an exploration bonus, expands the
+ * leaf it reaches, estimates its value and adds it to every node on the way.
+ * The move played is the most visited child of the root.
+ *
+ * The tree lives in a pool of nodes allocated once; the children of a node
+ * are contiguous in it, so a node only stores where they start. All the
+ * threads share the tree: visits and values are atomic counters, the first
+ * thread to reach a leaf expands it, and virtual losses spread the threads
+ * over different lines.
+ *
+ * Results are in [-1, 1], +1 being a win for the player who made the move
+ * leading to the node.
+ */
+class MCTS {
+public:
+	explicit MCTS(const MCTSConfig& config = MCTSConfig());
+	~MCTS();
+
+	MCTS(const MCTS&) = delete;
+	MCTS& operator = (const MCTS&) = delete;
+
+	/// Must not be called while thinking. A new pool size drops the tree.
+	void setConfig(const MCTSConfig& config);
+	const MCTSConfig& getConfig() const { return mConfig; }
+
+	/**
+	 * Takes the priors of the moves from @b network instead of giving every
+	 * move the same, or stops using a network when it is null. Must not be
+	 * called while thinking. A new network drops the tree.
+	 */
+	void setPolicy(std::shared_ptr<const PolicyNetwork> network);
+	const std::shared_ptr<const PolicyNetwork>& getPolicy() const { return mPolicy; }
+
+	/// Drops the tree, e.g. for a new game.
+	void clear();
+
+	/**
+	 * Searches @b root until a limit of @b limits is reached: SearchLimits::nodes
+	 * counts iterations, the time limits are shared with Search. Without any
+	 * limit, or while pondering, it runs until stop() or the pool is full.
+	 * SearchLimits::depth has no meaning here and is ignored.
+	 *
+	 * @return The best move for a piece of @b root, or an invalid Move when
+	 * there is no legal move.
+	 */
+	Move think(const BoardState& root, const SearchLimits& limits);
+
+	/// Makes a running think() return as soon as possible.
+	void stop() { mStop = true; }
+
+	const MCTSStats& getStats() const { return mStats; }
+
+	/// Average result of the root for the side to move, after think().
+	float getRootValue() const;
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	static const uint32_t NO_NODE = UINT32_MAX;
+	/// The tree is not walked deeper than this, the leaf is evaluated instead.
+	static const int MAX_DEPTH = 128;
+	/// Results are summed as integers in units of 1 / VALUE_SCALE.
+	static const int64_t VALUE_SCALE = 1 << 16;
+
+	enum NodeState : uint8_t {
+		UNEXPANDED,
+		EXPANDING,   //!< A thread is creating the children
+		EXPANDED,
+		CHECKMATED,  //!< The side to move has no move, these two are final
+		STALEMATED
+	};
+
+	/// 24 bytes, the pool holds millions of them.
+	struct Node {
+		std::atomic<int64_t> value;    //!< Sum of the results, virtual losses included
+		std::atomic<uint32_t> visits;  //!< Virtual visits included
+		uint32_t firstChild;           //!< Only valid once EXPANDED
+		float prior;
+		uint16_t move;                 //!< BoardState::encodeMove() code from the parent
+		uint8_t childCount;
+		std::atomic<uint8_t> state;
+	};
+
+	/// What one thread needs to walk the tree, its moves stacked by ply.
+	struct Walker {
+		BoardState state;
+		uint64_t random;
+		std::vector<uint32_t> path;
+		std::vector<Move> moves;
+		std::vector<BoardState::UndoInfo> undos;
+		int maxDepth;
+	};
+
+	MCTSConfig mConfig;
+	std::shared_ptr<const PolicyNetwork> mPolicy;
+	/// Only while thinking with a policy network.
+	std::unique_ptr<PolicyBatcher> mBatcher;
+	std::unique_ptr<Node[]> mNodes;      //!< Allocated by the first think()
+	std::atomic<uint32_t> mNodeCount;
+	uint32_t mRoot;
+	BoardState mRootState;               //!< Position of mRoot
+	bool mHasTree;
+
+	std::atomic<bool> mStop;
+	std::atomic<uint64_t> mIterations;
+	std::atomic<int> mMaxDepth;
+	SearchLimits mLimits;
+	Clock::time_point mStartTime;
+	int64_t mTimeLimit;                  //!< Milliseconds, 0 without a time limit
+	MCTSStats mStats;
+
+	/// Looks for @b root one or two plies below mRoot and keeps only its subtree.
+	bool reuseTree(const BoardState& root);
+	uint32_t findNode(const BoardState& position) const;
+	/// Moves the subtree of @b root to the start of the pool.
+	void compact(uint32_t root);
+
+	void work(int id);
+	/// Walks from the root to a leaf and backs up its value.
+	void iterate(Walker& w);
+	/// Picks the child of @b parent to walk into and adds a virtual loss to it.
+	uint32_t selectChild(const Node& parent);
+	/// Creates the children of @b node, returns false when another thread is at it or the pool is full.
+	bool expand(Node& node, const BoardState& state);
+	/// Value of the leaf at @b ply for its side to move.
+	float evaluateLeaf(Walker& w, int ply);
+
+	void allocateTime(const BoardState& root);
+	int64_t elapsed() const;
+	void checkLimits();
+};
+
+} /* namespace sch */
+
+#endif /* MCTS_H_ */
@@ -0,0 +1,390 @@
+//===-- smart-chess/MailboxBoard.cpp ----------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file MailboxBoard.cpp
+/// \brief Board backend on a plain array of squares with a 10x12 border.
+///
+//===----------------------------------------------------------------------===//
+
+#include "MailboxBoard.h"
+#include "Zobrist.h"
+#include <cstdlib>
+#include <cstring>
+
+using namespace std;
+
+namespace sch {
+
+namespace {
+	/// The 64 squares inside a border two squares high and one wide, -1 off the board.
+	const int MAILBOX[120] = {
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1,  0,  1,  2,  3,  4,  5,  6,  7, -1,
+		-1,  8,  9, 10, 11, 12, 13, 14, 15, -1,
+		-1, 16, 17, 18, 19, 20, 21, 22, 23, -1,
+		-1, 24, 25, 26, 27, 28, 29, 30, 31, -1,
+		-1, 32, 33, 34, 35, 36, 37, 38, 39, -1,
+		-1, 40, 41, 42, 43, 44, 45, 46, 47, -1,
+		-1, 48, 49, 50, 51, 52, 53, 54, 55, -1,
+		-1, 56, 57, 58, 59, 60, 61, 62, 63, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+	};
+
+	/// Where every square is in MAILBOX.
+	const int MAILBOX64[SQUARE_COUNT] = {
+		21, 22, 23, 24, 25, 26, 27, 28,
+		31, 32, 33, 34, 35, 36, 37, 38,
+		41, 42, 43, 44, 45, 46, 47, 48,
+		51, 52, 53, 54, 55, 56, 57, 58,
+		61, 62, 63, 64, 65, 66, 67, 68,
+		71, 72, 73, 74, 75, 76, 77, 78,
+		81, 82, 83, 84, 85, 86, 87, 88,
+		91, 92, 93, 94, 95, 96, 97, 98
+	};
+
+	// Steps in MAILBOX, a negative row step goes towards the 8th row
+	const int KNIGHT_OFFSETS[8] = { -21, -19, -12, -8, 8, 12, 19, 21 };
+	const int KING_OFFSETS[8] = { -11, -10, -9, -1, 1, 9, 10, 11 };
+	const int ROOK_OFFSETS[4] = { -10, -1, 1, 10 };
+	const int BISHOP_OFFSETS[4] = { -11, -9, 9, 11 };
+
+	/// The square @b offset away from @b square, -1 when it is off the board.
+	inline int step(int square, int offset) { return MAILBOX[MAILBOX64[square] + offset]; }
+
+	inline bool isEnemy(PieceType type, bool white) {
+		return type != PieceType::UNDEFINED && isWhitePieceType(type) != white;
+	}
+
+	bool isAttacked(const PieceType* board, int square, bool by_white) {
+		// A pawn attacks from the row behind it
+		const PieceType pawn = makePieceType(PAWN_KIND, by_white);
+		const int pawn_row = by_white ? 10 : -10;
+		for(int side = -1; side <= 1; side += 2) {
+			const int from = step(square, pawn_row + side);
+			if(from >= 0 && board[from] == pawn)
+				return true;
+		}
+
+		const PieceType knight = makePieceType(KNIGHT_KIND, by_white);
+		const PieceType king = makePieceType(KING_KIND, by_white);
+		for(int i = 0; i < 8; ++i) {
+			int from = step(square, KNIGHT_OFFSETS[i]);
+			if(from >= 0 && board[from] == knight)
+				return true;
+			from = step(square, KING_OFFSETS[i]);
+			if(from >= 0 && board[from] == king)
+				return true;
+		}
+
+		const PieceType queen = makePieceType(QUEEN_KIND, by_white);
+		const PieceType rook = makePieceType(ROOK_KIND, by_white);
+		const PieceType bishop = makePieceType(BISHOP_KIND, by_white);
+		for(int i = 0; i < 4; ++i) {
+			for(int from = step(square, ROOK_OFFSETS[i]); from >= 0; from = step(from, ROOK_OFFSETS[i])) {
+				if(board[from] == PieceType::UNDEFINED)
+					continue;
+				if(board[from] == rook || board[from] == queen)
+					return true;
+				break;
+			}
+			for(int from = step(square, BISHOP_OFFSETS[i]); from >= 0; from = step(from, BISHOP_OFFSETS[i])) {
+				if(board[from] == PieceType::UNDEFINED)
+					continue;
+				if(board[from] == bishop || board[from] == queen)
+					return true;
+				break;
+			}
+		}
+		return false;
+	}
+
+	/// The castling rights left after a move from or to @b square.
+	inline int castlingMask(int square) {
+		switch(square) {
+		case 0: return ~BoardState::BLACK_QUEEN_SIDE;
+		case 4: return ~(BoardState::BLACK_KING_SIDE | BoardState::BLACK_QUEEN_SIDE);
+		case 7: return ~BoardState::BLACK_KING_SIDE;
+		case 56: return ~BoardState::WHITE_QUEEN_SIDE;
+		case 60: return ~(BoardState::WHITE_KING_SIDE | BoardState::WHITE_QUEEN_SIDE);
+		case 63: return ~BoardState::WHITE_KING_SIDE;
+		}
+		return BoardState::ALL_CASTLING_RIGHTS;
+	}
+
+	inline uint16_t makeCode(int from, int to, int promotion_kind = 0) {
+		return static_cast<uint16_t>(from | (to << 6) | (promotion_kind << 12));
+	}
+}
+
+MailboxBoard::MailboxBoard()
+: mWhiteToMove(true), mCastlingRights(0), mEnPassant(-1), mHashKey(0), mHalfmoveClock(0),
+  mScore(), mPhase(0) {
+	for(int sq = 0; sq < SQUARE_COUNT; ++sq)
+		mBoard[sq] = PieceType::UNDEFINED;
+	mKingSquare[0] = mKingSquare[1] = -1;
+}
+
+void MailboxBoard::load(const BoardState& state) {
+	mScore = TaperedScore();
+	mPhase = 0;
+	for(int sq = 0; sq < SQUARE_COUNT; ++sq) {
+		mBoard[sq] = PieceType::UNDEFINED;
+		if(state.getPieceTypeAt(sq) != PieceType::UNDEFINED)
+			putPiece(sq, state.getPieceTypeAt(sq));
+	}
+	mWhiteToMove = state.getCurrentPlayer() == ChessPlayer::Color::WHITE;
+	mCastlingRights = state.getCastlingRights();
+	mEnPassant = state.getEnPassantSquare().isValid() ? toSquareIndex(state.getEnPassantSquare()) : -1;
+	mHalfmoveClock = state.getHalfmoveClock();
+	mHashKey = state.getHashKey();
+}
+
+void MailboxBoard::putPiece(int square, PieceType type) {
+	const PieceSquareTable& pst = PieceSquareTable::instance();
+	mBoard[square] = type;
+	mHashKey ^= Zobrist::instance().getPieceKey(type, square);
+	mScore += pst.getScore(type, square);
+	mPhase += pst.getPhase(type);
+	if(getPieceKind(type) == KING_KIND)
+		mKingSquare[isWhitePieceType(type) ? 0 : 1] = square;
+}
+
+PieceType MailboxBoard::takePiece(int square) {
+	const PieceSquareTable& pst = PieceSquareTable::instance();
+	const PieceType type = mBoard[square];
+	mBoard[square] = PieceType::UNDEFINED;
+	mHashKey ^= Zobrist::instance().getPieceKey(type, square);
+	mScore -= pst.getScore(type, square);
+	mPhase -= pst.getPhase(type);
+	return type;
+}
+
+size_t MailboxBoard::getPseudoLegalMoves(uint16_t* out) const {
+	const bool white = mWhiteToMove;
+	size_t count = 0;
+
+	for(int from = 0; from < SQUARE_COUNT; ++from) {
+		const PieceType type = mBoard[from];
+		if(type == PieceType::UNDEFINED || isWhitePieceType(type) != white)
+			continue;
+
+		switch(getPieceKind(type)) {
+		case PAWN_KIND: {
+			const int forward = white ? -10 : 10;
+			const int last_row = white ? 0 : 7;
+			const int start_row = white ? 6 : 1;
+			auto add = [&](int to) {
+				if(to / MAX_COL == last_row) {
+					for(int kind = QUEEN_KIND; kind <= KNIGHT_KIND; ++kind)
+						out[count++] = makeCode(from, to, kind);
+				} else {
+					out[count++] = makeCode(from, to);
+				}
+			};
+			const int to = step(from, forward);
+			if(to >= 0 && mBoard[to] == PieceType::UNDEFINED) {
+				add(to);
+				const int to2 = step(to, forward);
+				if(from / MAX_COL == start_row && mBoard[to2] == PieceType::UNDEFINED)
+					out[count++] = makeCode(from, to2);
+			}
+			for(int side = -1; side <= 1; side += 2) {
+				const int target = step(from, forward + side);
+				if(target >= 0 && (isEnemy(mBoard[target], white) || target == mEnPassant))
+					add(target);
+			}
+			break;
+		}
+		case KNIGHT_KIND:
+		case KING_KIND: {
+			const int* offsets = getPieceKind(type) == KNIGHT_KIND ? KNIGHT_OFFSETS : KING_OFFSETS;
+			for(int i = 0; i < 8; ++i) {
+				const int to = step(from, offsets[i]);
+				if(to >= 0 && (mBoard[to] == PieceType::UNDEFINED || isEnemy(mBoard[to], white)))
+					out[count++] = makeCode(from, to);
+			}
+			break;
+		}
+		default: {
+			const int kind = getPieceKind(type);
+			for(int d = 0; d < 8; ++d) {
+				int offset;
+				if(d < 4) {
+					if(kind == BISHOP_KIND)
+						continue;
+					offset = ROOK_OFFSETS[d];
+				} else {
+					if(kind == ROOK_KIND)
+						break;
+					offset = BISHOP_OFFSETS[d - 4];
+				}
+				for(int to = step(from, offset); to >= 0; to = step(to, offset)) {
+					if(mBoard[to] == PieceType::UNDEFINED) {
+						out[count++] = makeCode(from, to);
+						continue;
+					}
+					if(isEnemy(mBoard[to], white))
+						out[count++] = makeCode(from, to);
+					break;
+				}
+			}
+			break;
+		}
+		}
+	}
+
+	// Castling, the squares the king crosses must be empty and safe
+	const int king = white ? 60 : 4;
+	const int king_side = white ? BoardState::WHITE_KING_SIDE : BoardState::BLACK_KING_SIDE;
+	const int queen_side = white ? BoardState::WHITE_QUEEN_SIDE : BoardState::BLACK_QUEEN_SIDE;
+	if((mCastlingRights & (king_side | queen_side)) && !isAttacked(mBoard, king, !white)) {
+		if((mCastlingRights & king_side) && mBoard[king + 1] == PieceType::UNDEFINED
+				&& mBoard[king + 2] == PieceType::UNDEFINED
+				&& !isAttacked(mBoard, king + 1, !white) && !isAttacked(mBoard, king + 2, !white))
+			out[count++] = makeCode(king, king + 2);
+		if((mCastlingRights & queen_side) && mBoard[king - 1] == PieceType::UNDEFINED
+				&& mBoard[king - 2] == PieceType::UNDEFINED && mBoard[king - 3] == PieceType::UNDEFINED
+				&& !isAttacked(mBoard, king - 1, !white) && !isAttacked(mBoard, king - 2, !white))
+			out[count++] = makeCode(king, king - 2);
+	}
+	return count;
+}
+
+size_t MailboxBoard::getLegalMoves(uint16_t* out) const {
+	uint16_t moves[BoardState::MAX_MOVES];
+	const size_t pseudo = getPseudoLegalMoves(moves);
+	const bool white = mWhiteToMove;
+
+	PieceType scratch[SQUARE_COUNT];
+	size_t count = 0;
+	for(size_t i = 0; i < pseudo; ++i) {
+		const int from = moves[i] & 63;
+		const int to = (moves[i] >> 6) & 63;
+		const PieceType type = mBoard[from];
+		const int kind = getPieceKind(type);
+		if(kind == KING_KIND && abs(to - from) == 2) {
+			// Castling was checked while generating it
+			out[count++] = moves[i];
+			continue;
+		}
+
+		memcpy(scratch, mBoard, sizeof(scratch));
+		if(kind == PAWN_KIND && to == mEnPassant)
+			scratch[from / MAX_COL * MAX_COL + to % MAX_COL] = PieceType::UNDEFINED;
+		scratch[to] = type;
+		scratch[from] = PieceType::UNDEFINED;
+		const int king = kind == KING_KIND ? to : mKingSquare[white ? 0 : 1];
+		if(!isAttacked(scratch, king, !white))
+			out[count++] = moves[i];
+	}
+	return count;
+}
+
+void MailboxBoard::makeMove(uint16_t code, Undo& undo) {
+	const int from = code & 63;
+	const int to = (code >> 6) & 63;
+	const int promotion = code >> 12;
+	const bool white = mWhiteToMove;
+	const int kind = getPieceKind(mBoard[from]);
+
+	undo.castlingRights = mCastlingRights;
+	undo.enPassant = mEnPassant;
+	undo.halfmoveClock = mHalfmoveClock;
+	undo.hashKey = mHashKey;
+
+	const int captured_at = kind == PAWN_KIND && to == mEnPassant ? from / MAX_COL * MAX_COL + to % MAX_COL : to;
+	undo.captured = mBoard[captured_at] != PieceType::UNDEFINED ? takePiece(captured_at) : PieceType::UNDEFINED;
+
+	const PieceType type = takePiece(from);
+	putPiece(to, promotion ? makePieceType(promotion, white) : type);
+
+	if(kind == KING_KIND && abs(to - from) == 2) {
+		const bool king_side = to > from;
+		putPiece(king_side ? to - 1 : to + 1, takePiece(king_side ? to + 1 : to - 2));
+	}
+
+	const Zobrist& z = Zobrist::instance();
+	mHashKey ^= z.getCastlingKey(mCastlingRights);
+	mCastlingRights &= castlingMask(from) & castlingMask(to);
+	mHashKey ^= z.getCastlingKey(mCastlingRights);
+
+	// As BoardState: only kept when a pawn of the other side can capture
+	if(mEnPassant >= 0)
+		mHashKey ^= z.getEnPassantKey(static_cast<Column>(mEnPassant % MAX_COL));
+	mEnPassant = -1;
+	if(kind == PAWN_KIND && abs(to - from) == 2 * MAX_COL) {
+		const PieceType enemy_pawn = makePieceType(PAWN_KIND, !white);
+		const int col = to % MAX_COL;
+		if((col > 0 && mBoard[to - 1] == enemy_pawn) || (col < MAX_COL - 1 && mBoard[to + 1] == enemy_pawn)) {
+			mEnPassant = (from + to) / 2;
+			mHashKey ^= z.getEnPassantKey(static_cast<Column>(col));
+		}
+	}
+
+	mHalfmoveClock = kind == PAWN_KIND || undo.captured != PieceType::UNDEFINED ? 0 : mHalfmoveClock + 1;
+	mWhiteToMove = !white;
+	mHashKey ^= z.getSideKey();
+}
+
+void MailboxBoard::unmakeMove(uint16_t code, const Undo& undo) {
+	const int from = code & 63;
+	const int to = (code >> 6) & 63;
+	const int promotion = code >> 12;
+	mWhiteToMove = !mWhiteToMove;
+	const bool white = mWhiteToMove;
+
+	const PieceType moved = takePiece(to);
+	const int kind = promotion ? PAWN_KIND : getPieceKind(moved);
+	putPiece(from, promotion ? makePieceType(PAWN_KIND, white) : moved);
+
+	if(kind == KING_KIND && abs(to - from) == 2) {
+		const bool king_side = to > from;
+		putPiece(king_side ? to + 1 : to - 2, takePiece(king_side ? to - 1 : to + 1));
+	}
+
+	if(undo.captured != PieceType::UNDEFINED) {
+		const int captured_at = kind == PAWN_KIND && to == undo.enPassant
+				? from / MAX_COL * MAX_COL + to % MAX_COL : to;
+		putPiece(captured_at, undo.captured);
+	}
+
+	mCastlingRights = undo.castlingRights;
+	mEnPassant = undo.enPassant;
+	mHalfmoveClock = undo.halfmoveClock;
+	mHashKey = undo.hashKey;
+}
+
+bool MailboxBoard::isInCheck() const {
+	return isAttacked(mBoard, mKingSquare[mWhiteToMove ? 0 : 1], !mWhiteToMove);
+}
+
+int MailboxBoard::evaluate() const {
+	const int score = blendScore(mScore, mPhase);
+	return mWhiteToMove ? score : -score;
+}
+
+} /* namespace sch */
@@ -0,0 +1,101 @@
+//===-- smart-chess/MailboxBoard.h ------------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file MailboxBoard.h
+/// \brief Board backend on a plain array of squares with a 10x12 border.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef MAILBOXBOARD_H_
+#define MAILBOXBOARD_H_
+
+#include <cstddef>
+#include <cstdint>
+#include "BoardState.h"
+#include "Evaluation.h"
+
+namespace sch {
+
+/**
+ * The textbook mailbox representation: one PieceType per square and nothing
+ * else. Pieces walk the board through a 10x12 array whose border marks the
+ * squares off the board, moves are generated pseudo-legally and a move is
+ * legal when the king is not attacked on a scratch copy of the 64 squares.
+ *
+ * A backend for the templated algorithms, see BoardTraits.
+ */
+class MailboxBoard {
+public:
+	struct Undo {
+		PieceType captured;
+		int castlingRights;
+		int enPassant;
+		int halfmoveClock;
+		uint64_t hashKey;
+	};
+
+	static const char* getName() { return "mailbox"; }
+
+	MailboxBoard();
+
+	/// Copies the position of @b state, its history is not needed.
+	void load(const BoardState& state);
+
+	/// Writes the legal moves as BoardState::encodeMove() codes, @b out needs room for MAX_MOVES.
+	size_t getLegalMoves(uint16_t* out) const;
+
+	void makeMove(uint16_t code, Undo& undo);
+	void unmakeMove(uint16_t code, const Undo& undo);
+
+	bool isInCheck() const;
+	/// Same score as sch::evaluate() gives the same position.
+	int evaluate() const;
+
+	PieceType getPieceTypeAt(int square) const { return mBoard[square]; }
+	int getKingSquare(bool white) const { return mKingSquare[white ? 0 : 1]; }
+	bool isWhiteToMove() const { return mWhiteToMove; }
+	int getHalfmoveClock() const { return mHalfmoveClock; }
+	/// The same key BoardState::getHashKey() gives the same position.
+	uint64_t getHashKey() const { return mHashKey; }
+
+private:
+	PieceType mBoard[SQUARE_COUNT];
+	bool mWhiteToMove;
+	int mCastlingRights;   //!< BoardState::CastlingRight mask
+	int mEnPassant;        //!< Square a pawn can capture en passant, -1 when none
+	uint64_t mHashKey;
+	int mHalfmoveClock;
+	int mKingSquare[2];    //!< White, black
+	TaperedScore mScore;
+	int mPhase;
+
+	void putPiece(int square, PieceType type);
+	PieceType takePiece(int square);
+	size_t getPseudoLegalMoves(uint16_t* out) const;
+};
+
+} /* namespace sch */
+
+#endif /* MAILBOXBOARD_H_ */
@@ -0,0 +1,79 @@
+//===-- smart-chess/MappedFile.cpp ------------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file MappedFile.cpp
+/// \brief Read only memory mapping of a whole file.
+///
+//===----------------------------------------------------------------------===//
+
+#include "MappedFile.h"
+#include "Util.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace sch {
+
+MappedFile::MappedFile(const std::string& path)
+: mPath(path), mData(nullptr), mSize(0) {
+	const int fd = open(path.c_str(), O_RDONLY);
+	if(fd < 0)
+		throw FileException(path, strerror(errno));
+
+	struct stat st;
+	if(fstat(fd, &st) != 0) {
+		const int error = errno;
+		close(fd);
+		throw FileException(path, strerror(error));
+	}
+
+	mSize = static_cast<size_t>(st.st_size);
+	if(mSize) {
+		void* p = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, fd, 0);
+		if(p == MAP_FAILED) {
+			const int error = errno;
+			close(fd);
+			throw FileException(path, strerror(error));
+		}
+		mData = static_cast<const char*>(p);
+	}
+	// The mapping stays valid after the descriptor is closed
+	close(fd);
+}
+
+MappedFile::~MappedFile() {
+	if(mData)
+		munmap(const_cast<char*>(mData), mSize);
+}
+
+void MappedFile::adviseSequential() const {
+	if(mData)
+		madvise(const_cast<char*>(mData), mSize, MADV_SEQUENTIAL);
+}
+
+} /* namespace sch */
@@ -0,0 +1,68 @@
+//===-- smart-chess/MappedFile.h --------------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file MappedFile.h
+/// \brief Read only memory mapping of a whole file.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef MAPPEDFILE_H_
+#define MAPPEDFILE_H_
+
+#include <cstddef>
+#include <string>
+
+namespace sch {
+
+/**
+ * Maps a file read only into memory for as long as the object lives, so big
+ * databases can be scanned without reading them into buffers first.
+ */
+class MappedFile {
+public:
+	/// @throw FileException When the file cannot be opened or mapped.
+	explicit MappedFile(const std::string& path);
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator = (const MappedFile&) = delete;
+
+	/// The first byte of the file, null for an empty file.
+	const char* getData() const { return mData; }
+	size_t getSize() const { return mSize; }
+	const std::string& getPath() const { return mPath; }
+
+	/// Hints the kernel that the file will be read front to back.
+	void adviseSequential() const;
+
+private:
+	std::string mPath;
+	const char* mData;
+	size_t mSize;
+};
+
+} /* namespace sch */
+
+#endif /* MAPPEDFILE_H_ */
@@ -0,0 +1,253 @@
+//===-- smart-chess/Match.cpp -----------------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file Match.cpp
+/// \brief Plays engine against engine games and keeps the match statistics.
+///
+//===----------------------------------------------------------------------===//
+
+#include "Match.h"
+#include "BoardState.h"
+#include "Notation.h"
+#include "PGNWriter.h"
+#include "Search.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+using namespace std;
+
+namespace sch {
+
+namespace {
+	double toElo(double score) {
+		score = min(max(score, 1e-6), 1.0 - 1e-6);
+		return -400.0 * log10(1.0 / score - 1.0);
+	}
+
+	double toScore(double elo) {
+		return 1.0 / (1.0 + pow(10.0, -elo / 400.0));
+	}
+}
+
+void EngineConfig::configure(Search& search) const {
+	search.setHashSize(hashSize);
+	search.setThreads(threads);
+}
+
+GameRecord playGame(const EngineConfig& white_config, Search& white,
+		const EngineConfig& black_config, Search& black,
+		const std::string& fen, int max_plies, const MoveObserver& observer) {
+	typedef chrono::steady_clock Clock;
+
+	BoardState state;
+	if(!fen.empty())
+		state.loadFEN(fen);
+
+	GameRecord game;
+	game.white = white_config.name;
+	game.black = black_config.name;
+	game.startFEN = fen;
+
+	white.clear();
+	black.clear();
+
+	const EngineConfig* configs[2] = { &white_config, &black_config };
+	Search* searches[2] = { &white, &black };
+	int64_t clocks[2] = { white_config.baseTime, black_config.baseTime };
+
+	for(int ply = 0; ; ++ply) {
+		const int side = state.getCurrentPlayer() == ChessPlayer::Color::WHITE ? 0 : 1;
+		const GameResult loss = side == 0 ? GameResult::BLACK_WINS : GameResult::WHITE_WINS;
+
+		const GameStatus status = state.getGameStatus();
+		if(status != GameStatus::IN_PROGRESS) {
+			game.termination = "normal";
+			if(status == GameStatus::CHECKMATE) {
+				game.result = loss;
+				game.reason = side == 0 ? "Black mates" : "White mates";
+			} else {
+				game.result = GameResult::DRAW;
+				game.reason = toString(status);
+			}
+			break;
+		}
+		if(ply >= max_plies) {
+			game.termination = "adjudication";
+			game.reason = "Maximum game length reached";
+			break;
+		}
+
+		const EngineConfig& config = *configs[side];
+		SearchLimits limits;
+		limits.depth = config.depth;
+		limits.nodes = config.nodes;
+		limits.moveTime = config.moveTime;
+		for(int i = 0; i < 2; ++i) {
+			if(configs[i]->baseTime > 0) {
+				limits.time[i] = static_cast<int>(max<int64_t>(1, clocks[i]));
+				limits.increment[i] = configs[i]->increment;
+			}
+		}
+
+		const Clock::time_point start = Clock::now();
+		const Move m = searches[side]->think(state, limits);
+		const int64_t used = chrono::duration_cast<chrono::milliseconds>(Clock::now() - start).count();
+
+		if(config.baseTime > 0) {
+			clocks[side] -= used;
+			if(clocks[side] < 0) {
+				game.result = loss;
+				game.termination = "time forfeit";
+				game.reason = side == 0 ? "White loses on time" : "Black loses on time";
+				break;
+			}
+			clocks[side] += config.increment;
+		}
+
+		if(!m.isValid()) {
+			game.result = loss;
+			game.termination = "rules infraction";
+			game.reason = side == 0 ? "White makes no move" : "Black makes no move";
+			break;
+		}
+
+		if(observer)
+			observer(state, m, searches[side]->getScore());
+		game.moves.push_back(toSAN(state, m));
+		BoardState::UndoInfo undo;
+		state.makeMove(m, undo);
+	}
+	return game;
+}
+
+const char* toString(GameResult result) {
+	switch(result) {
+	case GameResult::WHITE_WINS: return "1-0";
+	case GameResult::BLACK_WINS: return "0-1";
+	case GameResult::DRAW: break;
+	}
+	return "1/2-1/2";
+}
+
+void writePGN(std::ostream& os, const GameRecord& game, const std::string& event, int round) {
+	PGNTags tags;
+	tags.push_back(make_pair("Event", event));
+	tags.push_back(make_pair("Site", "?"));
+	tags.push_back(make_pair("Date", "????.??.??"));
+	tags.push_back(make_pair("Round", to_string(round)));
+	tags.push_back(make_pair("White", game.white));
+	tags.push_back(make_pair("Black", game.black));
+	tags.push_back(make_pair("Result", toString(game.result)));
+	if(!game.startFEN.empty()) {
+		tags.push_back(make_pair("FEN", game.startFEN));
+		tags.push_back(make_pair("SetUp", "1"));
+	}
+	tags.push_back(make_pair("Termination", game.termination));
+	tags.push_back(make_pair("PlyCount", to_string(game.moves.size())));
+	sch::writePGN(os, tags, game.moves, toString(game.result), game.reason);
+}
+
+void MatchStatistics::add(double score) {
+	if(score > 0.75)
+		++mWins;
+	else if(score < 0.25)
+		++mLosses;
+	else
+		++mDraws;
+}
+
+double MatchStatistics::getScore() const {
+	const int games = getGames();
+	return games ? (mWins + 0.5 * mDraws) / games : 0.5;
+}
+
+double MatchStatistics::getVariance() const {
+	// Results of only one or two kinds, like a run of wins, would give no
+	// variance and stall the LLR: half a game of each result keeps it going
+	double wins = mWins, draws = mDraws, losses = mLosses;
+	if(!mWins || !mDraws || !mLosses) {
+		wins += 0.5;
+		draws += 0.5;
+		losses += 0.5;
+	}
+	const double games = wins + draws + losses;
+	const double s = (wins + 0.5 * draws) / games;
+	return (wins * (1 - s) * (1 - s) + draws * (0.5 - s) * (0.5 - s) + losses * s * s) / games;
+}
+
+double MatchStatistics::getElo() const {
+	return toElo(getScore());
+}
+
+double MatchStatistics::getEloError() const {
+	const int games = getGames();
+	if(!games)
+		return 0;
+	const double margin = 1.959964 * sqrt(getVariance() / games);
+	const double s = getScore();
+	return (toElo(s + margin) - toElo(s - margin)) / 2;
+}
+
+double MatchStatistics::getLOS() const {
+	if(mWins + mLosses == 0)
+		return 0.5;
+	return 0.5 * (1 + erf((mWins - mLosses) / sqrt(2.0 * (mWins + mLosses))));
+}
+
+double MatchStatistics::getLLR(double elo0, double elo1) const {
+	const double variance = getVariance();
+	const double s0 = toScore(elo0);
+	const double s1 = toScore(elo1);
+	return getGames() * (s1 - s0) * (2 * getScore() - s0 - s1) / (2 * variance);
+}
+
+double SPRT::getLowerBound() const {
+	return log(beta / (1 - alpha));
+}
+
+double SPRT::getUpperBound() const {
+	return log((1 - beta) / alpha);
+}
+
+SPRT::Status SPRT::check(const MatchStatistics& stats) const {
+	const double llr = stats.getLLR(elo0, elo1);
+	if(llr >= getUpperBound())
+		return Status::ACCEPT_H1;
+	if(llr <= getLowerBound())
+		return Status::ACCEPT_H0;
+	return Status::CONTINUE;
+}
+
+const char* toString(SPRT::Status status) {
+	switch(status) {
+	case SPRT::Status::ACCEPT_H0: return "H0";
+	case SPRT::Status::ACCEPT_H1: return "H1";
+	case SPRT::Status::CONTINUE: break;
+	}
+	return "continue";
+}
+
+} /* namespace sch */
@@ -0,0 +1,177 @@
+//===-- smart-chess/Match.h -------------------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file Match.h
+/// \brief Plays engine against engine games and keeps the match statistics.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef MATCH_H_
+#define MATCH_H_
+
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "Util.h"
+
+namespace sch {
+
+class BoardState;
+template<typename Board> class BasicSearch;
+typedef BasicSearch<BoardState> Search;
+
+/// One side of a match: how its Search is set up and how long it may think.
+struct EngineConfig {
+	std::string name;
+	size_t hashSize;  //!< Transposition table size in MB
+	int threads;
+	int depth;        //!< 0 for no depth limit
+	uint64_t nodes;   //!< 0 for no node limit
+	int moveTime;     //!< Fixed milliseconds per move, 0 for none
+	int baseTime;     //!< Milliseconds on the clock at the start, 0 for no clock
+	int increment;    //!< Milliseconds added after every move
+
+	EngineConfig()
+	: name("smart-chess"), hashSize(16), threads(1), depth(0), nodes(0),
+	  moveTime(0), baseTime(0), increment(0) {}
+
+	/// Applies the hash size and the thread count to @b search.
+	void configure(Search& search) const;
+};
+
+enum class GameResult {
+	WHITE_WINS,
+	BLACK_WINS,
+	DRAW
+};
+
+/// Everything needed to write a finished game as PGN.
+struct GameRecord {
+	std::string white;
+	std::string black;
+	std::string startFEN;            //!< Empty when the game started from the initial position
+	std::vector<std::string> moves;  //!< Standard algebraic notation
+	GameResult result;
+	std::string termination;         //!< PGN Termination tag: "normal", "time forfeit", ...
+	std::string reason;              //!< Human readable, e.g. "Black mates"
+
+	GameRecord() : result(GameResult::DRAW) {}
+};
+
+/**
+ * Called for every move of a game before it is made, with the score the
+ * search gave it from the point of view of the side to move.
+ */
+typedef std::function<void(const BoardState& state, const Move& move, int score)> MoveObserver;
+
+/**
+ * Plays a whole game between two searches, clearing them first. The game is
+ * adjudicated as a draw after @b max_plies plies.
+ *
+ * @param fen The starting position, empty for the initial position.
+ * @throw FENException When @b fen is malformed.
+ */
+GameRecord playGame(const EngineConfig& white_config, Search& white,
+		const EngineConfig& black_config, Search& black,
+		const std::string& fen, int max_plies,
+		const MoveObserver& observer = MoveObserver());
+
+/// "1-0", "0-1" or "1/2-1/2".
+const char* toString(GameResult result);
+
+/// Writes @b game with the seven tag roster, FEN and Termination tags.
+void writePGN(std::ostream& os, const GameRecord& game, const std::string& event, int round);
+
+/**
+ * Wins, draws and losses of the first engine of a match, with the Elo
+ * difference they suggest and a sequential probability ratio test.
+ */
+class MatchStatistics {
+public:
+	MatchStatistics() : mWins(0), mDraws(0), mLosses(0) {}
+
+	/// @param score 1 for a win of the first engine, 0.5 for a draw and 0 for a loss.
+	void add(double score);
+
+	int getWins() const { return mWins; }
+	int getDraws() const { return mDraws; }
+	int getLosses() const { return mLosses; }
+	int getGames() const { return mWins + mDraws + mLosses; }
+
+	/// Average score per game, 0.5 when no game was played.
+	double getScore() const;
+
+	double getElo() const;
+
+	/// Half the width of the 95% confidence interval of getElo().
+	double getEloError() const;
+
+	/// Likelihood of superiority: the probability the first engine is stronger.
+	double getLOS() const;
+
+	/**
+	 * Generalized log-likelihood ratio of the hypothesis "the Elo difference
+	 * is @b elo1" against "it is @b elo0", using the normal approximation of
+	 * the score distribution.
+	 */
+	double getLLR(double elo0, double elo1) const;
+
+private:
+	int mWins;
+	int mDraws;
+	int mLosses;
+
+	double getVariance() const;
+};
+
+/// Wald's sequential probability ratio test on the Elo difference.
+struct SPRT {
+	enum class Status {
+		CONTINUE,
+		ACCEPT_H0, //!< The change is not better than elo0
+		ACCEPT_H1  //!< The change is at least elo1 better
+	};
+
+	double elo0;
+	double elo1;
+	double alpha; //!< Probability of accepting H1 when H0 is true
+	double beta;  //!< Probability of accepting H0 when H1 is true
+
+	SPRT() : elo0(0), elo1(5), alpha(0.05), beta(0.05) {}
+
+	double getLowerBound() const;
+	double getUpperBound() const;
+
+	Status check(const MatchStatistics& stats) const;
+};
+
+const char* toString(SPRT::Status status);
+
+} /* namespace sch */
+
+#endif /* MATCH_H_ */
@@ -0,0 +1,177 @@
+//===-- smart-chess/MoveCache.cpp -------------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file MoveCache.cpp
+/// \brief Legal move lists kept across moves for the pieces they did not affect.
+///
+//===----------------------------------------------------------------------===//
+
+#include "MoveCache.h"
+#include "Attacks.h"
+#include <cstring>
+
+using namespace std;
+
+namespace sch {
+
+namespace {
+	inline uint64_t bit(int square) { return uint64_t(1) << square; }
+
+	/// The pieces of both colors pinned to their king.
+	inline uint64_t getPinned(const BoardState& state) {
+		return state.getPinnedPieces(ChessPlayer::Color::WHITE) | state.getPinnedPieces(ChessPlayer::Color::BLACK);
+	}
+
+	/// Whether the king of each color is attacked.
+	inline void getChecks(const BoardState& state, bool* in_check) {
+		for(int c = 0; c < 2; ++c) {
+			const ChessPlayer::Color color = c ? ChessPlayer::Color::BLACK : ChessPlayer::Color::WHITE;
+			const ChessPlayer::Color enemy = c ? ChessPlayer::Color::WHITE : ChessPlayer::Color::BLACK;
+			in_check[c] = state.getAttacks(enemy) >> toSquareIndex(state.getKingPosition(color)) & 1;
+		}
+	}
+}
+
+MoveCache::MoveCache() : mValid(false), mHashKey(0), mCurrentPlayer(ChessPlayer::Color::WHITE),
+		mEnPassant(), mCastlingRights(0), mPinned(0) {
+	memset(mTargets, 0, sizeof(mTargets));
+	memset(mDependencies, 0, sizeof(mDependencies));
+	mInCheck[0] = mInCheck[1] = false;
+	resetStats();
+}
+
+void MoveCache::clear() {
+	mValid = false;
+}
+
+void MoveCache::resetStats() {
+	memset(&mStats, 0, sizeof(mStats));
+}
+
+void MoveCache::generate(const BoardState& state, int square) {
+	const PieceType type = state.getPieceTypeAt(square);
+	mTargets[square] = state.getLegalTargets(square);
+	++mStats.regenerated;
+
+	if(type == PieceType::UNDEFINED) {
+		mDependencies[square] = 0;
+		return;
+	}
+
+	const uint64_t from = bit(square);
+	const int kind = getPieceKind(type);
+	switch(kind) {
+	case PAWN_KIND: {
+		// The captures and the one or two squares ahead
+		const bool white = isWhitePieceType(type);
+		const uint64_t ahead = white ? from >> 8 : from << 8;
+		mDependencies[square] = AttackGenerator::getPawnAttacks(from, white) | ahead | (white ? ahead >> 8 : ahead << 8);
+		break;
+	}
+	case KNIGHT_KIND:
+		mDependencies[square] = AttackGenerator::getKnightAttacks(from);
+		break;
+	case KING_KIND:
+		// Regenerated after every move anyway
+		mDependencies[square] = 0;
+		break;
+	default: {
+		// The rays up to the first piece, which may move or be captured
+		static const AttackGenerator generator;
+		const uint64_t straight = kind == ROOK_KIND || kind == QUEEN_KIND ? from : 0;
+		const uint64_t diagonal = kind == BISHOP_KIND || kind == QUEEN_KIND ? from : 0;
+		mDependencies[square] = generator.getSliderAttacks(straight, diagonal, state.getOccupied());
+		break;
+	}
+	}
+}
+
+void MoveCache::sync(const BoardState& state) {
+	if(mValid && state.getHashKey() == mHashKey && state.getCurrentPlayer() == mCurrentPlayer
+			&& state.getCastlingRights() == mCastlingRights && state.getEnPassantSquare() == mEnPassant) {
+		++mStats.hits;
+		return;
+	}
+	++mStats.syncs;
+
+	const uint64_t pinned = getPinned(state);
+	bool in_check[2];
+	getChecks(state, in_check);
+
+	if(!mValid) {
+		for(int sq = 0; sq < SQUARE_COUNT; ++sq)
+			generate(state, sq);
+	} else {
+		uint64_t changed = 0;
+		for(int sq = 0; sq < SQUARE_COUNT; ++sq)
+			if(state.getPieceTypeAt(sq) != mBoard[sq])
+				changed |= bit(sq);
+		const bool en_passant_changed = !(state.getEnPassantSquare() == mEnPassant);
+
+		for(int sq = 0; sq < SQUARE_COUNT; ++sq) {
+			const PieceType type = state.getPieceTypeAt(sq);
+			bool stale = (changed | pinned | mPinned) >> sq & 1;
+			if(!stale && type != PieceType::UNDEFINED) {
+				const int color = isWhitePieceType(type) ? 0 : 1;
+				const int kind = getPieceKind(type);
+				stale = (mDependencies[sq] & changed) || kind == KING_KIND
+						|| in_check[color] || mInCheck[color]
+						|| (en_passant_changed && kind == PAWN_KIND);
+			}
+			if(stale)
+				generate(state, sq);
+			else if(type != PieceType::UNDEFINED)
+				++mStats.kept;
+		}
+	}
+
+	mValid = true;
+	mHashKey = state.getHashKey();
+	mCurrentPlayer = state.getCurrentPlayer();
+	mEnPassant = state.getEnPassantSquare();
+	mCastlingRights = state.getCastlingRights();
+	for(int sq = 0; sq < SQUARE_COUNT; ++sq)
+		mBoard[sq] = state.getPieceTypeAt(sq);
+	mPinned = pinned;
+	mInCheck[0] = in_check[0];
+	mInCheck[1] = in_check[1];
+}
+
+std::vector<BoardPosition> MoveCache::getMoves(BoardPosition pos) const {
+	vector<BoardPosition> moves;
+	if(!pos.isOnBoard())
+		return moves;
+	for(uint64_t targets = mTargets[toSquareIndex(pos)]; targets; targets &= targets - 1)
+		moves.push_back(toBoardPosition(__builtin_ctzll(targets)));
+	return moves;
+}
+
+bool MoveCache::contains(const Move& m) const {
+	if(!m.initial_pos.isOnBoard() || !m.final_pos.isOnBoard())
+		return false;
+	return mTargets[toSquareIndex(m.initial_pos)] >> toSquareIndex(m.final_pos) & 1;
+}
+
+} /* namespace sch */
@@ -0,0 +1,104 @@
+//===-- smart-chess/MoveCache.h ---------------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file MoveCache.h
+/// \brief Legal move lists kept across moves for the pieces they did not affect.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef MOVECACHE_H_
+#define MOVECACHE_H_
+
+#include <cstdint>
+#include <vector>
+#include "BoardState.h"
+
+namespace sch {
+
+/**
+ * The legal moves of every piece on the board, of both colors, kept up to
+ * date as the game goes on. Asking for the moves of a piece again and again,
+ * as the GUI does, only costs a lookup.
+ *
+ * After a move sync() compares the board with the one it last saw and
+ * regenerates only the pieces that can be affected: those on a changed
+ * square or whose rays or targets include one, the kings, pinned pieces,
+ * every piece of a side in check before or after the move, and the pawns of
+ * the side to move when the en passant square changed.
+ */
+class MoveCache {
+public:
+	/// How much work sync() did and skipped.
+	struct Stats {
+		uint64_t syncs;        //!< sync() calls with a new position
+		uint64_t hits;         //!< sync() calls with the position already cached
+		uint64_t regenerated;  //!< Piece lists generated
+		uint64_t kept;         //!< Piece lists reused after a move
+	};
+
+	MoveCache();
+
+	/// Forgets the cached position, the next sync() generates every list.
+	void clear();
+
+	/// Brings the lists up to date with @b state.
+	void sync(const BoardState& state);
+
+	/**
+	 * The squares the piece on @b square can legally move to, bit n for
+	 * square n, as if it were its turn. 0 for an empty square.
+	 */
+	uint64_t getTargets(int square) const { return mTargets[square]; }
+
+	/// The same squares as getTargets(), for the piece at @b pos.
+	std::vector<BoardPosition> getMoves(BoardPosition pos) const;
+
+	/// True when the piece on the initial square of @b m can go to its final square.
+	bool contains(const Move& m) const;
+
+	const Stats& getStats() const { return mStats; }
+	void resetStats();
+
+private:
+	bool mValid;
+	uint64_t mHashKey;
+	ChessPlayer::Color mCurrentPlayer;
+	BoardPosition mEnPassant;
+	int mCastlingRights;
+	PieceType mBoard[SQUARE_COUNT];
+	uint64_t mTargets[SQUARE_COUNT];
+	/// The squares whose contents the moves of each piece depend on.
+	uint64_t mDependencies[SQUARE_COUNT];
+	/// Pinned pieces of both colors and the sides in check, when last synced.
+	uint64_t mPinned;
+	bool mInCheck[2];
+	Stats mStats;
+
+	void generate(const BoardState& state, int square);
+};
+
+} /* namespace sch */
+
+#endif /* MOVECACHE_H_ */
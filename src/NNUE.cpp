@@ -0,0 +1,239 @@
+//===-- smart-chess/NNUE.cpp ------------------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file NNUE.cpp
+/// \brief Efficiently updatable neural network evaluation.
+///
+//===----------------------------------------------------------------------===//
+
+#include "NNUE.h"
+#include "BitboardBoard.h"
+#include "BoardState.h"
+#include "BoardTraits.h"
+#include "MailboxBoard.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+using namespace std;
+
+namespace sch {
+
+namespace {
+	const int SIZE = NNUEAccumulator::SIZE;
+	const int PIECE_CLASSES = 10;
+
+	/// Hidden layers keep the sum shifted right by this many bits.
+	const int WEIGHT_SHIFT = 6;
+	/// The output neuron counts this many units per centipawn.
+	const int OUTPUT_SCALE = 16;
+
+}
+
+NNUEDelta NNUEDelta::fromMove(const BoardState& before, const Move& m) {
+	return fromMove(before, BoardState::encodeMove(m));
+}
+
+template<typename Board>
+NNUEDelta NNUEDelta::fromMove(const Board& before, uint16_t code) {
+	typedef BoardTraits<Board> Traits;
+	NNUEDelta delta;
+	delta.count = 0;
+	const int from = code & 63;
+	const int to = (code >> 6) & 63;
+	const int promotion = code >> 12;
+	const PieceType type = Traits::getPieceTypeAt(before, from);
+	const int kind = getPieceKind(type);
+
+	// A capture en passant takes the pawn next to the target square
+	int captured_at = to;
+	if(kind == PAWN_KIND && from % MAX_COL != to % MAX_COL
+			&& Traits::getPieceTypeAt(before, to) == PieceType::UNDEFINED)
+		captured_at = from / MAX_COL * MAX_COL + to % MAX_COL;
+	const PieceType captured = Traits::getPieceTypeAt(before, captured_at);
+	if(captured != PieceType::UNDEFINED)
+		delta.changes[delta.count++] = { captured, captured_at, -1 };
+
+	if(promotion) {
+		delta.changes[delta.count++] = { type, from, -1 };
+		delta.changes[delta.count++] = { makePieceType(promotion, isWhitePieceType(type)), -1, to };
+	} else {
+		delta.changes[delta.count++] = { type, from, to };
+	}
+
+	if(kind == KING_KIND && abs(to % MAX_COL - from % MAX_COL) == 2) {
+		const bool king_side = to % MAX_COL == Column::G;
+		const int row = from / MAX_COL * MAX_COL;
+		delta.changes[delta.count++] = { makePieceType(ROOK_KIND, isWhitePieceType(type)),
+				row + (king_side ? Column::H : Column::A), row + (king_side ? Column::F : Column::D) };
+	}
+	return delta;
+}
+
+bool NNUEDelta::movesKing(int side) const {
+	const PieceType king = side == 0 ? PieceType::WHITE_KING : PieceType::BLACK_KING;
+	for(int i = 0; i < count; ++i)
+		if(changes[i].type == king)
+			return true;
+	return false;
+}
+
+size_t NNUENetwork::getFileSize() {
+	return sizeof(Header)
+			+ alignSection(SIZE * sizeof(int16_t)) + alignSection(size_t(INPUTS) * SIZE * sizeof(int16_t))
+			+ alignSection(HIDDEN1 * sizeof(int32_t)) + alignSection(HIDDEN1 * 2 * SIZE)
+			+ alignSection(HIDDEN2 * sizeof(int32_t)) + alignSection(HIDDEN2 * HIDDEN1)
+			+ alignSection(sizeof(int32_t)) + alignSection(HIDDEN2);
+}
+
+NNUENetwork::NNUENetwork(const std::string& path)
+: mFile(path), mSimd(getBestSimd()) {
+	static_assert(sizeof(Header) == SECTION_ALIGNMENT, "The network header must take 64 bytes");
+
+	if(mFile.getSize() < sizeof(Header))
+		throw FileException(path, "not a network file");
+	Header header;
+	memcpy(&header, mFile.getData(), sizeof(header));
+	if(memcmp(header.magic, "SCHNNUE", 8) != 0)
+		throw FileException(path, "not a network file");
+	if(header.version != VERSION)
+		throw FileException(path, "network version " + std::to_string(header.version)
+				+ ", expected " + std::to_string(VERSION));
+	if(header.inputs != INPUTS || header.accumulatorSize != SIZE
+			|| header.hidden1 != HIDDEN1 || header.hidden2 != HIDDEN2)
+		throw FileException(path, "unsupported network architecture");
+	if(mFile.getSize() != getFileSize())
+		throw FileException(path, "truncated network file");
+
+	// The mapping is page aligned and so are the sections relative to it
+	const char* p = mFile.getData() + sizeof(Header);
+	auto next = [&p](size_t size) {
+		const char* section = p;
+		p += alignSection(size);
+		return section;
+	};
+	mFeatureBiases = reinterpret_cast<const int16_t*>(next(SIZE * sizeof(int16_t)));
+	mFeatureWeights = reinterpret_cast<const int16_t*>(next(size_t(INPUTS) * SIZE * sizeof(int16_t)));
+	mBiases1 = reinterpret_cast<const int32_t*>(next(HIDDEN1 * sizeof(int32_t)));
+	mWeights1 = reinterpret_cast<const int8_t*>(next(HIDDEN1 * 2 * SIZE));
+	mBiases2 = reinterpret_cast<const int32_t*>(next(HIDDEN2 * sizeof(int32_t)));
+	mWeights2 = reinterpret_cast<const int8_t*>(next(HIDDEN2 * HIDDEN1));
+	mOutputBias = reinterpret_cast<const int32_t*>(next(sizeof(int32_t)));
+	mOutputWeights = reinterpret_cast<const int8_t*>(next(HIDDEN2));
+}
+
+void NNUENetwork::setSimd(Simd simd) {
+	mSimd = min(simd, getBestSimd());
+}
+
+int NNUENetwork::getFeature(int side, int king, PieceType type, int square) {
+	// Own pieces first, then the opponent's, queen to pawn
+	const bool own = isWhitePieceType(type) == (side == 0);
+	const int piece_class = (getPieceKind(type) - 1) * 2 + (own ? 0 : 1);
+	if(side == 1) {
+		king = mirrorSquare(king);
+		square = mirrorSquare(square);
+	}
+	return (king * PIECE_CLASSES + piece_class) * SQUARE_COUNT + square;
+}
+
+template<typename Board>
+void NNUENetwork::refresh(const Board& board, NNUEAccumulator& acc) const {
+	refresh(board, 0, acc);
+	refresh(board, 1, acc);
+	acc.computed = true;
+}
+
+template<typename Board>
+void NNUENetwork::refresh(const Board& board, int side, NNUEAccumulator& acc) const {
+	typedef BoardTraits<Board> Traits;
+	const Int8Kernels& k = getInt8Kernels(mSimd);
+	int16_t* values = acc.values[side];
+	memcpy(values, mFeatureBiases, sizeof(acc.values[side]));
+	const int king = Traits::getKingSquare(board, side == 0);
+	for(int sq = 0; sq < SQUARE_COUNT; ++sq) {
+		const PieceType type = Traits::getPieceTypeAt(board, sq);
+		if(type == PieceType::UNDEFINED || getPieceKind(type) == KING_KIND)
+			continue;
+		k.add(values, mFeatureWeights + size_t(getFeature(side, king, type, sq)) * SIZE, SIZE);
+	}
+}
+
+template<typename Board>
+void NNUENetwork::update(const NNUEDelta& delta, const Board& board, int side,
+		NNUEAccumulator& acc) const {
+	const Int8Kernels& k = getInt8Kernels(mSimd);
+	int16_t* values = acc.values[side];
+	const int king = BoardTraits<Board>::getKingSquare(board, side == 0);
+	for(int i = 0; i < delta.count; ++i) {
+		const NNUEDelta::Change& c = delta.changes[i];
+		if(getPieceKind(c.type) == KING_KIND)
+			continue; // The other side's king is not a feature
+		if(c.from >= 0)
+			k.subtract(values, mFeatureWeights + size_t(getFeature(side, king, c.type, c.from)) * SIZE, SIZE);
+		if(c.to >= 0)
+			k.add(values, mFeatureWeights + size_t(getFeature(side, king, c.type, c.to)) * SIZE, SIZE);
+	}
+}
+
+int NNUENetwork::evaluate(const NNUEAccumulator& acc, ChessPlayer::Color side_to_move) const {
+	const Int8Kernels& k = getInt8Kernels(mSimd);
+	const int us = side_to_move == ChessPlayer::Color::WHITE ? 0 : 1;
+
+	uint8_t input[2 * SIZE];
+	k.clip(acc.values[us], input, SIZE);
+	k.clip(acc.values[1 - us], input + SIZE, SIZE);
+
+	uint8_t hidden1[HIDDEN1];
+	for(int i = 0; i < HIDDEN1; ++i)
+		hidden1[i] = clipActivation((mBiases1[i] + k.dot(input, mWeights1 + i * 2 * SIZE, 2 * SIZE)) >> WEIGHT_SHIFT);
+
+	uint8_t hidden2[HIDDEN2];
+	for(int i = 0; i < HIDDEN2; ++i)
+		hidden2[i] = clipActivation((mBiases2[i] + k.dot(hidden1, mWeights2 + i * HIDDEN1, HIDDEN1)) >> WEIGHT_SHIFT);
+
+	return (*mOutputBias + k.dot(hidden2, mOutputWeights, HIDDEN2)) / OUTPUT_SCALE;
+}
+
+int NNUENetwork::evaluate(const BoardState& state) const {
+	NNUEAccumulator acc;
+	refresh(state, acc);
+	return evaluate(acc, state.getCurrentPlayer());
+}
+
+template NNUEDelta NNUEDelta::fromMove(const BoardState&, uint16_t);
+template NNUEDelta NNUEDelta::fromMove(const MailboxBoard&, uint16_t);
+template NNUEDelta NNUEDelta::fromMove(const BitboardBoard&, uint16_t);
+template void NNUENetwork::refresh(const BoardState&, NNUEAccumulator&) const;
+template void NNUENetwork::refresh(const MailboxBoard&, NNUEAccumulator&) const;
+template void NNUENetwork::refresh(const BitboardBoard&, NNUEAccumulator&) const;
+template void NNUENetwork::refresh(const BoardState&, int, NNUEAccumulator&) const;
+template void NNUENetwork::refresh(const MailboxBoard&, int, NNUEAccumulator&) const;
+template void NNUENetwork::refresh(const BitboardBoard&, int, NNUEAccumulator&) const;
+template void NNUENetwork::update(const NNUEDelta&, const BoardState&, int, NNUEAccumulator&) const;
+template void NNUENetwork::update(const NNUEDelta&, const MailboxBoard&, int, NNUEAccumulator&) const;
+template void NNUENetwork::update(const NNUEDelta&, const BitboardBoard&, int, NNUEAccumulator&) const;
+
+} /* namespace sch */
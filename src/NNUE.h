@@ -0,0 +1,184 @@
+//===-- smart-chess/NNUE.h --------------------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file NNUE.h
+/// \brief Efficiently updatable neural network evaluation.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef NNUE_H_
+#define NNUE_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "ChessPlayer.h"
+#include "MappedFile.h"
+#include "Simd.h"
+#include "Util.h"
+
+namespace sch {
+
+class BoardState;
+
+/**
+ * The first layer of the network for both sides: white [0] and black [1].
+ * It is the sum of the feature weights of the pieces as seen by that side,
+ * see NNUENetwork.
+ */
+struct NNUEAccumulator {
+	static const int SIZE = 256;
+
+	int16_t values[2][SIZE];
+	bool computed; //!< False until the values match the position
+};
+
+/**
+ * The pieces a move puts on and takes off the board, all the first layer
+ * needs to update an accumulator.
+ */
+struct NNUEDelta {
+	struct Change {
+		PieceType type;
+		int from; //!< -1 when the piece is put on the board
+		int to;   //!< -1 when the piece is taken off the board
+	};
+
+	Change changes[3]; //!< Moving piece, captured piece and castling rook at most
+	int count;
+
+	/// The changes of @b m, a legal move of @b before.
+	static NNUEDelta fromMove(const BoardState& before, const Move& m);
+
+	/// The changes of the move @b code, see BoardState::encodeMove(), on any BoardTraits backend.
+	template<typename Board>
+	static NNUEDelta fromMove(const Board& before, uint16_t code);
+
+	/// True when the king of @b side moves, which changes all the features of that side.
+	bool movesKing(int side) const;
+};
+
+/**
+ * A small quantized network in the HalfKP style, loaded from a file that
+ * stays memory mapped:
+ *
+ *  - Input: for each side, one feature per (own king square, piece other
+ *    than a king, its square), 64 * 640 = 40960 features, with the board
+ *    flipped for black.
+ *  - Feature transformer: 40960 -> 256 int16 per side, the NNUEAccumulator.
+ *  - The side to move half and the other half, clipped to [0, 127], feed
+ *    two dense int8 layers of 32 neurons and a single output neuron.
+ *
+ * Only a few features change on a move, so the accumulator is updated
+ * with a handful of vector additions instead of being computed again.
+ *
+ * Inference uses AVX2 or SSE4.1 when the CPU has them and plain C++
+ * otherwise, see Simd.
+ *
+ * File layout, little endian, every section starts at a multiple of 64:
+ *   Header
+ *   int16 feature biases[256], int16 feature weights[40960][256]
+ *   int32 biases[32], int8 weights[32][512]   (first hidden layer)
+ *   int32 biases[32], int8 weights[32][32]    (second hidden layer)
+ *   int32 bias, int8 weights[32]              (output, 64 bytes each)
+ *
+ * The hidden layers shift their sums right by 6 bits and clip them to
+ * [0, 127], the output is divided by 16 to get centipawns.
+ */
+class NNUENetwork {
+public:
+	static const int INPUTS = 64 * 10 * 64;
+	static const int HIDDEN1 = 32;
+	static const int HIDDEN2 = 32;
+
+	/// Increased whenever the layout of the file changes.
+	static const uint32_t VERSION = 1;
+
+	/// The first 64 bytes of a network file.
+	struct Header {
+		char magic[8];         //!< "SCHNNUE" and a null
+		uint32_t version;
+		uint32_t inputs;
+		uint32_t accumulatorSize;
+		uint32_t hidden1;
+		uint32_t hidden2;
+		uint32_t reserved[9];
+	};
+
+	/// The size of a network file, computed from the layout above.
+	static size_t getFileSize();
+
+	/// @throw FileException When @b path is not a network of this VERSION.
+	explicit NNUENetwork(const std::string& path);
+
+	NNUENetwork(const NNUENetwork&) = delete;
+	NNUENetwork& operator = (const NNUENetwork&) = delete;
+
+	const std::string& getPath() const { return mFile.getPath(); }
+
+	/// Uses @b simd, or the best supported one below it, for this network.
+	void setSimd(Simd simd);
+	Simd getSimd() const { return mSimd; }
+
+	/// Computes the accumulator of @b board, any BoardTraits backend, from scratch.
+	template<typename Board>
+	void refresh(const Board& board, NNUEAccumulator& acc) const;
+
+	/// Computes the half of the accumulator of @b side (0 white, 1 black) from scratch.
+	template<typename Board>
+	void refresh(const Board& board, int side, NNUEAccumulator& acc) const;
+
+	/**
+	 * Applies @b delta to the half of @b acc that belongs to @b side, whose
+	 * king must not move in @b delta.
+	 */
+	template<typename Board>
+	void update(const NNUEDelta& delta, const Board& board, int side, NNUEAccumulator& acc) const;
+
+	/// The score in centipawns from the point of view of @b side_to_move.
+	int evaluate(const NNUEAccumulator& acc, ChessPlayer::Color side_to_move) const;
+
+	/// Refreshes an accumulator and evaluates it, the slow path.
+	int evaluate(const BoardState& state) const;
+
+private:
+	MappedFile mFile;
+	const int16_t* mFeatureBiases;
+	const int16_t* mFeatureWeights;
+	const int32_t* mBiases1;
+	const int8_t* mWeights1;
+	const int32_t* mBiases2;
+	const int8_t* mWeights2;
+	const int32_t* mOutputBias;
+	const int8_t* mOutputWeights;
+	Simd mSimd;
+
+	/// The index of a piece of @b type on @b square as seen by @b side with its king on @b king.
+	static int getFeature(int side, int king, PieceType type, int square);
+};
+
+} /* namespace sch */
+
+#endif /* NNUE_H_ */
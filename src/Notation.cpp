@@ -0,0 +1,231 @@
+//===-- smart-chess/Notation.cpp --------------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file Notation.cpp
+/// \brief Conversions between moves and their text representation.
+///
+//===----------------------------------------------------------------------===//
+
+#include "Notation.h"
+#include "BitboardBoard.h"
+#include "BoardState.h"
+#include "BoardTraits.h"
+#include "MailboxBoard.h"
+#include <cstring>
+
+using namespace std;
+
+namespace sch {
+
+namespace {
+	const char PROMOTION_LETTERS[] = "kqrbnp";
+	const char SAN_LETTERS[] = "KQRBN";
+}
+
+std::string toAlgebraic(BoardPosition pos) {
+	string text(2, ' ');
+	text[0] = static_cast<char>('a' + pos.column);
+	text[1] = static_cast<char>('0' + (MAX_ROW - pos.row));
+	return text;
+}
+
+std::string toUCI(const Move& m) {
+	if(!m.initial_pos.isOnBoard() || !m.final_pos.isOnBoard())
+		return "0000";
+	string text = toAlgebraic(m.initial_pos) + toAlgebraic(m.final_pos);
+	if(m.promotion != PieceType::UNDEFINED)
+		text += PROMOTION_LETTERS[getPieceKind(m.promotion)];
+	return text;
+}
+
+std::string toSAN(const BoardState& state, const Move& m) {
+	const PieceType type = m.piece->getPieceType();
+	const int kind = getPieceKind(type);
+	const bool is_pawn = kind == getPieceKind(PieceType::WHITE_PAWN);
+	const int distance = m.final_pos.column - m.initial_pos.column;
+	string text;
+
+	if(kind == getPieceKind(PieceType::WHITE_KING) && (distance == 2 || distance == -2)) {
+		text = distance > 0 ? "O-O" : "O-O-O";
+	} else {
+		const bool capture = state.getPieceTypeAt(toSquareIndex(m.final_pos)) != PieceType::UNDEFINED
+				|| (is_pawn && m.final_pos.column != m.initial_pos.column);
+		const auto moves = state.getLegalMoves();
+
+		if(is_pawn) {
+			if(capture)
+				text += static_cast<char>('a' + m.initial_pos.column);
+		} else {
+			text += SAN_LETTERS[kind];
+			// Name the column, the row or both when another piece of the
+			// same type can go to the same square.
+			bool ambiguous = false, same_column = false, same_row = false;
+			for(auto& other : moves) {
+				if(other.piece->getPieceType() != type || !(other.final_pos == m.final_pos)
+						|| other.initial_pos == m.initial_pos)
+					continue;
+				ambiguous = true;
+				same_column |= other.initial_pos.column == m.initial_pos.column;
+				same_row |= other.initial_pos.row == m.initial_pos.row;
+			}
+			if(ambiguous) {
+				const string from = toAlgebraic(m.initial_pos);
+				if(!same_column)
+					text += from[0];
+				else if(!same_row)
+					text += from[1];
+				else
+					text += from;
+			}
+		}
+		if(capture)
+			text += 'x';
+		text += toAlgebraic(m.final_pos);
+		if(m.promotion != PieceType::UNDEFINED) {
+			text += '=';
+			text += SAN_LETTERS[getPieceKind(m.promotion)];
+		}
+	}
+
+	BoardState next(state);
+	BoardState::UndoInfo undo;
+	next.makeMove(next.decodeMove(BoardState::encodeMove(m)), undo);
+	if(next.isInCheck())
+		text += next.hasAnyLegalMove() ? '+' : '#';
+	return text;
+}
+
+template<typename Board>
+uint16_t parseSANCode(const Board& board, const char* text, size_t length) {
+	typedef BoardTraits<Board> Traits;
+	while(length && strchr("+#!?", text[length - 1]))
+		--length;
+	if(length < 2)
+		return 0;
+
+	const int king = getPieceKind(PieceType::WHITE_KING);
+	const int pawn = getPieceKind(PieceType::WHITE_PAWN);
+	int kind = pawn;
+	int castle = 0; // 1 king side, -1 queen side
+	int from_column = -1, from_row = -1;
+	int promotion = -1;
+	bool capture = false;
+	BoardPosition to;
+
+	if(text[0] == 'O' || text[0] == '0') {
+		if(length == 3 && (text[1] == '-') && text[2] == text[0])
+			castle = 1;
+		else if(length == 5 && text[1] == '-' && text[2] == text[0] && text[3] == '-' && text[4] == text[0])
+			castle = -1;
+		else
+			return 0;
+		kind = king;
+	} else {
+		size_t begin = 0;
+		if(const char* letter = strchr(SAN_LETTERS, text[0])) {
+			kind = static_cast<int>(letter - SAN_LETTERS);
+			begin = 1;
+		}
+
+		// Promotion, "e8=Q" or "e8Q"
+		if(kind == pawn && length >= 3 && strchr(SAN_LETTERS + 1, text[length - 1])) {
+			promotion = static_cast<int>(strchr(SAN_LETTERS, text[length - 1]) - SAN_LETTERS);
+			length -= text[length - 2] == '=' ? 2 : 1;
+		}
+
+		if(length < begin + 2)
+			return 0;
+		const char file = text[length - 2], rank = text[length - 1];
+		if(file < 'a' || file > 'h' || rank < '1' || rank > '8')
+			return 0;
+		to = BoardPosition(static_cast<Row>(MAX_ROW - (rank - '0')), static_cast<Column>(file - 'a'));
+
+		// Whatever is left between the piece and the target disambiguates
+		for(size_t i = begin; i < length - 2; ++i) {
+			const char c = text[i];
+			if(c >= 'a' && c <= 'h')
+				from_column = c - 'a';
+			else if(c >= '1' && c <= '8')
+				from_row = MAX_ROW - (c - '0');
+			else if(c == 'x')
+				capture = true;
+			else if(c != '-')
+				return 0;
+		}
+		// A pawn captures "exd5" but only moves straight ahead "d5"
+		if(kind == pawn && capture != (from_column >= 0))
+			return 0;
+	}
+
+	uint16_t codes[BoardState::MAX_MOVES];
+	const size_t count = Traits::getLegalMoves(board, codes);
+	const int target = castle ? -1 : toSquareIndex(to);
+	const int code_promotion = promotion < 0 ? 0 : promotion;
+	uint16_t found = 0;
+	int matches = 0;
+	for(size_t i = 0; i < count; ++i) {
+		const int from = codes[i] & 63;
+		const int dest = (codes[i] >> 6) & 63;
+		if(getPieceKind(Traits::getPieceTypeAt(board, from)) != kind)
+			continue;
+		if(castle) {
+			if(dest % MAX_COL - from % MAX_COL != 2 * castle)
+				continue;
+		} else {
+			if(dest != target)
+				continue;
+			if(from_column >= 0 && from % MAX_COL != from_column)
+				continue;
+			if(from_row >= 0 && from / MAX_COL != from_row)
+				continue;
+			if(kind == pawn && (from % MAX_COL != dest % MAX_COL) != capture)
+				continue;
+			if((codes[i] >> 12) != code_promotion)
+				continue;
+		}
+		found = codes[i];
+		++matches;
+	}
+	return matches == 1 ? found : 0;
+}
+
+template uint16_t parseSANCode(const BoardState&, const char*, size_t);
+template uint16_t parseSANCode(const MailboxBoard&, const char*, size_t);
+template uint16_t parseSANCode(const BitboardBoard&, const char*, size_t);
+
+Move parseSAN(const BoardState& state, const char* text, size_t length) {
+	const uint16_t code = parseSANCode(state, text, length);
+	return code ? state.decodeMove(code) : Move();
+}
+
+Move parseUCIMove(const BoardState& state, const std::string& text) {
+	for(auto& m : state.getLegalMoves()) {
+		if(toUCI(m) == text)
+			return m;
+	}
+	return Move();
+}
+
+} /* namespace sch */
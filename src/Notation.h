@@ -0,0 +1,91 @@
+//===-- smart-chess/Notation.h ----------------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file Notation.h
+/// \brief Conversions between moves and their text representation.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef NOTATION_H_
+#define NOTATION_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "Util.h"
+
+namespace sch {
+
+class BoardState;
+
+/// Lower case coordinates of a square, e.g. "e4".
+std::string toAlgebraic(BoardPosition pos);
+
+/// Long algebraic notation used by UCI, e.g. "e2e4" or "e7e8q".
+std::string toUCI(const Move& m);
+
+/**
+ * Standard algebraic notation of @b m as used in PGN files, e.g. "Nbd7",
+ * "exd6", "e8=Q+" or "O-O-O#".
+ *
+ * @param state The position before @b m, which must be legal in it.
+ */
+std::string toSAN(const BoardState& state, const Move& m);
+
+/**
+ * Finds the legal move of @b state written in standard algebraic notation.
+ * Check marks and annotations ("+", "#", "!?") are ignored, "0-0" is taken
+ * for "O-O" and a promotion may omit the "=".
+ *
+ * @return The move, or an invalid Move when @b text does not name exactly
+ * one legal move of @b state.
+ */
+Move parseSAN(const BoardState& state, const char* text, size_t length);
+
+inline Move parseSAN(const BoardState& state, const std::string& text) {
+	return parseSAN(state, text.data(), text.size());
+}
+
+/**
+ * parseSAN() on any board backend, see BoardTraits. Defined for BoardState,
+ * MailboxBoard and BitboardBoard.
+ *
+ * @return The BoardState::encodeMove() code of the move, 0 when @b text does
+ * not name exactly one legal move.
+ */
+template<typename Board>
+uint16_t parseSANCode(const Board& board, const char* text, size_t length);
+
+/**
+ * Finds the legal move of @b state written in long algebraic notation.
+ *
+ * @return The move, or an invalid Move (see Move::isValid) when @b text is
+ * not a legal move in @b state.
+ */
+Move parseUCIMove(const BoardState& state, const std::string& text);
+
+} /* namespace sch */
+
+#endif /* NOTATION_H_ */
@@ -0,0 +1,269 @@
+//===-- smart-chess/OpeningIndex.cpp ----------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file OpeningIndex.cpp
+/// \brief Opening explorer: move statistics of every position of a game database.
+///
+//===----------------------------------------------------------------------===//
+
+#include "OpeningIndex.h"
+#include "BoardState.h"
+#include "PGNReader.h"
+#include "Util.h"
+#include "Varint.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+
+using namespace std;
+
+namespace sch {
+
+namespace {
+	/// File layout, all numbers in host byte order:
+	///   Header
+	///   BlockInfo[blockCount]
+	///   blocks of up to ENTRIES_PER_BLOCK records
+	/// A record is the varints key - previous key (the first key of a block
+	/// is relative to 0), move, games, white wins, draws, black wins and
+	/// average rating.
+	struct Header {
+		char magic[8];
+		uint32_t version;
+		uint32_t entriesPerBlock;
+		uint64_t entryCount;
+		uint64_t blockCount;
+	};
+
+	const char MAGIC[8] = { 'S', 'C', 'H', 'O', 'P', 'E', 'N', '\0' };
+	const uint32_t VERSION = 1;
+	const uint32_t ENTRIES_PER_BLOCK = 64;
+
+	struct EntryKey {
+		uint64_t key;
+		uint16_t move;
+		bool operator == (const EntryKey& that) const { return key == that.key && move == that.move; }
+	};
+
+	struct EntryKeyHash {
+		size_t operator()(const EntryKey& k) const { return static_cast<size_t>(k.key ^ (uint64_t(k.move) << 48)); }
+	};
+
+	/// +1 white won, -1 black won, 0 draw, anything else unknown.
+	int parseResult(const TextRef& result) {
+		if(result == "1-0") return 1;
+		if(result == "0-1") return -1;
+		if(result == "1/2-1/2") return 0;
+		return 2;
+	}
+
+	int parseRating(const TextRef& text) {
+		if(text.empty())
+			return 0;
+		return atoi(text.str().c_str());
+	}
+
+	void add(OpeningIndexBuilder::Entry& to, const OpeningIndexBuilder::Entry& from) {
+		to.games += from.games;
+		to.whiteWins += from.whiteWins;
+		to.draws += from.draws;
+		to.blackWins += from.blackWins;
+		to.ratingSum += from.ratingSum;
+		to.ratingCount += from.ratingCount;
+	}
+}
+
+OpeningIndexBuilder::OpeningIndexBuilder(int max_plies)
+: mMaxPlies(max_plies), mEntries() {
+}
+
+size_t OpeningIndexBuilder::addDatabase(const std::string& pgn_path, int threads) {
+	PGNReader reader(pgn_path);
+	threads = PGNReader::getThreadCount(threads);
+
+	typedef unordered_map<EntryKey, Entry, EntryKeyHash> Table;
+	vector<Table> tables(threads);
+
+	const size_t games = reader.forEachGame([this, &tables](const PGNGame& game, int worker) {
+		Table& table = tables[worker];
+		TextRef result_tag = game.getTag("Result");
+		const int result = parseResult(result_tag.empty() ? game.result : result_tag);
+		const int ratings[2] = { parseRating(game.getTag("WhiteElo")), parseRating(game.getTag("BlackElo")) };
+
+		// Whose move the first one is depends on the starting position
+		int side = 0;
+		const TextRef fen = game.getTag("FEN");
+		if(!fen.empty()) {
+			const string text = fen.str();
+			const size_t space = text.find(' ');
+			side = space != string::npos && space + 1 < text.size() && text[space + 1] == 'b';
+		}
+
+		const size_t plies = min(game.moves.size(), static_cast<size_t>(mMaxPlies));
+		for(size_t i = 0; i < plies; ++i, side ^= 1) {
+			Entry& e = table[EntryKey{ game.hashKeys[i], game.moves[i] }];
+			if(!e.games) {
+				memset(&e, 0, sizeof(e));
+				e.key = game.hashKeys[i];
+				e.move = game.moves[i];
+			}
+			++e.games;
+			e.whiteWins += result == 1;
+			e.draws += result == 0;
+			e.blackWins += result == -1;
+			if(ratings[side] > 0) {
+				e.ratingSum += ratings[side];
+				++e.ratingCount;
+			}
+		}
+	}, threads);
+
+	// Merge the per thread tables, then the result with what we already had
+	vector<Entry> added;
+	for(auto& table : tables) {
+		for(auto& kv : table)
+			added.push_back(kv.second);
+		Table().swap(table);
+	}
+	sort(added.begin(), added.end());
+
+	vector<Entry> merged;
+	merged.reserve(mEntries.size() + added.size());
+	auto a = mEntries.begin(), b = added.begin();
+	while(a != mEntries.end() || b != added.end()) {
+		const Entry& next = (b == added.end() || (a != mEntries.end() && *a < *b)) ? *a++ : *b++;
+		if(!merged.empty() && merged.back().key == next.key && merged.back().move == next.move)
+			add(merged.back(), next);
+		else
+			merged.push_back(next);
+	}
+	mEntries.swap(merged);
+	return games;
+}
+
+size_t OpeningIndexBuilder::write(const std::string& path, uint32_t min_games) const {
+	vector<OpeningIndex::BlockInfo> blocks;
+	vector<uint8_t> data;
+	uint64_t count = 0, previous = 0;
+
+	for(auto& e : mEntries) {
+		if(e.games < min_games)
+			continue;
+		if(count % ENTRIES_PER_BLOCK == 0) {
+			blocks.push_back(OpeningIndex::BlockInfo{ e.key, data.size() });
+			previous = 0;
+		}
+		appendVarint(data, e.key - previous);
+		appendVarint(data, e.move);
+		appendVarint(data, e.games);
+		appendVarint(data, e.whiteWins);
+		appendVarint(data, e.draws);
+		appendVarint(data, e.blackWins);
+		appendVarint(data, e.ratingCount ? (e.ratingSum + e.ratingCount / 2) / e.ratingCount : 0);
+		previous = e.key;
+		++count;
+	}
+
+	Header header;
+	memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.version = VERSION;
+	header.entriesPerBlock = ENTRIES_PER_BLOCK;
+	header.entryCount = count;
+	header.blockCount = blocks.size();
+
+	ofstream out(path, ios::binary);
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	out.write(reinterpret_cast<const char*>(blocks.data()), blocks.size() * sizeof(OpeningIndex::BlockInfo));
+	out.write(reinterpret_cast<const char*>(data.data()), data.size());
+	if(!out)
+		throw FileException(path, "could not write the opening index");
+	return count;
+}
+
+OpeningIndex::OpeningIndex(const std::string& path)
+: mFile(path), mEntryCount(0), mBlockCount(0), mBlocks(nullptr), mData(nullptr), mEnd(nullptr) {
+	const size_t size = mFile.getSize();
+	Header header;
+	if(size < sizeof(header))
+		throw FileException(path, "not an opening index");
+	memcpy(&header, mFile.getData(), sizeof(header));
+	if(memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0)
+		throw FileException(path, "not an opening index");
+	if(header.version != VERSION)
+		throw FileException(path, "unsupported opening index version " + to_string(header.version));
+	if(header.blockCount > (size - sizeof(header)) / sizeof(BlockInfo))
+		throw FileException(path, "truncated opening index");
+
+	mEntryCount = header.entryCount;
+	mBlockCount = header.blockCount;
+	mBlocks = reinterpret_cast<const BlockInfo*>(mFile.getData() + sizeof(header));
+	mData = reinterpret_cast<const uint8_t*>(mBlocks + mBlockCount);
+	mEnd = reinterpret_cast<const uint8_t*>(mFile.getData() + size);
+}
+
+std::vector<OpeningMoveStats> OpeningIndex::probe(uint64_t key) const {
+	vector<OpeningMoveStats> moves;
+
+	// The moves of a position may start at the end of the block before the
+	// first one whose first key is not smaller than key.
+	const BlockInfo* end = mBlocks + mBlockCount;
+	const BlockInfo* block = lower_bound(mBlocks, end, key,
+			[](const BlockInfo& b, uint64_t k) { return b.firstKey < k; });
+	if(block != mBlocks)
+		--block;
+
+	for(; block != end && block->firstKey <= key; ++block) {
+		const uint8_t* p = mData + block->offset;
+		const uint8_t* block_end = block + 1 != end ? mData + (block + 1)->offset : mEnd;
+		uint64_t current = 0;
+		while(p < block_end) {
+			current += readVarint(p, block_end);
+			OpeningMoveStats s;
+			s.move = static_cast<uint16_t>(readVarint(p, block_end));
+			s.games = static_cast<uint32_t>(readVarint(p, block_end));
+			s.whiteWins = static_cast<uint32_t>(readVarint(p, block_end));
+			s.draws = static_cast<uint32_t>(readVarint(p, block_end));
+			s.blackWins = static_cast<uint32_t>(readVarint(p, block_end));
+			s.averageRating = static_cast<uint16_t>(readVarint(p, block_end));
+			if(current == key)
+				moves.push_back(s);
+			else if(current > key)
+				break;
+		}
+	}
+
+	stable_sort(moves.begin(), moves.end(), [](const OpeningMoveStats& a, const OpeningMoveStats& b) {
+		return a.games > b.games;
+	});
+	return moves;
+}
+
+std::vector<OpeningMoveStats> OpeningIndex::probe(const BoardState& state) const {
+	return probe(state.getHashKey());
+}
+
+} /* namespace sch */
@@ -0,0 +1,145 @@
+//===-- smart-chess/OpeningIndex.h ------------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file OpeningIndex.h
+/// \brief Opening explorer: move statistics of every position of a game database.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef OPENINGINDEX_H_
+#define OPENINGINDEX_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+
+namespace sch {
+
+class BoardState;
+
+/// How a move played in a position turned out.
+struct OpeningMoveStats {
+	uint16_t move;          //!< See BoardState::encodeMove()
+	uint32_t games;
+	uint32_t whiteWins;
+	uint32_t draws;
+	uint32_t blackWins;     //!< Games without a result are only counted in games
+	uint16_t averageRating; //!< Of the player who made the move, 0 when unknown
+};
+
+/**
+ * Builds an opening index from PGN databases.
+ *
+ * Every game is replayed up to a maximum number of plies and each (position
+ * hash, move) pair gets its statistics. Each thread counts in its own table;
+ * the tables are merged once a database has been read.
+ */
+class OpeningIndexBuilder {
+public:
+	static const int DEFAULT_MAX_PLIES = 40;
+
+	explicit OpeningIndexBuilder(int max_plies = DEFAULT_MAX_PLIES);
+
+	/**
+	 * Adds every game of a PGN file, see PGNReader::forEachGame().
+	 *
+	 * @throw FileException When @b pgn_path cannot be read.
+	 * @return The number of games added.
+	 */
+	size_t addDatabase(const std::string& pgn_path, int threads = 0);
+
+	/// Distinct (position, move) pairs collected so far.
+	size_t getEntryCount() const { return mEntries.size(); }
+
+	/**
+	 * Writes the index, dropping the moves played in less than @b min_games
+	 * games.
+	 *
+	 * @throw FileException When @b path cannot be written.
+	 * @return The number of entries written.
+	 */
+	size_t write(const std::string& path, uint32_t min_games = 1) const;
+
+	struct Entry {
+		uint64_t key;
+		uint16_t move;
+		uint32_t games;
+		uint32_t whiteWins;
+		uint32_t draws;
+		uint32_t blackWins;
+		uint64_t ratingSum;
+		uint32_t ratingCount;
+
+		bool operator < (const Entry& that) const {
+			return key < that.key || (key == that.key && move < that.move);
+		}
+	};
+
+private:
+	int mMaxPlies;
+	std::vector<Entry> mEntries; //!< Sorted by key and move
+};
+
+/**
+ * Read only access to an index written by OpeningIndexBuilder.
+ *
+ * The file is memory mapped and never read as a whole. Entries are sorted by
+ * position hash and stored in blocks of delta and varint encoded records; an
+ * array with the first key of every block is binary searched, so a probe
+ * decodes one or two small blocks.
+ */
+class OpeningIndex {
+public:
+	/// @throw FileException When @b path is not an opening index.
+	explicit OpeningIndex(const std::string& path);
+
+	/// The moves played from the position with hash @b key, most played first.
+	std::vector<OpeningMoveStats> probe(uint64_t key) const;
+
+	std::vector<OpeningMoveStats> probe(const BoardState& state) const;
+
+	uint64_t getEntryCount() const { return mEntryCount; }
+
+private:
+	friend class OpeningIndexBuilder;
+
+	struct BlockInfo {
+		uint64_t firstKey;
+		uint64_t offset; //!< From the start of the block data
+	};
+
+	MappedFile mFile;
+	uint64_t mEntryCount;
+	uint64_t mBlockCount;
+	const BlockInfo* mBlocks;
+	const uint8_t* mData;
+	const uint8_t* mEnd;
+};
+
+} /* namespace sch */
+
+#endif /* OPENINGINDEX_H_ */
@@ -0,0 +1,304 @@
+//===-- smart-chess/PGNReader.cpp -------------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file PGNReader.cpp
+/// \brief Parallel reader of Portable Game Notation databases.
+///
+//===----------------------------------------------------------------------===//
+
+#include "PGNReader.h"
+#include "BoardState.h"
+#include "Notation.h"
+#include <algorithm>
+#include <cctype>
+#include <thread>
+
+using namespace std;
+
+namespace sch {
+
+namespace {
+	inline bool isSpace(char c) {
+		return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+	}
+
+	/// Characters that end a movetext token.
+	inline bool isDelimiter(char c) {
+		return isSpace(c) || c == '{' || c == '}' || c == '(' || c == ')' || c == ';' || c == '$';
+	}
+
+	inline bool isResult(const char* p, size_t n) {
+		return (n == 3 && (memcmp(p, "1-0", 3) == 0 || memcmp(p, "0-1", 3) == 0))
+				|| (n == 7 && memcmp(p, "1/2-1/2", 7) == 0)
+				|| (n == 1 && *p == '*');
+	}
+
+	/// Bytes of the file every worker takes at once.
+	const size_t CHUNK_SIZE = 4 * 1024 * 1024;
+}
+
+TextRef PGNGame::getTag(const char* name) const {
+	for(auto& tag : tags) {
+		if(tag.first == name)
+			return tag.second;
+	}
+	return TextRef();
+}
+
+void PGNGame::clear() {
+	offset = 0;
+	tags.clear();
+	san.clear();
+	moves.clear();
+	hashKeys.clear();
+	result = TextRef();
+	error.clear();
+}
+
+PGNReader::PGNReader(const std::string& path)
+: mFile(path), mCursor(0), mReplay(), mMoveCount(0), mErrorCount(0) {
+}
+
+size_t PGNReader::findGameStart(size_t pos) const {
+	const char* text = mFile.getData();
+	const size_t size = mFile.getSize();
+	if(pos == 0)
+		return 0;
+
+	// A game starts with a tag line right after a line that is not a tag:
+	// the blank line or the movetext ending the previous game.
+	for(; pos < size; ++pos) {
+		const char* nl = static_cast<const char*>(memchr(text + pos - 1, '\n', size - pos + 1));
+		if(!nl)
+			return size;
+		pos = nl - text + 1;
+		if(pos >= size)
+			return size;
+		if(text[pos] != '[')
+			continue;
+
+		size_t prev = nl - text;
+		while(prev > 0 && text[prev - 1] != '\n')
+			--prev;
+		if(text[prev] != '[')
+			return pos;
+	}
+	return size;
+}
+
+size_t PGNReader::parseGame(size_t pos, size_t end, PGNGame& game, Replay& replay) {
+	const char* text = mFile.getData();
+	game.clear();
+
+	// Tag pairs: [Name "Value"]
+	for(;;) {
+		while(pos < end && isSpace(text[pos]))
+			++pos;
+		if(pos >= end)
+			return end;
+		if(text[pos] == '%' && (pos == 0 || text[pos - 1] == '\n')) {
+			// Escaped line
+			while(pos < end && text[pos] != '\n')
+				++pos;
+			continue;
+		}
+		if(text[pos] != '[')
+			break;
+
+		if(game.tags.empty())
+			game.offset = pos;
+		++pos;
+		while(pos < end && isSpace(text[pos]))
+			++pos;
+		const size_t name = pos;
+		while(pos < end && !isSpace(text[pos]) && text[pos] != '"' && text[pos] != ']')
+			++pos;
+		const size_t name_end = pos;
+		while(pos < end && text[pos] != '"' && text[pos] != ']' && text[pos] != '\n')
+			++pos;
+		size_t value = pos, value_end = pos;
+		if(pos < end && text[pos] == '"') {
+			value = ++pos;
+			while(pos < end && text[pos] != '"' && text[pos] != '\n')
+				pos += text[pos] == '\\' ? 2 : 1;
+			value_end = min(pos, end);
+		}
+		while(pos < end && text[pos] != '\n')
+			++pos;
+		game.tags.push_back(make_pair(TextRef(text + name, name_end - name),
+				TextRef(text + value, value_end - value)));
+	}
+	if(game.tags.empty())
+		game.offset = pos;
+
+	// loadFEN() reuses the pieces of the setup, so a game costs no allocation
+	TextRef fen = game.getTag("FEN");
+	if(fen.empty())
+		fen = TextRef(BoardState::START_FEN, strlen(BoardState::START_FEN));
+	BitboardBoard& board = replay.board;
+	try {
+		replay.setup.loadFEN(fen.data, fen.size);
+		board.load(replay.setup);
+	} catch(const FENException& e) {
+		game.error = e.what();
+	}
+
+	// Movetext
+	while(pos < end) {
+		const char c = text[pos];
+		const bool line_start = pos == 0 || text[pos - 1] == '\n';
+
+		if(isSpace(c)) {
+			++pos;
+		} else if(c == '[' && line_start) {
+			break; // The next game, this one had no result
+		} else if(c == '{') {
+			const char* close = static_cast<const char*>(memchr(text + pos, '}', end - pos));
+			pos = close ? close - text + 1 : end;
+		} else if(c == ';' || (c == '%' && line_start)) {
+			const char* nl = static_cast<const char*>(memchr(text + pos, '\n', end - pos));
+			pos = nl ? nl - text + 1 : end;
+		} else if(c == '(') {
+			// Variations, which may nest and contain comments
+			int depth = 0;
+			for(; pos < end; ++pos) {
+				if(text[pos] == '(') {
+					++depth;
+				} else if(text[pos] == ')') {
+					if(--depth == 0) {
+						++pos;
+						break;
+					}
+				} else if(text[pos] == '{') {
+					const char* close = static_cast<const char*>(memchr(text + pos, '}', end - pos));
+					pos = close ? close - text : end - 1;
+				}
+			}
+		} else if(c == '$' || c == ')' || c == '}') {
+			++pos;
+			while(pos < end && isdigit(static_cast<unsigned char>(text[pos])))
+				++pos;
+		} else {
+			size_t token = pos;
+			while(pos < end && !isDelimiter(text[pos]))
+				++pos;
+			if(isResult(text + token, pos - token)) {
+				game.result = TextRef(text + token, pos - token);
+				break;
+			}
+			// Move numbers, "12." and "12...", maybe glued to the move. The
+			// digits need the dot: "0-0" is castling.
+			size_t digits = token;
+			while(digits < pos && isdigit(static_cast<unsigned char>(text[digits])))
+				++digits;
+			if(digits == pos || text[digits] == '.')
+				token = digits;
+			while(token < pos && text[token] == '.')
+				++token;
+			if(token == pos || !game.error.empty())
+				continue;
+
+			const uint16_t code = parseSANCode(board, text + token, pos - token);
+			if(!code) {
+				game.error = "illegal move " + string(text + token, pos - token)
+						+ " at ply " + to_string(game.moves.size() + 1);
+				continue;
+			}
+			game.san.push_back(TextRef(text + token, pos - token));
+			game.moves.push_back(code);
+			game.hashKeys.push_back(board.getHashKey());
+			BitboardBoard::Undo undo;
+			board.makeMove(code, undo);
+		}
+	}
+	game.hashKeys.push_back(board.getHashKey());
+	return pos;
+}
+
+bool PGNReader::next(PGNGame& game) {
+	const size_t size = mFile.getSize();
+	while(mCursor < size) {
+		mCursor = parseGame(mCursor, size, game, mReplay);
+		if(game.tags.empty() && game.san.empty() && game.result.empty())
+			continue;
+		mMoveCount.fetch_add(game.moves.size(), memory_order_relaxed);
+		if(!game.error.empty())
+			mErrorCount.fetch_add(1, memory_order_relaxed);
+		return true;
+	}
+	return false;
+}
+
+int PGNReader::getThreadCount(int threads) {
+	return threads > 0 ? threads : static_cast<int>(max(1u, thread::hardware_concurrency()));
+}
+
+size_t PGNReader::forEachGame(const GameCallback& callback, int threads) {
+	const size_t size = mFile.getSize();
+	threads = getThreadCount(threads);
+
+	// Every chunk runs from the first game starting after i * CHUNK_SIZE to
+	// the first one after (i + 1) * CHUNK_SIZE, so neighbours always agree
+	// on where they meet without talking to each other.
+	const size_t chunks = (size + CHUNK_SIZE - 1) / CHUNK_SIZE;
+	atomic<size_t> next_chunk(0);
+	atomic<size_t> games(0);
+	mFile.adviseSequential();
+
+	auto worker = [&](int index) {
+		PGNGame game;
+		Replay replay;
+		size_t count = 0;
+		uint64_t moves = 0, errors = 0;
+		size_t chunk;
+		while((chunk = next_chunk++) < chunks) {
+			size_t pos = findGameStart(chunk * CHUNK_SIZE);
+			const size_t stop = chunk + 1 < chunks ? findGameStart((chunk + 1) * CHUNK_SIZE) : size;
+			while(pos < stop) {
+				pos = parseGame(pos, stop, game, replay);
+				if(game.tags.empty() && game.san.empty() && game.result.empty())
+					continue;
+				++count;
+				moves += game.moves.size();
+				errors += !game.error.empty();
+				callback(game, index);
+			}
+		}
+		games += count;
+		mMoveCount.fetch_add(moves, memory_order_relaxed);
+		mErrorCount.fetch_add(errors, memory_order_relaxed);
+	};
+
+	vector<thread> pool;
+	const int workers = static_cast<int>(min<size_t>(threads, max<size_t>(1, chunks)));
+	for(int i = 1; i < workers; ++i)
+		pool.emplace_back(worker, i);
+	worker(0);
+	for(auto& t : pool)
+		t.join();
+	return games;
+}
+
+} /* namespace sch */
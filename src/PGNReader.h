@@ -0,0 +1,168 @@
+//===-- smart-chess/PGNReader.h ---------------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file PGNReader.h
+/// \brief Parallel reader of Portable Game Notation databases.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef PGNREADER_H_
+#define PGNREADER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+#include "BitboardBoard.h"
+#include "BoardState.h"
+#include "MappedFile.h"
+
+namespace sch {
+
+/// A piece of text inside the mapped file, valid while its PGNReader lives.
+struct TextRef {
+	const char* data;
+	size_t size;
+
+	TextRef() : data(nullptr), size(0) {}
+	TextRef(const char* d, size_t s) : data(d), size(s) {}
+
+	std::string str() const { return std::string(data, size); }
+	bool empty() const { return size == 0; }
+
+	bool operator == (const char* text) const {
+		return strlen(text) == size && memcmp(data, text, size) == 0;
+	}
+};
+
+/// A game as read from the file. Strings point into the mapped file.
+struct PGNGame {
+	/// Where the game starts in the file, unique for every game.
+	size_t offset;
+
+	std::vector<std::pair<TextRef, TextRef>> tags;
+
+	/// The moves as written in the file.
+	std::vector<TextRef> san;
+
+	/// The same moves packed with BoardState::encodeMove().
+	std::vector<uint16_t> moves;
+
+	/// BoardState::getHashKey() of the position before every move, and after the last one.
+	std::vector<uint64_t> hashKeys;
+
+	/// The game termination marker: "1-0", "0-1", "1/2-1/2" or "*".
+	TextRef result;
+
+	/// Empty when every move was legal, otherwise what went wrong. The moves
+	/// before the error are kept.
+	std::string error;
+
+	/// The value of tag @b name, empty when the game does not have it.
+	TextRef getTag(const char* name) const;
+
+	void clear();
+};
+
+/**
+ * Reads every game of a PGN file. The file is memory mapped and split in
+ * chunks at game boundaries; worker threads parse the chunks and replay the
+ * moves of every game on a BitboardBoard to check and encode them.
+ *
+ * Games are passed by reference to a callback, so parsing does not copy any
+ * tag or move text. The tags and moves are only valid during the callback
+ * and while the reader exists.
+ */
+class PGNReader {
+public:
+	/**
+	 * Called for every game, from several threads at the same time and in no
+	 * particular order. @b worker is the index of the calling thread, from 0
+	 * to getThreadCount() - 1, handy to keep per thread state without locks.
+	 */
+	typedef std::function<void(const PGNGame& game, int worker)> GameCallback;
+
+	/// @throw FileException When @b path cannot be mapped.
+	explicit PGNReader(const std::string& path);
+
+	/**
+	 * Parses the whole file with @b threads threads, 0 meaning one per core.
+	 *
+	 * @return The number of games read.
+	 */
+	size_t forEachGame(const GameCallback& callback, int threads = 0);
+
+	/// The number of threads forEachGame() uses for @b threads, 0 meaning one per core.
+	static int getThreadCount(int threads);
+
+	/**
+	 * Sequential access to the games, in file order and on the calling
+	 * thread, e.g. while(reader.next(game)) { ... }.
+	 *
+	 * @return False once every game was read.
+	 */
+	bool next(PGNGame& game);
+
+	/// Starts next() again from the first game.
+	void rewind() { mCursor = 0; }
+
+	size_t getFileSize() const { return mFile.getSize(); }
+
+	/// Total moves in the games read so far.
+	uint64_t getMoveCount() const { return mMoveCount.load(std::memory_order_relaxed); }
+
+	/// Games read so far that had an illegal or unreadable move.
+	uint64_t getErrorCount() const { return mErrorCount.load(std::memory_order_relaxed); }
+
+private:
+	MappedFile mFile;
+	size_t mCursor; //!< Offset of the next game for next()
+	/// Where a worker replays its games: the setup reads the FEN tags.
+	struct Replay {
+		BoardState setup;
+		BitboardBoard board;
+	};
+
+	Replay mReplay; //!< For the games of next()
+	std::atomic<uint64_t> mMoveCount;
+	std::atomic<uint64_t> mErrorCount;
+
+	/// Offset of the first game starting at or after @b pos.
+	size_t findGameStart(size_t pos) const;
+
+	/**
+	 * Parses the game starting at @b pos, ending before @b end, replaying
+	 * its moves on @b replay.
+	 *
+	 * @return Where the next game starts.
+	 */
+	size_t parseGame(size_t pos, size_t end, PGNGame& game, Replay& replay);
+};
+
+} /* namespace sch */
+
+#endif /* PGNREADER_H_ */
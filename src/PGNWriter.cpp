@@ -0,0 +1,93 @@
+//===-- smart-chess/PGNWriter.cpp -------------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file PGNWriter.cpp
+/// \brief Writes games in Portable Game Notation.
+///
+//===----------------------------------------------------------------------===//
+
+#include "PGNWriter.h"
+#include "BoardState.h"
+
+using namespace std;
+
+namespace sch {
+
+void writePGN(std::ostream& os, const PGNTags& tags, const std::vector<std::string>& san,
+		const std::string& result, const std::string& comment) {
+	// Move numbers follow the starting position, which may be a black move
+	BoardState start;
+	for(auto& tag : tags) {
+		os << "[" << tag.first << " \"";
+		for(char c : tag.second) {
+			if(c == '"' || c == '\\')
+				os << '\\';
+			os << c;
+		}
+		os << "\"]\n";
+		if(tag.first == "FEN") {
+			try {
+				start.loadFEN(tag.second);
+			} catch(const FENException&) {
+				// Numbered as from the initial position
+			}
+		}
+	}
+	os << "\n";
+
+	int number = start.getFullmoveNumber();
+	bool white = start.getCurrentPlayer() == ChessPlayer::Color::WHITE;
+
+	size_t column = 0;
+	auto word = [&os, &column](const string& w) {
+		// Lines of at most 80 characters, as the PGN standard asks
+		if(column && column + 1 + w.size() > 79) {
+			os << '\n';
+			column = 0;
+		} else if(column) {
+			os << ' ';
+			++column;
+		}
+		os << w;
+		column += w.size();
+	};
+
+	for(size_t i = 0; i < san.size(); ++i) {
+		if(white)
+			word(to_string(number) + ".");
+		else if(i == 0)
+			word(to_string(number) + "...");
+		word(san[i]);
+		if(!white)
+			++number;
+		white = !white;
+	}
+	if(!comment.empty())
+		word("{" + comment + "}");
+	word(result);
+	os << "\n\n";
+}
+
+} /* namespace sch */
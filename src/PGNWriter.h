@@ -0,0 +1,57 @@
+//===-- smart-chess/PGNWriter.h ---------------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file PGNWriter.h
+/// \brief Writes games in Portable Game Notation.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef PGNWRITER_H_
+#define PGNWRITER_H_
+
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace sch {
+
+/// Tag pairs in the order they are written, e.g. {"White", "Carlsen"}.
+typedef std::vector<std::pair<std::string, std::string>> PGNTags;
+
+/**
+ * Writes a game with its tags in the given order and the movetext wrapped
+ * at 80 columns. Move numbers follow the FEN tag when there is one.
+ *
+ * @param san The moves in standard algebraic notation.
+ * @param result "1-0", "0-1", "1/2-1/2" or "*".
+ * @param comment Written as {comment} before the result when not empty.
+ */
+void writePGN(std::ostream& os, const PGNTags& tags, const std::vector<std::string>& san,
+		const std::string& result, const std::string& comment = "");
+
+} /* namespace sch */
+
+#endif /* PGNWRITER_H_ */
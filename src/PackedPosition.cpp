@@ -0,0 +1,234 @@
+//===-- smart-chess/PackedPosition.cpp --------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file PackedPosition.cpp
+/// \brief Fixed size binary records of labeled positions.
+///
+//===----------------------------------------------------------------------===//
+
+#include "PackedPosition.h"
+#include "BoardState.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace sch {
+
+namespace {
+	const char PIECE_LETTERS[] = "KkQqRrBbNnPp";
+	const int PIECE_TYPES = static_cast<int>(PieceType::UNDEFINED);
+
+	/// Records gathered before they are written, 128 KB.
+	const size_t BUFFER_RECORDS = 4096;
+}
+
+PackedPosition PackedPosition::pack(const BoardState& state, int score, int result) {
+	PackedPosition p;
+	memset(&p, 0, sizeof(p));
+
+	int count = 0;
+	for(int square = 0; square < SQUARE_COUNT && count < 32; ++square) {
+		const PieceType type = state.getPieceTypeAt(square);
+		if(type == PieceType::UNDEFINED)
+			continue;
+		p.occupancy |= uint64_t(1) << square;
+		p.pieces[count / 2] |= static_cast<uint8_t>(static_cast<int>(type) << (count % 2 * 4));
+		++count;
+	}
+
+	p.score = static_cast<int16_t>(max(-32767, min(32767, score)));
+	p.result = static_cast<int8_t>(result > 0 ? 1 : result < 0 ? -1 : 0);
+	p.flags = static_cast<uint8_t>(state.getCastlingRights() << CASTLING_SHIFT);
+	if(state.getCurrentPlayer() == ChessPlayer::Color::BLACK)
+		p.flags |= BLACK_TO_MOVE;
+	const BoardPosition ep = state.getEnPassantSquare();
+	p.enPassant = ep.isOnBoard() ? static_cast<uint8_t>(toSquareIndex(ep)) : NO_SQUARE;
+	p.halfmoveClock = static_cast<uint8_t>(min(255, state.getHalfmoveClock()));
+	p.fullmoveNumber = static_cast<uint16_t>(min(65535, state.getFullmoveNumber()));
+	return p;
+}
+
+void PackedPosition::unpack(BoardState& state) const {
+	char fen[BoardState::MAX_FEN_LENGTH];
+	char* p = fen;
+
+	int n = 0;
+	for(int row = 0; row < MAX_ROW; ++row) {
+		int empty = 0;
+		for(int col = 0; col < MAX_COL; ++col) {
+			if(!(occupancy >> (row * MAX_COL + col) & 1)) {
+				++empty;
+				continue;
+			}
+			const int type = n < 32 ? static_cast<int>(getPieceType(n++)) : PIECE_TYPES;
+			if(type >= PIECE_TYPES)
+				throw FENException("", "the packed position has invalid pieces");
+			if(empty)
+				*p++ = static_cast<char>('0' + empty);
+			empty = 0;
+			*p++ = PIECE_LETTERS[type];
+		}
+		if(empty)
+			*p++ = static_cast<char>('0' + empty);
+		if(row + 1 < MAX_ROW)
+			*p++ = '/';
+	}
+
+	*p++ = ' ';
+	*p++ = isBlackToMove() ? 'b' : 'w';
+	*p++ = ' ';
+	const int rights = getCastlingRights();
+	if(!rights)
+		*p++ = '-';
+	if(rights & BoardState::WHITE_KING_SIDE) *p++ = 'K';
+	if(rights & BoardState::WHITE_QUEEN_SIDE) *p++ = 'Q';
+	if(rights & BoardState::BLACK_KING_SIDE) *p++ = 'k';
+	if(rights & BoardState::BLACK_QUEEN_SIDE) *p++ = 'q';
+	*p++ = ' ';
+	if(enPassant < SQUARE_COUNT) {
+		const BoardPosition ep = toBoardPosition(enPassant);
+		*p++ = static_cast<char>('a' + ep.column);
+		*p++ = static_cast<char>('0' + (MAX_ROW - ep.row));
+	} else {
+		*p++ = '-';
+	}
+	p += sprintf(p, " %d %d", halfmoveClock, max(1, static_cast<int>(fullmoveNumber)));
+
+	state.loadFEN(fen, static_cast<size_t>(p - fen));
+}
+
+PackedPositionWriter::PackedPositionWriter(const std::string& prefix,
+		size_t shard_size, size_t sync_interval)
+: mPrefix(prefix), mShardSize(max<size_t>(1, shard_size)),
+  mSyncInterval(max<size_t>(1, sync_interval)), mFd(-1), mShard(0),
+  mShardRecords(0), mUnsynced(0), mCount(0) {
+	mBuffer.reserve(BUFFER_RECORDS);
+	openShard();
+}
+
+PackedPositionWriter::~PackedPositionWriter() {
+	try {
+		close();
+	} catch(const ChessException&) {
+	}
+}
+
+void PackedPositionWriter::write(const PackedPosition& record) {
+	if(mFd < 0)
+		openShard();
+	mBuffer.push_back(record);
+	++mShardRecords;
+	++mCount;
+
+	if(mShardRecords >= mShardSize) {
+		close();
+		++mShard;
+	} else if(mBuffer.size() >= BUFFER_RECORDS || mUnsynced + mBuffer.size() >= mSyncInterval) {
+		writeBuffer();
+		if(mUnsynced >= mSyncInterval) {
+			fsync(mFd);
+			mUnsynced = 0;
+		}
+	}
+}
+
+void PackedPositionWriter::flush() {
+	if(mFd < 0)
+		return;
+	writeBuffer();
+	if(fsync(mFd) != 0)
+		throw FileException(getShardPath(mShard), strerror(errno));
+	mUnsynced = 0;
+}
+
+void PackedPositionWriter::close() {
+	if(mFd < 0)
+		return;
+	flush();
+	::close(mFd);
+	mFd = -1;
+}
+
+std::string PackedPositionWriter::getShardPath(int shard) const {
+	char number[16];
+	snprintf(number, sizeof(number), "%05d", shard);
+	return mPrefix + "-" + number + ".bin";
+}
+
+void PackedPositionWriter::openShard() {
+	for(;; ++mShard) {
+		const string path = getShardPath(mShard);
+		mFd = open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+		if(mFd < 0)
+			throw FileException(path, strerror(errno));
+
+		struct stat st;
+		if(fstat(mFd, &st) != 0) {
+			const int error = errno;
+			::close(mFd);
+			mFd = -1;
+			throw FileException(path, strerror(error));
+		}
+		// Cut off what is left of a record interrupted by a crash
+		const off_t whole = st.st_size - st.st_size % sizeof(PackedPosition);
+		if(whole != st.st_size && ftruncate(mFd, whole) != 0) {
+			const int error = errno;
+			::close(mFd);
+			mFd = -1;
+			throw FileException(path, strerror(error));
+		}
+
+		mShardRecords = static_cast<size_t>(whole / sizeof(PackedPosition));
+		if(mShardRecords < mShardSize)
+			return;
+		::close(mFd);
+		mFd = -1;
+	}
+}
+
+void PackedPositionWriter::writeBuffer() {
+	const char* data = reinterpret_cast<const char*>(mBuffer.data());
+	size_t left = mBuffer.size() * sizeof(PackedPosition);
+	while(left) {
+		const ssize_t written = ::write(mFd, data, left);
+		if(written < 0) {
+			if(errno == EINTR)
+				continue;
+			throw FileException(getShardPath(mShard), strerror(errno));
+		}
+		data += written;
+		left -= static_cast<size_t>(written);
+	}
+	mUnsynced += mBuffer.size();
+	mBuffer.clear();
+}
+
+} /* namespace sch */
@@ -0,0 +1,151 @@
+//===-- smart-chess/PackedPosition.h ----------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file PackedPosition.h
+/// \brief Fixed size binary records of labeled positions.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef PACKEDPOSITION_H_
+#define PACKEDPOSITION_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Util.h"
+
+namespace sch {
+
+class BoardState;
+
+/**
+ * A position labeled with a search score and the result of its game, in 32
+ * bytes. Used as training data for the evaluation.
+ *
+ * The occupied squares (see toSquareIndex) are the bits set in @b occupancy;
+ * the PieceType of the n-th occupied square, in increasing square order, is
+ * the n-th nibble of @b pieces, low nibble first. Numbers are stored in host
+ * byte order.
+ */
+struct PackedPosition {
+	enum Flags {
+		BLACK_TO_MOVE = 1,
+		CASTLING_SHIFT = 1 //!< CastlingRight mask in bits 1 to 4
+	};
+
+	/// Value of @b enPassant when there is no en passant capture.
+	static const uint8_t NO_SQUARE = 0xFF;
+
+	uint64_t occupancy;
+	uint8_t pieces[16];
+	int16_t score;          //!< Centipawns, from the side to move's point of view
+	int8_t result;          //!< 1 white won, 0 draw, -1 black won
+	uint8_t flags;
+	uint8_t enPassant;
+	uint8_t halfmoveClock;
+	uint16_t fullmoveNumber;
+
+	/**
+	 * Packs the position of @b state. The score is clamped to the range of
+	 * an int16_t and the clocks to the range of their fields.
+	 */
+	static PackedPosition pack(const BoardState& state, int score, int result);
+
+	/**
+	 * Sets up the position on @b state.
+	 *
+	 * @throw FENException When the record does not hold a valid position.
+	 */
+	void unpack(BoardState& state) const;
+
+	bool isBlackToMove() const { return flags & BLACK_TO_MOVE; }
+	int getCastlingRights() const { return (flags >> CASTLING_SHIFT) & 15; }
+
+	/// The type of the @b n-th occupied square, in increasing square order.
+	PieceType getPieceType(int n) const {
+		return static_cast<PieceType>((pieces[n / 2] >> (n % 2 * 4)) & 15);
+	}
+};
+
+static_assert(sizeof(PackedPosition) == 32, "PackedPosition must stay 32 bytes long");
+
+/**
+ * Writes PackedPosition records to append-only shard files named
+ * "<prefix>-<n>.bin", starting a new shard every @b shard_size records.
+ *
+ * Records are buffered and written in large blocks, and the data is synced
+ * to disk every @b sync_interval records, so a crash loses little data and
+ * never leaves a damaged record behind: a partial record at the end of a
+ * shard is cut off when the writer opens it again. Existing shards are
+ * appended to, so a stopped run can simply be started again.
+ */
+class PackedPositionWriter {
+public:
+	static const size_t DEFAULT_SHARD_SIZE = 1 << 20;
+	static const size_t DEFAULT_SYNC_INTERVAL = 1 << 16;
+
+	/// @throw FileException When the first shard cannot be opened.
+	explicit PackedPositionWriter(const std::string& prefix,
+			size_t shard_size = DEFAULT_SHARD_SIZE,
+			size_t sync_interval = DEFAULT_SYNC_INTERVAL);
+
+	/// Calls close(), errors are ignored.
+	~PackedPositionWriter();
+
+	PackedPositionWriter(const PackedPositionWriter&) = delete;
+	PackedPositionWriter& operator = (const PackedPositionWriter&) = delete;
+
+	/// @throw FileException When a shard cannot be written.
+	void write(const PackedPosition& record);
+
+	/// Writes the buffered records and syncs the current shard.
+	void flush();
+
+	/// Flushes and closes the current shard.
+	void close();
+
+	/// Records written by this writer, buffered ones included.
+	uint64_t getCount() const { return mCount; }
+
+private:
+	std::string mPrefix;
+	size_t mShardSize;
+	size_t mSyncInterval;
+	int mFd;
+	int mShard;             //!< Number of the current shard
+	size_t mShardRecords;   //!< Records in the current shard, buffered ones included
+	size_t mUnsynced;       //!< Records written since the last sync
+	uint64_t mCount;
+	std::vector<PackedPosition> mBuffer;
+
+	std::string getShardPath(int shard) const;
+	/// Opens the first shard from mShard on that is not full yet.
+	void openShard();
+	void writeBuffer();
+};
+
+} /* namespace sch */
+
+#endif /* PACKEDPOSITION_H_ */
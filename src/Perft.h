@@ -0,0 +1,88 @@
+//===-- smart-chess/Perft.h -------------------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file Perft.h
+/// \brief Move path enumeration over any board backend.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef PERFT_H_
+#define PERFT_H_
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "BoardTraits.h"
+
+namespace sch {
+
+/**
+ * Counts the leaves of the legal move tree of @b board, @b depth plies deep.
+ * The counts of well known positions are published, so this is the test of
+ * a move generator, and the number of leaves per second its benchmark.
+ *
+ * The last ply is not played, only counted.
+ */
+template<typename Board>
+uint64_t perft(Board& board, int depth) {
+	typedef BoardTraits<Board> Traits;
+	uint16_t moves[BoardState::MAX_MOVES];
+	const size_t count = Traits::getLegalMoves(board, moves);
+	if(depth <= 1)
+		return depth == 1 ? count : 1;
+
+	uint64_t nodes = 0;
+	for(size_t i = 0; i < count; ++i) {
+		typename Traits::Undo undo;
+		Traits::makeMove(board, moves[i], undo);
+		nodes += perft(board, depth - 1);
+		Traits::unmakeMove(board, moves[i], undo);
+	}
+	return nodes;
+}
+
+/**
+ * perft() of every legal move of @b board, to find which move a generator
+ * gets wrong when its total differs.
+ */
+template<typename Board>
+std::vector<std::pair<uint16_t, uint64_t>> perftDivide(Board& board, int depth) {
+	typedef BoardTraits<Board> Traits;
+	uint16_t moves[BoardState::MAX_MOVES];
+	const size_t count = Traits::getLegalMoves(board, moves);
+
+	std::vector<std::pair<uint16_t, uint64_t>> divide;
+	for(size_t i = 0; i < count; ++i) {
+		typename Traits::Undo undo;
+		Traits::makeMove(board, moves[i], undo);
+		divide.push_back(std::make_pair(moves[i], depth > 1 ? perft(board, depth - 1) : 1));
+		Traits::unmakeMove(board, moves[i], undo);
+	}
+	return divide;
+}
+
+} /* namespace sch */
+
+#endif /* PERFT_H_ */
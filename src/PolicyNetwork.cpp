@@ -0,0 +1,236 @@
+//===-- smart-chess/PolicyNetwork.cpp ---------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file PolicyNetwork.cpp
+/// \brief Quantized move prior network for the Monte Carlo tree search.
+///
+//===----------------------------------------------------------------------===//
+
+#include "PolicyNetwork.h"
+#include "BoardState.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+using namespace std;
+
+namespace sch {
+
+namespace {
+	const int PIECE_CLASSES = 12;
+
+	/// The hidden layer keeps the sum shifted right by this many bits.
+	const int WEIGHT_SHIFT = 6;
+	/// The head counts this many units per unit of logit.
+	const float LOGIT_SCALE = 1024.0f;
+	/// Logits taken from the queen promotion neuron for an underpromotion.
+	const float UNDERPROMOTION_PENALTY = 3.0f;
+}
+
+size_t PolicyNetwork::getFileSize() {
+	return sizeof(Header)
+			+ alignSection(HIDDEN1 * sizeof(int16_t)) + alignSection(size_t(INPUTS) * HIDDEN1 * sizeof(int16_t))
+			+ alignSection(HIDDEN2 * sizeof(int32_t)) + alignSection(HIDDEN2 * HIDDEN1)
+			+ alignSection(OUTPUTS * sizeof(int32_t)) + alignSection(size_t(OUTPUTS) * HIDDEN2);
+}
+
+PolicyNetwork::PolicyNetwork(const std::string& path)
+: mFile(path), mSimd(getBestSimd()) {
+	static_assert(sizeof(Header) == SECTION_ALIGNMENT, "The network header must take 64 bytes");
+	static_assert(MAX_MOVES == BoardState::MAX_MOVES, "An Input must hold every legal move");
+	static_assert(PIECE_CLASSES * SQUARE_COUNT == INPUTS, "One feature per piece and square");
+
+	if(mFile.getSize() < sizeof(Header))
+		throw FileException(path, "not a policy network file");
+	Header header;
+	memcpy(&header, mFile.getData(), sizeof(header));
+	if(memcmp(header.magic, "SCHPOLI", 8) != 0)
+		throw FileException(path, "not a policy network file");
+	if(header.version != VERSION)
+		throw FileException(path, "policy network version " + std::to_string(header.version)
+				+ ", expected " + std::to_string(VERSION));
+	if(header.inputs != INPUTS || header.hidden1 != HIDDEN1 || header.hidden2 != HIDDEN2
+			|| header.outputs != OUTPUTS)
+		throw FileException(path, "unsupported policy network architecture");
+	if(mFile.getSize() != getFileSize())
+		throw FileException(path, "truncated policy network file");
+
+	const char* p = mFile.getData() + sizeof(Header);
+	auto next = [&p](size_t size) {
+		const char* section = p;
+		p += alignSection(size);
+		return section;
+	};
+	mFeatureBiases = reinterpret_cast<const int16_t*>(next(HIDDEN1 * sizeof(int16_t)));
+	mFeatureWeights = reinterpret_cast<const int16_t*>(next(size_t(INPUTS) * HIDDEN1 * sizeof(int16_t)));
+	mBiases1 = reinterpret_cast<const int32_t*>(next(HIDDEN2 * sizeof(int32_t)));
+	mWeights1 = reinterpret_cast<const int8_t*>(next(HIDDEN2 * HIDDEN1));
+	mHeadBiases = reinterpret_cast<const int32_t*>(next(OUTPUTS * sizeof(int32_t)));
+	mHeadWeights = reinterpret_cast<const int8_t*>(next(size_t(OUTPUTS) * HIDDEN2));
+}
+
+void PolicyNetwork::setSimd(Simd simd) {
+	mSimd = min(simd, getBestSimd());
+}
+
+void PolicyNetwork::encode(const BoardState& state, const uint16_t* moves, size_t count, Input& input) {
+	const bool black = state.getCurrentPlayer() == ChessPlayer::Color::BLACK;
+	input.featureCount = 0;
+	for(int sq = 0; sq < SQUARE_COUNT; ++sq) {
+		const PieceType type = state.getPieceTypeAt(sq);
+		if(type == PieceType::UNDEFINED)
+			continue;
+		// No legal position has more pieces, but a BoardState set up by
+		// hand may: the rest of them are left out rather than overflow.
+		if(input.featureCount == MAX_FEATURES)
+			break;
+		// Own pieces first, king to pawn
+		const bool own = isWhitePieceType(type) != black;
+		const int piece_class = getPieceKind(type) * 2 + (own ? 0 : 1);
+		input.features[input.featureCount++] = static_cast<uint16_t>(
+				piece_class * SQUARE_COUNT + (black ? mirrorSquare(sq) : sq));
+	}
+
+	input.moveCount = count;
+	for(size_t i = 0; i < count; ++i) {
+		int from = moves[i] & 63;
+		int to = (moves[i] >> 6) & 63;
+		const int promotion = moves[i] >> 12;
+		if(black) {
+			from = mirrorSquare(from);
+			to = mirrorSquare(to);
+		}
+		input.outputs[i] = static_cast<uint16_t>(from * SQUARE_COUNT + to);
+		if(promotion && promotion != QUEEN_KIND)
+			input.outputs[i] |= UNDERPROMOTION;
+	}
+}
+
+void PolicyNetwork::evaluate(const Input* const* inputs, float* const* priors, size_t count) const {
+	assert(count <= MAX_BATCH);
+	const Int8Kernels& k = getInt8Kernels(mSimd);
+
+	// Four positions at a time: the 16 KB of hidden weights stay in the L1
+	// cache for the whole batch and dot4 loads each of them once per group.
+	alignas(64) int16_t acc[HIDDEN1];
+	alignas(64) uint8_t hidden1[4][HIDDEN1];
+	alignas(64) uint8_t hidden2[4][HIDDEN2];
+	int32_t sums[4];
+
+	for(size_t first = 0; first < count; first += 4) {
+		const size_t group = min<size_t>(4, count - first);
+		for(size_t j = 0; j < group; ++j) {
+			const Input& in = *inputs[first + j];
+			memcpy(acc, mFeatureBiases, sizeof(acc));
+			for(int f = 0; f < in.featureCount; ++f)
+				k.add(acc, mFeatureWeights + size_t(in.features[f]) * HIDDEN1, HIDDEN1);
+			k.clip(acc, hidden1[j], HIDDEN1);
+		}
+
+		for(int i = 0; i < HIDDEN2; ++i) {
+			const int8_t* weights = mWeights1 + i * HIDDEN1;
+			if(group == 4) {
+				k.dot4(hidden1[0], HIDDEN1, weights, HIDDEN1, sums);
+			} else {
+				for(size_t j = 0; j < group; ++j)
+					sums[j] = k.dot(hidden1[j], weights, HIDDEN1);
+			}
+			for(size_t j = 0; j < group; ++j)
+				hidden2[j][i] = clipActivation((mBiases1[i] + sums[j]) >> WEIGHT_SHIFT);
+		}
+
+		for(size_t j = 0; j < group; ++j) {
+			const Input& in = *inputs[first + j];
+			float* p = priors[first + j];
+			float best = -INFINITY;
+			for(size_t m = 0; m < in.moveCount; ++m) {
+				const int output = in.outputs[m] & ~UNDERPROMOTION;
+				const int32_t logit = mHeadBiases[output]
+						+ k.dot(hidden2[j], mHeadWeights + size_t(output) * HIDDEN2, HIDDEN2);
+				p[m] = logit / LOGIT_SCALE - ((in.outputs[m] & UNDERPROMOTION) ? UNDERPROMOTION_PENALTY : 0.0f);
+				best = max(best, p[m]);
+			}
+			float sum = 0;
+			for(size_t m = 0; m < in.moveCount; ++m) {
+				p[m] = exp(p[m] - best);
+				sum += p[m];
+			}
+			for(size_t m = 0; m < in.moveCount; ++m)
+				p[m] /= sum;
+		}
+	}
+}
+
+void PolicyNetwork::evaluate(const BoardState& state, const uint16_t* moves, size_t count, float* priors) const {
+	Input input;
+	encode(state, moves, count, input);
+	const Input* inputs[1] = { &input };
+	evaluate(inputs, &priors, 1);
+}
+
+PolicyBatcher::PolicyBatcher(const PolicyNetwork& network, size_t batch_size, std::chrono::microseconds wait)
+: mNetwork(network), mBatchSize(min<size_t>(max<size_t>(1, batch_size), PolicyNetwork::MAX_BATCH)),
+  mWait(wait), mMutex(), mWakeUp(), mPending(), mBatches(0), mPositions(0) {
+	mPending.reserve(mBatchSize);
+}
+
+void PolicyBatcher::evaluate(const PolicyNetwork::Input& input, float* priors) {
+	Request request = { &input, priors, false, false };
+	unique_lock<mutex> lock(mMutex);
+	mPending.push_back(&request);
+	// Give the other threads some time to add their positions
+	if(mPending.size() < mBatchSize)
+		mWakeUp.wait_for(lock, mWait, [&request] { return request.taken; });
+	if(!request.taken)
+		run(lock);
+	mWakeUp.wait(lock, [&request] { return request.done; });
+}
+
+void PolicyBatcher::run(std::unique_lock<std::mutex>& lock) {
+	const PolicyNetwork::Input* inputs[PolicyNetwork::MAX_BATCH];
+	float* priors[PolicyNetwork::MAX_BATCH];
+	Request* batch[PolicyNetwork::MAX_BATCH];
+	const size_t count = mPending.size();
+	for(size_t i = 0; i < count; ++i) {
+		batch[i] = mPending[i];
+		batch[i]->taken = true;
+		inputs[i] = batch[i]->input;
+		priors[i] = batch[i]->priors;
+	}
+	mPending.clear();
+
+	lock.unlock();
+	mNetwork.evaluate(inputs, priors, count);
+	lock.lock();
+
+	for(size_t i = 0; i < count; ++i)
+		batch[i]->done = true;
+	++mBatches;
+	mPositions += count;
+	mWakeUp.notify_all();
+}
+
+} /* namespace sch */
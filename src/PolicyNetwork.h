@@ -0,0 +1,197 @@
+//===-- smart-chess/PolicyNetwork.h -----------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file PolicyNetwork.h
+/// \brief Quantized move prior network for the Monte Carlo tree search.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef POLICYNETWORK_H_
+#define POLICYNETWORK_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+#include "Simd.h"
+
+namespace sch {
+
+class BoardState;
+
+/**
+ * A small int8 network that gives every legal move of a position a prior
+ * probability, for MCTS to know which moves to look at first. It is loaded
+ * from a file that stays memory mapped:
+ *
+ *  - Input: one feature per (piece, square), 12 * 64 = 768 features, seen
+ *    by the side to move: own pieces first and the board flipped for black.
+ *  - Feature transformer: 768 -> 256 int16, clipped to [0, 127].
+ *  - A dense int8 layer of 64 neurons.
+ *  - Policy head: one int8 neuron per (from, to) pair of squares, also seen
+ *    by the side to move. Only the neurons of the legal moves are computed,
+ *    and a softmax over them gives the priors.
+ *
+ * Positions are best given in batches: the dense layer then loads every
+ * weight once for four positions. Inference uses AVX2 or SSE4.1 when the
+ * CPU has them and plain C++ otherwise, see Simd.
+ *
+ * File layout, little endian, every section starts at a multiple of 64:
+ *   Header
+ *   int16 feature biases[256], int16 feature weights[768][256]
+ *   int32 biases[64], int8 weights[64][256]       (hidden layer)
+ *   int32 biases[4096], int8 weights[4096][64]    (policy head)
+ *
+ * The hidden layer shifts its sums right by 6 bits and clips them to
+ * [0, 127], the head counts 1024 units per unit of logit. Underpromotions
+ * share the neuron of the queen promotion, less a fixed penalty.
+ */
+class PolicyNetwork {
+public:
+	static const int INPUTS = 12 * 64;
+	static const int HIDDEN1 = 256;
+	static const int HIDDEN2 = 64;
+	static const int OUTPUTS = 64 * 64;
+	/// The most positions of one forward pass.
+	static const int MAX_BATCH = 256;
+	/// The most features of a position: one per piece.
+	static const int MAX_FEATURES = 32;
+	/// As BoardState::MAX_MOVES.
+	static const int MAX_MOVES = 256;
+	/// Marks the head neuron of an underpromotion in Input::outputs.
+	static const uint16_t UNDERPROMOTION = 1 << 15;
+
+	/// Increased whenever the layout of the file changes.
+	static const uint32_t VERSION = 1;
+
+	/// The first 64 bytes of a network file.
+	struct Header {
+		char magic[8];         //!< "SCHPOLI" and a null
+		uint32_t version;
+		uint32_t inputs;
+		uint32_t hidden1;
+		uint32_t hidden2;
+		uint32_t outputs;
+		uint32_t reserved[9];
+	};
+
+	/// A position ready for the network and the moves to score in it.
+	struct Input {
+		uint16_t features[MAX_FEATURES];
+		int featureCount;
+		uint16_t outputs[MAX_MOVES];  //!< Head neuron of each move, maybe with UNDERPROMOTION
+		size_t moveCount;
+	};
+
+	/// The size of a network file, computed from the layout above.
+	static size_t getFileSize();
+
+	/// @throw FileException When @b path is not a network of this VERSION.
+	explicit PolicyNetwork(const std::string& path);
+
+	PolicyNetwork(const PolicyNetwork&) = delete;
+	PolicyNetwork& operator = (const PolicyNetwork&) = delete;
+
+	const std::string& getPath() const { return mFile.getPath(); }
+
+	/// Uses @b simd, or the best supported one below it, for this network.
+	void setSimd(Simd simd);
+	Simd getSimd() const { return mSimd; }
+
+	/**
+	 * Fills @b input with the features of @b state and the head neurons of
+	 * its @b count legal moves, given as BoardState::encodeMove() codes.
+	 */
+	static void encode(const BoardState& state, const uint16_t* moves, size_t count, Input& input);
+
+	/**
+	 * Runs @b count <= MAX_BATCH positions through the network in one pass.
+	 * The priors of the moves of @b inputs[i], which add up to 1, are
+	 * written to @b priors[i] in the order of the moves.
+	 */
+	void evaluate(const Input* const* inputs, float* const* priors, size_t count) const;
+
+	/// The priors of the @b count legal @b moves of @b state, one position at a time.
+	void evaluate(const BoardState& state, const uint16_t* moves, size_t count, float* priors) const;
+
+private:
+	MappedFile mFile;
+	const int16_t* mFeatureBiases;
+	const int16_t* mFeatureWeights;
+	const int32_t* mBiases1;
+	const int8_t* mWeights1;
+	const int32_t* mHeadBiases;
+	const int8_t* mHeadWeights;
+	Simd mSimd;
+};
+
+/**
+ * Lets the searching threads share forward passes: a thread that needs
+ * priors queues its position and waits until a batch is full, or until a
+ * short wait is over, then one of them runs the whole batch. With a single
+ * thread every batch holds one position.
+ */
+class PolicyBatcher {
+public:
+	/// @b batch_size is capped to PolicyNetwork::MAX_BATCH.
+	PolicyBatcher(const PolicyNetwork& network, size_t batch_size, std::chrono::microseconds wait);
+
+	PolicyBatcher(const PolicyBatcher&) = delete;
+	PolicyBatcher& operator = (const PolicyBatcher&) = delete;
+
+	/// Blocks until the priors of @b input are in @b priors.
+	void evaluate(const PolicyNetwork::Input& input, float* priors);
+
+	uint64_t getBatches() const { return mBatches; }
+	uint64_t getPositions() const { return mPositions; }
+
+private:
+	struct Request {
+		const PolicyNetwork::Input* input;
+		float* priors;
+		bool taken;  //!< In a batch being run
+		bool done;
+	};
+
+	const PolicyNetwork& mNetwork;
+	size_t mBatchSize;
+	std::chrono::microseconds mWait;
+	std::mutex mMutex;
+	std::condition_variable mWakeUp;
+	std::vector<Request*> mPending;
+	uint64_t mBatches;
+	uint64_t mPositions;
+
+	/// Runs every pending request, @b lock is released meanwhile.
+	void run(std::unique_lock<std::mutex>& lock);
+};
+
+} /* namespace sch */
+
+#endif /* POLICYNETWORK_H_ */
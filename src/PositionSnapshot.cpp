@@ -0,0 +1,87 @@
+//===-- smart-chess/PositionSnapshot.cpp ------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file PositionSnapshot.cpp
+/// \brief Immutable copies of a position that any thread can hold.
+///
+//===----------------------------------------------------------------------===//
+
+#include "PositionSnapshot.h"
+
+using namespace std;
+
+namespace sch {
+
+shared_ptr<const PositionSnapshot> PositionSnapshot::create(const BoardState& state, const MoveCache& moves,
+		uint64_t sequence) {
+	shared_ptr<PositionSnapshot> snapshot(new PositionSnapshot());
+	snapshot->mSequence = sequence;
+	snapshot->mCurrentPlayer = state.getCurrentPlayer();
+	const bool white = snapshot->mCurrentPlayer == ChessPlayer::Color::WHITE;
+	bool has_legal_move = false;
+	for(int sq = 0; sq < MAX_ROW * MAX_COL; ++sq) {
+		const PieceType type = state.getPieceTypeAt(sq);
+		snapshot->mBoard[sq] = type;
+		// The cache also holds the moves of the other side
+		const bool own = type != PieceType::UNDEFINED && isWhitePieceType(type) == white;
+		snapshot->mTargets[sq] = own ? moves.getTargets(sq) : 0;
+		has_legal_move = has_legal_move || snapshot->mTargets[sq];
+	}
+	snapshot->mGameInProgress = state.isGameInProgress();
+	snapshot->mInCheck = state.isInCheck();
+	snapshot->mStatus = state.getGameStatus(has_legal_move);
+	snapshot->mHashKey = state.getHashKey();
+	const shared_ptr<ChessPiece> selected = state.getSelectedPiece();
+	snapshot->mSelected = selected ? selected->getBoardPosition() : BoardPosition();
+	snapshot->mFENLength = state.writeFEN(snapshot->mFEN);
+	return snapshot;
+}
+
+vector<BoardPosition> PositionSnapshot::getMoves(BoardPosition from) const {
+	vector<BoardPosition> moves;
+	for(uint64_t targets = mTargets[toSquareIndex(from)]; targets; targets &= targets - 1)
+		moves.push_back(toBoardPosition(__builtin_ctzll(targets)));
+	return moves;
+}
+
+BoardState PositionSnapshot::toBoardState() const {
+	return BoardState::fromFEN(getFEN());
+}
+
+SnapshotPublisher::SnapshotPublisher()
+: mCurrent(), mSequence(0) {
+}
+
+shared_ptr<const PositionSnapshot> SnapshotPublisher::publish(const BoardState& state, const MoveCache& moves) {
+	shared_ptr<const PositionSnapshot> snapshot = PositionSnapshot::create(state, moves, ++mSequence);
+	atomic_store(&mCurrent, snapshot);
+	return snapshot;
+}
+
+shared_ptr<const PositionSnapshot> SnapshotPublisher::get() const {
+	return atomic_load(&mCurrent);
+}
+
+} /* namespace sch */
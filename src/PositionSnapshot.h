@@ -0,0 +1,137 @@
+//===-- smart-chess/PositionSnapshot.h --------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file PositionSnapshot.h
+/// \brief Immutable copies of a position that any thread can hold.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef POSITIONSNAPSHOT_H_
+#define POSITIONSNAPSHOT_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "BoardState.h"
+#include "MoveCache.h"
+
+namespace sch {
+
+/**
+ * What a BoardState looks like at one point of a game: the pieces, whose
+ * turn it is, the status of the game and where every piece of the side to
+ * move can go.
+ *
+ * A snapshot never changes after it was created and it is only handed out
+ * as a std::shared_ptr to const, so the GUI, an engine thread and a logger
+ * can all keep the same one alive without copying it or locking anything.
+ * Unlike a BoardState it holds no ChessPiece objects, and the legal moves
+ * come from a MoveCache, so taking one costs about a kilobyte of copies.
+ */
+class PositionSnapshot {
+public:
+	/**
+	 * Captures @b state with the legal moves of @b moves, which must be
+	 * synced with it. @b sequence tells the snapshots of a publisher apart.
+	 */
+	static std::shared_ptr<const PositionSnapshot> create(const BoardState& state, const MoveCache& moves,
+			uint64_t sequence = 0);
+
+	PositionSnapshot(const PositionSnapshot&) = delete;
+	PositionSnapshot& operator = (const PositionSnapshot&) = delete;
+
+	uint64_t getSequence() const { return mSequence; }
+
+	PieceType getPieceTypeAt(int square) const { return mBoard[square]; }
+	PieceType getPieceTypeAt(BoardPosition pos) const { return mBoard[toSquareIndex(pos)]; }
+
+	ChessPlayer::Color getCurrentPlayer() const { return mCurrentPlayer; }
+	bool isGameInProgress() const { return mGameInProgress; }
+	bool isInCheck() const { return mInCheck; }
+	GameStatus getGameStatus() const { return mStatus; }
+	uint64_t getHashKey() const { return mHashKey; }
+	std::string getFEN() const { return std::string(mFEN, mFENLength); }
+
+	/// Position of the piece selected by the user, invalid when there is none.
+	BoardPosition getSelectedPosition() const { return mSelected; }
+
+	/// Legal targets of the piece on @b square, 0 unless it belongs to the side to move.
+	uint64_t getLegalTargets(int square) const { return mTargets[square]; }
+
+	/// Same as getLegalTargets() as a list of positions.
+	std::vector<BoardPosition> getMoves(BoardPosition from) const;
+
+	/**
+	 * A BoardState in the position of the snapshot, for code that needs to
+	 * play moves on it. It only knows the game from this position on, so
+	 * repetitions of earlier positions are not detected.
+	 */
+	BoardState toBoardState() const;
+
+private:
+	PositionSnapshot() {}
+
+	uint64_t mSequence;
+	PieceType mBoard[MAX_ROW * MAX_COL];
+	uint64_t mTargets[MAX_ROW * MAX_COL];
+	ChessPlayer::Color mCurrentPlayer;
+	bool mGameInProgress;
+	bool mInCheck;
+	GameStatus mStatus;
+	uint64_t mHashKey;
+	BoardPosition mSelected;
+	char mFEN[BoardState::MAX_FEN_LENGTH];
+	size_t mFENLength;
+};
+
+/**
+ * Holds the latest snapshot of a position that changes on one thread and
+ * is read on others. publish() replaces it with an atomic pointer swap, a
+ * reader gets either the old or the new snapshot, never a torn one, and
+ * the old one lives as long as some reader still holds it.
+ */
+class SnapshotPublisher {
+public:
+	SnapshotPublisher();
+
+	SnapshotPublisher(const SnapshotPublisher&) = delete;
+	SnapshotPublisher& operator = (const SnapshotPublisher&) = delete;
+
+	/// Captures @b state and makes it the current snapshot, which is returned, see PositionSnapshot::create().
+	std::shared_ptr<const PositionSnapshot> publish(const BoardState& state, const MoveCache& moves);
+
+	/// The last snapshot published, null before the first. Safe to call from any thread.
+	std::shared_ptr<const PositionSnapshot> get() const;
+
+private:
+	std::shared_ptr<const PositionSnapshot> mCurrent; //!< Only accessed through std::atomic_load/store
+	std::atomic<uint64_t> mSequence;
+};
+
+} /* namespace sch */
+
+#endif /* POSITIONSNAPSHOT_H_ */
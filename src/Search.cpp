@@ -0,0 +1,586 @@
+//===-- smart-chess/Search.cpp ----------------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file Search.cpp
+/// \brief Alpha-beta search used by the Algorithm player.
+///
+//===----------------------------------------------------------------------===//
+
+#include "Search.h"
+#include "BitboardBoard.h"
+#include "Evaluation.h"
+#include "MailboxBoard.h"
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+using namespace std;
+
+namespace sch {
+
+namespace {
+	/// Mate scores are stored relative to the node so they stay valid at any ply.
+	inline int scoreToTT(int score, int ply) {
+		if(score > Search::MATE_SCORE - Search::MAX_PLY) return score + ply;
+		if(score < -Search::MATE_SCORE + Search::MAX_PLY) return score - ply;
+		return score;
+	}
+
+	inline int scoreFromTT(int score, int ply) {
+		if(score > Search::MATE_SCORE - Search::MAX_PLY) return score - ply;
+		if(score < -Search::MATE_SCORE + Search::MAX_PLY) return score + ply;
+		return score;
+	}
+
+	inline int getFrom(uint16_t code) { return code & 63; }
+	inline int getTo(uint16_t code) { return (code >> 6) & 63; }
+	inline int getPromotionKind(uint16_t code) { return code >> 12; }
+
+	/// True for a legal move @b code of @b board that takes a piece.
+	template<typename Board>
+	inline bool isCapture(const Board& board, uint16_t code) {
+		typedef BoardTraits<Board> Traits;
+		if(Traits::getPieceTypeAt(board, getTo(code)) != PieceType::UNDEFINED)
+			return true;
+		// A pawn moving sideways to an empty square captures en passant
+		return getPieceKind(Traits::getPieceTypeAt(board, getFrom(code))) == PAWN_KIND
+				&& getFrom(code) % MAX_COL != getTo(code) % MAX_COL;
+	}
+
+	/// Nodes between two checks of the time and node limits.
+	const uint64_t CHECK_INTERVAL = 1024;
+}
+
+template<typename Board>
+BasicSearch<Board>::BasicSearch()
+: mTT(), mEvalCache(), mNetwork(), mThreadCount(1), mInfoCallback(), mWorkers(), mLimits(),
+  mStop(false), mPondering(false), mStartTime(Clock::now()), mSoftLimit(0),
+  mHardLimit(0), mLimitOffset(0), mPrepared(false) {
+}
+
+template<typename Board>
+BasicSearch<Board>::~BasicSearch() {
+}
+
+template<typename Board>
+void BasicSearch<Board>::setHashSize(size_t size_mb) {
+	mTT.resize(size_mb);
+}
+
+template<typename Board>
+void BasicSearch<Board>::setThreads(int count) {
+	mThreadCount = max(1, count);
+}
+
+template<typename Board>
+void BasicSearch<Board>::setNetwork(std::shared_ptr<const NNUENetwork> network) {
+	mNetwork = network;
+	// The cached scores come from the other evaluation
+	mEvalCache.clear();
+}
+
+template<typename Board>
+void BasicSearch<Board>::Worker::prepare(const BoardState& position, const NNUENetwork* network) {
+	Traits::load(board, position);
+	root = position;
+	// Room for every ply, so the search never grows it
+	history.clear();
+	history.reserve(position.getHistory().size() + MAX_PLY + 1);
+	history.insert(history.end(), position.getHistory().begin(), position.getHistory().end());
+	nodes = 0;
+	evalProbes = 0;
+	evalHits = 0;
+	selDepth = 0;
+	pv.clear();
+	pv.reserve(MAX_PLY);
+	score = 0;
+	depth = 0;
+
+	arena.reset();
+	frames = arena.create<Frame>(MAX_PLY + 1);
+	accumulators = nullptr;
+	deltas = nullptr;
+	if(network) {
+		accumulators = arena.create<NNUEAccumulator>(MAX_PLY);
+		deltas = arena.create<NNUEDelta>(MAX_PLY);
+		network->refresh(board, accumulators[0]);
+	}
+}
+
+template<typename Board>
+void BasicSearch<Board>::clear() {
+	mTT.clear();
+	mEvalCache.clear();
+}
+
+template<typename Board>
+Move BasicSearch<Board>::think(const BoardState& root, const SearchLimits& limits, Move* ponder) {
+	if(!mPrepared)
+		prepare(limits);
+	mPrepared = false;
+	mLimits = limits;
+	allocateTime(root);
+	mTT.newSearch();
+
+	if(mWorkers.size() != static_cast<size_t>(mThreadCount)) {
+		mWorkers.clear();
+		for(int i = 0; i < mThreadCount; ++i)
+			mWorkers.emplace_back(new Worker(i));
+	}
+	for(auto& w : mWorkers)
+		w->prepare(root, mNetwork.get());
+
+	vector<thread> helpers;
+	for(int i = 1; i < mThreadCount; ++i)
+		helpers.emplace_back(&BasicSearch::iterativeDeepening, this, ref(*mWorkers[i]));
+
+	iterativeDeepening(*mWorkers[0]);
+
+	// While pondering or in infinite mode the best move can only be given
+	// after ponderhit() or stop(), even if the search is already over.
+	{
+		unique_lock<mutex> lock(mMutex);
+		mWakeUp.wait(lock, [this] { return mStop || (!mPondering && !mLimits.infinite); });
+	}
+	mStop = true;
+	for(auto& t : helpers)
+		t.join();
+
+	const Worker& main = *mWorkers[0];
+	if(ponder)
+		*ponder = main.pv.size() > 1 ? main.pv[1] : Move();
+	if(!main.pv.empty())
+		return root.decodeMove(BoardState::encodeMove(main.pv[0]));
+
+	// Stopped before the first iteration finished, any legal move will do
+	auto moves = root.getLegalMoves();
+	return moves.empty() ? Move() : moves[0];
+}
+
+template<typename Board>
+void BasicSearch<Board>::prepare(const SearchLimits& limits) {
+	lock_guard<mutex> lock(mMutex);
+	mStop = false;
+	mPondering = limits.ponder;
+	mStartTime = Clock::now();
+	mLimitOffset = 0;
+	mPrepared = true;
+}
+
+template<typename Board>
+void BasicSearch<Board>::stop() {
+	lock_guard<mutex> lock(mMutex);
+	mStop = true;
+	mWakeUp.notify_all();
+}
+
+template<typename Board>
+void BasicSearch<Board>::ponderhit() {
+	lock_guard<mutex> lock(mMutex);
+	mLimitOffset = elapsed();
+	mPondering = false;
+	mWakeUp.notify_all();
+}
+
+template<typename Board>
+uint64_t BasicSearch<Board>::getNodes() const {
+	uint64_t nodes = 0;
+	for(auto& w : mWorkers)
+		nodes += w->nodes.load(memory_order_relaxed);
+	return nodes;
+}
+
+template<typename Board>
+uint64_t BasicSearch<Board>::getEvalCacheProbes() const {
+	uint64_t probes = 0;
+	for(auto& w : mWorkers)
+		probes += w->evalProbes.load(memory_order_relaxed);
+	return probes;
+}
+
+template<typename Board>
+uint64_t BasicSearch<Board>::getEvalCacheHits() const {
+	uint64_t hits = 0;
+	for(auto& w : mWorkers)
+		hits += w->evalHits.load(memory_order_relaxed);
+	return hits;
+}
+
+template<typename Board>
+int BasicSearch<Board>::getScore() const {
+	return mWorkers.empty() ? 0 : mWorkers[0]->score;
+}
+
+template<typename Board>
+int64_t BasicSearch<Board>::elapsed() const {
+	return chrono::duration_cast<chrono::milliseconds>(Clock::now() - mStartTime).count();
+}
+
+template<typename Board>
+void BasicSearch<Board>::allocateTime(const BoardState& root) {
+	const SearchLimits::TimeBudget budget = mLimits.getTimeBudget(
+			root.getCurrentPlayer() == ChessPlayer::Color::WHITE);
+	mHardLimit = budget.maximum;
+	mSoftLimit = budget.target;
+	// The next iteration usually takes longer than all the previous ones
+	if(mLimits.moveTime <= 0 && budget.target > 0)
+		mSoftLimit = max<int64_t>(1, budget.target / 2);
+}
+
+template<typename Board>
+void BasicSearch<Board>::checkLimits() {
+	if(mPondering || mLimits.infinite)
+		return;
+
+	if(mHardLimit && elapsed() - mLimitOffset >= mHardLimit)
+		mStop = true;
+	if(mLimits.nodes && getNodes() >= mLimits.nodes)
+		mStop = true;
+}
+
+template<typename Board>
+void BasicSearch<Board>::iterativeDeepening(Worker& w) {
+	const int max_depth = mLimits.depth > 0 ? min(mLimits.depth, MAX_PLY - 1) : MAX_PLY - 1;
+
+	for(int depth = 1; depth <= max_depth && !mStop; ++depth) {
+		// Helpers with an odd id search one ply deeper so the threads do not
+		// all walk the same tree in lock step.
+		const int d = min(max_depth, depth + (w.id & 1));
+		w.selDepth = 0;
+		const int score = search(w, -INFINITE_SCORE, INFINITE_SCORE, d, 0);
+		if(mStop && !w.pv.empty())
+			break;
+
+		updatePV(w);
+		w.score = score;
+		w.depth = d;
+
+		if(w.id == 0) {
+			reportInfo(w);
+			if(mStop)
+				break;
+			if(!mPondering && !mLimits.infinite && mSoftLimit
+					&& elapsed() - mLimitOffset >= mSoftLimit)
+				break;
+			// Nothing can beat a forced mate found at a full width depth
+			if(isMateScore(score) && !mPondering && !mLimits.infinite
+					&& d >= 2 * abs(getMateIn(score)))
+				break;
+		}
+	}
+}
+
+template<typename Board>
+int BasicSearch<Board>::search(Worker& w, int alpha, int beta, int depth, int ply) {
+	Frame& frame = w.frames[ply];
+	frame.pvLength = 0;
+	Board& board = w.board;
+
+	const bool in_check = Traits::isInCheck(board);
+	if(in_check && ply < MAX_PLY / 2)
+		++depth;
+	if(depth <= 0)
+		return quiesce(w, alpha, beta, ply);
+
+	const uint64_t nodes = w.nodes.load(memory_order_relaxed) + 1;
+	w.nodes.store(nodes, memory_order_relaxed);
+	if(w.id == 0 && (nodes % CHECK_INTERVAL) == 0)
+		checkLimits();
+	if(mStop)
+		return 0;
+	if(ply > w.selDepth)
+		w.selDepth = ply;
+
+	if(ply > 0) {
+		// A position seen before is scored as a draw at its first repetition
+		if(Traits::getHalfmoveClock(board) >= 100 || isRepetition(w))
+			return 0;
+		if(ply >= MAX_PLY - 1)
+			return evaluate(w, ply);
+	}
+
+	const uint64_t key = Traits::getHashKey(board);
+	uint16_t tt_move = 0;
+	TranspositionTable::Entry entry;
+	if(mTT.probe(key, entry)) {
+		tt_move = entry.move;
+		if(ply > 0 && entry.depth >= depth) {
+			const int score = scoreFromTT(entry.score, ply);
+			if(entry.bound == TranspositionTable::BOUND_EXACT
+					|| (entry.bound == TranspositionTable::BOUND_LOWER && score >= beta)
+					|| (entry.bound == TranspositionTable::BOUND_UPPER && score <= alpha))
+				return score;
+		}
+	}
+
+	frame.moveCount = Traits::getLegalMoves(board, frame.moves);
+	if(!frame.moveCount)
+		return in_check ? -MATE_SCORE + ply : 0;
+	orderMoves(board, frame, tt_move);
+
+	// The killers two plies down were found in another part of the tree
+	Frame& grandchild = w.frames[ply + 2];
+	grandchild.killers[0] = grandchild.killers[1] = 0;
+
+	const int old_alpha = alpha;
+	int best = -INFINITE_SCORE;
+	uint16_t best_move = 0;
+	const Frame& child = w.frames[ply + 1];
+
+	for(size_t i = 0; i < frame.moveCount; ++i) {
+		const uint16_t code = frame.moves[i];
+		typename Traits::Undo undo;
+		makeMove(w, code, undo, ply);
+
+		int score;
+		if(i == 0) {
+			score = -search(w, -beta, -alpha, depth - 1, ply + 1);
+		} else {
+			// Principal variation search: prove the move is worse with a
+			// null window and only search it fully when that fails.
+			score = -search(w, -alpha - 1, -alpha, depth - 1, ply + 1);
+			if(score > alpha && score < beta)
+				score = -search(w, -beta, -alpha, depth - 1, ply + 1);
+		}
+		unmakeMove(w, code, undo);
+
+		if(mStop)
+			return 0;
+
+		if(score > best) {
+			best = score;
+			best_move = code;
+			if(score > alpha) {
+				alpha = score;
+				frame.pv[0] = code;
+				memcpy(frame.pv + 1, child.pv, child.pvLength * sizeof(frame.pv[0]));
+				frame.pvLength = child.pvLength + 1;
+				if(alpha >= beta) {
+					if(!isCapture(board, code) && !getPromotionKind(code) && frame.killers[0] != code) {
+						frame.killers[1] = frame.killers[0];
+						frame.killers[0] = code;
+					}
+					break;
+				}
+			}
+		}
+	}
+
+	const TranspositionTable::Bound bound = best >= beta ? TranspositionTable::BOUND_LOWER
+			: (best > old_alpha ? TranspositionTable::BOUND_EXACT : TranspositionTable::BOUND_UPPER);
+	mTT.store(key, best_move, scoreToTT(best, ply), depth, bound);
+	return best;
+}
+
+template<typename Board>
+int BasicSearch<Board>::quiesce(Worker& w, int alpha, int beta, int ply) {
+	Board& board = w.board;
+
+	const uint64_t nodes = w.nodes.load(memory_order_relaxed) + 1;
+	w.nodes.store(nodes, memory_order_relaxed);
+	if(w.id == 0 && (nodes % CHECK_INTERVAL) == 0)
+		checkLimits();
+	if(mStop)
+		return 0;
+	if(ply > w.selDepth)
+		w.selDepth = ply;
+
+	Frame& frame = w.frames[ply];
+	const int stand_pat = frame.staticEval = evaluate(w, ply);
+	if(ply >= MAX_PLY - 1 || stand_pat >= beta)
+		return stand_pat;
+	if(stand_pat > alpha)
+		alpha = stand_pat;
+
+	const size_t count = Traits::getLegalMoves(board, frame.moves);
+	frame.moveCount = 0;
+	for(size_t i = 0; i < count; ++i) {
+		if(isCapture(board, frame.moves[i]) || getPromotionKind(frame.moves[i]))
+			frame.moves[frame.moveCount++] = frame.moves[i];
+	}
+	orderMoves(board, frame, 0);
+
+	for(size_t i = 0; i < frame.moveCount; ++i) {
+		typename Traits::Undo undo;
+		makeMove(w, frame.moves[i], undo, ply);
+		const int score = -quiesce(w, -beta, -alpha, ply + 1);
+		unmakeMove(w, frame.moves[i], undo);
+
+		if(mStop)
+			return 0;
+		if(score >= beta)
+			return score;
+		if(score > alpha)
+			alpha = score;
+	}
+	return alpha;
+}
+
+template<typename Board>
+int BasicSearch<Board>::evaluate(Worker& w, int ply) {
+	const uint64_t key = Traits::getHashKey(w.board);
+	int score;
+	w.evalProbes.store(w.evalProbes.load(memory_order_relaxed) + 1, memory_order_relaxed);
+	if(mEvalCache.probe(key, score)) {
+		w.evalHits.store(w.evalHits.load(memory_order_relaxed) + 1, memory_order_relaxed);
+		return score;
+	}
+	score = mNetwork ? evaluateNetwork(w, ply) : Traits::evaluate(w.board);
+	mEvalCache.store(key, score);
+	return score;
+}
+
+template<typename Board>
+int BasicSearch<Board>::evaluateNetwork(Worker& w, int ply) {
+	NNUEAccumulator& acc = w.accumulators[ply];
+	if(!acc.computed) {
+		// The root is always computed. Interior nodes that were never
+		// evaluated are skipped: their changes go straight into this ply.
+		int last = ply - 1;
+		while(!w.accumulators[last].computed)
+			--last;
+		for(int side = 0; side < 2; ++side) {
+			bool king_moved = false;
+			for(int p = last + 1; p <= ply; ++p)
+				king_moved = king_moved || w.deltas[p].movesKing(side);
+			if(king_moved) {
+				mNetwork->refresh(w.board, side, acc);
+				continue;
+			}
+			memcpy(acc.values[side], w.accumulators[last].values[side], sizeof(acc.values[side]));
+			for(int p = last + 1; p <= ply; ++p)
+				mNetwork->update(w.deltas[p], w.board, side, acc);
+		}
+		acc.computed = true;
+	}
+	return mNetwork->evaluate(acc, Traits::isWhiteToMove(w.board) ? ChessPlayer::Color::WHITE
+			: ChessPlayer::Color::BLACK);
+}
+
+template<typename Board>
+void BasicSearch<Board>::makeMove(Worker& w, uint16_t code, typename Traits::Undo& undo, int ply) {
+	if(mNetwork) {
+		w.deltas[ply + 1] = NNUEDelta::fromMove(w.board, code);
+		w.accumulators[ply + 1].computed = false;
+	}
+	Traits::makeMove(w.board, code, undo);
+	w.history.push_back(Traits::getHashKey(w.board));
+}
+
+template<typename Board>
+void BasicSearch<Board>::unmakeMove(Worker& w, uint16_t code, const typename Traits::Undo& undo) {
+	Traits::unmakeMove(w.board, code, undo);
+	w.history.pop_back();
+}
+
+template<typename Board>
+bool BasicSearch<Board>::isRepetition(const Worker& w) const {
+	const size_t size = w.history.size();
+	const size_t reversible = min(static_cast<size_t>(Traits::getHalfmoveClock(w.board)), size - 1);
+	const uint64_t key = w.history.back();
+	for(size_t back = 4; back <= reversible; back += 2)
+		if(w.history[size - 1 - back] == key)
+			return true;
+	return false;
+}
+
+template<typename Board>
+void BasicSearch<Board>::orderMoves(const Board& board, Frame& frame, uint16_t tt_move) const {
+	uint16_t* moves = frame.moves;
+	int* keys = frame.keys;
+	for(size_t i = 0; i < frame.moveCount; ++i) {
+		const uint16_t code = moves[i];
+		int key = 0;
+		if(tt_move && code == tt_move) {
+			key = 1 << 20;
+		} else {
+			// Most valuable victim first, then least valuable attacker
+			if(isCapture(board, code)) {
+				const PieceType victim = Traits::getPieceTypeAt(board, getTo(code));
+				const int victim_value = victim == PieceType::UNDEFINED ? 100 : getPieceValue(victim);
+				key = (1 << 16) + victim_value * 8 - getPieceValue(Traits::getPieceTypeAt(board, getFrom(code))) / 100;
+			} else if(code == frame.killers[0]) {
+				key = 2;
+			} else if(code == frame.killers[1]) {
+				key = 1;
+			}
+			if(getPromotionKind(code))
+				key += getPieceValue(makePieceType(getPromotionKind(code), true)) * 8;
+		}
+		keys[i] = key;
+	}
+
+	// Insertion sort, move lists are short and mostly keep their order
+	for(size_t i = 1; i < frame.moveCount; ++i) {
+		const uint16_t code = moves[i];
+		const int key = keys[i];
+		size_t j = i;
+		for(; j > 0 && keys[j - 1] < key; --j) {
+			moves[j] = moves[j - 1];
+			keys[j] = keys[j - 1];
+		}
+		moves[j] = code;
+		keys[j] = key;
+	}
+}
+
+template<typename Board>
+void BasicSearch<Board>::updatePV(Worker& w) {
+	const Frame& root = w.frames[0];
+	BoardState::UndoInfo undo[MAX_PLY];
+	w.pv.clear();
+	for(int i = 0; i < root.pvLength; ++i) {
+		const Move m = w.root.decodeMove(root.pv[i]);
+		if(!m.isValid() || !w.root.isLegal(m))
+			break;
+		w.pv.push_back(m);
+		w.root.makeMove(m, undo[i]);
+	}
+	for(size_t i = w.pv.size(); i-- > 0; )
+		w.root.unmakeMove(w.pv[i], undo[i]);
+}
+
+template<typename Board>
+void BasicSearch<Board>::reportInfo(const Worker& w) {
+	if(!mInfoCallback)
+		return;
+
+	SearchInfo info;
+	info.depth = w.depth;
+	info.selDepth = w.selDepth;
+	info.score = w.score;
+	info.nodes = getNodes();
+	info.time = elapsed();
+	info.nps = info.time > 0 ? info.nodes * 1000 / info.time : info.nodes;
+	info.hashFull = mTT.getHashFull();
+	info.pv = w.pv;
+	mInfoCallback(info);
+}
+
+template class BasicSearch<BoardState>;
+template class BasicSearch<MailboxBoard>;
+template class BasicSearch<BitboardBoard>;
+
+} /* namespace sch */
@@ -0,0 +1,249 @@
+//===-- smart-chess/Search.h ------------------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file Search.h
+/// \brief Alpha-beta search used by the Algorithm player.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef SEARCH_H_
+#define SEARCH_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "Arena.h"
+#include "BoardState.h"
+#include "BoardTraits.h"
+#include "EvalCache.h"
+#include "NNUE.h"
+#include "SearchLimits.h"
+#include "TranspositionTable.h"
+
+namespace sch {
+
+/// What the search reports after every completed iteration.
+struct SearchInfo {
+	int depth;
+	int selDepth;          //!< Deepest ply reached, quiescence included
+	int score;             //!< Centipawns, or a mate score (see BasicSearch::isMateScore)
+	uint64_t nodes;
+	int64_t time;          //!< Milliseconds since the search started
+	uint64_t nps;
+	int hashFull;          //!< Permill of the transposition table in use
+	std::vector<Move> pv;  //!< Principal variation, starting with the best move
+};
+
+/**
+ * Iterative deepening negamax search with alpha-beta pruning, a shared
+ * transposition table and quiescence search on captures.
+ *
+ * With more than one thread every thread searches the same root position on
+ * its own copy of the board and they cooperate only through the shared
+ * transposition table and evaluation cache (the "lazy SMP" approach).
+ *
+ * The root is always a BoardState, but the tree is walked on a @b Board,
+ * which can be any backend BoardTraits supports; Search below is the one
+ * the players and the tools use.
+ */
+template<typename Board>
+class BasicSearch {
+public:
+	static const int MAX_PLY = 64;
+	static const int MATE_SCORE = 32000;
+	static const int INFINITE_SCORE = MATE_SCORE + 1;
+
+	typedef std::function<void(const SearchInfo&)> InfoCallback;
+
+	BasicSearch();
+	~BasicSearch();
+
+	BasicSearch(const BasicSearch&) = delete;
+	BasicSearch& operator = (const BasicSearch&) = delete;
+
+	void setHashSize(size_t size_mb);
+	void setThreads(int count);
+	int getThreads() const { return mThreadCount; }
+
+	/// Called from the searching thread after every completed iteration.
+	void setInfoCallback(InfoCallback callback) { mInfoCallback = callback; }
+
+	/**
+	 * Evaluates positions with @b network instead of evaluate(), or with
+	 * evaluate() again when it is null. Must not be called while thinking.
+	 */
+	void setNetwork(std::shared_ptr<const NNUENetwork> network);
+	const std::shared_ptr<const NNUENetwork>& getNetwork() const { return mNetwork; }
+
+	/// Forgets everything learned in previous searches, e.g. for a new game.
+	void clear();
+
+	/**
+	 * Searches @b root within @b limits. It blocks until the search is over;
+	 * stop() and ponderhit() are meant to be called from another thread.
+	 * Unless prepare() was called first, a stop() that comes before the
+	 * search starts is lost.
+	 *
+	 * @param[out] ponder When not null receives the expected reply, if any.
+	 * @return The best move for a piece of @b root, or an invalid Move when
+	 * there is no legal move.
+	 */
+	Move think(const BoardState& root, const SearchLimits& limits, Move* ponder = nullptr);
+
+	/**
+	 * Starts the next search with @b limits on the calling thread, before
+	 * the thread that runs think() is created, so that stop() and
+	 * ponderhit() apply to it even if they come before think() does.
+	 */
+	void prepare(const SearchLimits& limits);
+
+	/// Makes a running think() return as soon as possible.
+	void stop();
+
+	/// The opponent played the expected move, the ponder search becomes a normal one.
+	void ponderhit();
+
+	/// Nodes searched by the last (or current) think() call.
+	uint64_t getNodes() const;
+
+	/// Probes and hits of the evaluation cache in the last (or current) think() call.
+	uint64_t getEvalCacheProbes() const;
+	uint64_t getEvalCacheHits() const;
+
+	/// Score of the move returned by the last think() call, from the side to move's point of view.
+	int getScore() const;
+
+	EvalCache& getEvalCache() { return mEvalCache; }
+	TranspositionTable& getTranspositionTable() { return mTT; }
+
+	static bool isMateScore(int score) { return score > MATE_SCORE - MAX_PLY || score < -MATE_SCORE + MAX_PLY; }
+
+	/// Moves (not plies) until mate, negative when the side to move gets mated.
+	static int getMateIn(int score) {
+		return score > 0 ? (MATE_SCORE - score + 1) / 2 : -(MATE_SCORE + score) / 2;
+	}
+
+private:
+	typedef std::chrono::steady_clock Clock;
+	typedef BoardTraits<Board> Traits;
+
+	/**
+	 * Scratch space of one ply. The frames of a thread are carved out of its
+	 * arena, so the search itself never calls the heap allocator. Each frame
+	 * starts on its own cache line.
+	 */
+	struct alignas(Arena::CACHE_LINE) Frame {
+		uint16_t moves[BoardState::MAX_MOVES]; //!< Legal move codes, best first once ordered
+		int keys[BoardState::MAX_MOVES];       //!< Ordering keys of @b moves
+		size_t moveCount;
+		uint16_t pv[MAX_PLY];                  //!< Principal variation from this ply on
+		int pvLength;
+		uint16_t killers[2];                   //!< Quiet moves that caused a cutoff at this ply
+		int staticEval;                        //!< Stand pat score of a quiescence node
+	};
+
+	/// The state owned by each searching thread, kept from one search to the next.
+	struct Worker {
+		int id;
+		Board board;
+		/// The root position, to turn the principal variation into Moves.
+		BoardState root;
+		/// Hash keys of every position since BoardState::loadFEN(), for the repetitions.
+		std::vector<uint64_t> history;
+		std::atomic<uint64_t> nodes;
+		/// Counted by every thread on its own rather than in the shared cache.
+		std::atomic<uint64_t> evalProbes;
+		std::atomic<uint64_t> evalHits;
+		int selDepth;
+		std::vector<Move> pv;  //!< Of the last completed iteration
+		int score;
+		int depth;
+		/// Reset at the start of every search, everything below lives in it.
+		Arena arena;
+		/// Indexed by ply, MAX_PLY + 1 of them.
+		Frame* frames;
+		/// Indexed by ply, only allocated with a network.
+		NNUEAccumulator* accumulators;
+		/// What the move leading to every ply changed, to bring the accumulators up to date.
+		NNUEDelta* deltas;
+
+		explicit Worker(int i) : id(i), board(), root(), history(), nodes(0), evalProbes(0), evalHits(0), selDepth(0), pv(), score(0), depth(0),
+				arena(), frames(nullptr), accumulators(nullptr), deltas(nullptr) {}
+
+		/// Gets ready to search @b position, reusing the memory of the last search.
+		void prepare(const BoardState& position, const NNUENetwork* network);
+	};
+
+	TranspositionTable mTT;
+	EvalCache mEvalCache;
+	std::shared_ptr<const NNUENetwork> mNetwork;
+	int mThreadCount;
+	InfoCallback mInfoCallback;
+
+	std::vector<std::unique_ptr<Worker>> mWorkers;
+	SearchLimits mLimits;
+	std::atomic<bool> mStop;
+	std::atomic<bool> mPondering;
+	Clock::time_point mStartTime;
+	int64_t mSoftLimit; //!< Do not start a new iteration after this many ms
+	int64_t mHardLimit; //!< Abort the search after this many ms
+	std::atomic<int64_t> mLimitOffset; //!< When the time limits started counting (ponderhit)
+	bool mPrepared; //!< prepare() was called for the next think()
+	std::mutex mMutex;
+	std::condition_variable mWakeUp;
+
+	void iterativeDeepening(Worker& w);
+	int search(Worker& w, int alpha, int beta, int depth, int ply);
+	int quiesce(Worker& w, int alpha, int beta, int ply);
+	int evaluate(Worker& w, int ply);
+	/// Brings the accumulator of @b ply up to date and evaluates it.
+	int evaluateNetwork(Worker& w, int ply);
+	/// Plays @b code at @b ply, recording what it changes for the network.
+	void makeMove(Worker& w, uint16_t code, typename Traits::Undo& undo, int ply);
+	void unmakeMove(Worker& w, uint16_t code, const typename Traits::Undo& undo);
+	/// Same as BoardState::isRepetition(), on the history of @b w.
+	bool isRepetition(const Worker& w) const;
+	/// Sorts the moves of @b frame: hash move, captures, killers, the rest.
+	void orderMoves(const Board& board, Frame& frame, uint16_t tt_move) const;
+	/// Fills Worker::pv from the principal variation of the root frame.
+	void updatePV(Worker& w);
+
+	void allocateTime(const BoardState& root);
+	int64_t elapsed() const;
+	/// Polled by the main thread, sets mStop when a limit is reached.
+	void checkLimits();
+	void reportInfo(const Worker& w);
+};
+
+/// The search of the players, the match runner and the engine tools.
+typedef BasicSearch<BoardState> Search;
+
+} /* namespace sch */
+
+#endif /* SEARCH_H_ */
@@ -0,0 +1,97 @@
+//===-- smart-chess/SearchLimits.h ------------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file SearchLimits.h
+/// \brief When a search has to stop.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef SEARCHLIMITS_H_
+#define SEARCHLIMITS_H_
+
+#include <algorithm>
+#include <cstdint>
+
+namespace sch {
+
+/**
+ * The budget of a single search. Every limit left at 0 is ignored; a search
+ * without any limit runs until Search::stop() is called.
+ */
+struct SearchLimits {
+	int depth;       //!< Maximum depth in plies
+	uint64_t nodes;  //!< Maximum number of nodes
+	int moveTime;    //!< Milliseconds to spend on this move
+	int time[2];     //!< Milliseconds left on the clock of white [0] and black [1]
+	int increment[2];//!< Milliseconds added to the clock after each move
+	int movesToGo;   //!< Moves until the next time control, 0 for sudden death
+	bool infinite;   //!< Keep searching until Search::stop()
+	bool ponder;     //!< Search on the opponent's time until Search::ponderhit()
+
+	SearchLimits()
+	: depth(0), nodes(0), moveTime(0), time{0, 0}, increment{0, 0},
+	  movesToGo(0), infinite(false), ponder(false) {}
+
+	/// Milliseconds a move may take, see getTimeBudget().
+	struct TimeBudget {
+		int64_t target;   //!< What the move should take
+		int64_t maximum;  //!< What it may take when the search needs more
+	};
+
+	/**
+	 * The time of a move of white, or of black when @b white is false:
+	 * moveTime when it is set, otherwise a share of the clock plus most of
+	 * the increment, keeping a small reserve for the communication with the
+	 * GUI. Both are 0 without a time limit.
+	 */
+	TimeBudget getTimeBudget(bool white) const {
+		TimeBudget budget = { 0, 0 };
+		if(moveTime > 0) {
+			budget.target = budget.maximum = moveTime;
+			return budget;
+		}
+		const int side = white ? 0 : 1;
+		const int64_t clock = time[side];
+		if(clock <= 0)
+			return budget;
+
+		const int64_t OVERHEAD = 30;
+		const int64_t moves_to_go = movesToGo > 0 ? std::min(movesToGo, 40) : 30;
+		const int64_t usable = std::max<int64_t>(1, clock - OVERHEAD);
+		budget.target = std::max<int64_t>(1, std::min(usable, clock / moves_to_go + increment[side] * 3 / 4));
+		budget.maximum = std::min(usable, budget.target * 3);
+		return budget;
+	}
+
+	static SearchLimits fromMoveTime(int ms) {
+		SearchLimits limits;
+		limits.moveTime = ms;
+		return limits;
+	}
+};
+
+} /* namespace sch */
+
+#endif /* SEARCHLIMITS_H_ */
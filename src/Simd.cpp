@@ -0,0 +1,226 @@
+//===-- smart-chess/Simd.cpp ------------------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file Simd.cpp
+/// \brief Instruction sets chosen at run time for the vectorized kernels.
+///
+//===----------------------------------------------------------------------===//
+
+#include "Simd.h"
+
+namespace sch {
+
+namespace {
+	void addScalar(int16_t* acc, const int16_t* weights, int n) {
+		for(int i = 0; i < n; ++i)
+			acc[i] = static_cast<int16_t>(acc[i] + weights[i]);
+	}
+
+	void subtractScalar(int16_t* acc, const int16_t* weights, int n) {
+		for(int i = 0; i < n; ++i)
+			acc[i] = static_cast<int16_t>(acc[i] - weights[i]);
+	}
+
+	void clipScalar(const int16_t* acc, uint8_t* out, int n) {
+		for(int i = 0; i < n; ++i)
+			out[i] = static_cast<uint8_t>(acc[i] < 0 ? 0 : (acc[i] > 127 ? 127 : acc[i]));
+	}
+
+	int32_t dotScalar(const uint8_t* in, const int8_t* weights, int n) {
+		int32_t sum = 0;
+		for(int i = 0; i < n; ++i)
+			sum += in[i] * weights[i];
+		return sum;
+	}
+
+	void dot4Scalar(const uint8_t* in, int stride, const int8_t* weights, int n, int32_t* out) {
+		for(int j = 0; j < 4; ++j)
+			out[j] = dotScalar(in + j * stride, weights, n);
+	}
+
+#ifdef SMARTCHESS_X86_SIMD
+	__attribute__((target("sse4.1")))
+	inline int32_t sumSSE41(__m128i sum) {
+		sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+		sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+		return _mm_cvtsi128_si32(sum);
+	}
+
+	__attribute__((target("sse4.1")))
+	void addSSE41(int16_t* acc, const int16_t* weights, int n) {
+		for(int i = 0; i < n; i += 8) {
+			__m128i* a = reinterpret_cast<__m128i*>(acc + i);
+			_mm_storeu_si128(a, _mm_add_epi16(_mm_loadu_si128(a),
+					_mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + i))));
+		}
+	}
+
+	__attribute__((target("sse4.1")))
+	void subtractSSE41(int16_t* acc, const int16_t* weights, int n) {
+		for(int i = 0; i < n; i += 8) {
+			__m128i* a = reinterpret_cast<__m128i*>(acc + i);
+			_mm_storeu_si128(a, _mm_sub_epi16(_mm_loadu_si128(a),
+					_mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + i))));
+		}
+	}
+
+	__attribute__((target("sse4.1")))
+	void clipSSE41(const int16_t* acc, uint8_t* out, int n) {
+		const __m128i max = _mm_set1_epi16(127);
+		for(int i = 0; i < n; i += 16) {
+			const __m128i a = _mm_min_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(acc + i)), max);
+			const __m128i b = _mm_min_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(acc + i + 8)), max);
+			// packus also clips negative values to 0
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(a, b));
+		}
+	}
+
+	__attribute__((target("sse4.1")))
+	int32_t dotSSE41(const uint8_t* in, const int8_t* weights, int n) {
+		const __m128i ones = _mm_set1_epi16(1);
+		__m128i sum = _mm_setzero_si128();
+		for(int i = 0; i < n; i += 16) {
+			// u8 * i8 pairs fit an int16 since the inputs are at most 127
+			const __m128i products = _mm_maddubs_epi16(
+					_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)),
+					_mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + i)));
+			sum = _mm_add_epi32(sum, _mm_madd_epi16(products, ones));
+		}
+		return sumSSE41(sum);
+	}
+
+	__attribute__((target("sse4.1")))
+	void dot4SSE41(const uint8_t* in, int stride, const int8_t* weights, int n, int32_t* out) {
+		const __m128i ones = _mm_set1_epi16(1);
+		__m128i sums[4] = { _mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128() };
+		for(int i = 0; i < n; i += 16) {
+			const __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + i));
+			for(int j = 0; j < 4; ++j) {
+				const __m128i products = _mm_maddubs_epi16(
+						_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + j * stride + i)), w);
+				sums[j] = _mm_add_epi32(sums[j], _mm_madd_epi16(products, ones));
+			}
+		}
+		for(int j = 0; j < 4; ++j)
+			out[j] = sumSSE41(sums[j]);
+	}
+
+	__attribute__((target("avx2")))
+	void addAVX2(int16_t* acc, const int16_t* weights, int n) {
+		for(int i = 0; i < n; i += 16) {
+			__m256i* a = reinterpret_cast<__m256i*>(acc + i);
+			_mm256_storeu_si256(a, _mm256_add_epi16(_mm256_loadu_si256(a),
+					_mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + i))));
+		}
+	}
+
+	__attribute__((target("avx2")))
+	void subtractAVX2(int16_t* acc, const int16_t* weights, int n) {
+		for(int i = 0; i < n; i += 16) {
+			__m256i* a = reinterpret_cast<__m256i*>(acc + i);
+			_mm256_storeu_si256(a, _mm256_sub_epi16(_mm256_loadu_si256(a),
+					_mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + i))));
+		}
+	}
+
+	__attribute__((target("avx2")))
+	void clipAVX2(const int16_t* acc, uint8_t* out, int n) {
+		const __m256i max = _mm256_set1_epi16(127);
+		for(int i = 0; i < n; i += 32) {
+			const __m256i a = _mm256_min_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc + i)), max);
+			const __m256i b = _mm256_min_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc + i + 16)), max);
+			// packus works on 128 bit lanes, the permute puts the bytes back in order
+			const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xD8);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), packed);
+		}
+	}
+
+	__attribute__((target("avx2")))
+	int32_t dotAVX2(const uint8_t* in, const int8_t* weights, int n) {
+		const __m256i ones = _mm256_set1_epi16(1);
+		__m256i sum = _mm256_setzero_si256();
+		for(int i = 0; i < n; i += 32) {
+			const __m256i products = _mm256_maddubs_epi16(
+					_mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i)),
+					_mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + i)));
+			sum = _mm256_add_epi32(sum, _mm256_madd_epi16(products, ones));
+		}
+		__m128i s = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+		s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(1, 0, 3, 2)));
+		s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(2, 3, 0, 1)));
+		return _mm_cvtsi128_si32(s);
+	}
+	__attribute__((target("avx2")))
+	void dot4AVX2(const uint8_t* in, int stride, const int8_t* weights, int n, int32_t* out) {
+		const __m256i ones = _mm256_set1_epi16(1);
+		__m256i sums[4] = { _mm256_setzero_si256(), _mm256_setzero_si256(), _mm256_setzero_si256(), _mm256_setzero_si256() };
+		for(int i = 0; i < n; i += 32) {
+			const __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + i));
+			for(int j = 0; j < 4; ++j) {
+				const __m256i products = _mm256_maddubs_epi16(
+						_mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + j * stride + i)), w);
+				sums[j] = _mm256_add_epi32(sums[j], _mm256_madd_epi16(products, ones));
+			}
+		}
+		for(int j = 0; j < 4; ++j)
+			out[j] = sumSSE41(_mm_add_epi32(_mm256_castsi256_si128(sums[j]), _mm256_extracti128_si256(sums[j], 1)));
+	}
+#endif
+
+	/// Indexed by Simd.
+	const Int8Kernels INT8_KERNELS[] = {
+		{ addScalar, subtractScalar, clipScalar, dotScalar, dot4Scalar },
+#ifdef SMARTCHESS_X86_SIMD
+		{ addSSE41, subtractSSE41, clipSSE41, dotSSE41, dot4SSE41 },
+		{ addAVX2, subtractAVX2, clipAVX2, dotAVX2, dot4AVX2 },
+#endif
+	};
+}
+
+Simd getBestSimd() {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx2"))
+		return Simd::AVX2;
+	if(__builtin_cpu_supports("sse4.1"))
+		return Simd::SSE41;
+#endif
+	return Simd::SCALAR;
+}
+
+const Int8Kernels& getInt8Kernels(Simd simd) {
+	return INT8_KERNELS[static_cast<int>(simd)];
+}
+
+const char* toString(Simd simd) {
+	switch(simd) {
+	case Simd::AVX2: return "avx2";
+	case Simd::SSE41: return "sse4.1";
+	case Simd::SCALAR: break;
+	}
+	return "scalar";
+}
+
+} /* namespace sch */
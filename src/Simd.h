@@ -0,0 +1,98 @@
+//===-- smart-chess/Simd.h --------------------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file Simd.h
+/// \brief Instruction sets chosen at run time for the vectorized kernels.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef SIMD_H_
+#define SIMD_H_
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * SMARTCHESS_X86_SIMD is defined where the SSE4.1 and AVX2 kernels can be
+ * compiled, with GCC or Clang on x86. Elsewhere only the scalar ones are.
+ */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SMARTCHESS_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+namespace sch {
+
+/**
+ * The vector instruction sets the kernels are written for, from slowest to
+ * fastest. The code for all of them is compiled in with target attributes,
+ * so a single binary runs on any x86-64 CPU and picks the best one.
+ */
+enum class Simd { SCALAR, SSE41, AVX2 };
+
+/// The best Simd the CPU running the program supports, SCALAR outside of x86.
+Simd getBestSimd();
+
+/// "scalar", "sse4.1" or "avx2".
+const char* toString(Simd simd);
+
+/**
+ * The building blocks of the quantized networks (see NNUENetwork and
+ * PolicyNetwork), in one version per instruction set. The lengths must be
+ * multiples of 32.
+ */
+struct Int8Kernels {
+	void (*add)(int16_t* acc, const int16_t* weights, int n);
+	void (*subtract)(int16_t* acc, const int16_t* weights, int n);
+	/// Clips @b n values of @b acc to [0, 127].
+	void (*clip)(const int16_t* acc, uint8_t* out, int n);
+	/// Dot product of @b n values, the inputs must be at most 127.
+	int32_t (*dot)(const uint8_t* in, const int8_t* weights, int n);
+	/**
+	 * The dot products of @b weights with four inputs @b stride bytes apart,
+	 * loading the weights once for all of them.
+	 */
+	void (*dot4)(const uint8_t* in, int stride, const int8_t* weights, int n, int32_t* out);
+};
+
+/// The kernels of @b simd, which the CPU must support.
+const Int8Kernels& getInt8Kernels(Simd simd);
+
+/// The scalar Int8Kernels::clip, for the neurons of the small layers.
+inline uint8_t clipActivation(int x) {
+	return static_cast<uint8_t>(x < 0 ? 0 : (x > 127 ? 127 : x));
+}
+
+/// Every section of a network file starts at a multiple of this many bytes.
+const size_t SECTION_ALIGNMENT = 64;
+
+/// @b size rounded up to the next SECTION_ALIGNMENT.
+inline size_t alignSection(size_t size) {
+	return (size + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+}
+
+} /* namespace sch */
+
+#endif /* SIMD_H_ */
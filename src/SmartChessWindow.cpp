@@ -30,7 +30,11 @@
 
 #include "Util.h"
 #include "SmartChessWindow.h"
+#include "ChessPlayer.h"
+#include "MCTS.h"
+#include <algorithm>
 #include <iostream>
+#include <thread>
 #include <gtkmm/aspectframe.h>
 #include <gtkmm/builder.h>
 #include <gtkmm/button.h>
@@ -48,6 +52,20 @@ using namespace std;
 
 namespace sch {
 
+	namespace {
+		/// Creates the player chosen in the combo box of the game options.
+		ChessPlayer* createPlayer(const Glib::ustring& name, ChessPlayer::Color color) {
+			if(name == "Human")
+				return new Human(color);
+			if(name == "MCTS") {
+				MCTSConfig config;
+				config.threads = max(1u, thread::hardware_concurrency());
+				return new MonteCarlo(color, config);
+			}
+			return new Algorithm(color);
+		}
+	}
+
 	SmartChessWindow::SmartChessWindow()
 	: mLogArea(nullptr), mOptionsGrid(nullptr), mSubOptionsGrid(nullptr) {
 		Gtk::Grid* main_grid = createMainGrid();
@@ -162,12 +180,14 @@ namespace sch {
         mCbt1 = Gtk::manage(new Gtk::ComboBoxText());
         mCbt1->append("Human");
         mCbt1->append("A.I.");
+        mCbt1->append("MCTS");
         mCbt1->set_active(0);
         mSubOptionsGrid->attach(*mCbt1, 0, 1, 1, 1);
 
         mCbt2 = Gtk::manage(new Gtk::ComboBoxText());
         mCbt2->append("Human");
         mCbt2->append("A.I.");
+        mCbt2->append("MCTS");
         mCbt2->set_active(1);
         mSubOptionsGrid->attach(*mCbt2, 2, 1, 1, 1);
 
@@ -343,9 +363,8 @@ namespace sch {
         cout << "SmartChessWindow::onStartGame" << endl;
         string err;
         if(validGameOptions(err)) {
-        	/// @todo when we have more algorithms we will have to create a factory method
-        	ChessPlayer* player1 = (mCbt1->get_active_text() == "Human") ? static_cast<ChessPlayer*>(new Human(rcg1->getColor())) : new Algorithm(rcg1->getColor());
-        	ChessPlayer* player2 = (mCbt2->get_active_text() == "Human") ? static_cast<ChessPlayer*>(new Human(rcg2->getColor())) : new Algorithm(rcg2->getColor());
+        	ChessPlayer* player1 = createPlayer(mCbt1->get_active_text(), rcg1->getColor());
+        	ChessPlayer* player2 = createPlayer(mCbt2->get_active_text(), rcg2->getColor());
 
         	if(typeid(*player1) != typeid(Human)) {
         		mAIPlayerConnection = Glib::signal_idle().connect(sigc::mem_fun(mBoardController, &BoardController::mainGameLogic));
@@ -395,12 +414,12 @@ namespace sch {
         return valid;
     }
 
-    void SmartChessWindow::onBoardStateUpdate(const BoardState& state) {
+    void SmartChessWindow::onBoardStateUpdate(std::shared_ptr<const PositionSnapshot> snapshot) {
         cout << "BoardState Updated" << endl;
         stringstream ss;
-        ss << state.getCurrentPlayer() << "'s turn";
+        ss << snapshot->getCurrentPlayer() << "'s turn";
         mStatusBar->pop();
         mStatusBar->push(ss.str());
-        mView->force_redraw(state);
+        mView->force_redraw(snapshot);
     }
 } /* namespace sch */
@@ -78,7 +78,7 @@ private:
     sigc::connection	mAIPlayerConnection;
     sigc::connection	mBoardViewConnection;
 
-    void onBoardStateUpdate(const BoardState& state);
+    void onBoardStateUpdate(std::shared_ptr<const PositionSnapshot> snapshot);
     void onStartGame();
     void onEndGame();
     void onResetGame();
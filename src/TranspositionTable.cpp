@@ -0,0 +1,119 @@
+//===-- smart-chess/TranspositionTable.cpp ----------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file TranspositionTable.cpp
+/// \brief Shared hash table of search results.
+///
+//===----------------------------------------------------------------------===//
+
+#include "TranspositionTable.h"
+
+namespace sch {
+
+namespace {
+	// Layout of the data word
+	// bits  0-15 move, 16-31 score, 32-39 depth, 40-41 bound, 42-47 age
+	inline uint64_t pack(uint16_t move, int score, int depth, int bound, int age) {
+		return static_cast<uint64_t>(move)
+				| (static_cast<uint64_t>(static_cast<uint16_t>(static_cast<int16_t>(score))) << 16)
+				| (static_cast<uint64_t>(static_cast<uint8_t>(depth)) << 32)
+				| (static_cast<uint64_t>(bound & 0x3) << 40)
+				| (static_cast<uint64_t>(age & 0x3F) << 42);
+	}
+
+	inline int depthOf(uint64_t data) { return static_cast<int8_t>(data >> 32); }
+	inline int boundOf(uint64_t data) { return (data >> 40) & 0x3; }
+	inline int ageOf(uint64_t data) { return (data >> 42) & 0x3F; }
+}
+
+TranspositionTable::TranspositionTable(size_t size_mb)
+: mTable(nullptr), mMask(0), mAge(0) {
+	resize(size_mb);
+}
+
+void TranspositionTable::resize(size_t size_mb) {
+	const size_t bytes = (size_mb ? size_mb : 1) * 1024 * 1024;
+	size_t slots = 1;
+	while(slots * 2 * sizeof(Slot) <= bytes)
+		slots *= 2;
+
+	mTable.reset(new Slot[slots]);
+	mMask = slots - 1;
+	clear();
+}
+
+void TranspositionTable::clear() {
+	for(size_t i = 0; i <= mMask; ++i) {
+		mTable[i].data.store(0, std::memory_order_relaxed);
+		mTable[i].check.store(0, std::memory_order_relaxed);
+	}
+	mAge = 0;
+}
+
+bool TranspositionTable::probe(uint64_t key, Entry& entry) const {
+	const Slot& slot = mTable[key & mMask];
+	const uint64_t data = slot.data.load(std::memory_order_relaxed);
+	const uint64_t check = slot.check.load(std::memory_order_relaxed);
+	if((check ^ data) != key || boundOf(data) == BOUND_NONE)
+		return false;
+
+	entry.move = static_cast<uint16_t>(data);
+	entry.score = static_cast<int16_t>(data >> 16);
+	entry.depth = depthOf(data);
+	entry.bound = static_cast<Bound>(boundOf(data));
+	return true;
+}
+
+void TranspositionTable::store(uint64_t key, uint16_t move, int score, int depth, Bound bound) {
+	Slot& slot = mTable[key & mMask];
+	const uint64_t old = slot.data.load(std::memory_order_relaxed);
+	const bool same_position = (slot.check.load(std::memory_order_relaxed) ^ old) == key;
+
+	// Keep deeper results of the current search, unless this one is exact
+	if(ageOf(old) == mAge && boundOf(old) != BOUND_NONE && bound != BOUND_EXACT
+			&& depth < depthOf(old) - (same_position ? 2 : 0))
+		return;
+
+	// Do not lose the best move when re-storing a position without one
+	if(!move && same_position)
+		move = static_cast<uint16_t>(old);
+
+	const uint64_t data = pack(move, score, depth, bound, mAge);
+	slot.data.store(data, std::memory_order_relaxed);
+	slot.check.store(key ^ data, std::memory_order_relaxed);
+}
+
+int TranspositionTable::getHashFull() const {
+	const size_t sample = mMask + 1 < 1000 ? mMask + 1 : 1000;
+	size_t used = 0;
+	for(size_t i = 0; i < sample; ++i) {
+		const uint64_t data = mTable[i].data.load(std::memory_order_relaxed);
+		if(boundOf(data) != BOUND_NONE && ageOf(data) == mAge)
+			++used;
+	}
+	return static_cast<int>(used * 1000 / sample);
+}
+
+} /* namespace sch */
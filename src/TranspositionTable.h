@@ -0,0 +1,98 @@
+//===-- smart-chess/TranspositionTable.h ------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file TranspositionTable.h
+/// \brief Shared hash table of search results.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef TRANSPOSITIONTABLE_H_
+#define TRANSPOSITIONTABLE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace sch {
+
+/**
+ * Remembers the result of searching a position so the search does not repeat
+ * the work when the same position is reached through another move order, in
+ * a later iteration or by another thread.
+ *
+ * Like EvalCache, every slot holds a data word and the key XOR'ed with it,
+ * so the table can be shared between threads without locks.
+ */
+class TranspositionTable {
+public:
+	static const size_t DEFAULT_SIZE_MB = 16;
+
+	/// How the stored score relates to the real score of the position.
+	enum Bound {
+		BOUND_NONE,
+		BOUND_UPPER, //!< The real score is at most the stored one (fail low)
+		BOUND_LOWER, //!< The real score is at least the stored one (fail high)
+		BOUND_EXACT
+	};
+
+	struct Entry {
+		uint16_t move; //!< Best move, see BoardState::encodeMove(), 0 if unknown
+		int score;
+		int depth;
+		Bound bound;
+	};
+
+	explicit TranspositionTable(size_t size_mb = DEFAULT_SIZE_MB);
+
+	TranspositionTable(const TranspositionTable&) = delete;
+	TranspositionTable& operator = (const TranspositionTable&) = delete;
+
+	void resize(size_t size_mb);
+	void clear();
+
+	/// Called once per search so older entries get replaced first.
+	void newSearch() { mAge = (mAge + 1) & 0x3F; }
+
+	bool probe(uint64_t key, Entry& entry) const;
+	void store(uint64_t key, uint16_t move, int score, int depth, Bound bound);
+
+	/// Permill of the slots used by the current search, as reported by UCI.
+	int getHashFull() const;
+
+private:
+	struct Slot {
+		std::atomic<uint64_t> data;
+		std::atomic<uint64_t> check; //!< key ^ data
+	};
+
+	std::unique_ptr<Slot[]> mTable;
+	size_t mMask;
+	uint8_t mAge;
+};
+
+} /* namespace sch */
+
+#endif /* TRANSPOSITIONTABLE_H_ */
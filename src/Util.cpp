@@ -3,45 +3,64 @@
 //
 
 #include "Util.h"
-
-#include "SmartChessConfig.h"
+#include "ChessPiece.h"
+#include <ostream>
 
 namespace sch {
 
-    ImageLoader &ImageLoader::instance() {
-        static ImageLoader m_instance;
-        return m_instance;
+    Move::Move(std::shared_ptr<ChessPiece> p, BoardPosition pos, PieceType promo)
+    : piece(p), initial_pos(p ? p->getBoardPosition() : BoardPosition()),
+      final_pos(pos), promotion(promo) {
     }
 
-    void ImageLoader::loadImages(std::string data_dir) {
-        images[PieceType::WHITE_KING] = Gdk::Pixbuf::create_from_file(data_dir + "/kingw.gif");
-        images[PieceType::WHITE_QUEEN] = Gdk::Pixbuf::create_from_file(data_dir + "/queenw.gif");
-        images[PieceType::WHITE_ROOK] = Gdk::Pixbuf::create_from_file(data_dir + "/rookw.gif");
-        images[PieceType::WHITE_BISHOP] = Gdk::Pixbuf::create_from_file(data_dir +"/bishopw.gif");
-        images[PieceType::WHITE_KNIGHT] = Gdk::Pixbuf::create_from_file(data_dir + "/knightw.gif");
-        images[PieceType::WHITE_PAWN] = Gdk::Pixbuf::create_from_file(data_dir + "/pawnw.gif");
-
-        images[PieceType::BLACK_KING] = Gdk::Pixbuf::create_from_file(data_dir + "/kingb.gif");
-        images[PieceType::BLACK_QUEEN] = Gdk::Pixbuf::create_from_file(data_dir + "/queenb.gif");
-        images[PieceType::BLACK_ROOK] = Gdk::Pixbuf::create_from_file(data_dir + "/rookb.gif");
-        images[PieceType::BLACK_BISHOP] = Gdk::Pixbuf::create_from_file(data_dir + "/bishopb.gif");
-        images[PieceType::BLACK_KNIGHT] = Gdk::Pixbuf::create_from_file(data_dir + "/knightb.gif");
-        images[PieceType::BLACK_PAWN] = Gdk::Pixbuf::create_from_file(data_dir + "/pawnb.gif");
-    }
-
-    ImageLoader::ImageLoader() {
-        loadImages(SMARTCHESS_DATA_DIR);
+    std::ostream& operator << (std::ostream& os, PlayerColor c) {
+    	switch(c) {
+    	case PlayerColor::WHITE_PLAYER: os << "white player"; break;
+    	case PlayerColor::BLACK_PLAYER: os << "black player"; break;
+    	}
+    	return os;
     }
 
-    Glib::RefPtr<Gdk::Pixbuf> ImageLoader::getImage(PieceType type) {
-        return images[type];
+    std::ostream& operator <<(std::ostream& os, Row r)
+    {
+    	switch (r) {
+    	case Row::ONE: os << 1; break;
+    	case Row::TWO: os << 2; break;
+    	case Row::THREE: os << 3; break;
+    	case Row::FOUR: os << 4; break;
+    	case Row::FIVE: os << 5; break;
+    	case Row::SIX: os << 6; break;
+    	case Row::SEVEN: os << 7; break;
+    	case Row::EIGHT: os << 8; break;
+    	default:
+    		os << "<Invalid BoardRow(" << int(r) << ")>";
+    		break;
+    	}
+    	return os;
     }
 
-    std::ostream& operator << (std::ostream& os, PlayerColor c) {
+    std::ostream& operator <<(std::ostream& os, Column c)
+    {
     	switch(c) {
-    	case PlayerColor::WHITE_PLAYER: os << "white player"; break;
-    	case PlayerColor::BLACK_PLAYER: os << "black player"; break;
+    	case Column::A: os << "A"; break;
+    	case Column::B: os << "B"; break;
+    	case Column::C: os << "C"; break;
+    	case Column::D: os << "D"; break;
+    	case Column::E: os << "E"; break;
+    	case Column::F: os << "F"; break;
+    	case Column::G: os << "G"; break;
+    	case Column::H: os << "H"; break;
+    	default:
+    		os << "<Invalid BoardColumn(" << int(c) << ")>";
+    		break;
     	}
     	return os;
     }
+
+    std::ostream& operator <<(std::ostream& os, Move m)
+    {
+    	os << "Move : "<<m.piece->getPieceType() << " to "
+    		<< m.final_pos.column << m.final_pos.row << std::endl;
+    	return os;
+    }
 }
@@ -32,8 +32,8 @@
 #define UTIL_H_
 
 #include <sstream>
+#include <string>
 #include <memory>
-#include <gdkmm/pixbuf.h>
 
 namespace sch
 {
@@ -61,6 +61,47 @@ namespace sch
         MAX_COL
     };
 
+    enum class PieceType {
+        WHITE_KING,
+        BLACK_KING,
+        WHITE_QUEEN,
+        BLACK_QUEEN,
+        WHITE_ROOK,
+        BLACK_ROOK,
+        WHITE_BISHOP,
+        BLACK_BISHOP,
+        WHITE_KNIGHT,
+        BLACK_KNIGHT,
+        WHITE_PAWN,
+        BLACK_PAWN,
+        UNDEFINED
+    };
+
+    /// Number of different kinds of pieces, regardless of their color.
+    const int PIECE_KINDS = 6;
+
+    /**
+     * The kind of a piece regardless of its color: 0 king, 1 queen, 2 rook,
+     * 3 bishop, 4 knight and 5 pawn. It follows the order of PieceType.
+     */
+    inline int getPieceKind(PieceType t) { return static_cast<int>(t) / 2; }
+
+    /// The values of getPieceKind().
+    const int KING_KIND = 0;
+    const int QUEEN_KIND = 1;
+    const int ROOK_KIND = 2;
+    const int BISHOP_KIND = 3;
+    const int KNIGHT_KIND = 4;
+    const int PAWN_KIND = 5;
+
+    inline bool isWhitePieceType(PieceType t) {
+        return t != PieceType::UNDEFINED && (static_cast<int>(t) & 1) == 0;
+    }
+
+    inline PieceType makePieceType(int kind, bool white) {
+        return static_cast<PieceType>(kind * 2 + (white ? 0 : 1));
+    }
+
 enum class PlayerColor {
 	WHITE_PLAYER,
 	BLACK_PLAYER
@@ -81,8 +122,23 @@ struct BoardPosition {
 	bool isValid() const {
 		return row != Row::MAX_ROW && column != Column::MAX_COL;
 	}
+	/// True when the position lies inside the 8x8 board.
+	bool isOnBoard() const {
+		return row >= 0 && row < Row::MAX_ROW && column >= 0 && column < Column::MAX_COL;
+	}
 };
 
+/// Squares are numbered from 0 to 63 row by row, starting at A8.
+const int SQUARE_COUNT = MAX_ROW * MAX_COL;
+
+inline int toSquareIndex(BoardPosition p) { return p.row * MAX_COL + p.column; }
+inline BoardPosition toBoardPosition(int square) {
+	return BoardPosition(square / MAX_COL, square % MAX_COL);
+}
+
+/// The square on the same column and the opposite row, e.g. A8 for A1.
+inline int mirrorSquare(int square) { return square ^ (SQUARE_COUNT - MAX_COL); }
+
 class ChessPiece;
 
 struct BoardSquare {
@@ -111,9 +167,17 @@ private:
 
 struct Move {
 	std::shared_ptr<ChessPiece> piece; // The piece we want to move
+	BoardPosition initial_pos; // Where the piece was when the move was created
 	BoardPosition final_pos; // The final position where the piece will be moved
-	Move() : piece(nullptr), final_pos() {}
-	Move(std::shared_ptr<ChessPiece> p, BoardPosition pos) : piece(p), final_pos(pos) {}
+	PieceType promotion; // What a pawn reaching the last row becomes, UNDEFINED otherwise
+	Move() : piece(nullptr), initial_pos(), final_pos(), promotion(PieceType::UNDEFINED) {}
+	Move(std::shared_ptr<ChessPiece> p, BoardPosition pos,
+			PieceType promo = PieceType::UNDEFINED);
+	bool operator ==(const Move& that) const {
+		return initial_pos == that.initial_pos && final_pos == that.final_pos
+				&& promotion == that.promotion;
+	}
+	bool isValid() const { return piece.operator bool(); }
 };
 
 std::ostream& operator <<(std::ostream& os, Row r);
@@ -138,6 +202,20 @@ private:
 	BoardPosition mPos;
 };
 
+class FENException : public ChessException {
+public:
+	FENException(const std::string& fen, const std::string& reason) {
+		mMsg = "Invalid FEN '" + fen + "': " + reason;
+	}
+};
+
+class FileException : public ChessException {
+public:
+	FileException(const std::string& path, const std::string& reason) {
+		mMsg = path + ": " + reason;
+	}
+};
+
     /**
      * Helper class to be used in a range based for. It will iterate from 0 to
      * N-1 element. Where N is the parameter used to construct a IntRange.
@@ -170,35 +248,6 @@ private:
         Iterator mEnd;
     };
 
-    enum class PieceType {
-        WHITE_KING,
-        BLACK_KING,
-        WHITE_QUEEN,
-        BLACK_QUEEN,
-        WHITE_ROOK,
-        BLACK_ROOK,
-        WHITE_BISHOP,
-        BLACK_BISHOP,
-        WHITE_KNIGHT,
-        BLACK_KNIGHT,
-        WHITE_PAWN,
-        BLACK_PAWN,
-        UNDEFINED
-    };
-
-    class ImageLoader {
-    public:
-        static ImageLoader& instance();
-
-        /// @note Call only once at the beginning of the program.
-        void loadImages(std::string data_dir);
-        Glib::RefPtr<Gdk::Pixbuf> getImage(PieceType type);
-    private:
-        std::map<PieceType, Glib::RefPtr<Gdk::Pixbuf>> images;
-
-        ImageLoader();
-    };
-
 }
 
 
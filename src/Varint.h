@@ -0,0 +1,81 @@
+//===-- smart-chess/Varint.h ------------------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file Varint.h
+/// \brief Variable length encoding of unsigned integers.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef VARINT_H_
+#define VARINT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace sch {
+
+/// Longest encoding of a 64 bit value.
+const size_t MAX_VARINT_LENGTH = 10;
+
+/**
+ * Writes @b value 7 bits per byte, least significant group first, with the
+ * high bit set on every byte but the last one. Small values take one byte.
+ *
+ * @return The number of bytes written to @b out.
+ */
+inline size_t writeVarint(uint64_t value, uint8_t* out) {
+	size_t n = 0;
+	while(value >= 0x80) {
+		out[n++] = static_cast<uint8_t>(value | 0x80);
+		value >>= 7;
+	}
+	out[n++] = static_cast<uint8_t>(value);
+	return n;
+}
+
+inline void appendVarint(std::vector<uint8_t>& out, uint64_t value) {
+	uint8_t buffer[MAX_VARINT_LENGTH];
+	out.insert(out.end(), buffer, buffer + writeVarint(value, buffer));
+}
+
+/**
+ * Reads a value written by writeVarint() and advances @b p past it. Reads
+ * stop at @b end, a truncated value decodes to whatever was read.
+ */
+inline uint64_t readVarint(const uint8_t*& p, const uint8_t* end) {
+	uint64_t value = 0;
+	for(int shift = 0; p < end && shift < 64; shift += 7) {
+		const uint8_t byte = *p++;
+		value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+		if(!(byte & 0x80))
+			break;
+	}
+	return value;
+}
+
+} /* namespace sch */
+
+#endif /* VARINT_H_ */
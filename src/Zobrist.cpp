@@ -0,0 +1,64 @@
+//===-- smart-chess/Zobrist.cpp ---------------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file Zobrist.cpp
+/// \brief Random keys used to compute the hash of a BoardState.
+///
+//===----------------------------------------------------------------------===//
+
+#include "Zobrist.h"
+
+namespace sch {
+
+namespace {
+	/// SplitMix64, good enough to fill the key tables and fully deterministic.
+	uint64_t nextRandom(uint64_t& seed) {
+		uint64_t z = (seed += 0x9E3779B97F4A7C15ULL);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		return z ^ (z >> 31);
+	}
+}
+
+const Zobrist& Zobrist::instance() {
+	static Zobrist m_instance;
+	return m_instance;
+}
+
+Zobrist::Zobrist() {
+	uint64_t seed = 0x5343484553534bULL;
+	for(int t = 0; t < PIECE_TYPES; ++t)
+		for(int sq = 0; sq < SQUARE_COUNT; ++sq)
+			mPieceKeys[t][sq] = nextRandom(seed);
+	mSideKey = nextRandom(seed);
+	// Index 0 (no rights left) must not change the hash.
+	mCastlingKeys[0] = 0;
+	for(int i = 1; i < 16; ++i)
+		mCastlingKeys[i] = nextRandom(seed);
+	for(int c = 0; c < MAX_COL; ++c)
+		mEnPassantKeys[c] = nextRandom(seed);
+}
+
+} /* namespace sch */
@@ -0,0 +1,83 @@
+//===-- smart-chess/Zobrist.h -----------------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file Zobrist.h
+/// \brief Random keys used to compute the hash of a BoardState.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef ZOBRIST_H_
+#define ZOBRIST_H_
+
+#include <cstdint>
+#include "Util.h"
+
+namespace sch {
+
+/**
+ * Holds the random numbers used for Zobrist hashing.
+ *
+ * The hash of a position is the XOR of the key of every piece on its square,
+ * the side key when black is to move, the key of the castling rights and the
+ * key of the en passant column when a capture en passant is possible. Since
+ * XOR is its own inverse a BoardState can update its hash incrementally on
+ * every move.
+ *
+ * The keys are generated from a fixed seed so hashes are stable across runs.
+ */
+class Zobrist {
+public:
+	static const Zobrist& instance();
+
+	uint64_t getPieceKey(PieceType type, BoardPosition pos) const {
+		return mPieceKeys[static_cast<int>(type)][toSquareIndex(pos)];
+	}
+
+	uint64_t getPieceKey(PieceType type, int square) const {
+		return mPieceKeys[static_cast<int>(type)][square];
+	}
+
+	/// XOR'ed into the hash when black is the side to move.
+	uint64_t getSideKey() const { return mSideKey; }
+
+	/// @param rights The castling rights bit mask, see BoardState::CastlingRight.
+	uint64_t getCastlingKey(int rights) const { return mCastlingKeys[rights & 0xF]; }
+
+	uint64_t getEnPassantKey(Column c) const { return mEnPassantKeys[c]; }
+
+private:
+	static const int PIECE_TYPES = static_cast<int>(PieceType::UNDEFINED);
+
+	uint64_t mPieceKeys[PIECE_TYPES][SQUARE_COUNT];
+	uint64_t mSideKey;
+	uint64_t mCastlingKeys[16];
+	uint64_t mEnPassantKeys[MAX_COL];
+
+	Zobrist();
+};
+
+} /* namespace sch */
+
+#endif /* ZOBRIST_H_ */
@@ -0,0 +1,83 @@
+//===-- smart-chess/fen_test.cpp --------------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file fen_test.cpp
+/// \brief Tests of the Forsyth-Edwards Notation reader.
+///
+//===----------------------------------------------------------------------===//
+
+#include "BoardState.h"
+#include <iostream>
+
+using namespace std;
+using namespace sch;
+
+namespace {
+
+int failures = 0;
+
+void check(bool condition, const char* what) {
+	if(!condition) {
+		cerr << "FAILED: " << what << endl;
+		++failures;
+	}
+}
+
+bool isRejected(const char* fen) {
+	BoardState state;
+	try {
+		state.loadFEN(fen);
+	} catch(const FENException&) {
+		return true;
+	}
+	return false;
+}
+
+void testEnPassant() {
+	// e3 is behind a white pawn, white to move could only take its own pawn
+	check(isRejected("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq e3 0 1"),
+			"en passant square on the rank of the side to move");
+	check(isRejected("rnbqkbnr/pppp1ppp/8/3P4/8/8/PPP1PPPP/RNBQKBNR w KQkq e6 0 2"),
+			"en passant square without the pawn that jumped");
+	check(isRejected("rnbqkbnr/pppp1ppp/4p3/3Pp3/8/8/PPP1PPPP/RNBQKBNR w KQkq e6 0 3"),
+			"en passant square that is not empty");
+	check(isRejected("rnbqkbnr/pppppppp/8/3Pp3/8/8/PPP1PPPP/RNBQKBNR w KQkq e6 0 3"),
+			"en passant square whose pawn never left its origin");
+
+	const BoardState capture = BoardState::fromFEN("rnbqkbnr/pppp1ppp/8/3Pp3/8/8/PPP1PPPP/RNBQKBNR w KQkq e6 0 3");
+	check(capture.getEnPassantSquare() == BoardPosition(2, 4), "en passant square kept when d5 can take");
+	const BoardState no_capture = BoardState::fromFEN("rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1");
+	check(!no_capture.getEnPassantSquare().isOnBoard(), "en passant square dropped when no pawn can take");
+}
+
+}
+
+int main()
+{
+	testEnPassant();
+	if(failures)
+		cerr << failures << " checks failed" << endl;
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,85 @@
+//===-- smart-chess/match_test.cpp ------------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file match_test.cpp
+/// \brief Tests of the match statistics and the SPRT.
+///
+//===----------------------------------------------------------------------===//
+
+#include "Match.h"
+#include <iostream>
+
+using namespace std;
+using namespace sch;
+
+namespace {
+
+int failures = 0;
+
+void check(bool condition, const char* what) {
+	if(!condition) {
+		cerr << "FAILED: " << what << endl;
+		++failures;
+	}
+}
+
+// Adds results until the SPRT stops, returns the number of games played
+int runUntilDecided(MatchStatistics& stats, double score, SPRT::Status& status) {
+	const SPRT sprt;
+	status = SPRT::Status::CONTINUE;
+	for(int games = 1; games <= 1000; ++games) {
+		stats.add(score);
+		status = sprt.check(stats);
+		if(status != SPRT::Status::CONTINUE)
+			return games;
+	}
+	return 0;
+}
+
+void testOneSided() {
+	MatchStatistics sweep;
+	for(int i = 0; i < 4; ++i)
+		sweep.add(1);
+	check(sweep.getLLR(0, 5) > 0, "a 4-0 score raises the LLR");
+	check(sweep.getEloError() > 0, "a 4-0 score has an Elo error");
+
+	SPRT::Status status;
+	MatchStatistics wins;
+	check(runUntilDecided(wins, 1, status) > 0 && status == SPRT::Status::ACCEPT_H1,
+	      "only wins accept H1");
+	MatchStatistics losses;
+	check(runUntilDecided(losses, 0, status) > 0 && status == SPRT::Status::ACCEPT_H0,
+	      "only losses accept H0");
+}
+
+}
+
+int main()
+{
+	testOneSided();
+	if(failures)
+		cerr << failures << " checks failed" << endl;
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,99 @@
+//===-- smart-chess/notation_test.cpp ---------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file notation_test.cpp
+/// \brief Tests of the Standard Algebraic Notation reader.
+///
+//===----------------------------------------------------------------------===//
+
+#include "Notation.h"
+#include "PGNReader.h"
+#include "BoardState.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+using namespace std;
+using namespace sch;
+
+namespace {
+
+int failures = 0;
+
+void check(bool condition, const char* what) {
+	if(!condition) {
+		cerr << "FAILED: " << what << endl;
+		++failures;
+	}
+}
+
+bool isAccepted(const BoardState& state, const char* san) {
+	return parseSANCode(state, san, strlen(san)) != 0;
+}
+
+/// The error PGNReader gives for a file holding only @b pgn.
+string readError(const char* pgn) {
+	const char* path = "notation_test.pgn";
+	{
+		ofstream file(path);
+		file << pgn;
+	}
+	string error = "no game";
+	{
+		PGNReader reader(path);
+		PGNGame game;
+		if(reader.next(game))
+			error = game.error;
+	}
+	remove(path);
+	return error;
+}
+
+void testPawnMoves() {
+	// Bishop on b5, black pawn on a6: "b5" is no move, only "axb5" takes
+	const BoardState ruy = BoardState::fromFEN("r1bqkb1r/1ppp1ppp/p1n2n2/1B2p3/4P3/5N2/PPPP1PPP/RNBQR1K1 b kq - 3 5");
+	check(!isAccepted(ruy, "b5"), "a pawn push onto a piece");
+	check(isAccepted(ruy, "axb5"), "a pawn capture");
+	check(!isAccepted(ruy, "ab5"), "a pawn capture without the 'x'");
+	check(!isAccepted(ruy, "xb5"), "a pawn capture without the file");
+	check(isAccepted(ruy, "b6"), "a pawn push");
+	check(!isAccepted(ruy, "bxb6"), "a pawn push written as a capture");
+
+	check(!readError("[Event \"?\"]\n\n1.e4 e5 2.Nf3 Nc6 3.Bb5 a6 4.O-O Nf6 5.Re1 b5 *\n").empty(),
+			"a game with a pawn push onto a piece");
+	check(readError("[Event \"?\"]\n\n1.e4 d5 2.exd5 Qxd5 3.Nc3 *\n").empty(),
+			"a game with pawn captures");
+}
+
+}
+
+int main()
+{
+	testPawnMoves();
+	if(failures)
+		cerr << failures << " checks failed" << endl;
+	return failures ? 1 : 0;
+}
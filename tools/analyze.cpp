@@ -0,0 +1,314 @@
+//===-- smart-chess/analyze.cpp ---------------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file analyze.cpp
+/// \brief Analyzes every position of an EPD file on all cores.
+///
+//===----------------------------------------------------------------------===//
+
+#include "BoardState.h"
+#include "Notation.h"
+#include "Search.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+using namespace std;
+using namespace sch;
+
+namespace {
+
+void usage(const char* program) {
+	cerr << "Usage: " << program << " [options] [FILE]\n"
+	     << "Reads EPD positions from FILE (or stdin) and writes them back, in the same\n"
+	     << "order, with the bm, ce (or dm), acd, acn and pv operations of the analysis.\n"
+	     << "  -depth N       Depth limit per position\n"
+	     << "  -nodes N       Node limit per position\n"
+	     << "  -movetime MS   Time limit per position\n"
+	     << "  -threads N     Positions analyzed at the same time (default: all cores)\n"
+	     << "  -hash MB       Transposition table size of every worker (default 16)\n"
+	     << "  -o FILE        Writes the results to FILE instead of stdout\n";
+}
+
+/// The operations written by this tool, dropped from the input to avoid duplicates.
+bool isResultOpcode(const string& opcode) {
+	return opcode == "bm" || opcode == "ce" || opcode == "dm" || opcode == "acd"
+			|| opcode == "acn" || opcode == "pv";
+}
+
+/**
+ * Splits the operations of an EPD line ("bm Nf3; id \"x\";") in opcodes and
+ * operands. Semicolons inside quoted strings do not end an operation.
+ */
+vector<pair<string, string>> parseOperations(const string& text) {
+	vector<pair<string, string>> ops;
+	string current;
+	bool quoted = false;
+	for(char c : text) {
+		if(c == '"')
+			quoted = !quoted;
+		if(c == ';' && !quoted) {
+			istringstream is(current);
+			string opcode, operand;
+			if(is >> opcode) {
+				getline(is >> ws, operand);
+				ops.push_back(make_pair(opcode, operand));
+			}
+			current.clear();
+		} else {
+			current += c;
+		}
+	}
+	return ops;
+}
+
+/// The outcome of analyzing a single line of the input.
+struct Analysis {
+	string line;      //!< What to write to the output
+	bool analyzed;    //!< False for empty or malformed lines
+	bool hasBestMove; //!< The input named the expected best moves
+	bool solved;      //!< The best move found is one of them
+	uint64_t nodes;
+};
+
+/// Analyzes one EPD line with @b search.
+Analysis analyze(Search& search, const SearchLimits& limits, const string& line) {
+	Analysis result = { line, false, false, false, 0 };
+
+	istringstream is(line);
+	string fields[4];
+	if(!(is >> fields[0] >> fields[1] >> fields[2] >> fields[3]))
+		return result;
+	string rest;
+	getline(is, rest);
+
+	BoardState state;
+	const string fen4 = fields[0] + " " + fields[1] + " " + fields[2] + " " + fields[3];
+	try {
+		state.loadFEN(fen4 + " 0 1");
+	} catch(const FENException& e) {
+		cerr << e.what() << endl;
+		return result;
+	}
+
+	SearchInfo last = SearchInfo();
+	search.setInfoCallback([&last](const SearchInfo& info) { last = info; });
+	search.clear();
+	const Move best = search.think(state, limits);
+
+	ostringstream os;
+	os << fen4;
+	if(best.isValid()) {
+		os << " bm " << toSAN(state, best) << ";";
+		if(Search::isMateScore(last.score))
+			os << " dm " << Search::getMateIn(last.score) << ";";
+		else
+			os << " ce " << last.score << ";";
+		os << " acd " << last.depth << "; acn " << last.nodes << ";";
+
+		// The pv in SAN, replayed on a copy of the position
+		BoardState pv_state(state);
+		os << " pv";
+		for(auto& m : last.pv) {
+			const Move move = pv_state.decodeMove(BoardState::encodeMove(m));
+			os << " " << toSAN(pv_state, move);
+			BoardState::UndoInfo undo;
+			pv_state.makeMove(move, undo);
+		}
+		os << ";";
+	}
+
+	for(auto& op : parseOperations(rest)) {
+		if(op.first == "bm") {
+			result.hasBestMove = true;
+			istringstream moves(op.second);
+			string san;
+			const string found = best.isValid() ? toSAN(state, best) : "";
+			while(moves >> san) {
+				// Ignore check and annotation marks, "Qxf7+" matches "Qxf7"
+				auto strip = [](string s) { return s.substr(0, s.find_first_of("+#!?")); };
+				if(strip(san) == strip(found))
+					result.solved = true;
+			}
+			os << " expected_bm " << op.second << ";";
+		} else if(!isResultOpcode(op.first)) {
+			os << " " << op.first << (op.second.empty() ? "" : " ") << op.second << ";";
+		}
+	}
+
+	result.line = os.str();
+	result.analyzed = true;
+	result.nodes = search.getNodes();
+	return result;
+}
+
+}
+
+int main(int argc, char * argv[])
+{
+	SearchLimits limits;
+	int threads = max(1u, thread::hardware_concurrency());
+	size_t hash = TranspositionTable::DEFAULT_SIZE_MB;
+	string input_path, output_path;
+
+	try {
+		for(int i = 1; i < argc; ++i) {
+			const string arg = argv[i];
+			auto value = [&]() -> string {
+				if(i + 1 >= argc)
+					throw runtime_error(arg + " needs a value");
+				return argv[++i];
+			};
+			if(arg == "-depth") limits.depth = stoi(value());
+			else if(arg == "-nodes") limits.nodes = stoull(value());
+			else if(arg == "-movetime") limits.moveTime = stoi(value());
+			else if(arg == "-threads") threads = max(1, stoi(value()));
+			else if(arg == "-hash") hash = stoul(value());
+			else if(arg == "-o") output_path = value();
+			else if(arg[0] == '-' && arg != "-") {
+				usage(argv[0]);
+				return arg == "-help" || arg == "-h" ? 0 : 1;
+			} else input_path = arg;
+		}
+	} catch(const exception& e) {
+		cerr << e.what() << endl;
+		usage(argv[0]);
+		return 1;
+	}
+	if(!limits.depth && !limits.nodes && !limits.moveTime) {
+		cerr << "Give at least one of -depth, -nodes or -movetime" << endl;
+		return 1;
+	}
+
+	ifstream input_file;
+	if(!input_path.empty() && input_path != "-") {
+		input_file.open(input_path);
+		if(!input_file) {
+			cerr << "Could not open " << input_path << endl;
+			return 1;
+		}
+	}
+	istream& input = input_file.is_open() ? input_file : cin;
+
+	ofstream output_file;
+	if(!output_path.empty()) {
+		output_file.open(output_path);
+		if(!output_file) {
+			cerr << "Could not create " << output_path << endl;
+			return 1;
+		}
+	}
+	ostream& output = output_file.is_open() ? output_file : cout;
+
+	// Lines read but not written yet are limited to WINDOW, so memory does
+	// not depend on the size of the input. Results that finish early wait in
+	// a ring buffer until every line before them has been written.
+	const size_t WINDOW = 8 * threads;
+	vector<Analysis> slots(WINDOW);
+	vector<bool> ready(WINDOW, false);
+	deque<pair<size_t, string>> jobs;
+	size_t next_write = 0;
+	bool eof = false;
+	mutex m;
+	condition_variable job_available, slot_available;
+
+	size_t positions = 0, solved = 0, with_best_move = 0;
+	uint64_t nodes = 0;
+
+	auto worker = [&]() {
+		Search search;
+		search.setHashSize(hash);
+
+		for(;;) {
+			pair<size_t, string> job;
+			{
+				unique_lock<mutex> lock(m);
+				job_available.wait(lock, [&] { return !jobs.empty() || eof; });
+				if(jobs.empty())
+					return;
+				job = move(jobs.front());
+				jobs.pop_front();
+			}
+
+			Analysis result = analyze(search, limits, job.second);
+
+			lock_guard<mutex> lock(m);
+			slots[job.first % WINDOW] = move(result);
+			ready[job.first % WINDOW] = true;
+			while(ready[next_write % WINDOW]) {
+				Analysis& a = slots[next_write % WINDOW];
+				output << a.line << '\n';
+				if(a.analyzed) {
+					++positions;
+					nodes += a.nodes;
+					with_best_move += a.hasBestMove;
+					solved += a.solved;
+				}
+				a.line.clear();
+				ready[next_write % WINDOW] = false;
+				++next_write;
+			}
+			output.flush();
+			slot_available.notify_one();
+		}
+	};
+
+	const auto start = chrono::steady_clock::now();
+	vector<thread> pool;
+	for(int i = 0; i < threads; ++i)
+		pool.emplace_back(worker);
+
+	string line;
+	for(size_t index = 0; getline(input, line); ++index) {
+		unique_lock<mutex> lock(m);
+		slot_available.wait(lock, [&] { return index < next_write + WINDOW; });
+		jobs.push_back(make_pair(index, move(line)));
+		job_available.notify_one();
+	}
+	{
+		lock_guard<mutex> lock(m);
+		eof = true;
+	}
+	job_available.notify_all();
+	for(auto& t : pool)
+		t.join();
+
+	const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	cerr << fixed << setprecision(1)
+	     << "Analyzed " << positions << " positions in " << seconds << " s: "
+	     << (seconds > 0 ? positions / seconds : 0) << " positions/s, "
+	     << setprecision(0) << (seconds > 0 ? nodes / seconds : 0) << " nodes/s" << endl;
+	if(with_best_move)
+		cerr << "Found the expected best move in " << solved << " of " << with_best_move << " positions" << endl;
+	return 0;
+}
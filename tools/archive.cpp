@@ -0,0 +1,145 @@
+//===-- smart-chess/archive.cpp ---------------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file archive.cpp
+/// \brief Converts between PGN files and game archives.
+///
+//===----------------------------------------------------------------------===//
+
+#include "GameArchive.h"
+#include "Notation.h"
+#include "PGNReader.h"
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+using namespace std;
+using namespace sch;
+
+namespace {
+
+typedef chrono::steady_clock Clock;
+
+void usage(const char* program) {
+	cerr << "Usage:\n"
+	     << "  " << program << " pgn2bin IN.pgn OUT.scg   Converts a PGN file to a game archive\n"
+	     << "  " << program << " bin2pgn IN.scg OUT.pgn   Converts a game archive back to PGN\n"
+	     << "  " << program << " bench IN.scg             Times replaying every game of an archive" << endl;
+}
+
+double secondsSince(Clock::time_point start) {
+	return chrono::duration<double>(Clock::now() - start).count();
+}
+
+int pgnToArchive(const string& in, const string& out) {
+	PGNReader reader(in);
+	GameArchiveWriter writer(out);
+	PGNGame game;
+	PGNTags tags;
+	size_t skipped = 0;
+	const Clock::time_point start = Clock::now();
+
+	while(reader.next(game)) {
+		tags.clear();
+		bool has_result = false;
+		for(auto& tag : game.tags) {
+			tags.push_back(make_pair(tag.first.str(), tag.second.str()));
+			has_result |= tag.first == "Result";
+		}
+		if(!has_result && !game.result.empty())
+			tags.push_back(make_pair("Result", game.result.str()));
+		if(!game.error.empty() || !writer.addGame(tags, game.moves))
+			++skipped;
+	}
+	writer.close();
+
+	cerr << fixed << setprecision(1) << "Wrote " << writer.getGameCount() << " games ("
+	     << skipped << " skipped) in " << secondsSince(start) << " s" << endl;
+	return 0;
+}
+
+int archiveToPGN(const string& in, const string& out) {
+	GameArchive archive(in);
+	ofstream pgn(out);
+	if(!pgn) {
+		cerr << "Could not create " << out << endl;
+		return 1;
+	}
+
+	BoardState state;
+	vector<string> san;
+	for(uint64_t i = 0; i < archive.getGameCount(); ++i) {
+		const PGNTags tags = archive.getTags(i);
+		san.clear();
+		archive.replay(i, state, [&san](const BoardState& s, uint16_t move) {
+			san.push_back(toSAN(s, s.decodeMove(move)));
+		});
+		string result = "*";
+		for(auto& tag : tags)
+			if(tag.first == "Result")
+				result = tag.second;
+		writePGN(pgn, tags, san, result);
+	}
+	cerr << "Wrote " << archive.getGameCount() << " games" << endl;
+	return 0;
+}
+
+int bench(const string& in) {
+	GameArchive archive(in);
+	BitboardBoard board;
+	uint64_t moves = 0, checksum = 0;
+	const Clock::time_point start = Clock::now();
+	for(uint64_t i = 0; i < archive.getGameCount(); ++i) {
+		moves += archive.replay(i, board, [&checksum](const BitboardBoard& b, uint16_t move) {
+			checksum ^= b.getHashKey() + move;
+		});
+	}
+	const double seconds = secondsSince(start);
+	cout << fixed << setprecision(3) << "Replayed " << archive.getGameCount() << " games, " << moves
+	     << " moves in " << seconds << " s: " << setprecision(0)
+	     << (seconds > 0 ? moves / seconds : 0) << " moves/s (checksum " << hex << checksum << ")" << endl;
+	return 0;
+}
+
+}
+
+int main(int argc, char * argv[])
+{
+	const string command = argc > 1 ? argv[1] : "";
+	try {
+		if(command == "pgn2bin" && argc == 4)
+			return pgnToArchive(argv[2], argv[3]);
+		if(command == "bin2pgn" && argc == 4)
+			return archiveToPGN(argv[2], argv[3]);
+		if(command == "bench" && argc == 3)
+			return bench(argv[2]);
+	} catch(const ChessException& e) {
+		cerr << e.what() << endl;
+		return 1;
+	}
+	usage(argv[0]);
+	return 1;
+}
@@ -0,0 +1,205 @@
+//===-- smart-chess/backends.cpp --------------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file backends.cpp
+/// \brief Perft and search benchmark of every board backend.
+///
+//===----------------------------------------------------------------------===//
+
+#include "BitboardBoard.h"
+#include "BoardState.h"
+#include "BoardTraits.h"
+#include "MailboxBoard.h"
+#include "Perft.h"
+#include "Search.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace sch;
+
+namespace {
+
+typedef chrono::steady_clock Clock;
+
+/// Published perft results, counts[d - 1] is the number of leaves at depth d.
+struct PerftCase {
+	static const int MAX_DEPTH = 5;
+
+	const char* fen;
+	int depth;            //!< Depth used by default
+	uint64_t counts[MAX_DEPTH];
+};
+
+const PerftCase PERFT_CASES[] = {
+	{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 5,
+		{ 20, 400, 8902, 197281, 4865609 } },
+	{ "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 4,
+		{ 48, 2039, 97862, 4085603, 193690690 } },
+	{ "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 5,
+		{ 14, 191, 2812, 43238, 674624 } },
+	{ "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 4,
+		{ 6, 264, 9467, 422333, 15833292 } },
+	{ "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 4,
+		{ 44, 1486, 62379, 2103487, 89941194 } },
+	{ "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 4,
+		{ 46, 2079, 89890, 3894594, 164075551 } },
+};
+
+/// Searched to a fixed depth by every backend, which must agree on the scores.
+const char* const SEARCH_FENS[] = {
+	"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+	"r1bqkb1r/pppp1ppp/2n2n2/4p2Q/2B1P3/8/PPPP1PPP/RNB1K1NR w KQkq - 4 4",
+	"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+	"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+	"6k1/5ppp/8/8/8/8/5PPP/R5K1 w - - 0 1",
+};
+
+double secondsSince(Clock::time_point start) {
+	return chrono::duration<double>(Clock::now() - start).count();
+}
+
+void printRate(const char* backend, const char* what, uint64_t nodes, double seconds) {
+	cout << left << setw(12) << backend << setw(8) << what << right << setw(12) << nodes << " nodes "
+	     << fixed << setprecision(3) << setw(8) << seconds << " s "
+	     << setprecision(2) << setw(8) << (seconds > 0 ? nodes / seconds / 1e6 : 0) << " Mnps" << endl;
+}
+
+/// Runs every PerftCase @b reduce plies shallower than its default depth.
+template<typename Board>
+bool runPerft(int reduce) {
+	typedef BoardTraits<Board> Traits;
+	bool ok = true;
+	uint64_t total = 0;
+	const Clock::time_point start = Clock::now();
+	for(auto& c : PERFT_CASES) {
+		Board board;
+		Traits::load(board, BoardState::fromFEN(c.fen));
+		const int depth = min(max(1, c.depth - reduce), int(PerftCase::MAX_DEPTH));
+		const uint64_t nodes = perft(board, depth);
+		total += nodes;
+		if(nodes != c.counts[depth - 1]) {
+			cerr << Traits::getName() << ": perft " << depth << " of " << c.fen << " is " << nodes
+			     << " instead of " << c.counts[depth - 1] << endl;
+			ok = false;
+		}
+	}
+	printRate(Traits::getName(), "perft", total, secondsSince(start));
+	return ok;
+}
+
+/**
+ * Searches every SEARCH_FENS position to @b depth with the engine's search
+ * on one thread and an empty table, appending the scores to @b scores.
+ */
+template<typename Board>
+void runSearch(int depth, vector<int>& scores) {
+	typedef BoardTraits<Board> Traits;
+	BasicSearch<Board> search;
+	SearchLimits limits;
+	limits.depth = depth;
+	uint64_t total = 0;
+	const Clock::time_point start = Clock::now();
+	for(auto fen : SEARCH_FENS) {
+		search.clear();
+		search.think(BoardState::fromFEN(fen), limits);
+		total += search.getNodes();
+		scores.push_back(search.getScore());
+	}
+	printRate(Traits::getName(), "search", total, secondsSince(start));
+}
+
+struct Backend {
+	const char* name;
+	bool (*perft)(int reduce);
+	void (*search)(int depth, vector<int>& scores);
+};
+
+template<typename Board>
+Backend makeBackend() {
+	Backend backend = { BoardTraits<Board>::getName(), runPerft<Board>, runSearch<Board> };
+	return backend;
+}
+
+}
+
+int main(int argc, char * argv[])
+{
+	const Backend BACKENDS[] = {
+		makeBackend<BoardState>(),
+		makeBackend<MailboxBoard>(),
+		makeBackend<BitboardBoard>(),
+	};
+
+	vector<string> names;
+	int reduce = 0;
+	int search_depth = 5;
+
+	for(int i = 1; i < argc; ++i) {
+		const string arg = argv[i];
+		if(arg == "-reduce" && i + 1 < argc) {
+			reduce = stoi(argv[++i]);
+		} else if(arg == "-depth" && i + 1 < argc) {
+			search_depth = stoi(argv[++i]);
+		} else if(arg[0] == '-') {
+			cerr << "Usage: " << argv[0] << " [-reduce N] [-depth N] [backend...]\n"
+			     << "  -reduce N  Perft N plies shallower than the default depths, never deeper than 5\n"
+			     << "  -depth N   Search depth, 0 skips the search (default 5)\n"
+			     << "Backends:";
+			for(auto& b : BACKENDS)
+				cerr << " " << b.name;
+			cerr << endl;
+			return arg == "-help" || arg == "-h" ? 0 : 1;
+		} else {
+			names.push_back(arg);
+		}
+	}
+
+	bool ok = true;
+	vector<int> reference;
+	const char* reference_name = nullptr;
+	for(auto& b : BACKENDS) {
+		if(!names.empty() && find(names.begin(), names.end(), b.name) == names.end())
+			continue;
+		ok &= b.perft(reduce);
+		if(search_depth <= 0)
+			continue;
+
+		vector<int> scores;
+		b.search(search_depth, scores);
+		if(!reference_name) {
+			reference = scores;
+			reference_name = b.name;
+		} else if(scores != reference) {
+			cerr << b.name << ": search scores differ from " << reference_name << endl;
+			ok = false;
+		}
+	}
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,301 @@
+//===-- smart-chess/bench.cpp -----------------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file bench.cpp
+/// \brief Microbenchmarks of the core library.
+///
+//===----------------------------------------------------------------------===//
+
+#include "Attacks.h"
+#include "BatchEvaluation.h"
+#include "BoardState.h"
+#include "MCTS.h"
+#include "PackedPosition.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace sch;
+
+namespace {
+
+typedef chrono::steady_clock Clock;
+
+/// Positions with every FEN feature: castling rights, en passant, counters.
+const char* const BENCH_FENS[] = {
+	"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+	"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+	"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+	"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+	"rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+	"rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3",
+	"4k3/8/8/8/8/8/8/4K2R b K - 37 119",
+};
+const size_t BENCH_FEN_COUNT = sizeof(BENCH_FENS) / sizeof(BENCH_FENS[0]);
+
+double secondsSince(Clock::time_point start) {
+	return chrono::duration<double>(Clock::now() - start).count();
+}
+
+/// Loads and writes back every position, checking the round trip first.
+bool benchFEN(uint64_t iterations) {
+	BoardState state;
+	char buffer[BoardState::MAX_FEN_LENGTH];
+	size_t lengths[BENCH_FEN_COUNT];
+
+	for(size_t i = 0; i < BENCH_FEN_COUNT; ++i) {
+		lengths[i] = strlen(BENCH_FENS[i]);
+		state.loadFEN(BENCH_FENS[i], lengths[i]);
+		if(state.writeFEN(buffer) != lengths[i] || memcmp(buffer, BENCH_FENS[i], lengths[i]) != 0) {
+			cerr << "fen: round trip failed\n  in:  " << BENCH_FENS[i] << "\n  out: " << buffer << endl;
+			return false;
+		}
+	}
+
+	size_t checksum = 0;
+	const Clock::time_point start = Clock::now();
+	for(uint64_t n = 0; n < iterations; ++n) {
+		const size_t i = n % BENCH_FEN_COUNT;
+		state.loadFEN(BENCH_FENS[i], lengths[i]);
+		checksum += state.writeFEN(buffer);
+	}
+	const double seconds = secondsSince(start);
+
+	cout << "fen: " << iterations << " round trips in " << fixed << setprecision(3) << seconds
+	     << " s, " << setprecision(0) << iterations / seconds << " round trips/s"
+	     << " (checksum " << checksum << ")" << endl;
+	return true;
+}
+
+/// Positions reached by random games from the start, to score in batches.
+vector<PackedPosition> makeRandomPositions(size_t count) {
+	mt19937 random(1);
+	vector<PackedPosition> positions;
+	BoardState state;
+	while(positions.size() < count) {
+		state.loadFEN(BoardState::START_FEN);
+		for(int ply = 0; ply < 200 && positions.size() < count; ++ply) {
+			const vector<Move> moves = state.getLegalMoves();
+			if(moves.empty())
+				break;
+			BoardState::UndoInfo undo;
+			state.makeMove(moves[random() % moves.size()], undo);
+			positions.push_back(PackedPosition::pack(state, 0, 0));
+		}
+	}
+	return positions;
+}
+
+/**
+ * Scores packed positions with BatchEvaluator on every instruction set the
+ * CPU has, against setting up a BoardState and calling evaluate() for each.
+ */
+bool benchBatchEval(uint64_t iterations) {
+	const vector<PackedPosition> positions = makeRandomPositions(4096);
+	const size_t count = positions.size();
+	vector<int> expected(count), scores(count);
+
+	BoardState state;
+	for(size_t i = 0; i < count; ++i) {
+		positions[i].unpack(state);
+		expected[i] = evaluate(state);
+	}
+
+	// The per-position path is far slower, give it a fraction of the work
+	const uint64_t single_iterations = max<uint64_t>(1, iterations / 64);
+	int64_t checksum = 0;
+	Clock::time_point start = Clock::now();
+	for(uint64_t n = 0; n < single_iterations; ++n) {
+		positions[n % count].unpack(state);
+		checksum += evaluate(state);
+	}
+	const double single_rate = single_iterations / secondsSince(start);
+	cout << "batch-eval: unpack + evaluate " << fixed << setprecision(0) << single_rate
+	     << " positions/s (checksum " << checksum << ")" << endl;
+
+	BatchEvaluator evaluator;
+	const uint64_t rounds = max<uint64_t>(1, iterations / count);
+	for(int level = 0; level <= static_cast<int>(getBestSimd()); ++level) {
+		evaluator.setSimd(static_cast<Simd>(level));
+		evaluator.evaluate(positions.data(), count, scores.data());
+		if(scores != expected) {
+			const size_t i = mismatch(scores.begin(), scores.end(), expected.begin()).first - scores.begin();
+			cerr << "batch-eval: " << toString(evaluator.getSimd()) << " scores position " << i
+			     << " " << scores[i] << ", evaluate() " << expected[i] << endl;
+			return false;
+		}
+
+		checksum = 0;
+		start = Clock::now();
+		for(uint64_t n = 0; n < rounds; ++n) {
+			evaluator.evaluate(positions.data(), count, scores.data());
+			checksum += scores[n % count];
+		}
+		const double rate = rounds * count / secondsSince(start);
+		cout << "batch-eval: batch " << toString(evaluator.getSimd()) << " " << setprecision(0) << rate
+		     << " positions/s, " << setprecision(1) << rate / single_rate << "x"
+		     << " (checksum " << checksum << ")" << endl;
+	}
+	return true;
+}
+
+/**
+ * Computes the squares attacked by each side with AttackGenerator on every
+ * instruction set the CPU has, against uniting the getPossibleMoves() of
+ * every piece. The set-wise results are checked against the attack maps
+ * BoardState keeps.
+ */
+bool benchAttacks(uint64_t iterations) {
+	const vector<PackedPosition> positions = makeRandomPositions(1024);
+	vector<BoardState> states(positions.size());
+	for(size_t i = 0; i < positions.size(); ++i)
+		positions[i].unpack(states[i]);
+	const ChessPlayer::Color colors[] = { ChessPlayer::Color::WHITE, ChessPlayer::Color::BLACK };
+
+	// Move lists allocate, give them a fraction of the work
+	const uint64_t piece_iterations = max<uint64_t>(1, iterations / 64);
+	uint64_t checksum = 0;
+	Clock::time_point start = Clock::now();
+	for(uint64_t n = 0; n < piece_iterations; ++n) {
+		const BoardState& state = states[n / 2 % states.size()];
+		const ChessPlayer::Color c = colors[n % 2];
+		uint64_t targets = 0;
+		for(auto& piece : c == ChessPlayer::Color::WHITE ? state.getWhitePieces() : state.getBlackPieces())
+			for(auto& pos : piece->getPossibleMoves(state))
+				targets |= uint64_t(1) << toSquareIndex(pos);
+		checksum += targets & 0xFFFF;
+	}
+	const double piece_rate = piece_iterations / secondsSince(start);
+	cout << "attacks: per piece " << fixed << setprecision(0) << piece_rate
+	     << " sides/s (checksum " << checksum << ")" << endl;
+
+	AttackGenerator generator;
+	for(int level = 0; level <= static_cast<int>(getBestSimd()); ++level) {
+		generator.setSimd(static_cast<Simd>(level));
+		for(auto& state : states) {
+			for(auto c : colors) {
+				if(generator.getAttacks(state, c) != state.getAttacks(c)) {
+					cerr << "attacks: " << toString(generator.getSimd()) << " disagrees with the attack maps in "
+					     << state.toFEN() << endl;
+					return false;
+				}
+			}
+		}
+
+		checksum = 0;
+		start = Clock::now();
+		for(uint64_t n = 0; n < iterations; ++n)
+			checksum += generator.getAttacks(states[n / 2 % states.size()], colors[n % 2]) & 0xFFFF;
+		const double rate = iterations / secondsSince(start);
+		cout << "attacks: set-wise " << toString(generator.getSimd()) << " " << setprecision(0) << rate
+		     << " sides/s, " << setprecision(1) << rate / piece_rate << "x"
+		     << " (checksum " << checksum << ")" << endl;
+	}
+	return true;
+}
+
+/**
+ * Runs the same number of MCTS iterations on the start position with 1, 2,
+ * 4... threads, up to the number of cores and at least 2, and reports how
+ * the rate scales with the threads.
+ */
+bool benchMCTS(uint64_t iterations) {
+	const int cores = static_cast<int>(thread::hardware_concurrency());
+	const BoardState root = BoardState::fromFEN(BENCH_FENS[0]);
+	SearchLimits limits;
+	limits.nodes = iterations;
+	cout << "mcts: " << max(1, cores) << " cores" << endl;
+
+	double single_rate = 0;
+	for(int threads = 1; threads <= max(2, cores); threads *= 2) {
+		MCTSConfig config;
+		config.threads = threads;
+		config.reuseTree = false;
+		MCTS mcts(config);
+		const Clock::time_point start = Clock::now();
+		if(!mcts.think(root, limits).isValid()) {
+			cerr << "mcts: no move found" << endl;
+			return false;
+		}
+		const double rate = mcts.getStats().iterations / secondsSince(start);
+		if(threads == 1)
+			single_rate = rate;
+		cout << "mcts: " << threads << " threads " << fixed << setprecision(0) << rate
+		     << " iterations/s, " << setprecision(2) << rate / single_rate << "x ("
+		     << mcts.getStats().nodes << " nodes, depth " << mcts.getStats().maxDepth << ")" << endl;
+	}
+	return true;
+}
+
+struct Benchmark {
+	const char* name;
+	bool (*run)(uint64_t iterations);
+	uint64_t defaultIterations;
+};
+
+const Benchmark BENCHMARKS[] = {
+	{ "fen", benchFEN, 2000000 },
+	{ "batch-eval", benchBatchEval, 20000000 },
+	{ "attacks", benchAttacks, 20000000 },
+	{ "mcts", benchMCTS, 500000 },
+};
+
+}
+
+int main(int argc, char * argv[])
+{
+	vector<string> names;
+	uint64_t iterations = 0;
+
+	for(int i = 1; i < argc; ++i) {
+		const string arg = argv[i];
+		if(arg == "-iterations" && i + 1 < argc) {
+			iterations = stoull(argv[++i]);
+		} else if(arg[0] == '-') {
+			cerr << "Usage: " << argv[0] << " [-iterations N] [benchmark...]\nBenchmarks:";
+			for(auto& b : BENCHMARKS)
+				cerr << " " << b.name;
+			cerr << endl;
+			return arg == "-help" || arg == "-h" ? 0 : 1;
+		} else {
+			names.push_back(arg);
+		}
+	}
+
+	bool ok = true;
+	for(auto& b : BENCHMARKS) {
+		if(!names.empty() && find(names.begin(), names.end(), b.name) == names.end())
+			continue;
+		ok &= b.run(iterations ? iterations : b.defaultIterations);
+	}
+	return ok ? 0 : 1;
+}
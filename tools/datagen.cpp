@@ -0,0 +1,219 @@
+//===-- smart-chess/datagen.cpp ---------------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file datagen.cpp
+/// \brief Self-play generator of labeled positions for evaluation tuning.
+///
+//===----------------------------------------------------------------------===//
+
+#include "BoardState.h"
+#include "Match.h"
+#include "PackedPosition.h"
+#include "Search.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <thread>
+
+using namespace std;
+using namespace sch;
+
+namespace {
+
+void usage(const char* program) {
+	cerr << "Usage: " << program << " [options]\n"
+	     << "Plays fixed node self-play games and writes their positions, labeled with\n"
+	     << "the search score and the game result, as 32 byte PackedPosition records to\n"
+	     << "the shards PREFIX-<thread>-<n>.bin.\n"
+	     << "  -out PREFIX       Prefix of the shard files (default selfplay)\n"
+	     << "  -nodes N          Nodes searched per move (default 5000)\n"
+	     << "  -games N          Games to play (default 1000)\n"
+	     << "  -positions N      Stop once N positions were written, 0 for no limit\n"
+	     << "  -threads N        Games played at the same time (default: all cores)\n"
+	     << "  -hash MB          Transposition table size of every thread (default 16)\n"
+	     << "  -random-plies N   Random moves played before the search takes over (default 8)\n"
+	     << "  -maxplies N       Adjudicate a draw after N plies (default 400)\n"
+	     << "  -shard-size N     Records per shard (default 1048576)\n"
+	     << "  -seed N           Seed of the random openings (default 1)\n";
+}
+
+/// The position after @b plies random legal moves from the initial position.
+string randomOpening(mt19937_64& random, int plies) {
+	for(;;) {
+		BoardState state;
+		int played = 0;
+		for(; played < plies; ++played) {
+			const vector<Move> moves = state.getLegalMoves();
+			if(moves.empty())
+				break;
+			BoardState::UndoInfo undo;
+			state.makeMove(moves[random() % moves.size()], undo);
+		}
+		if(played == plies && state.hasAnyLegalMove())
+			return state.toFEN();
+	}
+}
+
+/// Quiet positions only: the score of a capture or a check needs a search to make sense.
+bool isQuiet(const BoardState& state, const Move& best, int score) {
+	if(Search::isMateScore(score) || state.isInCheck() || best.promotion != PieceType::UNDEFINED)
+		return false;
+	if(state.getPieceTypeAt(toSquareIndex(best.final_pos)) != PieceType::UNDEFINED)
+		return false;
+	// En passant
+	return !(getPieceKind(best.piece->getPieceType()) == getPieceKind(PieceType::WHITE_PAWN)
+			&& best.initial_pos.column != best.final_pos.column);
+}
+
+}
+
+int main(int argc, char * argv[])
+{
+	string prefix = "selfplay";
+	EngineConfig config;
+	config.name = "datagen";
+	config.nodes = 5000;
+	uint64_t games = 1000, max_positions = 0;
+	int threads = max(1u, thread::hardware_concurrency());
+	int random_plies = 8, max_plies = 400;
+	size_t shard_size = PackedPositionWriter::DEFAULT_SHARD_SIZE;
+	uint64_t seed = 1;
+
+	try {
+		for(int i = 1; i < argc; ++i) {
+			const string arg = argv[i];
+			auto value = [&]() -> string {
+				if(i + 1 >= argc)
+					throw runtime_error(arg + " needs a value");
+				return argv[++i];
+			};
+			if(arg == "-out") prefix = value();
+			else if(arg == "-nodes") config.nodes = stoull(value());
+			else if(arg == "-games") games = stoull(value());
+			else if(arg == "-positions") max_positions = stoull(value());
+			else if(arg == "-threads") threads = max(1, stoi(value()));
+			else if(arg == "-hash") config.hashSize = stoul(value());
+			else if(arg == "-random-plies") random_plies = max(0, stoi(value()));
+			else if(arg == "-maxplies") max_plies = stoi(value());
+			else if(arg == "-shard-size") shard_size = stoul(value());
+			else if(arg == "-seed") seed = stoull(value());
+			else {
+				usage(argv[0]);
+				return arg == "-help" || arg == "-h" ? 0 : 1;
+			}
+		}
+	} catch(const exception& e) {
+		cerr << e.what() << endl;
+		usage(argv[0]);
+		return 1;
+	}
+	if(!config.nodes) {
+		cerr << "-nodes must be greater than 0" << endl;
+		return 1;
+	}
+
+	atomic<uint64_t> next_game(0), finished_games(0), positions(0);
+	atomic<bool> failed(false);
+	mutex error_mutex;
+
+	auto worker = [&](int id) {
+		try {
+			PackedPositionWriter writer(prefix + "-" + to_string(id), shard_size);
+			Search search;
+			config.configure(search);
+			vector<PackedPosition> game_positions;
+
+			for(;;) {
+				const uint64_t game = next_game++;
+				if(game >= games || failed
+						|| (max_positions && positions >= max_positions))
+					break;
+
+				// Every game has its own seed, the openings do not depend on the thread count
+				mt19937_64 random(seed * 0x9E3779B97F4A7C15ULL + game);
+				const string fen = randomOpening(random, random_plies);
+
+				game_positions.clear();
+				const GameRecord record = playGame(config, search, config, search, fen, max_plies,
+						[&](const BoardState& state, const Move& best, int score) {
+					if(isQuiet(state, best, score))
+						game_positions.push_back(PackedPosition::pack(state, score, 0));
+				});
+
+				const int8_t result = record.result == GameResult::WHITE_WINS ? 1
+						: record.result == GameResult::BLACK_WINS ? -1 : 0;
+				for(auto& p : game_positions) {
+					p.result = result;
+					writer.write(p);
+				}
+				positions += game_positions.size();
+				++finished_games;
+			}
+			writer.close();
+		} catch(const exception& e) {
+			lock_guard<mutex> lock(error_mutex);
+			cerr << e.what() << endl;
+			failed = true;
+		}
+	};
+
+	const auto start = chrono::steady_clock::now();
+	vector<thread> pool;
+	for(int i = 0; i < threads; ++i)
+		pool.emplace_back(worker, i);
+
+	auto report = [&](const char* what) {
+		const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+		const double rate = seconds > 0 ? positions / seconds : 0;
+		cerr << fixed << setprecision(1) << what << finished_games << " games, "
+		     << positions << " positions in " << seconds << " s: "
+		     << rate << " positions/s, " << rate / threads << " positions/s/core" << endl;
+	};
+
+	// Progress every ten seconds until the workers are done
+	atomic<bool> done(false);
+	thread progress([&]() {
+		auto next = chrono::steady_clock::now() + chrono::seconds(10);
+		while(!done) {
+			this_thread::sleep_for(chrono::milliseconds(100));
+			if(chrono::steady_clock::now() >= next && !done) {
+				report("");
+				next += chrono::seconds(10);
+			}
+		}
+	});
+
+	for(auto& t : pool)
+		t.join();
+	done = true;
+	progress.join();
+
+	report("Wrote ");
+	return failed ? 1 : 0;
+}
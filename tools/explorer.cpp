@@ -0,0 +1,148 @@
+//===-- smart-chess/explorer.cpp --------------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file explorer.cpp
+/// \brief Builds and queries opening explorer indexes.
+///
+//===----------------------------------------------------------------------===//
+
+#include "BoardState.h"
+#include "Notation.h"
+#include "OpeningIndex.h"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+
+using namespace std;
+using namespace sch;
+
+namespace {
+
+void usage(const char* program) {
+	cerr << "Usage:\n"
+	     << "  " << program << " build [-plies N] [-min-games N] [-threads N] -o INDEX FILE.pgn...\n"
+	     << "  " << program << " probe INDEX [FEN | startpos] [moves MOVE...]\n"
+	     << "Moves after \"moves\" are in UCI notation, e.g. e2e4." << endl;
+}
+
+int build(int argc, char * argv[]) {
+	int plies = OpeningIndexBuilder::DEFAULT_MAX_PLIES;
+	uint32_t min_games = 1;
+	int threads = 0;
+	string output;
+	vector<string> inputs;
+
+	for(int i = 2; i < argc; ++i) {
+		const string arg = argv[i];
+		if(arg == "-plies" && i + 1 < argc) plies = stoi(argv[++i]);
+		else if(arg == "-min-games" && i + 1 < argc) min_games = stoul(argv[++i]);
+		else if(arg == "-threads" && i + 1 < argc) threads = stoi(argv[++i]);
+		else if(arg == "-o" && i + 1 < argc) output = argv[++i];
+		else if(arg[0] == '-') {
+			usage(argv[0]);
+			return 1;
+		} else inputs.push_back(arg);
+	}
+	if(output.empty() || inputs.empty()) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	const auto start = chrono::steady_clock::now();
+	OpeningIndexBuilder builder(plies);
+	size_t games = 0;
+	for(auto& path : inputs) {
+		const size_t n = builder.addDatabase(path, threads);
+		cerr << path << ": " << n << " games" << endl;
+		games += n;
+	}
+	const size_t entries = builder.write(output, min_games);
+	const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	cerr << fixed << setprecision(1) << "Indexed " << games << " games in " << seconds << " s ("
+	     << (seconds > 0 ? games / seconds : 0) << " games/s), wrote " << entries << " of "
+	     << builder.getEntryCount() << " entries to " << output << endl;
+	return 0;
+}
+
+int probe(int argc, char * argv[]) {
+	if(argc < 3) {
+		usage(argv[0]);
+		return 1;
+	}
+	OpeningIndex index(argv[2]);
+
+	BoardState state;
+	int i = 3;
+	string fen;
+	for(; i < argc && string(argv[i]) != "moves"; ++i)
+		fen += (fen.empty() ? "" : " ") + string(argv[i]);
+	if(!fen.empty() && fen != "startpos")
+		state.loadFEN(fen);
+	for(++i; i < argc; ++i) {
+		const Move m = parseUCIMove(state, argv[i]);
+		if(!m.isValid()) {
+			cerr << "Illegal move " << argv[i] << endl;
+			return 1;
+		}
+		BoardState::UndoInfo undo;
+		state.makeMove(m, undo);
+	}
+
+	cout << state.toFEN() << "\n";
+	const auto moves = index.probe(state);
+	if(moves.empty()) {
+		cout << "No games" << endl;
+		return 0;
+	}
+	cout << left << setw(8) << "Move" << right << setw(10) << "Games" << setw(8) << "White"
+	     << setw(8) << "Draw" << setw(8) << "Black" << setw(8) << "Rating" << "\n";
+	for(auto& s : moves) {
+		const Move m = state.decodeMove(s.move);
+		auto percent = [&s](uint32_t n) { return s.games ? 100.0 * n / s.games : 0.0; };
+		cout << left << setw(8) << (m.isValid() ? toSAN(state, m) : "?") << right << setw(10) << s.games
+		     << fixed << setprecision(1) << setw(7) << percent(s.whiteWins) << "%" << setw(7)
+		     << percent(s.draws) << "%" << setw(7) << percent(s.blackWins) << "%" << setw(8)
+		     << s.averageRating << "\n";
+	}
+	return 0;
+}
+
+}
+
+int main(int argc, char * argv[])
+{
+	const string command = argc > 1 ? argv[1] : "";
+	try {
+		if(command == "build")
+			return build(argc, argv);
+		if(command == "probe")
+			return probe(argc, argv);
+	} catch(const ChessException& e) {
+		cerr << e.what() << endl;
+		return 1;
+	}
+	usage(argv[0]);
+	return 1;
+}
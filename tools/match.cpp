@@ -0,0 +1,361 @@
+//===-- smart-chess/match.cpp -----------------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file match.cpp
+/// \brief Plays self-play matches between two engine configurations.
+///
+//===----------------------------------------------------------------------===//
+
+#include "BoardState.h"
+#include "Match.h"
+#include "Search.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <thread>
+
+using namespace std;
+using namespace sch;
+
+namespace {
+
+void usage(const char* program) {
+	cerr << "Usage: " << program << " [options]\n"
+	     << "  -engine key=value ...  Adds an engine, give it twice. Keys: name, hash, threads,\n"
+	     << "                         depth, nodes, movetime, tc (seconds[+increment])\n"
+	     << "  -each key=value ...    Applies the keys to both engines, -engine keys win\n"
+	     << "  -games N               Games to play, rounded up to pairs (default 100)\n"
+	     << "  -concurrency N         Games played at the same time (default: all cores)\n"
+	     << "  -openings FILE         EPD file with the starting positions\n"
+	     << "  -seed N                Seed used to shuffle the openings (default 1)\n"
+	     << "  -maxplies N            Adjudicate a draw after N plies (default 400)\n"
+	     << "  -sprt key=value ...    Stop early on a decision. Keys: elo0, elo1, alpha, beta\n"
+	     << "  -pgnout FILE           Writes every game to FILE\n"
+	     << "  -jsonout FILE          Writes the final statistics to FILE\n";
+}
+
+/// Applies "key=value" to @b config, returns false on an unknown key.
+bool setEngineOption(EngineConfig& config, const string& key, const string& value) {
+	if(key == "name") {
+		config.name = value;
+	} else if(key == "hash") {
+		config.hashSize = stoul(value);
+	} else if(key == "threads") {
+		config.threads = stoi(value);
+	} else if(key == "depth") {
+		config.depth = stoi(value);
+	} else if(key == "nodes") {
+		config.nodes = stoull(value);
+	} else if(key == "movetime") {
+		config.moveTime = stoi(value);
+	} else if(key == "tc") {
+		const size_t plus = value.find('+');
+		config.baseTime = static_cast<int>(stod(value.substr(0, plus)) * 1000);
+		config.increment = plus == string::npos ? 0 : static_cast<int>(stod(value.substr(plus + 1)) * 1000);
+	} else {
+		return false;
+	}
+	return true;
+}
+
+bool setSPRTOption(SPRT& sprt, const string& key, const string& value) {
+	if(key == "elo0") sprt.elo0 = stod(value);
+	else if(key == "elo1") sprt.elo1 = stod(value);
+	else if(key == "alpha") sprt.alpha = stod(value);
+	else if(key == "beta") sprt.beta = stod(value);
+	else return false;
+	return true;
+}
+
+/**
+ * Reads the positions of an EPD file. Only the four FEN fields are used,
+ * the operations after them are ignored.
+ */
+vector<string> readOpenings(const string& path) {
+	ifstream in(path);
+	if(!in)
+		throw runtime_error("Could not open " + path);
+
+	vector<string> openings;
+	string line;
+	int number = 0;
+	while(getline(in, line)) {
+		++number;
+		istringstream is(line);
+		string fields[4];
+		if(!(is >> fields[0] >> fields[1] >> fields[2] >> fields[3]))
+			continue;
+		const string fen = fields[0] + " " + fields[1] + " " + fields[2] + " " + fields[3] + " 0 1";
+		try {
+			BoardState state;
+			state.loadFEN(fen);
+			openings.push_back(fen);
+		} catch(const FENException& e) {
+			cerr << path << ":" << number << ": " << e.what() << endl;
+		}
+	}
+	return openings;
+}
+
+string escapeJSON(const string& text) {
+	string out;
+	for(char c : text) {
+		if(c == '"' || c == '\\')
+			out += '\\';
+		out += c;
+	}
+	return out;
+}
+
+}
+
+int main(int argc, char * argv[])
+{
+	vector<vector<pair<string, string>>> engine_options;
+	vector<pair<string, string>> each_options;
+	SPRT sprt;
+	bool use_sprt = false;
+	int games = 100;
+	int concurrency = max(1u, thread::hardware_concurrency());
+	int max_plies = 400;
+	unsigned seed = 1;
+	string openings_path, pgn_path, json_path;
+
+	try {
+		for(int i = 1; i < argc; ++i) {
+			const string arg = argv[i];
+			// Collects the key=value words that follow an option
+			auto pairs = [&]() {
+				vector<pair<string, string>> result;
+				while(i + 1 < argc && string(argv[i + 1]).find('=') != string::npos) {
+					const string kv = argv[++i];
+					const size_t eq = kv.find('=');
+					result.push_back(make_pair(kv.substr(0, eq), kv.substr(eq + 1)));
+				}
+				return result;
+			};
+			auto value = [&]() -> string {
+				if(i + 1 >= argc)
+					throw runtime_error(arg + " needs a value");
+				return argv[++i];
+			};
+
+			// Checks the engine options as they come, they are applied once all are read
+			auto engineOptions = [&](vector<pair<string, string>>& options) {
+				EngineConfig config;
+				for(auto& kv : pairs()) {
+					if(!setEngineOption(config, kv.first, kv.second))
+						throw runtime_error("Unknown engine option " + kv.first);
+					options.push_back(kv);
+				}
+			};
+
+			if(arg == "-engine") {
+				engine_options.push_back(vector<pair<string, string>>());
+				engineOptions(engine_options.back());
+			} else if(arg == "-each") {
+				engineOptions(each_options);
+			} else if(arg == "-sprt") {
+				use_sprt = true;
+				for(auto& kv : pairs())
+					if(!setSPRTOption(sprt, kv.first, kv.second))
+						throw runtime_error("Unknown SPRT option " + kv.first);
+			} else if(arg == "-games") {
+				games = stoi(value());
+			} else if(arg == "-concurrency") {
+				concurrency = max(1, stoi(value()));
+			} else if(arg == "-openings") {
+				openings_path = value();
+			} else if(arg == "-seed") {
+				seed = static_cast<unsigned>(stoul(value()));
+			} else if(arg == "-maxplies") {
+				max_plies = stoi(value());
+			} else if(arg == "-pgnout") {
+				pgn_path = value();
+			} else if(arg == "-jsonout") {
+				json_path = value();
+			} else {
+				usage(argv[0]);
+				return arg == "-help" || arg == "-h" ? 0 : 1;
+			}
+		}
+	} catch(const exception& e) {
+		cerr << e.what() << endl;
+		usage(argv[0]);
+		return 1;
+	}
+
+	if(engine_options.size() != 2) {
+		usage(argv[0]);
+		return 1;
+	}
+	// As in cutechess-cli, the options of an engine win over those of -each
+	vector<EngineConfig> engines(2);
+	for(size_t e = 0; e < engines.size(); ++e) {
+		for(auto& kv : each_options)
+			setEngineOption(engines[e], kv.first, kv.second);
+		for(auto& kv : engine_options[e])
+			setEngineOption(engines[e], kv.first, kv.second);
+	}
+	if(engines[0].name == engines[1].name) {
+		engines[0].name += "-1";
+		engines[1].name += "-2";
+	}
+	for(auto& config : engines) {
+		if(!config.depth && !config.nodes && !config.moveTime && !config.baseTime) {
+			cerr << config.name << " has no depth, nodes, movetime or tc limit" << endl;
+			return 1;
+		}
+	}
+
+	vector<string> openings;
+	try {
+		if(!openings_path.empty())
+			openings = readOpenings(openings_path);
+	} catch(const exception& e) {
+		cerr << e.what() << endl;
+		return 1;
+	}
+	if(openings.empty())
+		openings.push_back("");
+	shuffle(openings.begin(), openings.end(), mt19937(seed));
+
+	// Both engines play every opening once with each color
+	games += games % 2;
+
+	ofstream pgn;
+	if(!pgn_path.empty()) {
+		pgn.open(pgn_path);
+		if(!pgn) {
+			cerr << "Could not create " << pgn_path << endl;
+			return 1;
+		}
+	}
+
+	MatchStatistics stats;
+	SPRT::Status status = SPRT::Status::CONTINUE;
+	atomic<int> next_game(0);
+	atomic<bool> stop(false);
+	mutex result_mutex;
+	const string event = engines[0].name + " vs " + engines[1].name;
+	const auto start = chrono::steady_clock::now();
+
+	auto worker = [&]() {
+		// Every game thread owns a pair of searches for the whole match
+		Search searches[2];
+		engines[0].configure(searches[0]);
+		engines[1].configure(searches[1]);
+
+		int index;
+		while(!stop && (index = next_game++) < games) {
+			const string& fen = openings[(index / 2) % openings.size()];
+			const int first = index % 2;
+			const GameRecord game = playGame(engines[first], searches[first],
+					engines[1 - first], searches[1 - first], fen, max_plies);
+
+			double score = 0.5;
+			if(game.result == GameResult::WHITE_WINS)
+				score = first == 0 ? 1 : 0;
+			else if(game.result == GameResult::BLACK_WINS)
+				score = first == 0 ? 0 : 1;
+
+			lock_guard<mutex> lock(result_mutex);
+			if(stop)
+				return;
+			stats.add(score);
+			if(pgn.is_open())
+				writePGN(pgn, game, event, index + 1);
+
+			cerr << "Game " << index + 1 << " (" << game.white << " vs " << game.black << "): "
+			     << toString(game.result) << " {" << game.reason << "}\n"
+			     << "Score of " << event << ": " << stats.getWins() << " - " << stats.getLosses()
+			     << " - " << stats.getDraws() << " [" << fixed << setprecision(3) << stats.getScore()
+			     << "] " << stats.getGames() << "\n"
+			     << "Elo difference: " << setprecision(1) << stats.getElo() << " +/- "
+			     << stats.getEloError() << ", LOS: " << stats.getLOS() * 100 << " %";
+			if(use_sprt) {
+				cerr << ", LLR: " << setprecision(2) << stats.getLLR(sprt.elo0, sprt.elo1)
+				     << " (" << sprt.getLowerBound() << ", " << sprt.getUpperBound() << ")";
+				status = sprt.check(stats);
+				if(status != SPRT::Status::CONTINUE) {
+					cerr << "\nSPRT: " << toString(status) << " accepted";
+					stop = true;
+				}
+			}
+			cerr << endl;
+		}
+	};
+
+	vector<thread> threads;
+	for(int i = 0; i < min(concurrency, games); ++i)
+		threads.emplace_back(worker);
+	for(auto& t : threads)
+		t.join();
+
+	const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	cerr << "Finished " << stats.getGames() << " games in " << setprecision(1) << seconds << " s" << endl;
+
+	if(!json_path.empty()) {
+		ofstream json(json_path);
+		if(!json) {
+			cerr << "Could not create " << json_path << endl;
+			return 1;
+		}
+		json << fixed << setprecision(2)
+		     << "{\n"
+		     << "  \"engines\": [\"" << escapeJSON(engines[0].name) << "\", \"" << escapeJSON(engines[1].name) << "\"],\n"
+		     << "  \"games\": " << stats.getGames() << ",\n"
+		     << "  \"wins\": " << stats.getWins() << ",\n"
+		     << "  \"losses\": " << stats.getLosses() << ",\n"
+		     << "  \"draws\": " << stats.getDraws() << ",\n"
+		     << "  \"score\": " << stats.getScore() << ",\n"
+		     << "  \"elo\": " << stats.getElo() << ",\n"
+		     << "  \"elo_error\": " << stats.getEloError() << ",\n"
+		     << "  \"los\": " << stats.getLOS() << ",\n";
+		if(use_sprt) {
+			json << "  \"sprt\": {\n"
+			     << "    \"elo0\": " << sprt.elo0 << ",\n"
+			     << "    \"elo1\": " << sprt.elo1 << ",\n"
+			     << "    \"alpha\": " << sprt.alpha << ",\n"
+			     << "    \"beta\": " << sprt.beta << ",\n"
+			     << "    \"llr\": " << stats.getLLR(sprt.elo0, sprt.elo1) << ",\n"
+			     << "    \"lower_bound\": " << sprt.getLowerBound() << ",\n"
+			     << "    \"upper_bound\": " << sprt.getUpperBound() << ",\n"
+			     << "    \"result\": \"" << toString(status) << "\"\n"
+			     << "  },\n";
+		}
+		json << "  \"seconds\": " << seconds << ",\n"
+		     << "  \"games_per_second\": " << (seconds > 0 ? stats.getGames() / seconds : 0) << "\n"
+		     << "}\n";
+	}
+	return 0;
+}
@@ -0,0 +1,272 @@
+//===-- smart-chess/nnue.cpp ------------------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file nnue.cpp
+/// \brief Creates, checks and benchmarks NNUE network files.
+///
+//===----------------------------------------------------------------------===//
+
+#include "BoardState.h"
+#include "NNUE.h"
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace sch;
+
+namespace {
+
+typedef chrono::steady_clock Clock;
+
+void usage(const char* program) {
+	cerr << "Usage: " << program << " <command> ...\n"
+	     << "  random FILE [-seed N]   Writes a network with random weights, to test the\n"
+	     << "                          engine until a trained one is available\n"
+	     << "  eval FILE [FEN]         Evaluates a position with every instruction set\n"
+	     << "  bench FILE [-games N]   Checks the incremental updates against full\n"
+	     << "                          refreshes on random games and times both\n";
+}
+
+/// Writes @b size bytes and pads them to the 64 byte sections of the file.
+void writeSection(ostream& os, const void* data, size_t size) {
+	static const char PADDING[64] = {};
+	os.write(static_cast<const char*>(data), static_cast<streamsize>(size));
+	if(size % 64)
+		os.write(PADDING, static_cast<streamsize>(64 - size % 64));
+}
+
+template<class T>
+vector<T> randomValues(mt19937_64& random, size_t count, int low, int high) {
+	uniform_int_distribution<int> distribution(low, high);
+	vector<T> values(count);
+	for(auto& v : values)
+		v = static_cast<T>(distribution(random));
+	return values;
+}
+
+int writeRandom(const string& path, uint64_t seed) {
+	const int SIZE = NNUEAccumulator::SIZE;
+	const int INPUTS = NNUENetwork::INPUTS;
+	const int HIDDEN1 = NNUENetwork::HIDDEN1;
+	const int HIDDEN2 = NNUENetwork::HIDDEN2;
+	mt19937_64 random(seed);
+
+	NNUENetwork::Header header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, "SCHNNUE", 8);
+	header.version = NNUENetwork::VERSION;
+	header.inputs = INPUTS;
+	header.accumulatorSize = SIZE;
+	header.hidden1 = HIDDEN1;
+	header.hidden2 = HIDDEN2;
+
+	ofstream os(path, ios::binary);
+	if(!os) {
+		cerr << "Could not create " << path << endl;
+		return 1;
+	}
+	os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	auto feature_biases = randomValues<int16_t>(random, SIZE, 0, 64);
+	auto feature_weights = randomValues<int16_t>(random, size_t(INPUTS) * SIZE, -16, 16);
+	auto biases1 = randomValues<int32_t>(random, HIDDEN1, -1024, 1024);
+	auto weights1 = randomValues<int8_t>(random, HIDDEN1 * 2 * SIZE, -20, 20);
+	auto biases2 = randomValues<int32_t>(random, HIDDEN2, -1024, 1024);
+	auto weights2 = randomValues<int8_t>(random, HIDDEN2 * HIDDEN1, -64, 64);
+	auto output_bias = randomValues<int32_t>(random, 1, -256, 256);
+	auto output_weights = randomValues<int8_t>(random, HIDDEN2, -64, 64);
+
+	writeSection(os, feature_biases.data(), feature_biases.size() * sizeof(int16_t));
+	writeSection(os, feature_weights.data(), feature_weights.size() * sizeof(int16_t));
+	writeSection(os, biases1.data(), biases1.size() * sizeof(int32_t));
+	writeSection(os, weights1.data(), weights1.size());
+	writeSection(os, biases2.data(), biases2.size() * sizeof(int32_t));
+	writeSection(os, weights2.data(), weights2.size());
+	writeSection(os, output_bias.data(), sizeof(int32_t));
+	writeSection(os, output_weights.data(), output_weights.size());
+	os.close();
+	if(!os) {
+		cerr << "Could not write " << path << endl;
+		return 1;
+	}
+	cout << "Wrote " << path << ", " << NNUENetwork::getFileSize() << " bytes" << endl;
+	return 0;
+}
+
+/// Every instruction set this CPU can run.
+vector<Simd> getSupportedSimd() {
+	vector<Simd> levels;
+	for(int i = 0; i <= static_cast<int>(getBestSimd()); ++i)
+		levels.push_back(static_cast<Simd>(i));
+	return levels;
+}
+
+int evaluatePosition(NNUENetwork& network, const string& fen) {
+	BoardState state;
+	if(!fen.empty())
+		state.loadFEN(fen);
+	for(auto simd : getSupportedSimd()) {
+		network.setSimd(simd);
+		cout << setw(8) << toString(simd) << ": " << network.evaluate(state) << " cp" << endl;
+	}
+	return 0;
+}
+
+/**
+ * Plays random games, keeping an accumulator per ply up to date the way
+ * the search does, and compares every one of them with a full refresh.
+ */
+int bench(NNUENetwork& network, int games) {
+	mt19937_64 random(1);
+	vector<BoardState> positions;
+	vector<vector<NNUEDelta>> deltas;
+	for(int g = 0; g < games; ++g) {
+		BoardState state;
+		deltas.push_back(vector<NNUEDelta>());
+		for(int ply = 0; ; ++ply) {
+			positions.push_back(state);
+			const vector<Move> moves = state.getLegalMoves();
+			if(moves.empty() || ply == 200)
+				break;
+			const Move& m = moves[random() % moves.size()];
+			deltas.back().push_back(NNUEDelta::fromMove(state, m));
+			BoardState::UndoInfo undo;
+			state.makeMove(m, undo);
+		}
+	}
+
+	bool ok = true;
+	for(auto simd : getSupportedSimd()) {
+		network.setSimd(simd);
+
+		// Incremental updates, checked against refreshes
+		size_t index = 0, mismatches = 0;
+		NNUEAccumulator acc, fresh;
+		for(auto& game : deltas) {
+			network.refresh(positions[index], acc);
+			for(size_t ply = 0; ply <= game.size(); ++ply, ++index) {
+				const BoardState& state = positions[index];
+				if(ply > 0) {
+					for(int side = 0; side < 2; ++side) {
+						if(game[ply - 1].movesKing(side))
+							network.refresh(state, side, acc);
+						else
+							network.update(game[ply - 1], state, side, acc);
+					}
+				}
+				network.refresh(state, fresh);
+				if(memcmp(acc.values, fresh.values, sizeof(acc.values)) != 0)
+					++mismatches;
+			}
+		}
+		if(mismatches) {
+			cerr << toString(simd) << ": " << mismatches << " accumulators differ from a refresh" << endl;
+			ok = false;
+		}
+
+		// The same evaluations, timed with and without the incremental updates
+		Clock::time_point start = Clock::now();
+		uint64_t checksum = 0;
+		index = 0;
+		for(auto& game : deltas) {
+			network.refresh(positions[index], acc);
+			for(size_t ply = 0; ply <= game.size(); ++ply, ++index) {
+				if(ply > 0) {
+					for(int side = 0; side < 2; ++side) {
+						if(game[ply - 1].movesKing(side))
+							network.refresh(positions[index], side, acc);
+						else
+							network.update(game[ply - 1], positions[index], side, acc);
+					}
+				}
+				checksum += network.evaluate(acc, positions[index].getCurrentPlayer());
+			}
+		}
+		const double incremental = chrono::duration<double>(Clock::now() - start).count();
+
+		start = Clock::now();
+		for(auto& state : positions)
+			checksum -= network.evaluate(state);
+		const double refresh = chrono::duration<double>(Clock::now() - start).count();
+
+		cout << setw(8) << toString(simd) << ": " << fixed << setprecision(0)
+		     << positions.size() / incremental << " evals/s incremental, "
+		     << positions.size() / refresh << " evals/s with refresh"
+		     << (checksum ? " (evaluations differ!)" : "") << endl;
+		ok = ok && checksum == 0;
+	}
+	return ok ? 0 : 1;
+}
+
+}
+
+int main(int argc, char * argv[])
+{
+	if(argc < 3) {
+		usage(argv[0]);
+		return 1;
+	}
+	const string command = argv[1];
+	const string path = argv[2];
+	uint64_t seed = 1;
+	int games = 100;
+	string fen;
+
+	for(int i = 3; i < argc; ++i) {
+		const string arg = argv[i];
+		if(arg == "-seed" && i + 1 < argc)
+			seed = stoull(argv[++i]);
+		else if(arg == "-games" && i + 1 < argc)
+			games = max(1, stoi(argv[++i]));
+		else if(command == "eval" && arg[0] != '-')
+			fen += (fen.empty() ? "" : " ") + arg;
+		else {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if(command == "random")
+		return writeRandom(path, seed);
+	if(command != "eval" && command != "bench") {
+		usage(argv[0]);
+		return 1;
+	}
+
+	try {
+		NNUENetwork network(path);
+		cout << "Best instruction set: " << toString(getBestSimd()) << endl;
+		return command == "eval" ? evaluatePosition(network, fen) : bench(network, games);
+	} catch(const ChessException& e) {
+		cerr << e.what() << endl;
+		return 1;
+	}
+}
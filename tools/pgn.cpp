@@ -0,0 +1,91 @@
+//===-- smart-chess/pgn.cpp -------------------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file pgn.cpp
+/// \brief Reads a PGN database and reports how fast it was parsed.
+///
+//===----------------------------------------------------------------------===//
+
+#include "PGNReader.h"
+#include "Util.h"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+
+using namespace std;
+using namespace sch;
+
+int main(int argc, char * argv[])
+{
+	int threads = 0;
+	bool verbose = false;
+	string path;
+
+	for(int i = 1; i < argc; ++i) {
+		const string arg = argv[i];
+		if(arg == "-threads" && i + 1 < argc) {
+			threads = stoi(argv[++i]);
+		} else if(arg == "-v") {
+			verbose = true;
+		} else if(arg[0] != '-' && path.empty()) {
+			path = arg;
+		} else {
+			cerr << "Usage: " << argv[0] << " [-threads N] [-v] FILE.pgn\n"
+			     << "Parses and replays every game of FILE.pgn, -v lists the games with errors." << endl;
+			return 1;
+		}
+	}
+	if(path.empty()) {
+		cerr << "Usage: " << argv[0] << " [-threads N] [-v] FILE.pgn" << endl;
+		return 1;
+	}
+
+	try {
+		PGNReader reader(path);
+		mutex output_mutex;
+		const auto start = chrono::steady_clock::now();
+
+		const size_t games = reader.forEachGame([&](const PGNGame& game, int) {
+			if(verbose && !game.error.empty()) {
+				lock_guard<mutex> lock(output_mutex);
+				cerr << path << " @" << game.offset << " (" << game.getTag("White").str() << " - "
+				     << game.getTag("Black").str() << "): " << game.error << endl;
+			}
+		}, threads);
+
+		const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+		cout << fixed << setprecision(1)
+		     << "Games:   " << games << " (" << reader.getErrorCount() << " with errors)\n"
+		     << "Moves:   " << reader.getMoveCount() << "\n"
+		     << "Time:    " << setprecision(3) << seconds << " s\n" << setprecision(1)
+		     << "Speed:   " << (seconds > 0 ? games / seconds : 0) << " games/s, "
+		     << (seconds > 0 ? reader.getFileSize() / seconds / (1024 * 1024) : 0) << " MB/s" << endl;
+	} catch(const ChessException& e) {
+		cerr << e.what() << endl;
+		return 1;
+	}
+	return 0;
+}
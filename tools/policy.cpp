@@ -0,0 +1,269 @@
+//===-- smart-chess/policy.cpp ----------------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file policy.cpp
+/// \brief Creates, checks and benchmarks policy network files.
+///
+//===----------------------------------------------------------------------===//
+
+#include "BoardState.h"
+#include "Notation.h"
+#include "PolicyNetwork.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace sch;
+
+namespace {
+
+typedef chrono::steady_clock Clock;
+
+void usage(const char* program) {
+	cerr << "Usage: " << program << " <command> ...\n"
+	     << "  random FILE [-seed N]         Writes a network with random weights, to test the\n"
+	     << "                                engine until a trained one is available\n"
+	     << "  eval FILE [FEN]               Prints the priors of the moves of a position with\n"
+	     << "                                every instruction set\n"
+	     << "  bench FILE [-positions N]     Checks batched against single evaluations and\n"
+	     << "                                reports positions/s for batches of 1 to 256\n";
+}
+
+/// Writes @b size bytes and pads them to the 64 byte sections of the file.
+void writeSection(ostream& os, const void* data, size_t size) {
+	static const char PADDING[64] = {};
+	os.write(static_cast<const char*>(data), static_cast<streamsize>(size));
+	if(size % 64)
+		os.write(PADDING, static_cast<streamsize>(64 - size % 64));
+}
+
+template<class T>
+vector<T> randomValues(mt19937_64& random, size_t count, int low, int high) {
+	uniform_int_distribution<int> distribution(low, high);
+	vector<T> values(count);
+	for(auto& v : values)
+		v = static_cast<T>(distribution(random));
+	return values;
+}
+
+int writeRandom(const string& path, uint64_t seed) {
+	const int INPUTS = PolicyNetwork::INPUTS;
+	const int HIDDEN1 = PolicyNetwork::HIDDEN1;
+	const int HIDDEN2 = PolicyNetwork::HIDDEN2;
+	const int OUTPUTS = PolicyNetwork::OUTPUTS;
+	mt19937_64 random(seed);
+
+	PolicyNetwork::Header header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, "SCHPOLI", 8);
+	header.version = PolicyNetwork::VERSION;
+	header.inputs = INPUTS;
+	header.hidden1 = HIDDEN1;
+	header.hidden2 = HIDDEN2;
+	header.outputs = OUTPUTS;
+
+	ofstream os(path, ios::binary);
+	if(!os) {
+		cerr << "Could not create " << path << endl;
+		return 1;
+	}
+	os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	auto feature_biases = randomValues<int16_t>(random, HIDDEN1, 0, 64);
+	auto feature_weights = randomValues<int16_t>(random, size_t(INPUTS) * HIDDEN1, -16, 16);
+	auto biases1 = randomValues<int32_t>(random, HIDDEN2, -1024, 1024);
+	auto weights1 = randomValues<int8_t>(random, HIDDEN2 * HIDDEN1, -20, 20);
+	auto head_biases = randomValues<int32_t>(random, OUTPUTS, -1024, 1024);
+	auto head_weights = randomValues<int8_t>(random, size_t(OUTPUTS) * HIDDEN2, -8, 8);
+
+	writeSection(os, feature_biases.data(), feature_biases.size() * sizeof(int16_t));
+	writeSection(os, feature_weights.data(), feature_weights.size() * sizeof(int16_t));
+	writeSection(os, biases1.data(), biases1.size() * sizeof(int32_t));
+	writeSection(os, weights1.data(), weights1.size());
+	writeSection(os, head_biases.data(), head_biases.size() * sizeof(int32_t));
+	writeSection(os, head_weights.data(), head_weights.size());
+	os.close();
+	if(!os) {
+		cerr << "Could not write " << path << endl;
+		return 1;
+	}
+	cout << "Wrote " << path << ", " << PolicyNetwork::getFileSize() << " bytes" << endl;
+	return 0;
+}
+
+/// Every instruction set this CPU can run.
+vector<Simd> getSupportedSimd() {
+	vector<Simd> levels;
+	for(int i = 0; i <= static_cast<int>(getBestSimd()); ++i)
+		levels.push_back(static_cast<Simd>(i));
+	return levels;
+}
+
+int evaluatePosition(PolicyNetwork& network, const string& fen) {
+	BoardState state;
+	if(!fen.empty())
+		state.loadFEN(fen);
+	uint16_t codes[BoardState::MAX_MOVES];
+	const size_t count = state.getLegalMoveCodes(codes);
+	float priors[BoardState::MAX_MOVES];
+
+	for(auto simd : getSupportedSimd()) {
+		network.setSimd(simd);
+		network.evaluate(state, codes, count, priors);
+
+		vector<size_t> order(count);
+		for(size_t i = 0; i < count; ++i)
+			order[i] = i;
+		sort(order.begin(), order.end(), [&priors](size_t a, size_t b) { return priors[a] > priors[b]; });
+		cout << setw(8) << toString(simd) << ":";
+		for(size_t i = 0; i < min<size_t>(order.size(), 5); ++i)
+			cout << " " << toSAN(state, state.decodeMove(codes[order[i]])) << " "
+			     << fixed << setprecision(3) << priors[order[i]];
+		cout << endl;
+	}
+	return 0;
+}
+
+/// The positions of random games, ready for the network.
+struct BenchPosition {
+	PolicyNetwork::Input input;
+	vector<float> priors;
+};
+
+int bench(PolicyNetwork& network, int count) {
+	mt19937_64 random(1);
+	vector<BenchPosition> positions(count);
+	BoardState state;
+	uint16_t codes[BoardState::MAX_MOVES];
+	for(auto& p : positions) {
+		size_t moves = state.getLegalMoveCodes(codes);
+		if(moves == 0 || state.getHalfmoveClock() >= 100) {
+			state.loadFEN(BoardState::START_FEN);
+			moves = state.getLegalMoveCodes(codes);
+		}
+		PolicyNetwork::encode(state, codes, moves, p.input);
+		p.priors.resize(moves);
+		BoardState::UndoInfo undo;
+		state.makeMove(state.decodeMove(codes[random() % moves]), undo);
+	}
+
+	vector<const PolicyNetwork::Input*> inputs(positions.size());
+	vector<float*> priors(positions.size());
+	for(size_t i = 0; i < positions.size(); ++i) {
+		inputs[i] = &positions[i].input;
+		priors[i] = positions[i].priors.data();
+	}
+
+	// One position at a time with plain C++ is the reference
+	network.setSimd(Simd::SCALAR);
+	vector<vector<float>> expected(positions.size());
+	for(size_t i = 0; i < positions.size(); ++i) {
+		network.evaluate(&inputs[i], &priors[i], 1);
+		expected[i] = positions[i].priors;
+	}
+
+	bool ok = true;
+	cout << "Positions per second by batch size" << endl << "   batch";
+	for(auto simd : getSupportedSimd())
+		cout << setw(10) << toString(simd);
+	cout << endl;
+
+	for(int batch = 1; batch <= PolicyNetwork::MAX_BATCH; batch *= 2) {
+		cout << setw(8) << batch;
+		for(auto simd : getSupportedSimd()) {
+			network.setSimd(simd);
+			const Clock::time_point start = Clock::now();
+			for(size_t first = 0; first < positions.size(); first += batch) {
+				const size_t n = min<size_t>(batch, positions.size() - first);
+				network.evaluate(&inputs[first], &priors[first], n);
+			}
+			const double seconds = chrono::duration<double>(Clock::now() - start).count();
+			cout << setw(10) << fixed << setprecision(0) << positions.size() / seconds;
+
+			for(size_t i = 0; i < positions.size(); ++i) {
+				if(positions[i].priors != expected[i]) {
+					cerr << endl << toString(simd) << ", batches of " << batch
+					     << ": the priors of position " << i << " differ" << endl;
+					ok = false;
+					break;
+				}
+			}
+		}
+		cout << endl;
+	}
+	return ok ? 0 : 1;
+}
+
+}
+
+int main(int argc, char * argv[])
+{
+	if(argc < 3) {
+		usage(argv[0]);
+		return 1;
+	}
+	const string command = argv[1];
+	const string path = argv[2];
+	uint64_t seed = 1;
+	int positions = 20000;
+	string fen;
+
+	for(int i = 3; i < argc; ++i) {
+		const string arg = argv[i];
+		if(arg == "-seed" && i + 1 < argc)
+			seed = stoull(argv[++i]);
+		else if(arg == "-positions" && i + 1 < argc)
+			positions = max(1, stoi(argv[++i]));
+		else if(command == "eval" && arg[0] != '-')
+			fen += (fen.empty() ? "" : " ") + arg;
+		else {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if(command == "random")
+		return writeRandom(path, seed);
+	if(command != "eval" && command != "bench") {
+		usage(argv[0]);
+		return 1;
+	}
+
+	try {
+		PolicyNetwork network(path);
+		cout << "Best instruction set: " << toString(getBestSimd()) << endl;
+		return command == "eval" ? evaluatePosition(network, fen) : bench(network, positions);
+	} catch(const ChessException& e) {
+		cerr << e.what() << endl;
+		return 1;
+	}
+}
@@ -0,0 +1,580 @@
+//===-- smart-chess/tune.cpp ------------------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file tune.cpp
+/// \brief Texel style tuner of the evaluation weights.
+///
+//===----------------------------------------------------------------------===//
+
+#include "EvalWeights.h"
+#include "MappedFile.h"
+#include "PackedPosition.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace sch;
+
+namespace {
+
+typedef chrono::steady_clock Clock;
+
+/**
+ * One feature per piece kind and square. The tuner works on the sum of the
+ * piece value and the piece-square value, which makes the middle game and
+ * endgame scores plain sums of weights, and splits it back when writing
+ * the header.
+ */
+const int FEATURE_COUNT = PIECE_KINDS * SQUARE_COUNT;
+
+/// The middle game weights of every feature followed by the endgame ones.
+const int PARAMETER_COUNT = 2 * FEATURE_COUNT;
+
+/// Set in a feature for the pieces of black, which subtract their weight.
+const uint16_t BLACK_FEATURE = 0x8000;
+
+void usage(const char* program) {
+	cerr << "Usage: " << program << " [options] FILE...\n"
+	     << "Fits the weights of EvalWeights.h to the PackedPosition records of FILE,\n"
+	     << "e.g. the shards written by smartchess-datagen, and writes a new header.\n"
+	     << "  -o FILE        Header to write (default EvalWeights.h)\n"
+	     << "  -epochs N      Passes over the data (default 10)\n"
+	     << "  -batch N       Positions per gradient step (default 16384)\n"
+	     << "  -rate R        Learning rate, in centipawns (default 1)\n"
+	     << "  -k K           Scale of the sigmoid, fitted to the data by default\n"
+	     << "  -lambda L      Weight of the search score in the target, the rest is\n"
+	     << "                 the game result (default 0)\n"
+	     << "  -threads N     Threads to use (default: all cores)\n"
+	     << "  -seed N        Seed used to shuffle the positions (default 1)\n";
+}
+
+/**
+ * Runs the same job on a fixed set of threads and waits for all of them,
+ * much cheaper than starting threads for every mini-batch.
+ */
+class ThreadPool {
+public:
+	typedef function<void(int thread, int threads)> Job;
+
+	explicit ThreadPool(int threads) : mRound(0), mRunning(0), mStop(false) {
+		for(int i = 1; i < threads; ++i)
+			mThreads.emplace_back(&ThreadPool::loop, this, i);
+	}
+
+	~ThreadPool() {
+		{
+			lock_guard<mutex> lock(mMutex);
+			mStop = true;
+		}
+		mWakeUp.notify_all();
+		for(auto& t : mThreads)
+			t.join();
+	}
+
+	int getThreadCount() const { return static_cast<int>(mThreads.size()) + 1; }
+
+	/// Calls @b job on every thread, the calling one included, and waits for them.
+	void run(const Job& job) {
+		{
+			lock_guard<mutex> lock(mMutex);
+			mJob = &job;
+			mRunning = static_cast<int>(mThreads.size());
+			++mRound;
+		}
+		mWakeUp.notify_all();
+		job(0, getThreadCount());
+		unique_lock<mutex> lock(mMutex);
+		mDone.wait(lock, [this] { return mRunning == 0; });
+	}
+
+private:
+	vector<thread> mThreads;
+	mutex mMutex;
+	condition_variable mWakeUp, mDone;
+	const Job* mJob;
+	uint64_t mRound;
+	int mRunning;
+	bool mStop;
+
+	void loop(int id) {
+		uint64_t seen = 0;
+		for(;;) {
+			const Job* job;
+			{
+				unique_lock<mutex> lock(mMutex);
+				mWakeUp.wait(lock, [&] { return mStop || mRound != seen; });
+				if(mStop)
+					return;
+				seen = mRound;
+				job = mJob;
+			}
+			(*job)(id, getThreadCount());
+			lock_guard<mutex> lock(mMutex);
+			if(--mRunning == 0)
+				mDone.notify_one();
+		}
+	}
+};
+
+/// The part of [0, count) that @b thread works on.
+inline void split(size_t count, int thread, int threads, size_t& begin, size_t& end) {
+	begin = count * thread / threads;
+	end = count * (thread + 1) / threads;
+}
+
+/**
+ * The positions as a structure of arrays: the features of position i are
+ * features[offsets[i]] to features[offsets[i + 1]], one per piece, and the
+ * arrays are scanned from beginning to end by every pass.
+ */
+struct Dataset {
+	vector<uint64_t> offsets;
+	vector<uint16_t> features; //!< kind * 64 + square as seen by white, | BLACK_FEATURE
+	vector<uint8_t> phases;    //!< Game phase, at most MAX_PHASE
+	vector<float> results;     //!< Of the game, 0 black won, 0.5 draw, 1 white won
+	vector<int16_t> scores;    //!< Of the search, from white's point of view
+	vector<float> targets;     //!< What the tuner fits, see setTargets()
+
+	size_t size() const { return results.size(); }
+};
+
+/// Converts the records to features, in a random order so every mini-batch mixes many games.
+void loadDataset(const vector<const PackedPosition*>& records, uint64_t seed,
+		ThreadPool& pool, Dataset& data) {
+	const size_t count = records.size();
+	vector<uint32_t> order(count);
+	for(size_t i = 0; i < count; ++i)
+		order[i] = static_cast<uint32_t>(i);
+	shuffle(order.begin(), order.end(), mt19937_64(seed));
+
+	data.offsets.assign(count + 1, 0);
+	data.phases.resize(count);
+	data.results.resize(count);
+	data.scores.resize(count);
+	for(size_t i = 0; i < count; ++i)
+		data.offsets[i + 1] = data.offsets[i] + __builtin_popcountll(records[order[i]]->occupancy);
+	data.features.resize(data.offsets[count]);
+
+	pool.run([&](int thread, int threads) {
+		size_t begin, end;
+		split(count, thread, threads, begin, end);
+		for(size_t i = begin; i < end; ++i) {
+			const PackedPosition& p = *records[order[i]];
+			uint16_t* out = &data.features[data.offsets[i]];
+			uint64_t occupied = p.occupancy;
+			int phase = 0;
+			for(int n = 0; occupied; ++n, occupied &= occupied - 1) {
+				const int square = __builtin_ctzll(occupied);
+				const PieceType type = p.getPieceType(n);
+				const int kind = getPieceKind(type);
+				phase += PHASE_WEIGHTS[kind];
+				*out++ = isWhitePieceType(type)
+						? static_cast<uint16_t>(kind * SQUARE_COUNT + square)
+						: static_cast<uint16_t>(kind * SQUARE_COUNT + mirrorSquare(square)) | BLACK_FEATURE;
+			}
+			data.phases[i] = static_cast<uint8_t>(min(phase, MAX_PHASE));
+			data.results[i] = (p.result + 1) * 0.5f;
+			data.scores[i] = p.isBlackToMove() ? static_cast<int16_t>(-p.score) : p.score;
+		}
+	});
+}
+
+inline double sigmoid(double k, double score) {
+	return 1 / (1 + exp(-k * score));
+}
+
+/// The evaluation of position @b i from white's point of view, tapered like sch::evaluate().
+inline double evaluate(const Dataset& data, size_t i, const double* weights) {
+	const double* endgame = weights + FEATURE_COUNT;
+	double mg = 0, eg = 0;
+	for(uint64_t f = data.offsets[i]; f < data.offsets[i + 1]; ++f) {
+		const uint16_t feature = data.features[f];
+		if(feature & BLACK_FEATURE) {
+			mg -= weights[feature & ~BLACK_FEATURE];
+			eg -= endgame[feature & ~BLACK_FEATURE];
+		} else {
+			mg += weights[feature];
+			eg += endgame[feature];
+		}
+	}
+	const double phase = data.phases[i] / static_cast<double>(MAX_PHASE);
+	return mg * phase + eg * (1 - phase);
+}
+
+/// Blends the game results with the search scores.
+void setTargets(Dataset& data, double k, double lambda, ThreadPool& pool) {
+	data.targets.resize(data.size());
+	pool.run([&](int thread, int threads) {
+		size_t begin, end;
+		split(data.size(), thread, threads, begin, end);
+		for(size_t i = begin; i < end; ++i)
+			data.targets[i] = static_cast<float>(lambda * sigmoid(k, data.scores[i])
+					+ (1 - lambda) * data.results[i]);
+	});
+}
+
+/// Mean squared error of the predicted results against @b targets.
+double meanError(const Dataset& data, const vector<float>& targets, const double* weights,
+		double k, ThreadPool& pool) {
+	vector<double> sums(pool.getThreadCount(), 0);
+	pool.run([&](int thread, int threads) {
+		size_t begin, end;
+		split(data.size(), thread, threads, begin, end);
+		double sum = 0;
+		for(size_t i = begin; i < end; ++i) {
+			const double e = targets[i] - sigmoid(k, evaluate(data, i, weights));
+			sum += e * e;
+		}
+		sums[thread] = sum;
+	});
+	double total = 0;
+	for(double s : sums)
+		total += s;
+	return data.size() ? total / data.size() : 0;
+}
+
+/// The K that best maps the evaluation to the game results, by golden section search.
+double fitK(const Dataset& data, const double* weights, ThreadPool& pool) {
+	const double ratio = (sqrt(5.0) - 1) / 2;
+	double low = 0.0001, high = 0.05;
+	for(int i = 0; i < 40; ++i) {
+		const double a = high - ratio * (high - low);
+		const double b = low + ratio * (high - low);
+		if(meanError(data, data.results, weights, a, pool) < meanError(data, data.results, weights, b, pool))
+			high = b;
+		else
+			low = a;
+	}
+	return (low + high) / 2;
+}
+
+/**
+ * The gradient of the mean squared error over positions [begin, end).
+ * Every thread adds up its share in its own array, which are summed at the end.
+ */
+void gradient(const Dataset& data, size_t begin, size_t end, const double* weights, double k,
+		ThreadPool& pool, vector<vector<double>>& partial, double* out) {
+	pool.run([&](int thread, int threads) {
+		vector<double>& g = partial[thread];
+		fill(g.begin(), g.end(), 0.0);
+		size_t first, last;
+		split(end - begin, thread, threads, first, last);
+		for(size_t i = begin + first; i < begin + last; ++i) {
+			const double s = sigmoid(k, evaluate(data, i, weights));
+			const double d = (s - data.targets[i]) * s * (1 - s);
+			const double phase = data.phases[i] / static_cast<double>(MAX_PHASE);
+			const double mg = d * phase, eg = d - mg;
+			for(uint64_t f = data.offsets[i]; f < data.offsets[i + 1]; ++f) {
+				const uint16_t feature = data.features[f];
+				if(feature & BLACK_FEATURE) {
+					g[feature & ~BLACK_FEATURE] -= mg;
+					g[FEATURE_COUNT + (feature & ~BLACK_FEATURE)] -= eg;
+				} else {
+					g[feature] += mg;
+					g[FEATURE_COUNT + feature] += eg;
+				}
+			}
+		}
+	});
+	const double scale = 2 * k / (end - begin);
+	for(int p = 0; p < PARAMETER_COUNT; ++p) {
+		double sum = 0;
+		for(auto& g : partial)
+			sum += g[p];
+		out[p] = sum * scale;
+	}
+}
+
+/// Can a piece of kind @b kind stand on @b square? Pawns never reach the first or last row.
+bool isReachable(int kind, int square) {
+	const int row = square / MAX_COL;
+	return kind != getPieceKind(PieceType::WHITE_PAWN) || (row != 0 && row != MAX_ROW - 1);
+}
+
+/**
+ * The piece values hidden in @b weights (the middle game or the endgame
+ * ones): the average over the squares a piece can stand on.
+ */
+void getPieceValues(const double* weights, int* values) {
+	for(int kind = 0; kind < PIECE_KINDS; ++kind) {
+		double sum = 0;
+		int count = 0;
+		for(int sq = 0; sq < SQUARE_COUNT; ++sq) {
+			if(isReachable(kind, sq)) {
+				sum += weights[kind * SQUARE_COUNT + sq];
+				++count;
+			}
+		}
+		// getPieceValue() promises 0 for the king
+		values[kind] = kind == getPieceKind(PieceType::WHITE_KING) ? 0 : static_cast<int>(lround(sum / count));
+	}
+}
+
+void writePieceValues(ostream& os, const char* name, const int* values) {
+	os << "const int " << name << "[PIECE_KINDS] = {";
+	for(int kind = 0; kind < PIECE_KINDS; ++kind)
+		os << (kind ? ", " : " ") << values[kind];
+	os << " };\n";
+}
+
+/// What is left of @b weights once @b values are taken out.
+void writePieceSquareValues(ostream& os, const char* name, const double* weights, const int* values) {
+	static const char* const KIND_NAMES[PIECE_KINDS] = { "king", "queen", "rook", "bishop", "knight", "pawn" };
+	os << "const int " << name << "[PIECE_KINDS][SQUARE_COUNT] = {\n";
+	for(int kind = 0; kind < PIECE_KINDS; ++kind) {
+		os << "\t{ // " << KIND_NAMES[kind] << "\n";
+		for(int row = 0; row < MAX_ROW; ++row) {
+			os << "\t\t";
+			for(int col = 0; col < MAX_COL; ++col) {
+				const int sq = row * MAX_COL + col;
+				const int v = isReachable(kind, sq)
+						? static_cast<int>(lround(weights[kind * SQUARE_COUNT + sq])) - values[kind] : 0;
+				os << setw(4) << v << (col + 1 < MAX_COL ? ", " : ",\n");
+			}
+		}
+		os << "\t},\n";
+	}
+	os << "};\n";
+}
+
+/// Writes the weights as EvalWeights.h.
+bool writeHeader(const string& path, const double* weights, size_t positions, double error) {
+	int midgame[PIECE_KINDS], endgame[PIECE_KINDS];
+	getPieceValues(weights, midgame);
+	getPieceValues(weights + FEATURE_COUNT, endgame);
+
+	ofstream os(path);
+	if(!os)
+		return false;
+	os << "//===-- smart-chess/EvalWeights.h -------------------------------*- C++ -*-===//\n"
+	      "//\n"
+	      "// This file is part of smart-chess, a chess game meant to provide an easy\n"
+	      "// interface to experiment, learn and implement Artificial Intelligence\n"
+	      "// algorithms.\n"
+	      "//\n"
+	      "// Copyright (c) 2014 Adri\xC3\xA1n Ortega Garc\xC3\xAD" "a <adrianog(dot)sw(at)gmail(dot)com>\n"
+	      "// All rights reserved.\n"
+	      "//\n"
+	      "// smart-chess is free software: you can redistribute it and/or modify\n"
+	      "// it under the terms of the GNU General Public License as published by\n"
+	      "// the Free Software Foundation, either version 3 of the License, or\n"
+	      "// (at your option) any later version.\n"
+	      "//\n"
+	      "// smart-chess is distributed in the hope that it will be useful,\n"
+	      "// but WITHOUT ANY WARRANTY; without even the implied warranty of\n"
+	      "// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the\n"
+	      "// GNU General Public License for more details.\n"
+	      "//\n"
+	      "// You should have received a copy of the GNU General Public License\n"
+	      "// along with smart-chess (See file COPYING for details).\n"
+	      "// If not, see <http://www.gnu.org/licenses/>.\n"
+	      "//\n"
+	      "//===----------------------------------------------------------------------===//\n"
+	      "///\n"
+	      "/// \\file EvalWeights.h\n"
+	      "/// \\brief Evaluation weights fitted by smartchess-tune.\n"
+	      "///\n"
+	      "//===----------------------------------------------------------------------===//\n"
+	      "\n"
+	      "#ifndef EVALWEIGHTS_H_\n"
+	      "#define EVALWEIGHTS_H_\n"
+	      "\n"
+	      "#include \"Util.h\"\n"
+	      "\n"
+	      "namespace sch {\n"
+	      "\n"
+	      "// Written by smartchess-tune, which also starts tuning from these values.\n"
+	      "// Last fitted to " << positions << " positions, mean squared error "
+	   << fixed << setprecision(6) << error << ".\n"
+	      "\n"
+	      "/// Sum of the PHASE_WEIGHTS of the pieces at the start of a game.\n"
+	      "const int MAX_PHASE = " << MAX_PHASE << ";\n"
+	      "\n"
+	      "/// How much a piece counts towards the game phase, indexed by getPieceKind().\n";
+	writePieceValues(os, "PHASE_WEIGHTS", PHASE_WEIGHTS);
+	os << "\n"
+	      "/// Indexed by getPieceKind(): king, queen, rook, bishop, knight, pawn.\n";
+	writePieceValues(os, "MIDGAME_PIECE_VALUES", midgame);
+	writePieceValues(os, "ENDGAME_PIECE_VALUES", endgame);
+	os << "\n"
+	      "/**\n"
+	      " * Added to the value of a piece on a square. Indexed by getPieceKind() and\n"
+	      " * the square (see toSquareIndex) as seen by white: black pieces use the\n"
+	      " * square with the row flipped.\n"
+	      " */\n";
+	writePieceSquareValues(os, "MIDGAME_PIECE_SQUARE_VALUES", weights, midgame);
+	os << "\n";
+	writePieceSquareValues(os, "ENDGAME_PIECE_SQUARE_VALUES", weights + FEATURE_COUNT, endgame);
+	os << "\n"
+	      "} /* namespace sch */\n"
+	      "\n"
+	      "#endif /* EVALWEIGHTS_H_ */\n";
+	return static_cast<bool>(os);
+}
+
+double secondsSince(Clock::time_point start) {
+	return chrono::duration<double>(Clock::now() - start).count();
+}
+
+}
+
+int main(int argc, char * argv[])
+{
+	string output_path = "EvalWeights.h";
+	vector<string> inputs;
+	int epochs = 10;
+	size_t batch_size = 16384;
+	double rate = 1, k = 0, lambda = 0;
+	int threads = max(1u, thread::hardware_concurrency());
+	uint64_t seed = 1;
+
+	try {
+		for(int i = 1; i < argc; ++i) {
+			const string arg = argv[i];
+			auto value = [&]() -> string {
+				if(i + 1 >= argc)
+					throw runtime_error(arg + " needs a value");
+				return argv[++i];
+			};
+			if(arg == "-o") output_path = value();
+			else if(arg == "-epochs") epochs = max(0, stoi(value()));
+			else if(arg == "-batch") batch_size = max<size_t>(1, stoul(value()));
+			else if(arg == "-rate") rate = stod(value());
+			else if(arg == "-k") k = stod(value());
+			else if(arg == "-lambda") lambda = stod(value());
+			else if(arg == "-threads") threads = max(1, stoi(value()));
+			else if(arg == "-seed") seed = stoull(value());
+			else if(arg[0] == '-') {
+				usage(argv[0]);
+				return arg == "-help" || arg == "-h" ? 0 : 1;
+			} else inputs.push_back(arg);
+		}
+	} catch(const exception& e) {
+		cerr << e.what() << endl;
+		usage(argv[0]);
+		return 1;
+	}
+	if(inputs.empty()) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	// The files stay mapped while the features are built, the records are not copied
+	vector<unique_ptr<MappedFile>> files;
+	vector<const PackedPosition*> records;
+	try {
+		for(auto& path : inputs) {
+			files.emplace_back(new MappedFile(path));
+			const MappedFile& file = *files.back();
+			file.adviseSequential();
+			const PackedPosition* p = reinterpret_cast<const PackedPosition*>(file.getData());
+			const size_t count = file.getSize() / sizeof(PackedPosition);
+			for(size_t i = 0; i < count; ++i)
+				records.push_back(p + i);
+		}
+	} catch(const ChessException& e) {
+		cerr << e.what() << endl;
+		return 1;
+	}
+	if(records.empty()) {
+		cerr << "No positions to tune on" << endl;
+		return 1;
+	}
+
+	ThreadPool pool(threads);
+	Dataset data;
+	Clock::time_point start = Clock::now();
+	loadDataset(records, seed, pool, data);
+	records.clear();
+	records.shrink_to_fit();
+	files.clear();
+	cerr << fixed << setprecision(2) << "Loaded " << data.size() << " positions, "
+	     << data.features.size() << " features in " << secondsSince(start) << " s" << endl;
+
+	vector<double> weights(PARAMETER_COUNT);
+	for(int kind = 0; kind < PIECE_KINDS; ++kind) {
+		for(int sq = 0; sq < SQUARE_COUNT; ++sq) {
+			const int f = kind * SQUARE_COUNT + sq;
+			weights[f] = MIDGAME_PIECE_VALUES[kind] + MIDGAME_PIECE_SQUARE_VALUES[kind][sq];
+			weights[FEATURE_COUNT + f] = ENDGAME_PIECE_VALUES[kind] + ENDGAME_PIECE_SQUARE_VALUES[kind][sq];
+		}
+	}
+
+	if(k <= 0) {
+		start = Clock::now();
+		k = fitK(data, weights.data(), pool);
+		cerr << setprecision(6) << "Fitted K = " << k << " in " << setprecision(2) << secondsSince(start) << " s" << endl;
+	}
+	setTargets(data, k, lambda, pool);
+	cerr << setprecision(6) << "Initial error " << meanError(data, data.targets, weights.data(), k, pool) << endl;
+
+	// Adam, which copes well with weights of very different scales
+	const double BETA1 = 0.9, BETA2 = 0.999, EPSILON = 1e-8;
+	vector<double> m(PARAMETER_COUNT, 0), v(PARAMETER_COUNT, 0), g(PARAMETER_COUNT);
+	vector<vector<double>> partial(pool.getThreadCount(), vector<double>(PARAMETER_COUNT));
+	uint64_t step = 0;
+	double error = 0;
+
+	for(int epoch = 1; epoch <= epochs; ++epoch) {
+		start = Clock::now();
+		for(size_t begin = 0; begin < data.size(); begin += batch_size) {
+			const size_t end = min(data.size(), begin + batch_size);
+			gradient(data, begin, end, weights.data(), k, pool, partial, g.data());
+			++step;
+			const double correction1 = 1 - pow(BETA1, static_cast<double>(step));
+			const double correction2 = 1 - pow(BETA2, static_cast<double>(step));
+			for(int p = 0; p < PARAMETER_COUNT; ++p) {
+				m[p] = BETA1 * m[p] + (1 - BETA1) * g[p];
+				v[p] = BETA2 * v[p] + (1 - BETA2) * g[p] * g[p];
+				weights[p] -= rate * (m[p] / correction1) / (sqrt(v[p] / correction2) + EPSILON);
+			}
+		}
+		const double seconds = secondsSince(start);
+		error = meanError(data, data.targets, weights.data(), k, pool);
+		cerr << "Epoch " << epoch << ": error " << setprecision(6) << error << ", "
+		     << setprecision(2) << seconds << " s, "
+		     << setprecision(0) << data.size() / seconds << " positions/s" << endl;
+	}
+	if(!epochs)
+		error = meanError(data, data.targets, weights.data(), k, pool);
+
+	if(!writeHeader(output_path, weights.data(), data.size(), error)) {
+		cerr << "Could not write " << output_path << endl;
+		return 1;
+	}
+	cerr << "Wrote " << output_path << endl;
+	return 0;
+}
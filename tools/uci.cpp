@@ -0,0 +1,253 @@
+//===-- smart-chess/uci.cpp -------------------------------------*- C++ -*-===//
+//
+// This file is part of smart-chess, a chess game meant to provide an easy
+// interface to experiment, learn and implement Artificial Intelligence
+// algorithms.
+//
+// Copyright (c) 2014 Adrián Ortega García <adrianog(dot)sw(at)gmail(dot)com>
+// All rights reserved.
+//
+// smart-chess is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// smart-chess is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with smart-chess (See file COPYING for details).
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file uci.cpp
+/// \brief Headless engine speaking the Universal Chess Interface protocol.
+///
+//===----------------------------------------------------------------------===//
+
+#include "BoardState.h"
+#include "Notation.h"
+#include "Search.h"
+#include "SmartChessConfig.h"
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+using namespace std;
+using namespace sch;
+
+namespace {
+
+const int MAX_HASH_MB = 4096;
+const int MAX_THREADS = 64;
+
+/**
+ * Reads UCI commands from stdin and answers on stdout. The search runs on a
+ * thread of its own so "stop" and "ponderhit" are handled while thinking.
+ */
+class UciEngine {
+public:
+	UciEngine() : mSearch(), mState(), mThinker(), mOutputMutex() {
+		mSearch.setInfoCallback([this](const SearchInfo& info) { sendInfo(info); });
+	}
+
+	~UciEngine() {
+		mSearch.stop();
+		waitForSearch();
+	}
+
+	int loop() {
+		string line;
+		while(getline(cin, line)) {
+			istringstream is(line);
+			string cmd;
+			is >> cmd;
+
+			if(cmd == "uci") {
+				ostringstream os;
+				os << "id name smart-chess " << SMARTCHESS_VERSION_MAJOR << "." << SMARTCHESS_VERSION_MINOR << "\n"
+				   << "id author Adrian Ortega Garcia\n"
+				   << "option name Hash type spin default " << TranspositionTable::DEFAULT_SIZE_MB
+				   << " min 1 max " << MAX_HASH_MB << "\n"
+				   << "option name Threads type spin default 1 min 1 max " << MAX_THREADS << "\n"
+				   << "option name Ponder type check default false\n"
+				   << "option name EvalFile type string default <empty>\n"
+				   << "uciok";
+				send(os.str());
+			} else if(cmd == "isready") {
+				send("readyok");
+			} else if(cmd == "setoption") {
+				setOption(is);
+			} else if(cmd == "ucinewgame") {
+				waitForSearch();
+				mSearch.clear();
+				mState = BoardState();
+			} else if(cmd == "position") {
+				waitForSearch();
+				position(is);
+			} else if(cmd == "go") {
+				go(is);
+			} else if(cmd == "stop") {
+				mSearch.stop();
+				waitForSearch();
+			} else if(cmd == "ponderhit") {
+				mSearch.ponderhit();
+			} else if(cmd == "quit") {
+				break;
+			} else if(!cmd.empty()) {
+				send("info string unknown command " + cmd);
+			}
+		}
+		return 0;
+	}
+
+private:
+	Search mSearch;
+	BoardState mState;
+	thread mThinker;
+	mutex mOutputMutex;
+
+	void send(const string& text) {
+		lock_guard<mutex> lock(mOutputMutex);
+		cout << text << endl;
+	}
+
+	void waitForSearch() {
+		if(mThinker.joinable())
+			mThinker.join();
+	}
+
+	void setOption(istringstream& is) {
+		// setoption name <id> [value <x>], the name may contain spaces
+		string token, name, value;
+		is >> token;
+		while(is >> token && token != "value")
+			name += (name.empty() ? "" : " ") + token;
+		getline(is >> ws, value);
+
+		waitForSearch();
+		try {
+			if(name == "Hash")
+				mSearch.setHashSize(max(1, min(stoi(value), MAX_HASH_MB)));
+			else if(name == "Threads")
+				mSearch.setThreads(max(1, min(stoi(value), MAX_THREADS)));
+			else if(name == "EvalFile")
+				setNetwork(value);
+			else if(name != "Ponder")
+				send("info string unknown option " + name);
+		} catch(const exception&) {
+			send("info string invalid value for " + name);
+		}
+	}
+
+	/// Switches to the network in file @b path, or to the classical evaluation for "<empty>".
+	void setNetwork(const string& path) {
+		if(path.empty() || path == "<empty>") {
+			mSearch.setNetwork(nullptr);
+			send("info string using the classical evaluation");
+			return;
+		}
+		try {
+			shared_ptr<const NNUENetwork> network(new NNUENetwork(path));
+			mSearch.setNetwork(network);
+			send("info string using network " + path + " with "
+					+ toString(network->getSimd()));
+		} catch(const ChessException& e) {
+			send(string("info string ") + e.what());
+		}
+	}
+
+	void position(istringstream& is) {
+		string token;
+		is >> token;
+
+		BoardState state;
+		if(token == "fen") {
+			string fen;
+			while(is >> token && token != "moves")
+				fen += (fen.empty() ? "" : " ") + token;
+			try {
+				state.loadFEN(fen);
+			} catch(const FENException& e) {
+				send(string("info string ") + e.what());
+				return;
+			}
+		} else if(token == "startpos") {
+			is >> token;
+		} else {
+			return;
+		}
+
+		if(token == "moves") {
+			while(is >> token) {
+				Move m = parseUCIMove(state, token);
+				if(!m.isValid()) {
+					send("info string illegal move " + token);
+					break;
+				}
+				BoardState::UndoInfo undo;
+				state.makeMove(m, undo);
+			}
+		}
+		mState = state;
+	}
+
+	void go(istringstream& is) {
+		waitForSearch();
+
+		SearchLimits limits;
+		string token;
+		while(is >> token) {
+			if(token == "wtime") is >> limits.time[0];
+			else if(token == "btime") is >> limits.time[1];
+			else if(token == "winc") is >> limits.increment[0];
+			else if(token == "binc") is >> limits.increment[1];
+			else if(token == "movestogo") is >> limits.movesToGo;
+			else if(token == "depth") is >> limits.depth;
+			else if(token == "nodes") is >> limits.nodes;
+			else if(token == "movetime") is >> limits.moveTime;
+			else if(token == "infinite") limits.infinite = true;
+			else if(token == "ponder") limits.ponder = true;
+		}
+
+		// A "stop" may come before the thinker gets to think()
+		mSearch.prepare(limits);
+		const BoardState root(mState);
+		mThinker = thread([this, root, limits]() {
+			Move ponder;
+			const Move best = mSearch.think(root, limits, &ponder);
+			string text = "bestmove " + toUCI(best);
+			if(ponder.isValid())
+				text += " ponder " + toUCI(ponder);
+			send(text);
+		});
+	}
+
+	void sendInfo(const SearchInfo& info) {
+		ostringstream os;
+		os << "info depth " << info.depth << " seldepth " << info.selDepth;
+		if(Search::isMateScore(info.score))
+			os << " score mate " << Search::getMateIn(info.score);
+		else
+			os << " score cp " << info.score;
+		os << " nodes " << info.nodes << " nps " << info.nps << " time " << info.time
+		   << " hashfull " << info.hashFull << " pv";
+		for(auto& m : info.pv)
+			os << " " << toUCI(m);
+		send(os.str());
+	}
+};
+
+}
+
+int main()
+{
+	// The GUI reads our answers line by line
+	cout.setf(ios::unitbuf);
+	UciEngine engine;
+	return engine.loop();
+}